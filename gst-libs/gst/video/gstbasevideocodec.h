@@ -79,6 +79,24 @@ G_BEGIN_DECLS
  */
 #define GST_BASE_VIDEO_CODEC_FLOW_NEED_DATA GST_FLOW_CUSTOM_SUCCESS
 
+/**
+ * GstVideoFrameType:
+ * @GST_VIDEO_FRAME_TYPE_AUTO: no preference, the codec decides
+ * @GST_VIDEO_FRAME_TYPE_KEY: the frame should be a sync point
+ * @GST_VIDEO_FRAME_TYPE_DELTA: the frame should predict from other frames
+ * @GST_VIDEO_FRAME_TYPE_DISPOSABLE: no other frame should predict from it
+ *
+ * The type a frame to encode should preferably be coded as, e.g. as
+ * decided from a lookahead analysis.
+ */
+typedef enum
+{
+  GST_VIDEO_FRAME_TYPE_AUTO,
+  GST_VIDEO_FRAME_TYPE_KEY,
+  GST_VIDEO_FRAME_TYPE_DELTA,
+  GST_VIDEO_FRAME_TYPE_DISPOSABLE
+} GstVideoFrameType;
+
 typedef struct _GstVideoState GstVideoState;
 typedef struct _GstVideoFrame GstVideoFrame;
 typedef struct _GstBaseVideoCodec GstBaseVideoCodec;
@@ -135,6 +153,9 @@ struct _GstVideoFrame
   /* Events that should be pushed downstream *before*
    * the next src_buffer */
   GList *events;
+
+  /* frame type hint for encoding */
+  GstVideoFrameType type_hint;
 };
 
 struct _GstBaseVideoCodec
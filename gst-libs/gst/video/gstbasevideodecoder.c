@@ -100,6 +100,17 @@
  * and should ensure the parsing stage properly marks keyframes or rely on
  * upstream to do so properly for incoming data.
  *
+ * A subclass that can decode several frames at once can declare so with
+ * gst_base_video_decoder_set_parallelism().  Frames are then handed to
+ * @handle_frame from a pool of worker threads during forward playback,
+ * either each on its own or one GOP after the other, and the base class
+ * pushes the frames given to @gst_base_video_decoder_finish_frame in the
+ * order they would have been pushed by a serial decoder.  @handle_frame
+ * should then finish the frames it gets before returning, or in GOP mode
+ * from @finish, which is called at the end of every GOP from the worker
+ * thread.  State that is private to a GOP can be kept with
+ * gst_base_video_decoder_set_gop_hook().
+ *
  * Things that subclass need to take care of:
  * <itemizedlist>
  *   <listitem><para>Provide pad templates</para></listitem>
@@ -171,6 +182,34 @@ static GstVideoFrame *gst_base_video_decoder_new_frame (GstBaseVideoDecoder *
     base_video_decoder);
 
 static void gst_base_video_decoder_clear_queues (GstBaseVideoDecoder * dec);
+static GstFlowReturn gst_base_video_decoder_drain_parallel (GstBaseVideoDecoder
+    * dec, gboolean discard);
+static GstFlowReturn gst_base_video_decoder_push_frame (GstBaseVideoDecoder *
+    base_video_decoder, GstVideoFrame * frame);
+
+/* Frames that are handled one after the other by a worker, a GOP or a
+ * single frame.  Lanes are queued in decoding order and the frames they
+ * finish are pushed once all lanes before them are done. */
+typedef struct
+{
+  GstBaseVideoDecoder *decoder;
+  /* frames waiting for @handle_frame */
+  GQueue pending;
+  /* frames given to finish_frame and not pushed yet */
+  GQueue finished;
+  /* a worker is handling the frames */
+  gboolean running;
+  /* no more frames will be added */
+  gboolean closed;
+  /* @finish was called at the end of the GOP */
+  gboolean drained;
+
+  gpointer coder_hook;
+  GDestroyNotify coder_hook_destroy_notify;
+} GstBaseVideoDecoderLane;
+
+/* the lane handled by the calling worker thread */
+static GStaticPrivate current_lane = G_STATIC_PRIVATE_INIT;
 
 GST_BOILERPLATE (GstBaseVideoDecoder, gst_base_video_decoder,
     GstBaseVideoCodec, GST_TYPE_BASE_VIDEO_CODEC);
@@ -307,6 +346,9 @@ gst_base_video_decoder_sink_setcaps (GstPad * pad, GstCaps * caps)
     state.codec_data = GST_BUFFER (gst_value_dup_mini_object (codec_data));
   }
 
+  /* frames still being decoded use the previous format */
+  gst_base_video_decoder_drain_parallel (base_video_decoder, FALSE);
+
   if (base_video_decoder_class->set_format) {
     ret = base_video_decoder_class->set_format (base_video_decoder, &state);
   }
@@ -344,6 +386,14 @@ gst_base_video_decoder_finalize (GObject * object)
     g_object_unref (base_video_decoder->output_adapter);
     base_video_decoder->output_adapter = NULL;
   }
+  if (base_video_decoder->pool) {
+    g_thread_pool_free (base_video_decoder->pool, FALSE, TRUE);
+    base_video_decoder->pool = NULL;
+  }
+  if (base_video_decoder->parallel_lock) {
+    g_mutex_free (base_video_decoder->parallel_lock);
+    g_cond_free (base_video_decoder->parallel_cond);
+  }
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -359,6 +409,11 @@ gst_base_video_decoder_flush (GstBaseVideoDecoder * dec, gboolean hard)
 
   GST_LOG_OBJECT (dec, "flush hard %d", hard);
 
+  /* the frames in the workers belong to the previous segment */
+  gst_base_video_decoder_drain_parallel (dec, hard);
+  if (hard)
+    dec->parallel_ret = GST_FLOW_OK;
+
   /* Inform subclass */
   /* FIXME ? only if hard, or tell it if hard ? */
   if (klass->reset)
@@ -412,6 +467,8 @@ gst_base_video_decoder_sink_event (GstPad * pad, GstEvent * event)
         } while (flow_ret == GST_FLOW_OK);
       }
 
+      gst_base_video_decoder_drain_parallel (base_video_decoder, FALSE);
+
       if (base_video_decoder_class->finish) {
         flow_ret = base_video_decoder_class->finish (base_video_decoder);
       } else {
@@ -992,7 +1049,7 @@ gst_base_video_decoder_chain_forward (GstBaseVideoDecoder * base_video_decoder,
   if (base_video_decoder->packetized) {
     base_video_decoder->current_frame->sink_buffer = buf;
 
-    if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+    if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
       base_video_decoder->current_frame->is_sync_point = TRUE;
 
     ret = gst_base_video_decoder_have_frame_2 (base_video_decoder);
@@ -1288,9 +1345,21 @@ gst_base_video_decoder_change_state (GstElement * element,
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      base_video_decoder->parallel_ret = GST_FLOW_OK;
+      base_video_decoder->queue_depth = 0;
+      base_video_decoder->max_queue_depth = 0;
+      base_video_decoder->n_decoded = 0;
+      base_video_decoder->total_decode_time = 0;
+      base_video_decoder->max_frame_decode_time = 0;
       if (base_video_decoder_class->start) {
         base_video_decoder_class->start (base_video_decoder);
       }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* the frames are freed when chaining up, and nothing is dispatched
+       * any more once this failed the flow */
+      gst_base_video_decoder_drain_parallel (base_video_decoder, TRUE);
+      break;
     default:
       break;
   }
@@ -1299,6 +1368,15 @@ gst_base_video_decoder_change_state (GstElement * element,
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      if (base_video_decoder->n_decoded) {
+        GST_DEBUG_OBJECT (base_video_decoder, "decoded %" G_GUINT64_FORMAT
+            " frames, average %" GST_TIME_FORMAT ", max %" GST_TIME_FORMAT
+            ", max queue depth %u", base_video_decoder->n_decoded,
+            GST_TIME_ARGS (base_video_decoder->total_decode_time /
+                base_video_decoder->n_decoded),
+            GST_TIME_ARGS (base_video_decoder->max_frame_decode_time),
+            base_video_decoder->max_queue_depth);
+      }
       if (base_video_decoder_class->stop) {
         base_video_decoder_class->stop (base_video_decoder);
       }
@@ -1338,6 +1416,299 @@ gst_base_video_decoder_new_frame (GstBaseVideoDecoder * base_video_decoder)
   return frame;
 }
 
+static void
+gst_base_video_decoder_add_decode_time (GstBaseVideoDecoder * dec,
+    GstClockTime time)
+{
+  dec->n_decoded++;
+  dec->total_decode_time += time;
+  dec->max_frame_decode_time = MAX (dec->max_frame_decode_time, time);
+}
+
+static GstBaseVideoDecoderLane *
+gst_base_video_decoder_lane_new (GstBaseVideoDecoder * dec)
+{
+  GstBaseVideoDecoderLane *lane;
+
+  lane = g_slice_new0 (GstBaseVideoDecoderLane);
+  lane->decoder = dec;
+  g_queue_init (&lane->pending);
+  g_queue_init (&lane->finished);
+
+  return lane;
+}
+
+static void
+gst_base_video_decoder_lane_free (GstBaseVideoDecoderLane * lane)
+{
+  if (lane->coder_hook_destroy_notify && lane->coder_hook)
+    lane->coder_hook_destroy_notify (lane->coder_hook);
+
+  g_slice_free (GstBaseVideoDecoderLane, lane);
+}
+
+static void
+gst_base_video_decoder_drop_frame (GstBaseVideoDecoder * dec,
+    GstVideoFrame * frame)
+{
+  GST_OBJECT_LOCK (dec);
+  GST_BASE_VIDEO_CODEC (dec)->frames =
+      g_list_remove (GST_BASE_VIDEO_CODEC (dec)->frames, frame);
+  GST_OBJECT_UNLOCK (dec);
+  gst_base_video_codec_free_frame (frame);
+}
+
+/* call with the parallel lock.  Not-linked doesn't stop the workers, it is
+ * passed upstream once, as a serial decoder returns it for the frame that
+ * couldn't be pushed.  The other errors stick until the next flush. */
+static gboolean
+gst_base_video_decoder_parallel_failed (GstBaseVideoDecoder * dec)
+{
+  return dec->parallel_ret != GST_FLOW_OK &&
+      dec->parallel_ret != GST_FLOW_NOT_LINKED;
+}
+
+/* call with the parallel lock */
+static void
+gst_base_video_decoder_set_parallel_ret (GstBaseVideoDecoder * dec,
+    GstFlowReturn ret)
+{
+  if (ret < GST_FLOW_OK && !gst_base_video_decoder_parallel_failed (dec)) {
+    GST_DEBUG_OBJECT (dec, "flow %s", gst_flow_get_name (ret));
+    dec->parallel_ret = ret;
+  }
+}
+
+/* call with the parallel lock */
+static gboolean
+gst_base_video_decoder_lane_needs_worker (GstBaseVideoDecoder * dec,
+    GstBaseVideoDecoderLane * lane)
+{
+  GstBaseVideoDecoderClass *klass = GST_BASE_VIDEO_DECODER_GET_CLASS (dec);
+
+  if (!g_queue_is_empty (&lane->pending))
+    return TRUE;
+
+  /* the end of a GOP is drained with @finish */
+  return lane->closed && !lane->drained && !dec->discarding &&
+      dec->parallelism == GST_BASE_VIDEO_DECODER_PARALLELISM_GOP &&
+      klass->finish != NULL;
+}
+
+/* call with the parallel lock */
+static void
+gst_base_video_decoder_lane_schedule (GstBaseVideoDecoder * dec,
+    GstBaseVideoDecoderLane * lane)
+{
+  if (!lane->running && gst_base_video_decoder_lane_needs_worker (dec, lane)) {
+    lane->running = TRUE;
+    g_thread_pool_push (dec->pool, lane, NULL);
+  }
+}
+
+/* call with the parallel lock */
+static void
+gst_base_video_decoder_close_lane (GstBaseVideoDecoder * dec)
+{
+  GstBaseVideoDecoderLane *lane = dec->current_lane;
+
+  if (lane) {
+    lane->closed = TRUE;
+    gst_base_video_decoder_lane_schedule (dec, lane);
+    dec->current_lane = NULL;
+  }
+}
+
+/* call with the parallel lock, frees the lanes that are done */
+static GstVideoFrame *
+gst_base_video_decoder_next_output (GstBaseVideoDecoder * dec)
+{
+  GstBaseVideoDecoderLane *lane;
+
+  while ((lane = g_queue_peek_head (&dec->lanes))) {
+    if (!g_queue_is_empty (&lane->finished))
+      return g_queue_pop_head (&lane->finished);
+
+    if (!lane->closed || lane->running ||
+        gst_base_video_decoder_lane_needs_worker (dec, lane))
+      return NULL;
+
+    g_queue_pop_head (&dec->lanes);
+    gst_base_video_decoder_lane_free (lane);
+  }
+
+  return NULL;
+}
+
+/* pushes the frames finished by the lanes next in line.  One thread pushes
+ * at a time, the others leave their frames to it. */
+static GstFlowReturn
+gst_base_video_decoder_push_finished (GstBaseVideoDecoder * dec)
+{
+  GstVideoFrame *frame;
+  GstFlowReturn ret;
+
+  g_mutex_lock (dec->parallel_lock);
+  if (!dec->outputting) {
+    dec->outputting = TRUE;
+    while ((frame = gst_base_video_decoder_next_output (dec))) {
+      if (dec->discarding) {
+        gst_base_video_decoder_drop_frame (dec, frame);
+        continue;
+      }
+
+      g_mutex_unlock (dec->parallel_lock);
+      ret = gst_base_video_decoder_push_frame (dec, frame);
+      g_mutex_lock (dec->parallel_lock);
+
+      gst_base_video_decoder_set_parallel_ret (dec, ret);
+    }
+    dec->outputting = FALSE;
+    g_cond_broadcast (dec->parallel_cond);
+  }
+  ret = dec->parallel_ret;
+  g_mutex_unlock (dec->parallel_lock);
+
+  return ret;
+}
+
+static void
+gst_base_video_decoder_lane_func (gpointer data, gpointer user_data)
+{
+  GstBaseVideoDecoderLane *lane = data;
+  GstBaseVideoDecoder *dec = user_data;
+  GstBaseVideoDecoderClass *klass = GST_BASE_VIDEO_DECODER_GET_CLASS (dec);
+  GstVideoFrame *frame;
+  GstClockTime start, elapsed;
+  GstFlowReturn ret;
+
+  g_static_private_set (&current_lane, lane, NULL);
+
+  g_mutex_lock (dec->parallel_lock);
+  while (gst_base_video_decoder_lane_needs_worker (dec, lane)) {
+    frame = g_queue_pop_head (&lane->pending);
+
+    if (frame == NULL) {
+      GST_LOG_OBJECT (dec, "end of GOP");
+      lane->drained = TRUE;
+      g_mutex_unlock (dec->parallel_lock);
+      ret = klass->finish (dec);
+      g_mutex_lock (dec->parallel_lock);
+    } else if (dec->discarding) {
+      dec->queue_depth--;
+      gst_base_video_decoder_drop_frame (dec, frame);
+      ret = GST_FLOW_OK;
+    } else {
+      g_mutex_unlock (dec->parallel_lock);
+      start = gst_util_get_timestamp ();
+      ret = klass->handle_frame (dec, frame);
+      elapsed = gst_util_get_timestamp () - start;
+      g_mutex_lock (dec->parallel_lock);
+      dec->queue_depth--;
+      gst_base_video_decoder_add_decode_time (dec, elapsed);
+    }
+
+    gst_base_video_decoder_set_parallel_ret (dec, ret);
+    g_cond_broadcast (dec->parallel_cond);
+  }
+  lane->running = FALSE;
+  g_mutex_unlock (dec->parallel_lock);
+
+  /* the lane can be freed from now on */
+  g_static_private_set (&current_lane, NULL, NULL);
+
+  gst_base_video_decoder_push_finished (dec);
+}
+
+/* hands @frame to the workers, waits while too many frames are in flight */
+static GstFlowReturn
+gst_base_video_decoder_dispatch_frame (GstBaseVideoDecoder * dec,
+    GstVideoFrame * frame)
+{
+  GstBaseVideoDecoderLane *lane;
+  GstFlowReturn ret;
+  gboolean new_lane;
+  guint max_lanes;
+
+  if (dec->parallelism == GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME) {
+    new_lane = TRUE;
+    max_lanes = 2 * dec->n_threads;
+  } else {
+    new_lane = frame->is_sync_point || dec->current_lane == NULL;
+    /* a GOP per worker, and the one being gathered */
+    max_lanes = dec->n_threads + 1;
+  }
+
+  g_mutex_lock (dec->parallel_lock);
+  while (new_lane && !gst_base_video_decoder_parallel_failed (dec) &&
+      g_queue_get_length (&dec->lanes) >= max_lanes)
+    g_cond_wait (dec->parallel_cond, dec->parallel_lock);
+
+  ret = dec->parallel_ret;
+  if (ret == GST_FLOW_NOT_LINKED) {
+    /* reported now, the frame is decoded all the same */
+    dec->parallel_ret = GST_FLOW_OK;
+  } else if (ret != GST_FLOW_OK) {
+    g_mutex_unlock (dec->parallel_lock);
+    GST_DEBUG_OBJECT (dec, "dropping frame, flow %s", gst_flow_get_name (ret));
+    gst_base_video_decoder_drop_frame (dec, frame);
+    return ret;
+  }
+
+  if (new_lane) {
+    gst_base_video_decoder_close_lane (dec);
+    dec->current_lane = gst_base_video_decoder_lane_new (dec);
+    g_queue_push_tail (&dec->lanes, dec->current_lane);
+  }
+  lane = dec->current_lane;
+  g_queue_push_tail (&lane->pending, frame);
+
+  dec->queue_depth++;
+  dec->max_queue_depth = MAX (dec->max_queue_depth, dec->queue_depth);
+  GST_LOG_OBJECT (dec, "dispatched frame %d, queue depth %u, %u lanes",
+      frame->system_frame_number, dec->queue_depth,
+      g_queue_get_length (&dec->lanes));
+
+  gst_base_video_decoder_lane_schedule (dec, lane);
+  g_mutex_unlock (dec->parallel_lock);
+
+  return ret;
+}
+
+/* waits until the dispatched frames are decoded and pushed.  With @discard
+ * they are dropped instead and the flow fails until parallel_ret is reset. */
+static GstFlowReturn
+gst_base_video_decoder_drain_parallel (GstBaseVideoDecoder * dec,
+    gboolean discard)
+{
+  GstFlowReturn ret;
+
+  if (dec->pool == NULL)
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (dec, "draining workers, discard %d", discard);
+
+  g_mutex_lock (dec->parallel_lock);
+  if (discard) {
+    dec->discarding = TRUE;
+    gst_base_video_decoder_set_parallel_ret (dec, GST_FLOW_WRONG_STATE);
+    g_cond_broadcast (dec->parallel_cond);
+  }
+  gst_base_video_decoder_close_lane (dec);
+  g_mutex_unlock (dec->parallel_lock);
+
+  gst_base_video_decoder_push_finished (dec);
+
+  g_mutex_lock (dec->parallel_lock);
+  while (!g_queue_is_empty (&dec->lanes) || dec->outputting)
+    g_cond_wait (dec->parallel_cond, dec->parallel_lock);
+  dec->discarding = FALSE;
+  ret = dec->parallel_ret;
+  g_mutex_unlock (dec->parallel_lock);
+
+  return ret;
+}
+
 /**
  * gst_base_video_decoder_finish_frame:
  * @base_video_decoder: a #GstBaseVideoDecoder
@@ -1348,11 +1719,31 @@ gst_base_video_decoder_new_frame (GstBaseVideoDecoder * base_video_decoder)
  * If no output data is provided, @frame is considered skipped.
  * In any case, the frame is considered finished and released.
  *
+ * When called from a worker thread, @frame is pushed once the frames
+ * dispatched before the ones of the worker have been pushed.
+ *
  * Returns: a #GstFlowReturn resulting from sending data downstream
  */
 GstFlowReturn
 gst_base_video_decoder_finish_frame (GstBaseVideoDecoder * base_video_decoder,
     GstVideoFrame * frame)
+{
+  GstBaseVideoDecoderLane *lane;
+
+  lane = g_static_private_get (&current_lane);
+  if (lane == NULL || lane->decoder != base_video_decoder)
+    return gst_base_video_decoder_push_frame (base_video_decoder, frame);
+
+  g_mutex_lock (base_video_decoder->parallel_lock);
+  g_queue_push_tail (&lane->finished, frame);
+  g_mutex_unlock (base_video_decoder->parallel_lock);
+
+  return gst_base_video_decoder_push_finished (base_video_decoder);
+}
+
+static GstFlowReturn
+gst_base_video_decoder_push_frame (GstBaseVideoDecoder * base_video_decoder,
+    GstVideoFrame * frame)
 {
   GstVideoState *state = &GST_BASE_VIDEO_CODEC (base_video_decoder)->state;
   GstBuffer *src_buffer;
@@ -1702,6 +2093,7 @@ gst_base_video_decoder_have_frame_2 (GstBaseVideoDecoder * base_video_decoder)
   GstVideoFrame *frame = base_video_decoder->current_frame;
   GstBaseVideoDecoderClass *base_video_decoder_class;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime start;
 
   base_video_decoder_class =
       GST_BASE_VIDEO_DECODER_GET_CLASS (base_video_decoder);
@@ -1739,8 +2131,17 @@ gst_base_video_decoder_have_frame_2 (GstBaseVideoDecoder * base_video_decoder)
       (base_video_decoder)->segment, GST_FORMAT_TIME,
       frame->presentation_timestamp);
 
+  if (base_video_decoder->pool &&
+      GST_BASE_VIDEO_CODEC (base_video_decoder)->segment.rate > 0.0) {
+    ret = gst_base_video_decoder_dispatch_frame (base_video_decoder, frame);
+    goto exit;
+  }
+
   /* do something with frame */
+  start = gst_util_get_timestamp ();
   ret = base_video_decoder_class->handle_frame (base_video_decoder, frame);
+  gst_base_video_decoder_add_decode_time (base_video_decoder,
+      gst_util_get_timestamp () - start);
   if (ret != GST_FLOW_OK) {
     GST_DEBUG_OBJECT (base_video_decoder, "flow error %s",
         gst_flow_get_name (ret));
@@ -2008,9 +2409,151 @@ gst_base_video_decoder_get_max_decode_time (GstBaseVideoDecoder *
       GST_TIME_ARGS (earliest_time), GST_TIME_ARGS (frame->deadline),
       GST_TIME_ARGS (deadline));
 
+#ifndef GST_DISABLE_GST_DEBUG
+  if (base_video_decoder->parallel_lock)
+    g_mutex_lock (base_video_decoder->parallel_lock);
+  GST_LOG_OBJECT (base_video_decoder, "queue depth %u (max %u), decode time "
+      "average %" GST_TIME_FORMAT ", max %" GST_TIME_FORMAT,
+      base_video_decoder->queue_depth, base_video_decoder->max_queue_depth,
+      GST_TIME_ARGS (base_video_decoder->n_decoded ?
+          base_video_decoder->total_decode_time /
+          base_video_decoder->n_decoded : 0),
+      GST_TIME_ARGS (base_video_decoder->max_frame_decode_time));
+  if (base_video_decoder->parallel_lock)
+    g_mutex_unlock (base_video_decoder->parallel_lock);
+#endif
+
   return deadline;
 }
 
+/**
+ * gst_base_video_decoder_get_decode_stats:
+ * @base_video_decoder: a #GstBaseVideoDecoder
+ * @n_decoded: (out) (allow-none): the number of frames given to @handle_frame
+ * @average: (out) (allow-none): the average time spent in @handle_frame
+ * @max: (out) (allow-none): the longest time spent in @handle_frame
+ * @max_queue_depth: (out) (allow-none): the most frames dispatched to the
+ *     worker threads and not handled yet at the same time
+ *
+ * Gets the decoding statistics gathered since the element went to PAUSED.
+ * Can be called from any thread.
+ */
+void
+gst_base_video_decoder_get_decode_stats (GstBaseVideoDecoder *
+    base_video_decoder, guint64 * n_decoded, GstClockTime * average,
+    GstClockTime * max, guint * max_queue_depth)
+{
+  g_return_if_fail (GST_IS_BASE_VIDEO_DECODER (base_video_decoder));
+
+  if (base_video_decoder->parallel_lock)
+    g_mutex_lock (base_video_decoder->parallel_lock);
+  if (n_decoded)
+    *n_decoded = base_video_decoder->n_decoded;
+  if (average)
+    *average = base_video_decoder->n_decoded ?
+        base_video_decoder->total_decode_time /
+        base_video_decoder->n_decoded : 0;
+  if (max)
+    *max = base_video_decoder->max_frame_decode_time;
+  if (max_queue_depth)
+    *max_queue_depth = base_video_decoder->max_queue_depth;
+  if (base_video_decoder->parallel_lock)
+    g_mutex_unlock (base_video_decoder->parallel_lock);
+}
+
+/**
+ * gst_base_video_decoder_set_parallelism:
+ * @base_video_decoder: a #GstBaseVideoDecoder
+ * @parallelism: the frames that can be decoded concurrently
+ * @n_threads: the number of worker threads
+ *
+ * Lets the base class hand the frames to @handle_frame from @n_threads
+ * worker threads during forward playback.  In GOP mode, the frames from a
+ * sync point to the next one are handled in order, one at a time.  The
+ * output is pushed in order all the same, once the frames before it have
+ * been pushed.  Should be called while not streaming, e.g. from @start.
+ */
+void
+gst_base_video_decoder_set_parallelism (GstBaseVideoDecoder *
+    base_video_decoder, GstBaseVideoDecoderParallelism parallelism,
+    guint n_threads)
+{
+  g_return_if_fail (GST_IS_BASE_VIDEO_DECODER (base_video_decoder));
+
+  GST_DEBUG_OBJECT (base_video_decoder, "parallelism %d, %u threads",
+      parallelism, n_threads);
+
+  gst_base_video_decoder_drain_parallel (base_video_decoder, FALSE);
+  if (base_video_decoder->pool) {
+    g_thread_pool_free (base_video_decoder->pool, FALSE, TRUE);
+    base_video_decoder->pool = NULL;
+  }
+
+  if (n_threads == 0)
+    parallelism = GST_BASE_VIDEO_DECODER_PARALLELISM_NONE;
+  base_video_decoder->parallelism = parallelism;
+  base_video_decoder->n_threads = n_threads;
+  if (parallelism == GST_BASE_VIDEO_DECODER_PARALLELISM_NONE)
+    return;
+
+  if (base_video_decoder->parallel_lock == NULL) {
+    base_video_decoder->parallel_lock = g_mutex_new ();
+    base_video_decoder->parallel_cond = g_cond_new ();
+    g_queue_init (&base_video_decoder->lanes);
+  }
+  base_video_decoder->pool =
+      g_thread_pool_new (gst_base_video_decoder_lane_func, base_video_decoder,
+      n_threads, TRUE, NULL);
+  if (base_video_decoder->pool == NULL) {
+    GST_WARNING_OBJECT (base_video_decoder, "failed to create worker threads");
+    base_video_decoder->parallelism = GST_BASE_VIDEO_DECODER_PARALLELISM_NONE;
+  }
+}
+
+/**
+ * gst_base_video_decoder_set_gop_hook:
+ * @base_video_decoder: a #GstBaseVideoDecoder
+ * @hook: data private to the GOP being decoded
+ * @destroy_notify: frees @hook, or %NULL
+ *
+ * In GOP-parallel mode, attaches @hook to the GOP handled by the calling
+ * worker thread.  @hook is freed once the GOP has been pushed.  Can only be
+ * called from @handle_frame or @finish.
+ */
+void
+gst_base_video_decoder_set_gop_hook (GstBaseVideoDecoder * base_video_decoder,
+    gpointer hook, GDestroyNotify destroy_notify)
+{
+  GstBaseVideoDecoderLane *lane;
+
+  lane = g_static_private_get (&current_lane);
+  g_return_if_fail (lane != NULL && lane->decoder == base_video_decoder);
+
+  if (lane->coder_hook_destroy_notify && lane->coder_hook)
+    lane->coder_hook_destroy_notify (lane->coder_hook);
+  lane->coder_hook = hook;
+  lane->coder_hook_destroy_notify = destroy_notify;
+}
+
+/**
+ * gst_base_video_decoder_get_gop_hook:
+ * @base_video_decoder: a #GstBaseVideoDecoder
+ *
+ * Returns: the hook set on the GOP handled by the calling worker thread,
+ * %NULL if there is none
+ */
+gpointer
+gst_base_video_decoder_get_gop_hook (GstBaseVideoDecoder * base_video_decoder)
+{
+  GstBaseVideoDecoderLane *lane;
+
+  lane = g_static_private_get (&current_lane);
+  if (lane == NULL || lane->decoder != base_video_decoder)
+    return NULL;
+
+  return lane->coder_hook;
+}
+
 /**
  * gst_base_video_decoder_get_oldest_frame:
  * @base_video_decoder_class: a #GstBaseVideoDecoderClass
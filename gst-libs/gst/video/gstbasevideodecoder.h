@@ -75,6 +75,25 @@ G_BEGIN_DECLS
 typedef struct _GstBaseVideoDecoder GstBaseVideoDecoder;
 typedef struct _GstBaseVideoDecoderClass GstBaseVideoDecoderClass;
 
+/**
+ * GstBaseVideoDecoderParallelism:
+ * @GST_BASE_VIDEO_DECODER_PARALLELISM_NONE: @handle_frame is called for one
+ *   frame at a time from the streaming thread
+ * @GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME: every frame can be decoded
+ *   independently of the others
+ * @GST_BASE_VIDEO_DECODER_PARALLELISM_GOP: frames depend on the frames
+ *   since the last sync point only, i.e. GOPs are closed
+ *
+ * Which frames a subclass can decode concurrently, see
+ * gst_base_video_decoder_set_parallelism().
+ */
+typedef enum
+{
+  GST_BASE_VIDEO_DECODER_PARALLELISM_NONE,
+  GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME,
+  GST_BASE_VIDEO_DECODER_PARALLELISM_GOP
+} GstBaseVideoDecoderParallelism;
+
 
 /* do not use this one, use macro below */
 GstFlowReturn _gst_base_video_decoder_error (GstBaseVideoDecoder *dec, gint weight,
@@ -182,6 +201,30 @@ struct _GstBaseVideoDecoder
   int               reorder_depth;
   int               distance_from_sync;
 
+  /* parallel decoding */
+  GstBaseVideoDecoderParallelism parallelism;
+  guint             n_threads;
+  GThreadPool      *pool;
+  /* protects the lanes and statistics below */
+  GMutex           *parallel_lock;
+  GCond            *parallel_cond;
+  /* frames decoded one after the other, in output order */
+  GQueue            lanes;
+  gpointer          current_lane;
+  /* a thread is pushing finished frames */
+  gboolean          outputting;
+  /* frames are dropped instead of decoded and pushed */
+  gboolean          discarding;
+  GstFlowReturn     parallel_ret;
+
+  /* frames dispatched and not handled yet */
+  guint             queue_depth;
+  guint             max_queue_depth;
+  /* time spent in @handle_frame */
+  guint64           n_decoded;
+  GstClockTime      total_decode_time;
+  GstClockTime      max_frame_decode_time;
+
   /* FIXME before moving to base */
   void             *padding[GST_PADDING_LARGE];
 };
@@ -265,9 +308,19 @@ GstVideoState   *gst_base_video_decoder_get_state (GstBaseVideoDecoder *base_vid
 GstClockTimeDiff gst_base_video_decoder_get_max_decode_time (
                                     GstBaseVideoDecoder *base_video_decoder,
                                     GstVideoFrame *frame);
+void             gst_base_video_decoder_get_decode_stats (GstBaseVideoDecoder *base_video_decoder,
+                                    guint64 *n_decoded, GstClockTime *average,
+                                    GstClockTime *max, guint *max_queue_depth);
 GstFlowReturn    gst_base_video_decoder_finish_frame (GstBaseVideoDecoder *base_video_decoder,
                                     GstVideoFrame *frame);
 
+void             gst_base_video_decoder_set_parallelism (GstBaseVideoDecoder *base_video_decoder,
+                                    GstBaseVideoDecoderParallelism parallelism,
+                                    guint n_threads);
+void             gst_base_video_decoder_set_gop_hook (GstBaseVideoDecoder *base_video_decoder,
+                                    gpointer hook, GDestroyNotify destroy_notify);
+gpointer         gst_base_video_decoder_get_gop_hook (GstBaseVideoDecoder *base_video_decoder);
+
 GType            gst_base_video_decoder_get_type (void);
 
 G_END_DECLS
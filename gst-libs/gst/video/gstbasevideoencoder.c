@@ -62,6 +62,11 @@
  *       downstream.
  *     </para></listitem>
  *     <listitem><para>
+ *       If configured with gst_base_video_encoder_set_lookahead(), baseclass
+ *       queues frames so that subclass can analyse the ones following the
+ *       frames it encodes, and hands them over in batches to @handle_frames.
+ *     </para></listitem>
+ *     <listitem><para>
  *       If implemented, baseclass calls subclass @shape_output which then sends
  *       data downstream in desired form.  Otherwise, it is sent as-is.
  *     </para></listitem>
@@ -129,6 +134,8 @@ static const GstQueryType *gst_base_video_encoder_get_query_types (GstPad *
     pad);
 static gboolean gst_base_video_encoder_src_query (GstPad * pad,
     GstQuery * query);
+static GstFlowReturn gst_base_video_encoder_submit_frames (GstBaseVideoEncoder *
+    enc, gboolean drain);
 
 
 static void
@@ -193,6 +200,11 @@ gst_base_video_encoder_reset (GstBaseVideoEncoder * base_video_encoder)
       (GFunc) gst_event_unref, NULL);
   g_list_free (base_video_encoder->current_frame_events);
   base_video_encoder->current_frame_events = NULL;
+
+  /* the frames themselves are freed along with the pending ones */
+  g_list_free (base_video_encoder->lookahead_frames);
+  base_video_encoder->lookahead_frames = NULL;
+  base_video_encoder->n_lookahead_frames = 0;
 }
 
 static void
@@ -222,11 +234,45 @@ gst_base_video_encoder_init (GstBaseVideoEncoder * base_video_encoder,
       GST_DEBUG_FUNCPTR (gst_base_video_encoder_src_event));
 
   base_video_encoder->a.at_eos = FALSE;
+  base_video_encoder->batch = 1;
 
   /* encoder is expected to do so */
   base_video_encoder->sink_clipping = TRUE;
 }
 
+/* frees the queued frames, which are never handed to subclass */
+static void
+gst_base_video_encoder_drop_lookahead (GstBaseVideoEncoder * enc)
+{
+  GList *l;
+
+  for (l = enc->lookahead_frames; l; l = l->next) {
+    GST_BASE_VIDEO_CODEC (enc)->frames =
+        g_list_remove (GST_BASE_VIDEO_CODEC (enc)->frames, l->data);
+    gst_base_video_codec_free_frame (l->data);
+  }
+  g_list_free (enc->lookahead_frames);
+  enc->lookahead_frames = NULL;
+  enc->n_lookahead_frames = 0;
+}
+
+/* hands all the queued frames over to subclass, the ones left over after
+ * a flow error are dropped */
+static GstFlowReturn
+gst_base_video_encoder_drain_lookahead (GstBaseVideoEncoder * enc)
+{
+  GstFlowReturn ret;
+
+  ret = gst_base_video_encoder_submit_frames (enc, TRUE);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (enc, "dropping %u queued frames, flow %s",
+        enc->n_lookahead_frames, gst_flow_get_name (ret));
+    gst_base_video_encoder_drop_lookahead (enc);
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_base_video_encoder_drain (GstBaseVideoEncoder * enc)
 {
@@ -244,9 +290,12 @@ gst_base_video_encoder_drain (GstBaseVideoEncoder * enc)
     return TRUE;
   }
 
+  if (gst_base_video_encoder_drain_lookahead (enc) != GST_FLOW_OK)
+    ret = FALSE;
+
   if (enc_class->reset) {
     GST_DEBUG_OBJECT (enc, "requesting subclass to finish");
-    ret = enc_class->reset (enc);
+    ret = enc_class->reset (enc) && ret;
   }
   /* everything should be away now */
   if (codec->frames) {
@@ -272,7 +321,7 @@ gst_base_video_encoder_sink_setcaps (GstPad * pad, GstCaps * caps)
   GstStructure *structure;
   GstVideoState *state, tmp_state;
   gboolean ret;
-  gboolean changed = FALSE;
+  gboolean changed = FALSE, has_lookahead;
 
   base_video_encoder = GST_BASE_VIDEO_ENCODER (gst_pad_get_parent (pad));
   base_video_encoder_class =
@@ -339,6 +388,15 @@ gst_base_video_encoder_sink_setcaps (GstPad * pad, GstCaps * caps)
     if (ret) {
       gst_caps_replace (&state->caps, NULL);
       *state = tmp_state;
+
+      /* the lookahead latency depends on the framerate */
+      GST_OBJECT_LOCK (base_video_encoder);
+      has_lookahead = base_video_encoder->lookahead ||
+          base_video_encoder->batch > 1;
+      GST_OBJECT_UNLOCK (base_video_encoder);
+      if (has_lookahead)
+        gst_element_post_message (GST_ELEMENT_CAST (base_video_encoder),
+            gst_message_new_latency (GST_OBJECT_CAST (base_video_encoder)));
     }
   } else {
     /* no need to stir things up */
@@ -384,6 +442,9 @@ gst_base_video_encoder_sink_eventfunc (GstBaseVideoEncoder * base_video_encoder,
 
       base_video_encoder->a.at_eos = TRUE;
 
+      /* EOS goes on all the same */
+      gst_base_video_encoder_drain_lookahead (base_video_encoder);
+
       if (base_video_encoder_class->finish) {
         flow_ret = base_video_encoder_class->finish (base_video_encoder);
       } else {
@@ -419,11 +480,17 @@ gst_base_video_encoder_sink_eventfunc (GstBaseVideoEncoder * base_video_encoder,
 
       base_video_encoder->a.at_eos = FALSE;
 
+      /* queued frames belong to the previous segment */
+      gst_base_video_encoder_drain_lookahead (base_video_encoder);
+
       gst_segment_set_newsegment_full (&GST_BASE_VIDEO_CODEC
           (base_video_encoder)->segment, update, rate, applied_rate, format,
           start, stop, position);
       break;
     }
+    case GST_EVENT_FLUSH_STOP:
+      gst_base_video_encoder_drop_lookahead (base_video_encoder);
+      break;
     case GST_EVENT_CUSTOM_DOWNSTREAM:
     {
       const GstStructure *s;
@@ -552,6 +619,22 @@ gst_base_video_encoder_get_query_types (GstPad * pad)
   return query_types;
 }
 
+/* call with the object lock */
+static GstClockTime
+gst_base_video_encoder_get_lookahead_latency (GstBaseVideoEncoder * enc)
+{
+  GstVideoState *state = &GST_BASE_VIDEO_CODEC (enc)->state;
+  guint n_frames;
+
+  /* the last frame of a batch waits for the whole lookahead and batch */
+  n_frames = enc->lookahead + MAX (enc->batch, 1) - 1;
+  if (n_frames == 0 || state->fps_n == 0)
+    return 0;
+
+  return gst_util_uint64_scale (n_frames, state->fps_d * GST_SECOND,
+      state->fps_n);
+}
+
 static gboolean
 gst_base_video_encoder_src_query (GstPad * pad, GstQuery * query)
 {
@@ -582,7 +665,7 @@ gst_base_video_encoder_src_query (GstPad * pad, GstQuery * query)
     case GST_QUERY_LATENCY:
     {
       gboolean live;
-      GstClockTime min_latency, max_latency;
+      GstClockTime min_latency, max_latency, lookahead;
 
       res = gst_pad_query (peerpad, query);
       if (res) {
@@ -592,12 +675,18 @@ gst_base_video_encoder_src_query (GstPad * pad, GstQuery * query)
             GST_TIME_ARGS (min_latency), GST_TIME_ARGS (max_latency));
 
         GST_OBJECT_LOCK (enc);
-        min_latency += enc->min_latency;
+        lookahead = gst_base_video_encoder_get_lookahead_latency (enc);
+        min_latency += enc->min_latency + lookahead;
         if (max_latency != GST_CLOCK_TIME_NONE) {
-          max_latency += enc->max_latency;
+          max_latency += enc->max_latency + lookahead;
         }
         GST_OBJECT_UNLOCK (enc);
 
+        GST_DEBUG_OBJECT (enc, "Our latency: min %" GST_TIME_FORMAT
+            " max %" GST_TIME_FORMAT ", of which lookahead %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (enc->min_latency), GST_TIME_ARGS (enc->max_latency),
+            GST_TIME_ARGS (lookahead));
+
         gst_query_set_latency (query, live, min_latency, max_latency);
       }
     }
@@ -616,6 +705,56 @@ error:
   return res;
 }
 
+/* hands the queued frames over to the subclass, a batch at a time once
+ * enough frames follow them, or all of them when draining */
+static GstFlowReturn
+gst_base_video_encoder_submit_frames (GstBaseVideoEncoder * enc,
+    gboolean drain)
+{
+  GstBaseVideoEncoderClass *klass;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint lookahead, batch;
+
+  klass = GST_BASE_VIDEO_ENCODER_GET_CLASS (enc);
+
+  GST_OBJECT_LOCK (enc);
+  lookahead = enc->lookahead;
+  batch = MAX (enc->batch, 1);
+  GST_OBJECT_UNLOCK (enc);
+
+  while (ret == GST_FLOW_OK && enc->n_lookahead_frames > 0 &&
+      (drain || enc->n_lookahead_frames >= lookahead + batch)) {
+    GList *frames, *rest;
+    guint n;
+
+    n = MIN (batch, enc->n_lookahead_frames);
+    frames = enc->lookahead_frames;
+    rest = g_list_nth (frames, n);
+    if (rest) {
+      rest->prev->next = NULL;
+      rest->prev = NULL;
+    }
+    enc->lookahead_frames = rest;
+    enc->n_lookahead_frames -= n;
+
+    GST_LOG_OBJECT (enc, "passing %u frames from pfn %d to subclass, "
+        "%u queued", n, ((GstVideoFrame *) frames->data)->
+        presentation_frame_number, enc->n_lookahead_frames);
+
+    if (klass->handle_frames) {
+      ret = klass->handle_frames (enc, frames);
+    } else {
+      GList *l;
+
+      for (l = frames; l && ret == GST_FLOW_OK; l = l->next)
+        ret = klass->handle_frame (enc, l->data);
+    }
+    g_list_free (frames);
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_base_video_encoder_chain (GstPad * pad, GstBuffer * buf)
 {
@@ -623,11 +762,13 @@ gst_base_video_encoder_chain (GstPad * pad, GstBuffer * buf)
   GstBaseVideoEncoderClass *klass;
   GstVideoFrame *frame;
   GstFlowReturn ret = GST_FLOW_OK;
+  gboolean queue;
 
   base_video_encoder = GST_BASE_VIDEO_ENCODER (gst_pad_get_parent (pad));
   klass = GST_BASE_VIDEO_ENCODER_GET_CLASS (base_video_encoder);
 
-  g_return_val_if_fail (klass->handle_frame != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (klass->handle_frame != NULL
+      || klass->handle_frames != NULL, GST_FLOW_ERROR);
 
   if (!GST_PAD_CAPS (pad)) {
     return GST_FLOW_NOT_NEGOTIATED;
@@ -675,6 +816,8 @@ gst_base_video_encoder_chain (GstPad * pad, GstBuffer * buf)
   base_video_encoder->presentation_frame_number++;
   frame->force_keyframe = base_video_encoder->force_keyframe;
   base_video_encoder->force_keyframe = FALSE;
+  if (frame->force_keyframe)
+    frame->type_hint = GST_VIDEO_FRAME_TYPE_KEY;
 
   GST_BASE_VIDEO_CODEC (base_video_encoder)->frames =
       g_list_append (GST_BASE_VIDEO_CODEC (base_video_encoder)->frames, frame);
@@ -682,10 +825,24 @@ gst_base_video_encoder_chain (GstPad * pad, GstBuffer * buf)
   /* new data, more finish needed */
   base_video_encoder->drained = FALSE;
 
-  GST_LOG_OBJECT (base_video_encoder, "passing frame pfn %d to subclass",
-      frame->presentation_frame_number);
+  /* frames still queued from before the lookahead was lowered go first */
+  GST_OBJECT_LOCK (base_video_encoder);
+  queue = base_video_encoder->lookahead > 0 || base_video_encoder->batch > 1 ||
+      base_video_encoder->n_lookahead_frames > 0 || !klass->handle_frame;
+  GST_OBJECT_UNLOCK (base_video_encoder);
+
+  if (!queue) {
+    GST_LOG_OBJECT (base_video_encoder, "passing frame pfn %d to subclass",
+        frame->presentation_frame_number);
 
-  ret = klass->handle_frame (base_video_encoder, frame);
+    ret = klass->handle_frame (base_video_encoder, frame);
+  } else {
+    base_video_encoder->lookahead_frames =
+        g_list_append (base_video_encoder->lookahead_frames, frame);
+    base_video_encoder->n_lookahead_frames++;
+
+    ret = gst_base_video_encoder_submit_frames (base_video_encoder, FALSE);
+  }
 
 done:
   g_object_unref (base_video_encoder);
@@ -839,6 +996,11 @@ gst_base_video_encoder_finish_frame (GstBaseVideoEncoder * base_video_encoder,
     goto done;
   }
 
+  if (frame->type_hint == GST_VIDEO_FRAME_TYPE_KEY && !frame->is_sync_point) {
+    GST_DEBUG_OBJECT (base_video_encoder, "frame pfn %d hinted as key frame "
+        "was not encoded as one", frame->presentation_frame_number);
+  }
+
   if (frame->is_sync_point) {
     GST_LOG_OBJECT (base_video_encoder, "key frame");
     base_video_encoder->distance_from_sync = 0;
@@ -960,6 +1122,54 @@ gst_base_video_encoder_set_latency_fields (GstBaseVideoEncoder *
 
 }
 
+/**
+ * gst_base_video_encoder_set_lookahead:
+ * @base_video_encoder: a #GstBaseVideoEncoder
+ * @lookahead: number of frames to queue after the ones being encoded
+ * @batch: number of frames to hand over at once
+ *
+ * Makes baseclass queue incoming frames, so that subclass can analyse the
+ * @lookahead frames following the ones it encodes with
+ * gst_base_video_encoder_get_lookahead(), and hand them over @batch at a
+ * time to @handle_frames, or one by one to @handle_frame.  All queued
+ * frames are handed over when draining, at EOS and on a new segment.
+ * The delay is added to the latency reported upstream, on top of the one
+ * set with gst_base_video_encoder_set_latency().
+ */
+void
+gst_base_video_encoder_set_lookahead (GstBaseVideoEncoder * base_video_encoder,
+    guint lookahead, guint batch)
+{
+  g_return_if_fail (batch > 0);
+
+  GST_DEBUG_OBJECT (base_video_encoder, "lookahead %u, batch %u", lookahead,
+      batch);
+
+  GST_OBJECT_LOCK (base_video_encoder);
+  base_video_encoder->lookahead = lookahead;
+  base_video_encoder->batch = batch;
+  GST_OBJECT_UNLOCK (base_video_encoder);
+
+  gst_element_post_message (GST_ELEMENT_CAST (base_video_encoder),
+      gst_message_new_latency (GST_OBJECT_CAST (base_video_encoder)));
+}
+
+/**
+ * gst_base_video_encoder_get_lookahead:
+ * @base_video_encoder: a #GstBaseVideoEncoder
+ *
+ * Gives the frames queued after the ones being handed to subclass, in
+ * presentation order.  Subclass may set their @type_hint, but should not
+ * modify the list, which is only valid until returning to baseclass.
+ *
+ * Returns: the #GList of queued #GstVideoFrame
+ */
+GList *
+gst_base_video_encoder_get_lookahead (GstBaseVideoEncoder * base_video_encoder)
+{
+  return base_video_encoder->lookahead_frames;
+}
+
 /**
  * gst_base_video_encoder_get_oldest_frame:
  * @base_video_encoder: a #GstBaseVideoEncoder
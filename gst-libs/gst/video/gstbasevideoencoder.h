@@ -98,6 +98,13 @@ struct _GstBaseVideoEncoder
   GstEvent         *force_keyunit_event;
   GList            *current_frame_events;
 
+  /* lookahead, protected by the object lock */
+  guint             lookahead;
+  guint             batch;
+  /* frames not handed to the subclass yet */
+  GList            *lookahead_frames;
+  guint             n_lookahead_frames;
+
   union {
     void *padding;
     gboolean at_eos;
@@ -133,6 +140,11 @@ struct _GstBaseVideoEncoder
  *                  (i.e. not unref'ed).
  * @getcaps:        Optional, but recommended.
  *                  Provides src pad caps to baseclass.
+ * @handle_frames:  Optional.
+ *                  Provides a batch of input frames to subclass, in
+ *                  presentation order, when a lookahead is configured.
+ *                  The frames are to be finished as with @handle_frame,
+ *                  the list belongs to the baseclass.
  *
  * Subclasses can override any of the available virtual methods or not, as
  * needed. At minimum @handle_frame needs to be overridden, and @set_format
@@ -166,9 +178,12 @@ struct _GstBaseVideoEncoderClass
 
   GstCaps *     (*get_caps)           (GstBaseVideoEncoder *coder);
 
+  GstFlowReturn (*handle_frames)      (GstBaseVideoEncoder *coder,
+                                       GList *frames);
+
   /*< private >*/
   /* FIXME before moving to base */
-  gpointer       _gst_reserved[GST_PADDING_LARGE];
+  gpointer       _gst_reserved[GST_PADDING_LARGE - 1];
 };
 
 GType                  gst_base_video_encoder_get_type (void);
@@ -184,6 +199,10 @@ void                   gst_base_video_encoder_set_latency (GstBaseVideoEncoder *
 void                   gst_base_video_encoder_set_latency_fields (GstBaseVideoEncoder *base_video_encoder,
                                                                   int n_fields);
 
+void                   gst_base_video_encoder_set_lookahead (GstBaseVideoEncoder *base_video_encoder,
+                                                             guint lookahead, guint batch);
+GList*                 gst_base_video_encoder_get_lookahead (GstBaseVideoEncoder *base_video_encoder);
+
 G_END_DECLS
 
 #endif
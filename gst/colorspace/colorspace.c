@@ -35,6 +35,7 @@ static void colorspace_convert_lookup_getput (ColorspaceConvert * convert);
 static void colorspace_dither_none (ColorspaceConvert * convert, int j);
 static void colorspace_dither_verterr (ColorspaceConvert * convert, int j);
 static void colorspace_dither_halftone (ColorspaceConvert * convert, int j);
+static void colorspace_convert_free_bands (ColorspaceConvert * convert);
 
 
 ColorspaceConvert *
@@ -78,6 +79,7 @@ colorspace_convert_new (GstVideoFormat to_format, ColorSpaceColorSpec to_spec,
   convert->width = width;
   convert->convert = colorspace_convert_generic;
   convert->dither16 = colorspace_dither_none;
+  convert->n_threads = 1;
 
   if (gst_video_format_get_component_depth (to_format, 0) > 8 ||
       gst_video_format_get_component_depth (from_format, 0) > 8) {
@@ -141,6 +143,14 @@ colorspace_convert_new (GstVideoFormat to_format, ColorSpaceColorSpec to_spec,
 void
 colorspace_convert_free (ColorspaceConvert * convert)
 {
+  colorspace_convert_free_bands (convert);
+  if (convert->pool)
+    g_thread_pool_free (convert->pool, FALSE, TRUE);
+  if (convert->lock) {
+    g_mutex_free (convert->lock);
+    g_cond_free (convert->cond);
+  }
+
   g_free (convert->palette);
   g_free (convert->tmpline);
   g_free (convert->tmpline16);
@@ -153,12 +163,16 @@ void
 colorspace_convert_set_interlaced (ColorspaceConvert * convert,
     gboolean interlaced)
 {
+  if (convert->interlaced != interlaced)
+    colorspace_convert_free_bands (convert);
   convert->interlaced = interlaced;
 }
 
 void
 colorspace_convert_set_dither (ColorspaceConvert * convert, int type)
 {
+  void (*dither16) (ColorspaceConvert * convert, int j) = convert->dither16;
+
   switch (type) {
     case 0:
     default:
@@ -171,6 +185,10 @@ colorspace_convert_set_dither (ColorspaceConvert * convert, int type)
       convert->dither16 = colorspace_dither_halftone;
       break;
   }
+
+  /* the bands are copies of the converter */
+  if (convert->dither16 != dither16)
+    colorspace_convert_free_bands (convert);
 }
 
 void
@@ -189,11 +207,168 @@ colorspace_convert_get_palette (ColorspaceConvert * convert)
   return convert->palette;
 }
 
+/* Lines that share a chroma line, with interlaced content the lines of
+ * both fields that do, and the lines of a halftone dither pattern must be
+ * converted by the same band to get the same result as a single thread */
+static int
+colorspace_convert_band_alignment (ColorspaceConvert * convert)
+{
+  int align = 1;
+  int c;
+
+  for (c = 1; c < 3; c++) {
+    align = MAX (align, 16 /
+        gst_video_format_get_component_height (convert->from_format, c, 16));
+    align = MAX (align, 16 /
+        gst_video_format_get_component_height (convert->to_format, c, 16));
+  }
+
+  if (convert->interlaced)
+    align *= 2;
+
+  if (convert->dither16 == colorspace_dither_halftone)
+    align = MAX (align, 8);
+
+  return align;
+}
+
+static void
+colorspace_convert_setup_bands (ColorspaceConvert * convert)
+{
+  int align, n_bands, i, c, y, next;
+
+  convert->n_bands = 1;
+
+  /* The vertical error diffusion runs through the whole frame and the fast
+   * paths handle the last line of odd widths in their own way, those stay
+   * on one thread. So do the rare paletted formats. */
+  if (convert->dither16 == colorspace_dither_verterr || (convert->width & 1) ||
+      convert->from_format == GST_VIDEO_FORMAT_RGB8_PALETTED ||
+      convert->to_format == GST_VIDEO_FORMAT_RGB8_PALETTED)
+    return;
+
+  align = colorspace_convert_band_alignment (convert);
+  n_bands = MIN (convert->n_threads, convert->height / align);
+  if (n_bands < 2)
+    return;
+
+  convert->bands = g_new0 (ColorspaceConvert *, n_bands);
+  for (i = 0, y = 0; i < n_bands; i++, y = next) {
+    ColorspaceConvert *band;
+
+    if (i == n_bands - 1)
+      next = convert->height;
+    else
+      next = ((i + 1) * (convert->height / align) / n_bands) * align;
+
+    band = g_memdup (convert, sizeof (ColorspaceConvert));
+    band->height = next - y;
+    band->n_threads = 1;
+    band->n_bands = 1;
+    band->bands = NULL;
+    band->pool = NULL;
+    band->lock = NULL;
+    band->cond = NULL;
+    band->tmpline = g_malloc (sizeof (guint8) * (convert->width + 8) * 4);
+    band->tmpline16 = g_malloc (sizeof (guint16) * (convert->width + 8) * 4);
+    band->errline = g_malloc (sizeof (guint16) * convert->width * 4);
+
+    for (c = 0; y > 0 && c < 4; c++) {
+      band->src_offset[c] += band->src_stride[c] *
+          gst_video_format_get_component_height (convert->from_format, c, y);
+      band->dest_offset[c] += band->dest_stride[c] *
+          gst_video_format_get_component_height (convert->to_format, c, y);
+    }
+
+    GST_DEBUG ("band %d: lines %d to %d", i, y, next);
+    convert->bands[i] = band;
+  }
+  convert->n_bands = n_bands;
+}
+
+static void
+colorspace_convert_free_bands (ColorspaceConvert * convert)
+{
+  int i;
+
+  if (convert->bands) {
+    for (i = 0; i < convert->n_bands; i++) {
+      g_free (convert->bands[i]->tmpline);
+      g_free (convert->bands[i]->tmpline16);
+      g_free (convert->bands[i]->errline);
+      g_free (convert->bands[i]);
+    }
+    g_free (convert->bands);
+    convert->bands = NULL;
+  }
+  convert->n_bands = 0;
+}
+
+static void
+colorspace_convert_band_func (gpointer data, gpointer user_data)
+{
+  ColorspaceConvert *band = data;
+  ColorspaceConvert *convert = user_data;
+
+  band->convert (band, convert->band_dest, convert->band_src);
+
+  g_mutex_lock (convert->lock);
+  if (--convert->bands_pending == 0)
+    g_cond_signal (convert->cond);
+  g_mutex_unlock (convert->lock);
+}
+
+void
+colorspace_convert_set_n_threads (ColorspaceConvert * convert, int n_threads)
+{
+  n_threads = MAX (n_threads, 1);
+  if (convert->n_threads == n_threads)
+    return;
+
+  colorspace_convert_free_bands (convert);
+  if (convert->pool) {
+    g_thread_pool_free (convert->pool, FALSE, TRUE);
+    convert->pool = NULL;
+  }
+
+  convert->n_threads = n_threads;
+  if (n_threads > 1) {
+    /* the calling thread converts the first band itself */
+    convert->pool = g_thread_pool_new (colorspace_convert_band_func, convert,
+        n_threads - 1, TRUE, NULL);
+    if (!convert->lock) {
+      convert->lock = g_mutex_new ();
+      convert->cond = g_cond_new ();
+    }
+  }
+}
+
 void
 colorspace_convert_convert (ColorspaceConvert * convert,
     guint8 * dest, const guint8 * src)
 {
-  convert->convert (convert, dest, src);
+  int i;
+
+  if (convert->n_threads > 1 && convert->n_bands == 0)
+    colorspace_convert_setup_bands (convert);
+
+  if (convert->n_bands < 2) {
+    convert->convert (convert, dest, src);
+    return;
+  }
+
+  convert->band_dest = dest;
+  convert->band_src = src;
+  convert->bands_pending = convert->n_bands - 1;
+  for (i = 1; i < convert->n_bands; i++)
+    g_thread_pool_push (convert->pool, convert->bands[i], NULL);
+
+  convert->bands[0]->convert (convert->bands[0], dest, src);
+
+  g_mutex_lock (convert->lock);
+  while (convert->bands_pending > 0)
+    g_cond_wait (convert->cond, convert->lock);
+  g_mutex_unlock (convert->lock);
 }
 
 /* Line conversion to AYUV */
@@ -2286,6 +2461,199 @@ convert_Y444_AYUV (ColorspaceConvert * convert, guint8 * dest,
       convert->src_stride[2], convert->width, convert->height);
 }
 
+static void
+convert_NV12_I420 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  cogorc_memcpy_2d (FRAME_GET_LINE (dest, 0, 0), convert->dest_stride[0],
+      FRAME_GET_LINE (src, 0, 0), convert->src_stride[0],
+      convert->width, convert->height);
+
+  cogorc_convert_NV12_I420_uv (FRAME_GET_LINE (dest, 1, 0),
+      convert->dest_stride[1], FRAME_GET_LINE (dest, 2, 0),
+      convert->dest_stride[2], FRAME_GET_LINE (src, 1, 0),
+      convert->src_stride[1], (convert->width + 1) / 2,
+      (convert->height + 1) / 2);
+}
+
+static void
+convert_NV21_I420 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  cogorc_memcpy_2d (FRAME_GET_LINE (dest, 0, 0), convert->dest_stride[0],
+      FRAME_GET_LINE (src, 0, 0), convert->src_stride[0],
+      convert->width, convert->height);
+
+  /* V comes first in NV21 */
+  cogorc_convert_NV12_I420_uv (FRAME_GET_LINE (dest, 2, 0),
+      convert->dest_stride[2], FRAME_GET_LINE (dest, 1, 0),
+      convert->dest_stride[1], FRAME_GET_LINE (src, 2, 0),
+      convert->src_stride[2], (convert->width + 1) / 2,
+      (convert->height + 1) / 2);
+}
+
+static void
+convert_I420_NV12 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  cogorc_memcpy_2d (FRAME_GET_LINE (dest, 0, 0), convert->dest_stride[0],
+      FRAME_GET_LINE (src, 0, 0), convert->src_stride[0],
+      convert->width, convert->height);
+
+  cogorc_convert_I420_NV12_uv (FRAME_GET_LINE (dest, 1, 0),
+      convert->dest_stride[1], FRAME_GET_LINE (src, 1, 0),
+      convert->src_stride[1], FRAME_GET_LINE (src, 2, 0),
+      convert->src_stride[2], (convert->width + 1) / 2,
+      (convert->height + 1) / 2);
+}
+
+static void
+convert_I420_NV21 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  cogorc_memcpy_2d (FRAME_GET_LINE (dest, 0, 0), convert->dest_stride[0],
+      FRAME_GET_LINE (src, 0, 0), convert->src_stride[0],
+      convert->width, convert->height);
+
+  cogorc_convert_I420_NV12_uv (FRAME_GET_LINE (dest, 2, 0),
+      convert->dest_stride[2], FRAME_GET_LINE (src, 2, 0),
+      convert->src_stride[2], FRAME_GET_LINE (src, 1, 0),
+      convert->src_stride[1], (convert->width + 1) / 2,
+      (convert->height + 1) / 2);
+}
+
+/* The twelve 10 bit samples of a 16 byte v210 group are in UYVY order,
+ * they are truncated to 8 bits like getline_v210() does. YUY2 output
+ * swaps each pair. */
+static inline void
+unpack_v210_group (guint8 * d, const guint8 * s, gboolean yuy2)
+{
+  guint32 a0, a1, a2, a3;
+  guint8 t[12];
+  int k;
+
+  a0 = GST_READ_UINT32_LE (s + 0);
+  a1 = GST_READ_UINT32_LE (s + 4);
+  a2 = GST_READ_UINT32_LE (s + 8);
+  a3 = GST_READ_UINT32_LE (s + 12);
+
+  t[0] = a0 >> 2;
+  t[1] = a0 >> 12;
+  t[2] = a0 >> 22;
+  t[3] = a1 >> 2;
+  t[4] = a1 >> 12;
+  t[5] = a1 >> 22;
+  t[6] = a2 >> 2;
+  t[7] = a2 >> 12;
+  t[8] = a2 >> 22;
+  t[9] = a3 >> 2;
+  t[10] = a3 >> 12;
+  t[11] = a3 >> 22;
+
+  if (yuy2) {
+    for (k = 0; k < 12; k += 2) {
+      d[k] = t[k + 1];
+      d[k + 1] = t[k];
+    }
+  } else {
+    memcpy (d, t, 12);
+  }
+}
+
+static inline void
+unpack_v210_line (guint8 * dest, const guint8 * src, int width, gboolean yuy2)
+{
+  guint8 tail[12];
+  int i;
+
+  for (i = 0; i + 6 <= width; i += 6) {
+    unpack_v210_group (dest, src, yuy2);
+    dest += 12;
+    src += 16;
+  }
+
+  /* don't write past the end of the line */
+  if (i < width) {
+    unpack_v210_group (tail, src, yuy2);
+    memcpy (dest, tail, 2 * GST_ROUND_UP_2 (width - i));
+  }
+}
+
+static void
+convert_v210_UYVY (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  int i;
+
+  /* dithering needs the 16 bit intermediate */
+  if (convert->dither16 != colorspace_dither_none) {
+    colorspace_convert_generic (convert, dest, src);
+    return;
+  }
+
+  for (i = 0; i < convert->height; i++)
+    unpack_v210_line (FRAME_GET_LINE (dest, 0, i), FRAME_GET_LINE (src, 0, i),
+        convert->width, FALSE);
+}
+
+static void
+convert_v210_YUY2 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  int i;
+
+  if (convert->dither16 != colorspace_dither_none) {
+    colorspace_convert_generic (convert, dest, src);
+    return;
+  }
+
+  for (i = 0; i < convert->height; i++)
+    unpack_v210_line (FRAME_GET_LINE (dest, 0, i), FRAME_GET_LINE (src, 0, i),
+        convert->width, TRUE);
+}
+
+static void
+convert_v210_I420 (ColorspaceConvert * convert, guint8 * dest,
+    const guint8 * src)
+{
+  guint8 *uyvy1 = convert->tmpline;
+  guint8 *uyvy2 = convert->tmpline + 2 * GST_ROUND_UP_2 (convert->width);
+  int i;
+
+  if (convert->dither16 != colorspace_dither_none) {
+    colorspace_convert_generic (convert, dest, src);
+    return;
+  }
+
+  /* two lines of UYVY stay in the cache, unlike a full AYUV round trip */
+  for (i = 0; i < GST_ROUND_DOWN_2 (convert->height); i += 2) {
+    unpack_v210_line (uyvy1, FRAME_GET_LINE (src, 0, i), convert->width,
+        FALSE);
+    unpack_v210_line (uyvy2, FRAME_GET_LINE (src, 0, i + 1), convert->width,
+        FALSE);
+    cogorc_convert_UYVY_I420 (FRAME_GET_LINE (dest, 0, i),
+        FRAME_GET_LINE (dest, 0, i + 1),
+        FRAME_GET_LINE (dest, 1, i >> 1),
+        FRAME_GET_LINE (dest, 2, i >> 1), uyvy1, uyvy2,
+        (convert->width + 1) / 2);
+  }
+
+  /* now handle last line, putline_I420() leaves out the last pixel of odd
+   * widths */
+  if (convert->height & 1) {
+    int j = convert->height - 1;
+
+    getline_v210 (convert, convert->tmpline, src, j);
+    putline_I420 (convert, dest, convert->tmpline, j);
+    if (convert->width & 1) {
+      i = convert->width - 1;
+      FRAME_GET_LINE (dest, 0, j)[i] = convert->tmpline[4 * i + 1];
+      FRAME_GET_LINE (dest, 1, j >> 1)[i >> 1] = convert->tmpline[4 * i + 2];
+      FRAME_GET_LINE (dest, 2, j >> 1)[i >> 1] = convert->tmpline[4 * i + 3];
+    }
+  }
+}
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
 static void
 convert_AYUV_ARGB (ColorspaceConvert * convert, guint8 * dest,
@@ -2437,6 +2805,33 @@ static const ColorspaceTransform transforms[] = {
   {GST_VIDEO_FORMAT_Y444, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_Y42B,
       COLOR_SPEC_NONE, TRUE, convert_Y444_Y42B},
 
+  /* the I420 paths only use the component offsets, so they work for YV12 */
+  {GST_VIDEO_FORMAT_NV12, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_I420,
+      COLOR_SPEC_NONE, TRUE, convert_NV12_I420},
+  {GST_VIDEO_FORMAT_NV12, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_YV12,
+      COLOR_SPEC_NONE, TRUE, convert_NV12_I420},
+  {GST_VIDEO_FORMAT_NV21, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_I420,
+      COLOR_SPEC_NONE, TRUE, convert_NV21_I420},
+  {GST_VIDEO_FORMAT_NV21, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_YV12,
+      COLOR_SPEC_NONE, TRUE, convert_NV21_I420},
+  {GST_VIDEO_FORMAT_I420, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_NV12,
+      COLOR_SPEC_NONE, TRUE, convert_I420_NV12},
+  {GST_VIDEO_FORMAT_YV12, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_NV12,
+      COLOR_SPEC_NONE, TRUE, convert_I420_NV12},
+  {GST_VIDEO_FORMAT_I420, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_NV21,
+      COLOR_SPEC_NONE, TRUE, convert_I420_NV21},
+  {GST_VIDEO_FORMAT_YV12, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_NV21,
+      COLOR_SPEC_NONE, TRUE, convert_I420_NV21},
+
+  {GST_VIDEO_FORMAT_v210, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_I420,
+      COLOR_SPEC_NONE, TRUE, convert_v210_I420},
+  {GST_VIDEO_FORMAT_v210, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_YV12,
+      COLOR_SPEC_NONE, TRUE, convert_v210_I420},
+  {GST_VIDEO_FORMAT_v210, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_UYVY,
+      COLOR_SPEC_NONE, TRUE, convert_v210_UYVY},
+  {GST_VIDEO_FORMAT_v210, COLOR_SPEC_NONE, GST_VIDEO_FORMAT_YUY2,
+      COLOR_SPEC_NONE, TRUE, convert_v210_YUY2},
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
   {GST_VIDEO_FORMAT_AYUV, COLOR_SPEC_YUV_BT470_6, GST_VIDEO_FORMAT_ARGB,
       COLOR_SPEC_RGB, FALSE, convert_AYUV_ARGB},
@@ -77,6 +77,18 @@ struct _ColorspaceConvert {
   void (*putline16) (ColorspaceConvert *convert, guint8 *dest, const guint16 *src, int j);
   void (*matrix16) (ColorspaceConvert *convert);
   void (*dither16) (ColorspaceConvert *convert, int j);
+
+  /* slice-parallel conversion: n_bands copies of this converter, each
+   * for its own horizontal band of the frame, 0 if not set up yet */
+  gint n_threads;
+  gint n_bands;
+  ColorspaceConvert **bands;
+  GThreadPool *pool;
+  GMutex *lock;
+  GCond *cond;
+  gint bands_pending;
+  guint8 *band_dest;
+  const guint8 *band_src;
 };
 
 ColorspaceConvert * colorspace_convert_new (GstVideoFormat to_format,
@@ -85,6 +97,8 @@ ColorspaceConvert * colorspace_convert_new (GstVideoFormat to_format,
 void colorspace_convert_set_dither (ColorspaceConvert * convert, int type);
 void colorspace_convert_set_interlaced (ColorspaceConvert *convert,
     gboolean interlaced);
+void colorspace_convert_set_n_threads (ColorspaceConvert * convert,
+    int n_threads);
 void colorspace_convert_set_palette (ColorspaceConvert *convert,
     const guint32 *palette);
 const guint32 * colorspace_convert_get_palette (ColorspaceConvert *convert);
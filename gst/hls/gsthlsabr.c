@@ -0,0 +1,222 @@
+/* GStreamer
+ *
+ * gsthlsabr.c:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Throughput estimation and variant selection for hlsdemux.
+ *
+ * The estimators are fed with the size and download time of every
+ * fragment. The selection picks the best variant that fits in a fraction
+ * of the estimate, switches up one variant at a time and only with enough
+ * data buffered, and switches down only when the current variant can't be
+ * sustained or the buffer runs low. It doesn't depend on the element so
+ * it can be driven by the simulator in the tests. */
+
+#include <math.h>
+
+#include "gstfragmented.h"
+#include "gsthlsabr.h"
+
+#define GST_CAT_DEFAULT fragmented_debug
+
+#define DEFAULT_SAFETY 0.8
+#define DEFAULT_DOWN_LEVEL 1.0
+#define DEFAULT_UP_LEVEL 2.0
+
+/* half lives of the moving averages, in seconds of download time */
+#define FAST_HALF_LIFE 2.0
+#define SLOW_HALF_LIFE 5.0
+
+GstHLSAbr *
+gst_hls_abr_new (GstHLSAbrPolicy policy)
+{
+  GstHLSAbr *abr;
+
+  abr = g_new0 (GstHLSAbr, 1);
+  abr->policy = policy;
+  abr->safety = DEFAULT_SAFETY;
+  abr->down_level = DEFAULT_DOWN_LEVEL;
+  abr->up_level = DEFAULT_UP_LEVEL;
+
+  return abr;
+}
+
+void
+gst_hls_abr_free (GstHLSAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  g_free (abr);
+}
+
+void
+gst_hls_abr_set_policy (GstHLSAbr * abr, GstHLSAbrPolicy policy)
+{
+  g_return_if_fail (abr != NULL);
+
+  abr->policy = policy;
+}
+
+void
+gst_hls_abr_reset (GstHLSAbr * abr)
+{
+  g_return_if_fail (abr != NULL);
+
+  abr->n_samples = 0;
+  abr->fast = 0;
+  abr->slow = 0;
+  abr->total_time = 0;
+}
+
+static gdouble
+ewma_add (gdouble estimate, gdouble half_life, gdouble time, gdouble value)
+{
+  gdouble alpha = pow (0.5, time / half_life);
+
+  return value * (1 - alpha) + estimate * alpha;
+}
+
+/* the averages start at 0, correct for the missing history */
+static gdouble
+ewma_get (gdouble estimate, gdouble half_life, gdouble total_time)
+{
+  return estimate / (1 - pow (0.5, total_time / half_life));
+}
+
+void
+gst_hls_abr_add_sample (GstHLSAbr * abr, guint64 bytes,
+    GstClockTime download_time)
+{
+  gdouble time, bitrate;
+
+  g_return_if_fail (abr != NULL);
+
+  if (!GST_CLOCK_TIME_IS_VALID (download_time) || download_time == 0 ||
+      bytes == 0)
+    return;
+
+  time = (gdouble) download_time / GST_SECOND;
+  bitrate = bytes * 8 / time;
+
+  GST_LOG ("fragment of %" G_GUINT64_FORMAT " bytes in %" GST_TIME_FORMAT
+      ": %.0f bits/s", bytes, GST_TIME_ARGS (download_time), bitrate);
+
+  abr->fast = ewma_add (abr->fast, FAST_HALF_LIFE, time, bitrate);
+  abr->slow = ewma_add (abr->slow, SLOW_HALF_LIFE, time, bitrate);
+  abr->total_time += time;
+
+  abr->samples[abr->n_samples % GST_HLS_ABR_HARMONIC_SAMPLES] = bitrate;
+  abr->n_samples++;
+}
+
+/**
+ * gst_hls_abr_get_bandwidth:
+ * @abr: a #GstHLSAbr
+ *
+ * Returns: the estimated throughput in bits per second, 0 if there is no
+ * estimate yet
+ */
+guint64
+gst_hls_abr_get_bandwidth (GstHLSAbr * abr)
+{
+  gdouble estimate = 0;
+  guint i, n;
+
+  g_return_val_if_fail (abr != NULL, 0);
+
+  if (abr->n_samples == 0)
+    return 0;
+
+  switch (abr->policy) {
+    case GST_HLS_ABR_POLICY_EWMA:
+      estimate = MIN (ewma_get (abr->fast, FAST_HALF_LIFE, abr->total_time),
+          ewma_get (abr->slow, SLOW_HALF_LIFE, abr->total_time));
+      break;
+    case GST_HLS_ABR_POLICY_LEGACY:
+    case GST_HLS_ABR_POLICY_HARMONIC:
+      n = MIN (abr->n_samples, GST_HLS_ABR_HARMONIC_SAMPLES);
+      for (i = 0; i < n; i++)
+        estimate += 1 / abr->samples[i];
+      estimate = n / estimate;
+      break;
+  }
+
+  return estimate;
+}
+
+/**
+ * gst_hls_abr_select:
+ * @abr: a #GstHLSAbr
+ * @variants: the #GstM3U8 variants, sorted by bandwidth
+ * @current: the current variant
+ * @buffer_level: the duration of the data fetched and not yet played
+ * @fragment_duration: the target duration of the fragments
+ *
+ * Returns: the variant to fetch the next fragment from
+ */
+GstM3U8 *
+gst_hls_abr_select (GstHLSAbr * abr, GList * variants, GstM3U8 * current,
+    GstClockTime buffer_level, GstClockTime fragment_duration)
+{
+  GstM3U8 *target = NULL;
+  GList *walk, *cur;
+  guint64 bandwidth;
+  gdouble level;
+
+  g_return_val_if_fail (abr != NULL, current);
+  g_return_val_if_fail (current != NULL, current);
+
+  bandwidth = gst_hls_abr_get_bandwidth (abr);
+  if (bandwidth == 0 || variants == NULL)
+    return current;
+
+  /* the best variant that fits, or the lowest one */
+  for (walk = variants; walk; walk = g_list_next (walk)) {
+    GstM3U8 *variant = walk->data;
+
+    if (target == NULL || variant->bandwidth <= bandwidth * abr->safety)
+      target = variant;
+  }
+
+  if (fragment_duration > 0)
+    level = (gdouble) buffer_level / fragment_duration;
+  else
+    level = abr->up_level;
+
+  GST_DEBUG ("estimate %" G_GUINT64_FORMAT " bits/s, buffer level %.2f "
+      "fragments, current %d, target %d", bandwidth, level,
+      current->bandwidth, target->bandwidth);
+
+  if (target->bandwidth > current->bandwidth) {
+    /* one variant at a time, with enough data to absorb a bad guess */
+    if (level < abr->up_level)
+      return current;
+    cur = g_list_find (variants, current);
+    if (cur && g_list_next (cur))
+      return g_list_next (cur)->data;
+    return target;
+  } else if (target->bandwidth < current->bandwidth) {
+    /* keep the current variant while it can be sustained and the buffer
+     * absorbs the variations of the throughput */
+    if (level >= abr->down_level && bandwidth >= current->bandwidth)
+      return current;
+    return target;
+  }
+
+  return current;
+}
@@ -0,0 +1,78 @@
+/* GStreamer
+ *
+ * gsthlsabr.h:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_HLS_ABR_H__
+#define __GST_HLS_ABR_H__
+
+#include <gst/gst.h>
+#include "m3u8.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GstHLSAbr GstHLSAbr;
+
+/**
+ * GstHLSAbrPolicy:
+ * @GST_HLS_ABR_POLICY_LEGACY: switch on the delay of the downloads with
+ *   respect to their schedule, done by hlsdemux itself
+ * @GST_HLS_ABR_POLICY_EWMA: estimate the throughput with the minimum of a
+ *   fast and a slow exponentially weighted moving average
+ * @GST_HLS_ABR_POLICY_HARMONIC: estimate the throughput with the harmonic
+ *   mean of the last downloads
+ */
+typedef enum
+{
+  GST_HLS_ABR_POLICY_LEGACY,
+  GST_HLS_ABR_POLICY_EWMA,
+  GST_HLS_ABR_POLICY_HARMONIC
+} GstHLSAbrPolicy;
+
+#define GST_HLS_ABR_HARMONIC_SAMPLES 5
+
+struct _GstHLSAbr
+{
+  GstHLSAbrPolicy policy;
+
+  /* Switching parameters */
+  gdouble safety;               /* Fraction of the estimate a variant can use */
+  gdouble down_level;           /* Buffer level, in fragments, below which we switch down at once */
+  gdouble up_level;             /* Buffer level, in fragments, needed to switch up */
+
+  /*< private > */
+  guint n_samples;
+  gdouble fast;                 /* EWMA estimates in bits per second */
+  gdouble slow;
+  gdouble total_time;           /* Download time of all samples, in seconds */
+  gdouble samples[GST_HLS_ABR_HARMONIC_SAMPLES];
+};
+
+GstHLSAbr *gst_hls_abr_new (GstHLSAbrPolicy policy);
+void gst_hls_abr_free (GstHLSAbr * abr);
+void gst_hls_abr_set_policy (GstHLSAbr * abr, GstHLSAbrPolicy policy);
+void gst_hls_abr_reset (GstHLSAbr * abr);
+void gst_hls_abr_add_sample (GstHLSAbr * abr, guint64 bytes,
+    GstClockTime download_time);
+guint64 gst_hls_abr_get_bandwidth (GstHLSAbr * abr);
+GstM3U8 *gst_hls_abr_select (GstHLSAbr * abr, GList * variants,
+    GstM3U8 * current, GstClockTime buffer_level,
+    GstClockTime fragment_duration);
+
+G_END_DECLS
+#endif /* __GST_HLS_ABR_H__ */
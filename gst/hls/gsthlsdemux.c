@@ -67,6 +67,10 @@ enum
 
   PROP_FRAGMENTS_CACHE,
   PROP_BITRATE_SWITCH_TOLERANCE,
+  PROP_PREFETCH_FRAGMENTS,
+  PROP_STARTUP_LATENCY,
+  PROP_NETWORK_WAIT_TIME,
+  PROP_ABR_POLICY,
   PROP_LAST
 };
 
@@ -75,6 +79,31 @@ static const float update_interval_factor[] = { 1, 0.5, 1.5, 3 };
 #define DEFAULT_FRAGMENTS_CACHE 3
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_BITRATE_SWITCH_TOLERANCE 0.4
+#define DEFAULT_PREFETCH_FRAGMENTS 1
+#define DEFAULT_ABR_POLICY GST_HLS_ABR_POLICY_EWMA
+
+#define GST_TYPE_HLS_ABR_POLICY (gst_hls_abr_policy_get_type ())
+static GType
+gst_hls_abr_policy_get_type (void)
+{
+  static GType gtype = 0;
+
+  if (gtype == 0) {
+    static const GEnumValue values[] = {
+      {GST_HLS_ABR_POLICY_LEGACY,
+          "Switch on the delay of the downloads (bitrate-switch-tolerance)",
+          "legacy"},
+      {GST_HLS_ABR_POLICY_EWMA,
+          "Throughput estimated with moving averages (default)", "ewma"},
+      {GST_HLS_ABR_POLICY_HARMONIC,
+          "Throughput estimated with the harmonic mean", "harmonic"},
+      {0, NULL, NULL}
+    };
+
+    gtype = g_enum_register_static ("GstHLSAbrPolicy", values);
+  }
+  return gtype;
+}
 
 /* GObject */
 static void gst_hls_demux_set_property (GObject * object, guint prop_id,
@@ -100,8 +129,10 @@ static gboolean gst_hls_demux_fetcher_sink_event (GstPad * pad,
     GstEvent * event);
 static void gst_hls_demux_loop (GstHLSDemux * demux);
 static void gst_hls_demux_stop (GstHLSDemux * demux);
-static void gst_hls_demux_stop_fetcher (GstHLSDemux * demux,
-    gboolean cancelled);
+static void gst_hls_demux_cancel_fetchers (GstHLSDemux * demux);
+static void gst_hls_demux_stop_prefetch (GstHLSDemux * demux);
+static GstHLSFetcher *gst_hls_fetcher_new (GstHLSDemux * demux);
+static void gst_hls_fetcher_free (GstHLSFetcher * fetcher);
 static gboolean gst_hls_demux_start_update (GstHLSDemux * demux);
 static gboolean gst_hls_demux_cache_fragments (GstHLSDemux * demux);
 static gboolean gst_hls_demux_schedule (GstHLSDemux * demux);
@@ -149,9 +180,6 @@ gst_hls_demux_dispose (GObject * obj)
 {
   GstHLSDemux *demux = GST_HLS_DEMUX (obj);
 
-  g_cond_free (demux->fetcher_cond);
-  g_mutex_free (demux->fetcher_lock);
-
   g_cond_free (demux->thread_cond);
   g_mutex_free (demux->thread_lock);
 
@@ -162,12 +190,18 @@ gst_hls_demux_dispose (GObject * obj)
   gst_object_unref (demux->task);
   g_static_rec_mutex_free (&demux->task_lock);
 
-  gst_object_unref (demux->fetcher_bus);
-  gst_object_unref (demux->fetcherpad);
-
   gst_hls_demux_reset (demux, TRUE);
 
-  gst_object_unref (demux->download);
+  g_list_foreach (demux->fetchers, (GFunc) gst_hls_fetcher_free, NULL);
+  g_list_free (demux->fetchers);
+  demux->fetchers = NULL;
+  g_queue_free (demux->prefetch);
+  g_queue_free (demux->idle_fetchers);
+
+  if (demux->abr) {
+    gst_hls_abr_free (demux->abr);
+    demux->abr = NULL;
+  }
 
   G_OBJECT_CLASS (parent_class)->dispose (obj);
 }
@@ -199,6 +233,33 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_SWITCH_TOLERANCE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of fragments downloaded in parallel ahead of the one "
+          "needed next. Fragments being downloaded count against "
+          "fragments-cache (0 = download one fragment at a time)",
+          0, G_MAXUINT, DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STARTUP_LATENCY,
+      g_param_spec_uint64 ("startup-latency", "Startup latency",
+          "Time from receiving the main playlist to pushing the first "
+          "fragment (in nanoseconds, -1 until then)",
+          0, G_MAXUINT64, GST_CLOCK_TIME_NONE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NETWORK_WAIT_TIME,
+      g_param_spec_uint64 ("network-wait-time", "Network wait time",
+          "Total time spent waiting for playlist and fragment downloads "
+          "(in nanoseconds)", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ABR_POLICY,
+      g_param_spec_enum ("abr-policy", "ABR policy",
+          "Method used to select the variant playlist",
+          GST_TYPE_HLS_ABR_POLICY, DEFAULT_ABR_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_hls_demux_change_state);
 }
@@ -223,28 +284,20 @@ gst_hls_demux_init (GstHLSDemux * demux, GstHLSDemuxClass * klass)
   gst_pad_set_element_private (demux->srcpad, demux);
   gst_element_add_pad (GST_ELEMENT (demux), demux->srcpad);
 
-  /* fetcher pad */
-  demux->fetcherpad =
-      gst_pad_new_from_static_template (&fetchertemplate, "sink");
-  gst_pad_set_chain_function (demux->fetcherpad,
-      GST_DEBUG_FUNCPTR (gst_hls_demux_fetcher_chain));
-  gst_pad_set_event_function (demux->fetcherpad,
-      GST_DEBUG_FUNCPTR (gst_hls_demux_fetcher_sink_event));
-  gst_pad_set_element_private (demux->fetcherpad, demux);
-  gst_pad_activate_push (demux->fetcherpad, TRUE);
-
   /* Properties */
   demux->fragments_cache = DEFAULT_FRAGMENTS_CACHE;
   demux->bitrate_switch_tol = DEFAULT_BITRATE_SWITCH_TOLERANCE;
+  demux->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
+  demux->abr_policy = DEFAULT_ABR_POLICY;
+  demux->abr = gst_hls_abr_new (DEFAULT_ABR_POLICY);
+
+  /* fetchers */
+  demux->fetcher = gst_hls_fetcher_new (demux);
+  demux->prefetch = g_queue_new ();
+  demux->idle_fetchers = g_queue_new ();
 
-  demux->download = gst_adapter_new ();
-  demux->fetcher_bus = gst_bus_new ();
-  gst_bus_set_sync_handler (demux->fetcher_bus,
-      gst_hls_demux_fetcher_bus_handler, demux);
   demux->thread_cond = g_cond_new ();
   demux->thread_lock = g_mutex_new ();
-  demux->fetcher_cond = g_cond_new ();
-  demux->fetcher_lock = g_mutex_new ();
   demux->queue = g_queue_new ();
   g_static_rec_mutex_init (&demux->task_lock);
   demux->task = gst_task_create ((GstTaskFunction) gst_hls_demux_loop, demux);
@@ -264,6 +317,14 @@ gst_hls_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_SWITCH_TOLERANCE:
       demux->bitrate_switch_tol = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      demux->prefetch_fragments = g_value_get_uint (value);
+      break;
+    case PROP_ABR_POLICY:
+      GST_OBJECT_LOCK (demux);
+      demux->abr_policy = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -283,6 +344,24 @@ gst_hls_demux_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_BITRATE_SWITCH_TOLERANCE:
       g_value_set_float (value, demux->bitrate_switch_tol);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->prefetch_fragments);
+      break;
+    case PROP_ABR_POLICY:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_enum (value, demux->abr_policy);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_STARTUP_LATENCY:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->startup_latency);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_NETWORK_WAIT_TIME:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->network_wait);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -307,8 +386,7 @@ gst_hls_demux_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
-      demux->cancelled = TRUE;
-      g_cond_signal (demux->fetcher_cond);
+      gst_hls_demux_cancel_fetchers (demux);
       break;
     default:
       break;
@@ -381,6 +459,10 @@ gst_hls_demux_sink_event (GstPad * pad, GstEvent * event)
         return FALSE;
       }
 
+      GST_OBJECT_LOCK (demux);
+      demux->start_time = gst_util_get_timestamp ();
+      GST_OBJECT_UNLOCK (demux);
+
       gst_task_start (demux->task);
       gst_event_unref (event);
       return TRUE;
@@ -455,14 +537,17 @@ gst_hls_demux_src_query (GstPad * pad, GstQuery * query)
 static gboolean
 gst_hls_demux_fetcher_sink_event (GstPad * pad, GstEvent * event)
 {
-  GstHLSDemux *demux = GST_HLS_DEMUX (gst_pad_get_element_private (pad));
+  GstHLSFetcher *fetcher = gst_pad_get_element_private (pad);
 
   switch (event->type) {
     case GST_EVENT_EOS:{
-      GST_DEBUG_OBJECT (demux, "Got EOS on the fetcher pad");
+      GST_DEBUG_OBJECT (fetcher->demux, "Got EOS on the fetcher pad");
       /* signal we have fetched the URI */
-      if (!demux->cancelled)
-        g_cond_signal (demux->fetcher_cond);
+      g_mutex_lock (fetcher->lock);
+      fetcher->end_time = gst_util_get_timestamp ();
+      fetcher->fetching = FALSE;
+      g_cond_signal (fetcher->cond);
+      g_mutex_unlock (fetcher->lock);
     }
     default:
       break;
@@ -490,21 +575,23 @@ gst_hls_demux_chain (GstPad * pad, GstBuffer * buf)
 static GstFlowReturn
 gst_hls_demux_fetcher_chain (GstPad * pad, GstBuffer * buf)
 {
-  GstHLSDemux *demux = GST_HLS_DEMUX (gst_pad_get_element_private (pad));
+  GstHLSFetcher *fetcher = gst_pad_get_element_private (pad);
 
   /* The source element can be an http source element. In case we get a 404,
    * the html response will be sent downstream and the adapter
    * will not be null, which might make us think that the request proceed
    * successfully. But it will also post an error message in the bus that
-   * is handled synchronously and that will set demux->fetcher_error to TRUE,
+   * is handled synchronously and that will set fetcher->error to TRUE,
    * which is used to discard this buffer with the html response. */
-  if (demux->fetcher_error) {
+  if (fetcher->error) {
+    gst_buffer_unref (buf);
     goto done;
   }
 
-  GST_LOG_OBJECT (demux, "The uri fetcher received a new buffer of size %u",
+  GST_LOG_OBJECT (fetcher->demux,
+      "The uri fetcher received a new buffer of size %u",
       GST_BUFFER_SIZE (buf));
-  gst_adapter_push (demux->download, buf);
+  gst_adapter_push (fetcher->download, buf);
 
 done:
   {
@@ -513,43 +600,51 @@ done:
 }
 
 static void
-gst_hls_demux_stop_fetcher (GstHLSDemux * demux, gboolean cancelled)
+gst_hls_fetcher_stop (GstHLSFetcher * fetcher)
 {
   GstPad *pad;
 
-  /* When the fetcher is stopped while it's downloading, we will get an EOS that
-   * unblocks the fetcher thread and tries to stop it again from that thread.
-   * Here we check if the fetcher as already been stopped before continuing */
-  if (demux->fetcher == NULL || demux->stopping_fetcher)
+  if (fetcher->element == NULL)
     return;
 
-  GST_DEBUG_OBJECT (demux, "Stopping fetcher.");
-  demux->stopping_fetcher = TRUE;
+  GST_DEBUG_OBJECT (fetcher->demux, "Stopping fetcher.");
   /* set the element state to NULL */
-  gst_element_set_state (demux->fetcher, GST_STATE_NULL);
-  gst_element_get_state (demux->fetcher, NULL, NULL, GST_CLOCK_TIME_NONE);
+  gst_element_set_state (fetcher->element, GST_STATE_NULL);
+  gst_element_get_state (fetcher->element, NULL, NULL, GST_CLOCK_TIME_NONE);
   /* unlink it from the internal pad */
-  pad = gst_pad_get_peer (demux->fetcherpad);
+  pad = gst_pad_get_peer (fetcher->pad);
   if (pad) {
-    gst_pad_unlink (pad, demux->fetcherpad);
+    gst_pad_unlink (pad, fetcher->pad);
     gst_object_unref (pad);
   }
   /* and finally unref it */
-  gst_object_unref (demux->fetcher);
-  demux->fetcher = NULL;
-
-  /* if we stopped it to cancell a download, free the cached buffer */
-  if (cancelled && !gst_adapter_available (demux->download)) {
-    gst_adapter_clear (demux->download);
-    /* signal the fetcher thread that the download has finished/cancelled */
-    g_cond_signal (demux->fetcher_cond);
+  gst_object_unref (fetcher->element);
+  fetcher->element = NULL;
+}
+
+/* Wakes up the thread waiting for a download. The fetchers are stopped by
+ * the thread that started them */
+static void
+gst_hls_demux_cancel_fetchers (GstHLSDemux * demux)
+{
+  GList *walk;
+
+  GST_OBJECT_LOCK (demux);
+  demux->cancelled = TRUE;
+  for (walk = demux->fetchers; walk; walk = g_list_next (walk)) {
+    GstHLSFetcher *fetcher = walk->data;
+
+    g_mutex_lock (fetcher->lock);
+    g_cond_signal (fetcher->cond);
+    g_mutex_unlock (fetcher->lock);
   }
+  GST_OBJECT_UNLOCK (demux);
 }
 
 static void
 gst_hls_demux_stop (GstHLSDemux * demux)
 {
-  gst_hls_demux_stop_fetcher (demux, TRUE);
+  gst_hls_demux_cancel_fetchers (demux);
   if (GST_TASK_STATE (demux->task) != GST_TASK_STOPPED)
     gst_task_stop (demux->task);
   g_cond_signal (demux->thread_cond);
@@ -588,10 +683,22 @@ gst_hls_demux_loop (GstHLSDemux * demux)
   }
 
   buf = g_queue_pop_head (demux->queue);
+  GST_OBJECT_LOCK (demux);
+  demux->queued_duration -= MIN (demux->queued_duration,
+      GST_BUFFER_DURATION (buf));
+  GST_OBJECT_UNLOCK (demux);
   ret = gst_pad_push (demux->srcpad, buf);
   if (ret != GST_FLOW_OK)
     goto error;
 
+  GST_OBJECT_LOCK (demux);
+  if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (demux->startup_latency))) {
+    demux->startup_latency = gst_util_get_timestamp () - demux->start_time;
+    GST_INFO_OBJECT (demux, "First fragment pushed after %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (demux->startup_latency));
+  }
+  GST_OBJECT_UNLOCK (demux);
+
   return;
 
 end_of_playlist:
@@ -622,49 +729,271 @@ static GstBusSyncReply
 gst_hls_demux_fetcher_bus_handler (GstBus * bus,
     GstMessage * message, gpointer data)
 {
-  GstHLSDemux *demux = GST_HLS_DEMUX (data);
+  GstHLSFetcher *fetcher = data;
 
   if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR) {
-    demux->fetcher_error = TRUE;
-    g_cond_signal (demux->fetcher_cond);
+    g_mutex_lock (fetcher->lock);
+    fetcher->error = TRUE;
+    fetcher->fetching = FALSE;
+    g_cond_signal (fetcher->cond);
+    g_mutex_unlock (fetcher->lock);
   }
 
   gst_message_unref (message);
   return GST_BUS_DROP;
 }
 
+static GstHLSFetcher *
+gst_hls_fetcher_new (GstHLSDemux * demux)
+{
+  GstHLSFetcher *fetcher = g_slice_new0 (GstHLSFetcher);
+
+  fetcher->demux = demux;
+
+  fetcher->pad = gst_pad_new_from_static_template (&fetchertemplate, "sink");
+  gst_pad_set_chain_function (fetcher->pad,
+      GST_DEBUG_FUNCPTR (gst_hls_demux_fetcher_chain));
+  gst_pad_set_event_function (fetcher->pad,
+      GST_DEBUG_FUNCPTR (gst_hls_demux_fetcher_sink_event));
+  gst_pad_set_element_private (fetcher->pad, fetcher);
+  gst_pad_activate_push (fetcher->pad, TRUE);
+
+  fetcher->bus = gst_bus_new ();
+  gst_bus_set_sync_handler (fetcher->bus, gst_hls_demux_fetcher_bus_handler,
+      fetcher);
+  fetcher->lock = g_mutex_new ();
+  fetcher->cond = g_cond_new ();
+  fetcher->download = gst_adapter_new ();
+
+  GST_OBJECT_LOCK (demux);
+  demux->fetchers = g_list_prepend (demux->fetchers, fetcher);
+  GST_OBJECT_UNLOCK (demux);
+
+  return fetcher;
+}
+
+static void
+gst_hls_fetcher_free (GstHLSFetcher * fetcher)
+{
+  gst_hls_fetcher_stop (fetcher);
+
+  gst_object_unref (fetcher->pad);
+  gst_object_unref (fetcher->bus);
+  g_cond_free (fetcher->cond);
+  g_mutex_free (fetcher->lock);
+  g_object_unref (fetcher->download);
+  g_clear_error (&fetcher->start_error);
+  g_free (fetcher->start_debug);
+
+  g_slice_free (GstHLSFetcher, fetcher);
+}
+
 static gboolean
-gst_hls_demux_make_fetcher (GstHLSDemux * demux, const gchar * uri)
+gst_hls_fetcher_handles_uri (GstHLSFetcher * fetcher, const gchar * uri)
 {
-  GstPad *pad;
+  gchar **protocols;
+  gchar *protocol;
+  gboolean ret = FALSE;
+  gint i;
+
+  protocols =
+      gst_uri_handler_get_protocols (GST_URI_HANDLER (fetcher->element));
+  protocol = gst_uri_get_protocol (uri);
+  for (i = 0; protocols && protocols[i] && !ret; i++)
+    ret = !g_ascii_strcasecmp (protocols[i], protocol);
+  g_free (protocol);
+
+  return ret;
+}
+
+static void
+gst_hls_fetcher_clear_error (GstHLSFetcher * fetcher)
+{
+  g_clear_error (&fetcher->start_error);
+  g_free (fetcher->start_debug);
+  fetcher->start_debug = NULL;
+}
+
+/* Starts the download of uri. The source element of the previous download
+ * is reused if it handles the protocol of uri. Errors are not posted here
+ * but by gst_hls_fetcher_wait(), so that a fragment prefetched and never
+ * used doesn't stop the playback */
+static gboolean
+gst_hls_fetcher_start (GstHLSFetcher * fetcher, const gchar * uri)
+{
+  GstHLSDemux *demux = fetcher->demux;
+  GstStateChangeReturn ret;
+
+  gst_adapter_clear (fetcher->download);
+  gst_hls_fetcher_clear_error (fetcher);
+
+  g_mutex_lock (fetcher->lock);
+  fetcher->fetching = FALSE;
+  fetcher->error = TRUE;
+  g_mutex_unlock (fetcher->lock);
 
   if (!gst_uri_is_valid (uri))
+    goto uri_error;
+
+  if (fetcher->element && !gst_hls_fetcher_handles_uri (fetcher, uri))
+    gst_hls_fetcher_stop (fetcher);
+
+  if (fetcher->element == NULL) {
+    GstPad *pad;
+
+    GST_DEBUG_OBJECT (demux, "Creating fetcher for the URI:%s", uri);
+    fetcher->element = gst_element_make_from_uri (GST_URI_SRC, uri, NULL);
+    if (!fetcher->element)
+      goto uri_error;
+
+    gst_element_set_bus (fetcher->element, fetcher->bus);
+    pad = gst_element_get_static_pad (fetcher->element, "src");
+    if (pad) {
+      gst_pad_link (pad, fetcher->pad);
+      gst_object_unref (pad);
+    }
+  } else {
+    GST_DEBUG_OBJECT (demux, "Reusing fetcher for the URI:%s", uri);
+  }
+
+  g_mutex_lock (fetcher->lock);
+  fetcher->fetching = TRUE;
+  fetcher->error = FALSE;
+  fetcher->start_time = gst_util_get_timestamp ();
+  fetcher->end_time = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (fetcher->lock);
+
+  g_object_set (G_OBJECT (fetcher->element), "location", uri, NULL);
+  ret = gst_element_set_state (fetcher->element, GST_STATE_PLAYING);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    goto state_change_error;
+
+  return TRUE;
+
+uri_error:
+  {
+    GST_WARNING_OBJECT (demux, "Could not create an element to fetch the "
+        "URI: %s", uri);
+    fetcher->start_error = g_error_new_literal (GST_RESOURCE_ERROR,
+        GST_RESOURCE_ERROR_OPEN_READ,
+        "Could not create an element to fetch the given URI.");
+    fetcher->start_debug = g_strdup_printf ("URI: \"%s\"", uri);
     return FALSE;
+  }
 
-  GST_DEBUG_OBJECT (demux, "Creating fetcher for the URI:%s", uri);
-  demux->fetcher = gst_element_make_from_uri (GST_URI_SRC, uri, NULL);
-  if (!demux->fetcher)
+state_change_error:
+  {
+    GST_WARNING_OBJECT (demux, "Error changing state of the fetcher element");
+    fetcher->start_error = g_error_new_literal (GST_CORE_ERROR,
+        GST_CORE_ERROR_STATE_CHANGE,
+        "Error changing state of the fetcher element.");
+    g_mutex_lock (fetcher->lock);
+    fetcher->fetching = FALSE;
+    fetcher->error = TRUE;
+    g_mutex_unlock (fetcher->lock);
+    gst_hls_fetcher_stop (fetcher);
     return FALSE;
+  }
+}
 
-  demux->fetcher_error = FALSE;
-  demux->stopping_fetcher = FALSE;
-  gst_element_set_bus (GST_ELEMENT (demux->fetcher), demux->fetcher_bus);
+/* Waits for the end of the download started with gst_hls_fetcher_start()
+ * and returns TRUE if data was fetched. An error starting the download is
+ * posted now */
+static gboolean
+gst_hls_fetcher_wait (GstHLSFetcher * fetcher)
+{
+  GstHLSDemux *demux = fetcher->demux;
+  GstClockTime start;
+  gboolean ret;
 
-  g_object_set (G_OBJECT (demux->fetcher), "location", uri, NULL);
-  pad = gst_element_get_static_pad (demux->fetcher, "src");
-  if (pad) {
-    gst_pad_link (pad, demux->fetcherpad);
-    gst_object_unref (pad);
+  start = gst_util_get_timestamp ();
+
+  GST_DEBUG_OBJECT (demux, "Waiting to fetch the URI");
+  g_mutex_lock (fetcher->lock);
+  while (fetcher->fetching && !demux->cancelled)
+    g_cond_wait (fetcher->cond, fetcher->lock);
+  ret = !fetcher->error && !demux->cancelled;
+  fetcher->fetching = FALSE;
+  g_mutex_unlock (fetcher->lock);
+
+  GST_OBJECT_LOCK (demux);
+  demux->network_wait += gst_util_get_timestamp () - start;
+  GST_OBJECT_UNLOCK (demux);
+
+  /* keep the source for the next download unless it failed */
+  if (ret)
+    gst_element_set_state (fetcher->element, GST_STATE_READY);
+  else
+    gst_hls_fetcher_stop (fetcher);
+
+  if (fetcher->start_error && !demux->cancelled) {
+    gst_element_message_full (GST_ELEMENT (demux), GST_MESSAGE_ERROR,
+        fetcher->start_error->domain, fetcher->start_error->code,
+        g_strdup (fetcher->start_error->message), fetcher->start_debug,
+        __FILE__, GST_FUNCTION, __LINE__);
+    fetcher->start_debug = NULL;
   }
+  gst_hls_fetcher_clear_error (fetcher);
+
+  if (ret && gst_adapter_available (fetcher->download)) {
+    GST_INFO_OBJECT (demux, "URI fetched successfully");
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Starts the download of the next fragment of the playlist, returns FALSE
+ * if there are no more fragments. Errors are reported when waiting for it */
+static gboolean
+gst_hls_demux_prefetch_next (GstHLSDemux * demux)
+{
+  GstHLSFetcher *fetcher;
+  const gchar *next_fragment_uri;
+  GstClockTime duration;
+  gboolean discont;
+
+  if (!gst_m3u8_client_get_next_fragment (demux->client, &discont,
+          &next_fragment_uri, &duration))
+    return FALSE;
+
+  GST_INFO_OBJECT (demux, "Fetching next fragment %s", next_fragment_uri);
+
+  fetcher = g_queue_pop_head (demux->idle_fetchers);
+  if (fetcher == NULL)
+    fetcher = gst_hls_fetcher_new (demux);
+
+  fetcher->duration = duration;
+  fetcher->sequence = demux->client->sequence - 1;
+  fetcher->discont = discont;
+  if (!gst_hls_fetcher_start (fetcher, next_fragment_uri))
+    GST_WARNING_OBJECT (demux, "Could not start fetching the fragment, the "
+        "error is reported if it's needed");
+  g_queue_push_tail (demux->prefetch, fetcher);
+
   return TRUE;
 }
 
+static void
+gst_hls_demux_stop_prefetch (GstHLSDemux * demux)
+{
+  GstHLSFetcher *fetcher;
+
+  while ((fetcher = g_queue_pop_head (demux->prefetch))) {
+    gst_hls_fetcher_stop (fetcher);
+    gst_hls_fetcher_clear_error (fetcher);
+    gst_adapter_clear (fetcher->download);
+    g_queue_push_tail (demux->idle_fetchers, fetcher);
+  }
+}
+
 static void
 gst_hls_demux_reset (GstHLSDemux * demux, gboolean dispose)
 {
   demux->need_cache = TRUE;
   demux->thread_return = FALSE;
   demux->accumulated_delay = 0;
+  demux->last_download_end = 0;
   demux->end_of_playlist = FALSE;
   demux->cancelled = FALSE;
 
@@ -678,7 +1007,17 @@ gst_hls_demux_reset (GstHLSDemux * demux, gboolean dispose)
     demux->playlist = NULL;
   }
 
-  gst_adapter_clear (demux->download);
+  gst_hls_demux_stop_prefetch (demux);
+  gst_adapter_clear (demux->fetcher->download);
+
+  GST_OBJECT_LOCK (demux);
+  demux->start_time = GST_CLOCK_TIME_NONE;
+  demux->startup_latency = GST_CLOCK_TIME_NONE;
+  demux->network_wait = 0;
+  demux->queued_duration = 0;
+  gst_hls_abr_set_policy (demux->abr, demux->abr_policy);
+  GST_OBJECT_UNLOCK (demux);
+  gst_hls_abr_reset (demux->abr);
 
   if (demux->client)
     gst_m3u8_client_free (demux->client);
@@ -756,6 +1095,7 @@ gst_hls_demux_update_thread (GstHLSDemux * demux)
 
 quit:
   {
+    gst_hls_demux_stop_prefetch (demux);
     g_mutex_unlock (demux->thread_lock);
     return TRUE;
   }
@@ -815,11 +1155,14 @@ gst_hls_demux_cache_fragments (GstHLSDemux * demux)
     if (!gst_hls_demux_get_next_fragment (demux, FALSE)) {
       if (!demux->cancelled)
         GST_ERROR_OBJECT (demux, "Error caching the first fragments");
+      gst_hls_demux_stop_prefetch (demux);
       return FALSE;
     }
     /* make sure we stop caching fragments if something cancelled it */
-    if (demux->cancelled)
+    if (demux->cancelled) {
+      gst_hls_demux_stop_prefetch (demux);
       return FALSE;
+    }
   }
 
   g_get_current_time (&demux->next_update);
@@ -831,53 +1174,10 @@ gst_hls_demux_cache_fragments (GstHLSDemux * demux)
 static gboolean
 gst_hls_demux_fetch_location (GstHLSDemux * demux, const gchar * uri)
 {
-  GstStateChangeReturn ret;
-  gboolean bret = FALSE;
-
-  g_mutex_lock (demux->fetcher_lock);
-
-  if (!gst_hls_demux_make_fetcher (demux, uri)) {
-    goto uri_error;
-  }
-
-  ret = gst_element_set_state (demux->fetcher, GST_STATE_PLAYING);
-  if (ret == GST_STATE_CHANGE_FAILURE)
-    goto state_change_error;
-
-  /* wait until we have fetched the uri */
-  GST_DEBUG_OBJECT (demux, "Waiting to fetch the URI");
-  g_cond_wait (demux->fetcher_cond, demux->fetcher_lock);
-
-  gst_hls_demux_stop_fetcher (demux, FALSE);
-
-  if (gst_adapter_available (demux->download)) {
-    GST_INFO_OBJECT (demux, "URI fetched successfully");
-    bret = TRUE;
-  }
-  goto quit;
-
-uri_error:
-  {
-    GST_ELEMENT_ERROR (demux, RESOURCE, OPEN_READ,
-        ("Could not create an element to fetch the given URI."), ("URI: \"%s\"",
-            uri));
-    bret = FALSE;
-    goto quit;
-  }
+  /* errors starting the download are posted when waiting for it */
+  gst_hls_fetcher_start (demux->fetcher, uri);
 
-state_change_error:
-  {
-    GST_ELEMENT_ERROR (demux, CORE, STATE_CHANGE,
-        ("Error changing state of the fetcher element."), NULL);
-    bret = FALSE;
-    goto quit;
-  }
-
-quit:
-  {
-    g_mutex_unlock (demux->fetcher_lock);
-    return bret;
-  }
+  return gst_hls_fetcher_wait (demux->fetcher);
 }
 
 static gchar *
@@ -906,10 +1206,10 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean retry)
   if (!gst_hls_demux_fetch_location (demux, demux->client->current->uri))
     return FALSE;
 
-  avail = gst_adapter_available (demux->download);
-  data = gst_adapter_peek (demux->download, avail);
+  avail = gst_adapter_available (demux->fetcher->download);
+  data = gst_adapter_peek (demux->fetcher->download, avail);
   playlist = gst_hls_src_buf_to_utf8_playlist ((gchar *) data, avail);
-  gst_adapter_clear (demux->download);
+  gst_adapter_clear (demux->fetcher->download);
   if (playlist == NULL) {
     GST_WARNING_OBJECT (demux, "Couldn't not validate playlist encoding");
     return FALSE;
@@ -919,20 +1219,28 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean retry)
 }
 
 static gboolean
-gst_hls_demux_change_playlist (GstHLSDemux * demux, gboolean is_fast)
+gst_hls_demux_set_playlist (GstHLSDemux * demux, GList * list)
 {
-  GList *list;
+  GstHLSFetcher *fetcher;
   GstStructure *s;
-
-  if (is_fast)
-    list = g_list_next (demux->client->main->lists);
-  else
-    list = g_list_previous (demux->client->main->lists);
+  gboolean is_fast;
 
   /* Don't do anything else if the playlist is the same */
   if (!list || list->data == demux->client->current)
     return TRUE;
 
+  /* The fragments being prefetched are those of the previous variant, drop
+   * them and continue with the first of them from the new one */
+  fetcher = g_queue_peek_head (demux->prefetch);
+  if (fetcher) {
+    GST_DEBUG_OBJECT (demux, "Dropping %u prefetched fragments",
+        g_queue_get_length (demux->prefetch));
+    demux->client->sequence = fetcher->sequence;
+    gst_hls_demux_stop_prefetch (demux);
+  }
+
+  is_fast = ((GstM3U8 *) list->data)->bandwidth >
+      demux->client->current->bandwidth;
   demux->client->main->lists = list;
 
   gst_m3u8_client_set_current (demux->client, demux->client->main->lists->data);
@@ -949,6 +1257,19 @@ gst_hls_demux_change_playlist (GstHLSDemux * demux, gboolean is_fast)
   return TRUE;
 }
 
+static gboolean
+gst_hls_demux_change_playlist (GstHLSDemux * demux, gboolean is_fast)
+{
+  GList *list;
+
+  if (is_fast)
+    list = g_list_next (demux->client->main->lists);
+  else
+    list = g_list_previous (demux->client->main->lists);
+
+  return gst_hls_demux_set_playlist (demux, list);
+}
+
 static gboolean
 gst_hls_demux_schedule (GstHLSDemux * demux)
 {
@@ -977,6 +1298,26 @@ gst_hls_demux_schedule (GstHLSDemux * demux)
   return TRUE;
 }
 
+/* Selects the variant with the throughput estimated from the downloads and
+ * the duration of the fragments queued */
+static gboolean
+gst_hls_demux_select_playlist (GstHLSDemux * demux)
+{
+  GList *variants;
+  GstM3U8 *next;
+  GstClockTime queued;
+
+  GST_OBJECT_LOCK (demux);
+  queued = demux->queued_duration;
+  GST_OBJECT_UNLOCK (demux);
+
+  variants = g_list_first (demux->client->main->lists);
+  next = gst_hls_abr_select (demux->abr, variants, demux->client->current,
+      queued, demux->client->current->targetduration * GST_SECOND);
+
+  return gst_hls_demux_set_playlist (demux, g_list_find (variants, next));
+}
+
 static gboolean
 gst_hls_demux_switch_playlist (GstHLSDemux * demux)
 {
@@ -987,6 +1328,9 @@ gst_hls_demux_switch_playlist (GstHLSDemux * demux)
   if (!demux->client->main->lists)
     return TRUE;
 
+  if (demux->abr->policy != GST_HLS_ABR_POLICY_LEGACY)
+    return gst_hls_demux_select_playlist (demux);
+
   /* compare the time when the fragment was downloaded with the time when it was
    * scheduled */
   diff = (GST_TIMEVAL_TO_TIME (demux->next_update) - GST_TIMEVAL_TO_TIME (now));
@@ -1012,28 +1356,47 @@ gst_hls_demux_switch_playlist (GstHLSDemux * demux)
 static gboolean
 gst_hls_demux_get_next_fragment (GstHLSDemux * demux, gboolean retry)
 {
+  GstHLSFetcher *fetcher;
   GstBuffer *buf;
   guint avail;
-  const gchar *next_fragment_uri;
-  GstClockTime duration;
-  gboolean discont;
 
-  if (!gst_m3u8_client_get_next_fragment (demux->client, &discont,
-          &next_fragment_uri, &duration)) {
+  if (g_queue_is_empty (demux->prefetch) &&
+      !gst_hls_demux_prefetch_next (demux)) {
     GST_INFO_OBJECT (demux, "This playlist doesn't contain more fragments");
     demux->end_of_playlist = TRUE;
     GST_TASK_SIGNAL (demux->task);
     return FALSE;
   }
+  fetcher = g_queue_pop_head (demux->prefetch);
+
+  /* Start the downloads of the following fragments before waiting for this
+   * one. The fragments queued and being downloaded are limited to the
+   * fragments cache */
+  while (g_queue_get_length (demux->prefetch) < demux->prefetch_fragments &&
+      g_queue_get_length (demux->queue) + g_queue_get_length (demux->prefetch)
+      + 1 < demux->fragments_cache) {
+    if (!gst_hls_demux_prefetch_next (demux))
+      break;
+  }
 
-  GST_INFO_OBJECT (demux, "Fetching next fragment %s", next_fragment_uri);
-
-  if (!gst_hls_demux_fetch_location (demux, next_fragment_uri))
+  if (!gst_hls_fetcher_wait (fetcher)) {
+    g_queue_push_tail (demux->idle_fetchers, fetcher);
     return FALSE;
+  }
 
-  avail = gst_adapter_available (demux->download);
-  buf = gst_adapter_take_buffer (demux->download, avail);
-  GST_BUFFER_DURATION (buf) = duration;
+  avail = gst_adapter_available (fetcher->download);
+  buf = gst_adapter_take_buffer (fetcher->download, avail);
+  GST_BUFFER_DURATION (buf) = fetcher->duration;
+
+  /* Parallel downloads share the link, only count the time since the
+   * previous one ended */
+  if (GST_CLOCK_TIME_IS_VALID (fetcher->end_time)) {
+    gst_hls_abr_add_sample (demux->abr, avail, fetcher->end_time -
+        MIN (MAX (fetcher->start_time, demux->last_download_end),
+            fetcher->end_time));
+    demux->last_download_end = MAX (fetcher->end_time,
+        demux->last_download_end);
+  }
 
   if (G_UNLIKELY (demux->input_caps == NULL)) {
     demux->input_caps = gst_type_find_helper_for_buffer (NULL, buf, NULL);
@@ -1044,13 +1407,17 @@ gst_hls_demux_get_next_fragment (GstHLSDemux * demux, gboolean retry)
     }
   }
 
-  if (discont) {
+  if (fetcher->discont) {
     GST_DEBUG_OBJECT (demux, "Marking fragment as discontinuous");
     GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
   }
 
+  g_queue_push_tail (demux->idle_fetchers, fetcher);
+
+  GST_OBJECT_LOCK (demux);
+  demux->queued_duration += GST_BUFFER_DURATION (buf);
+  GST_OBJECT_UNLOCK (demux);
   g_queue_push_tail (demux->queue, buf);
   GST_TASK_SIGNAL (demux->task);
-  gst_adapter_clear (demux->download);
   return TRUE;
 }
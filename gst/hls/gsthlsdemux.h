@@ -27,6 +27,7 @@
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 #include "m3u8.h"
+#include "gsthlsabr.h"
 
 G_BEGIN_DECLS
 #define GST_TYPE_HLS_DEMUX \
@@ -41,6 +42,32 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_HLS_DEMUX))
 typedef struct _GstHLSDemux GstHLSDemux;
 typedef struct _GstHLSDemuxClass GstHLSDemuxClass;
+typedef struct _GstHLSFetcher GstHLSFetcher;
+
+/* A source element and the pad it pushes to. The element is kept between
+ * downloads and reused for the URIs of the same protocol */
+struct _GstHLSFetcher
+{
+  GstHLSDemux *demux;
+
+  GstElement *element;
+  GstPad *pad;
+  GstBus *bus;
+  GMutex *lock;
+  GCond *cond;
+  GstAdapter *download;
+
+  GstClockTime duration;        /* Duration of the fragment being fetched */
+  gint sequence;                /* and its media sequence number */
+  gboolean discont;
+  GstClockTime start_time;      /* Times the download started and ended */
+  GstClockTime end_time;
+
+  gboolean fetching;
+  gboolean error;
+  GError *start_error;          /* Error starting the download and its debug */
+  gchar *start_debug;           /* message, posted by gst_hls_fetcher_wait() */
+};
 
 /**
  * GstHLSDemux:
@@ -66,6 +93,7 @@ struct _GstHLSDemux
   /* Properties */
   guint fragments_cache;        /* number of fragments needed to be cached to start playing */
   gfloat bitrate_switch_tol;    /* tolerance with respect to the fragment duration to switch the bitarate*/
+  guint prefetch_fragments;     /* number of fragments downloaded ahead */
 
   /* Updates thread */
   GThread *updates_thread;      /* Thread handling the playlist and fragments updates */
@@ -75,18 +103,23 @@ struct _GstHLSDemux
   GTimeVal next_update;         /* Time of the next update */
   gint64 accumulated_delay;     /* Delay accumulated fetching fragments, used to decide a playlist switch */
 
+  /* Bitrate selection */
+  GstHLSAbr *abr;
+  GstHLSAbrPolicy abr_policy;
+  GstClockTime last_download_end;       /* End of the last fragment download */
+  GstClockTime queued_duration; /* Duration of the fragments queued, protected by the object lock */
+
   /* Fragments fetcher */
-  GstElement *fetcher;
-  GstBus *fetcher_bus;
-  GstPad *fetcherpad;
-  GMutex *fetcher_lock;
-  GCond *fetcher_cond;
-  GTimeVal *timeout;
-  gboolean fetcher_error;
-  gboolean stopping_fetcher;
+  GstHLSFetcher *fetcher;       /* Fetcher for the playlists */
+  GQueue *prefetch;             /* Fetchers downloading the next fragments, in order */
+  GQueue *idle_fetchers;        /* Fetchers kept for the next fragments */
+  GList *fetchers;              /* All the fetchers, protected by the object lock */
   gboolean cancelled;
-  GstAdapter *download;
 
+  /* Statistics, protected by the object lock */
+  GstClockTime start_time;      /* Time the main playlist was received */
+  GstClockTime startup_latency; /* From then to the first fragment pushed */
+  GstClockTime network_wait;    /* Time spent waiting for downloads */
 };
 
 struct _GstHLSDemuxClass
@@ -77,9 +77,18 @@ static gboolean gst_inter_audio_sink_unlock_stop (GstBaseSink * sink);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_BUFFER_TIME,
+  PROP_SAMPLES_DROPPED,
+  PROP_CHANNEL,
+  PROP_CHANNELS
 };
 
+#define DEFAULT_CHANNEL "default"
+
+/* 3200 samples at 48 kHz */
+#define DEFAULT_BUFFER_TIME (GST_SECOND / 15)
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_inter_audio_sink_sink_template =
@@ -150,6 +159,27 @@ gst_inter_audio_sink_class_init (GstInterAudioSinkClass * klass)
   base_sink_class->unlock_stop =
       GST_DEBUG_FUNCPTR (gst_inter_audio_sink_unlock_stop);
 
+  g_object_class_install_property (gobject_class, PROP_BUFFER_TIME,
+      g_param_spec_uint64 ("buffer-time", "Buffer time",
+          "Maximum amount of audio queued for interaudiosrc (in nanoseconds), "
+          "older samples are dropped beyond that",
+          GST_MSECOND, G_MAXUINT64, DEFAULT_BUFFER_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SAMPLES_DROPPED,
+      g_param_spec_uint64 ("samples-dropped", "Samples dropped",
+          "Number of samples dropped because interaudiosrc fell behind",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNEL,
+      g_param_spec_string ("channel", "Channel",
+          "Channel name to match inter src and sink elements, changes take "
+          "effect on the next start", DEFAULT_CHANNEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNELS,
+      g_param_spec_value_array ("channels", "Channels",
+          "All active inter channels with their format and fill level",
+          g_param_spec_boxed ("channel", "Channel", "Channel description",
+              GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -161,16 +191,35 @@ gst_inter_audio_sink_init (GstInterAudioSink * interaudiosink,
       gst_pad_new_from_static_template (&gst_inter_audio_sink_sink_template,
       "sink");
 
-  interaudiosink->surface = gst_inter_surface_get ("default");
+  interaudiosink->channel = g_strdup (DEFAULT_CHANNEL);
+  interaudiosink->buffer_time = DEFAULT_BUFFER_TIME;
 }
 
 void
 gst_inter_audio_sink_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object); */
+  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object);
 
   switch (property_id) {
+    case PROP_BUFFER_TIME:
+      /* the object lock keeps stop() from releasing the surface under us */
+      GST_OBJECT_LOCK (interaudiosink);
+      interaudiosink->buffer_time = g_value_get_uint64 (value);
+      if (interaudiosink->surface) {
+        g_mutex_lock (interaudiosink->surface->mutex);
+        interaudiosink->surface->audio_max_bytes =
+            gst_util_uint64_scale (interaudiosink->buffer_time,
+            interaudiosink->sample_rate, GST_SECOND) * 2 *
+            interaudiosink->n_channels;
+        g_mutex_unlock (interaudiosink->surface->mutex);
+      }
+      GST_OBJECT_UNLOCK (interaudiosink);
+      break;
+    case PROP_CHANNEL:
+      g_free (interaudiosink->channel);
+      interaudiosink->channel = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -181,9 +230,21 @@ void
 gst_inter_audio_sink_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object); */
+  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object);
 
   switch (property_id) {
+    case PROP_BUFFER_TIME:
+      g_value_set_uint64 (value, interaudiosink->buffer_time);
+      break;
+    case PROP_SAMPLES_DROPPED:
+      g_value_set_uint64 (value, interaudiosink->samples_dropped);
+      break;
+    case PROP_CHANNEL:
+      g_value_set_string (value, interaudiosink->channel);
+      break;
+    case PROP_CHANNELS:
+      g_value_take_boxed (value, gst_inter_surface_list ());
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -203,9 +264,10 @@ gst_inter_audio_sink_dispose (GObject * object)
 void
 gst_inter_audio_sink_finalize (GObject * object)
 {
-  /* GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object); */
+  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (object);
 
-  /* clean up object here */
+  g_free (interaudiosink->channel);
+  interaudiosink->channel = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -222,6 +284,28 @@ gst_inter_audio_sink_get_caps (GstBaseSink * sink)
 static gboolean
 gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 {
+  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
+  const GstStructure *structure;
+  int sample_rate, n_channels;
+
+  structure = gst_caps_get_structure (caps, 0);
+
+  if (!gst_structure_get_int (structure, "rate", &sample_rate) ||
+      !gst_structure_get_int (structure, "channels", &n_channels))
+    return FALSE;
+
+  GST_OBJECT_LOCK (interaudiosink);
+  interaudiosink->sample_rate = sample_rate;
+  interaudiosink->n_channels = n_channels;
+
+  g_mutex_lock (interaudiosink->surface->mutex);
+  interaudiosink->surface->sample_rate = sample_rate;
+  interaudiosink->surface->n_channels = n_channels;
+  interaudiosink->surface->audio_max_bytes =
+      gst_util_uint64_scale (interaudiosink->buffer_time, sample_rate,
+      GST_SECOND) * 2 * n_channels;
+  g_mutex_unlock (interaudiosink->surface->mutex);
+  GST_OBJECT_UNLOCK (interaudiosink);
 
   return TRUE;
 }
@@ -259,6 +343,15 @@ gst_inter_audio_sink_get_times (GstBaseSink * sink, GstBuffer * buffer,
 static gboolean
 gst_inter_audio_sink_start (GstBaseSink * sink)
 {
+  GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
+  GstInterSurface *surface;
+
+  surface = gst_inter_surface_get (interaudiosink->channel);
+
+  GST_OBJECT_LOCK (interaudiosink);
+  interaudiosink->samples_dropped = 0;
+  interaudiosink->surface = surface;
+  GST_OBJECT_UNLOCK (interaudiosink);
 
   return TRUE;
 }
@@ -267,12 +360,22 @@ static gboolean
 gst_inter_audio_sink_stop (GstBaseSink * sink)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
+  GstInterSurface *surface;
+  GSList *garbage = NULL;
 
   GST_DEBUG ("stop");
 
-  g_mutex_lock (interaudiosink->surface->mutex);
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
-  g_mutex_unlock (interaudiosink->surface->mutex);
+  GST_OBJECT_LOCK (interaudiosink);
+  surface = interaudiosink->surface;
+  interaudiosink->surface = NULL;
+  GST_OBJECT_UNLOCK (interaudiosink);
+
+  g_mutex_lock (surface->mutex);
+  gst_inter_surface_clear_audio (surface, &garbage);
+  g_mutex_unlock (surface->mutex);
+  gst_inter_surface_free_garbage (garbage);
+
+  gst_inter_surface_unref (surface);
 
   return TRUE;
 }
@@ -302,20 +405,22 @@ static GstFlowReturn
 gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
-  int n;
+  GSList *garbage = NULL;
+  guint dropped;
 
   GST_DEBUG ("render %d", GST_BUFFER_SIZE (buffer));
 
   g_mutex_lock (interaudiosink->surface->mutex);
-  n = gst_adapter_available (interaudiosink->surface->audio_adapter) / 4;
-  if (n > (800 * 2 * 2)) {
-    GST_INFO ("flushing 800 samples");
-    gst_adapter_flush (interaudiosink->surface->audio_adapter, 800 * 4);
-    n -= 800;
-  }
-  gst_adapter_push (interaudiosink->surface->audio_adapter,
-      gst_buffer_ref (buffer));
+  dropped = gst_inter_surface_push_audio (interaudiosink->surface, buffer,
+      &garbage);
   g_mutex_unlock (interaudiosink->surface->mutex);
+  gst_inter_surface_free_garbage (garbage);
+
+  if (dropped > 0) {
+    GST_INFO ("dropped %d bytes", dropped);
+    interaudiosink->samples_dropped +=
+        dropped / (2 * MAX (interaudiosink->n_channels, 1));
+  }
 
   return GST_FLOW_OK;
 }
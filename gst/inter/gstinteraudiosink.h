@@ -44,6 +44,12 @@ struct _GstInterAudioSink
 
   int fps_n;
   int fps_d;
+
+  int sample_rate;
+  int n_channels;
+  GstClockTime buffer_time;
+  guint64 samples_dropped;
+  char *channel;
 };
 
 struct _GstInterAudioSinkClass
@@ -79,9 +79,14 @@ gst_inter_audio_src_prepare_seek_segment (GstBaseSrc * src, GstEvent * seek,
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_SAMPLES_SILENCED,
+  PROP_CHANNEL,
+  PROP_CHANNELS
 };
 
+#define DEFAULT_CHANNEL "default"
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_inter_audio_src_src_template =
@@ -158,6 +163,22 @@ gst_inter_audio_src_class_init (GstInterAudioSrcClass * klass)
     base_src_class->prepare_seek_segment =
         GST_DEBUG_FUNCPTR (gst_inter_audio_src_prepare_seek_segment);
 
+  g_object_class_install_property (gobject_class, PROP_SAMPLES_SILENCED,
+      g_param_spec_uint64 ("samples-silenced", "Samples silenced",
+          "Number of samples of silence inserted because interaudiosink "
+          "ran dry", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNEL,
+      g_param_spec_string ("channel", "Channel",
+          "Channel name to match inter src and sink elements, changes take "
+          "effect on the next start", DEFAULT_CHANNEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNELS,
+      g_param_spec_value_array ("channels", "Channels",
+          "All active inter channels with their format and fill level",
+          g_param_spec_boxed ("channel", "Channel", "Channel description",
+              GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
 }
 
@@ -173,16 +194,20 @@ gst_inter_audio_src_init (GstInterAudioSrc * interaudiosrc,
   gst_base_src_set_live (GST_BASE_SRC (interaudiosrc), TRUE);
   gst_base_src_set_blocksize (GST_BASE_SRC (interaudiosrc), -1);
 
-  interaudiosrc->surface = gst_inter_surface_get ("default");
+  interaudiosrc->channel = g_strdup (DEFAULT_CHANNEL);
 }
 
 void
 gst_inter_audio_src_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object); */
+  GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object);
 
   switch (property_id) {
+    case PROP_CHANNEL:
+      g_free (interaudiosrc->channel);
+      interaudiosrc->channel = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -193,9 +218,18 @@ void
 gst_inter_audio_src_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object); */
+  GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object);
 
   switch (property_id) {
+    case PROP_SAMPLES_SILENCED:
+      g_value_set_uint64 (value, interaudiosrc->samples_silenced);
+      break;
+    case PROP_CHANNEL:
+      g_value_set_string (value, interaudiosrc->channel);
+      break;
+    case PROP_CHANNELS:
+      g_value_take_boxed (value, gst_inter_surface_list ());
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -215,9 +249,10 @@ gst_inter_audio_src_dispose (GObject * object)
 void
 gst_inter_audio_src_finalize (GObject * object)
 {
-  /* GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object); */
+  GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (object);
 
-  /* clean up object here */
+  g_free (interaudiosrc->channel);
+  interaudiosrc->channel = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -280,6 +315,9 @@ gst_inter_audio_src_start (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (interaudiosrc, "start");
 
+  interaudiosrc->samples_silenced = 0;
+  interaudiosrc->surface = gst_inter_surface_get (interaudiosrc->channel);
+
   return TRUE;
 }
 
@@ -290,6 +328,14 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (interaudiosrc, "stop");
 
+  if (interaudiosrc->silence) {
+    gst_buffer_unref (interaudiosrc->silence);
+    interaudiosrc->silence = NULL;
+  }
+
+  gst_inter_surface_unref (interaudiosrc->surface);
+  interaudiosrc->surface = NULL;
+
   return TRUE;
 }
 
@@ -355,6 +401,7 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
+  GSList *garbage = NULL;
   GstBuffer *buffer;
   int n;
 
@@ -362,33 +409,28 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
 
   buffer = NULL;
 
+  /* the sink keeps the queue bounded, so there is no need to trim it here.
+   * Only the oldest queued buffer is looked at, its samples are passed on
+   * without copying even if that makes the output buffer short. */
   g_mutex_lock (interaudiosrc->surface->mutex);
-  n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / 4;
-  if (n > 1600 * 2) {
-    GST_DEBUG ("flushing %d samples", 800);
-    gst_adapter_flush (interaudiosrc->surface->audio_adapter, 800 * 4);
-    n -= 800;
-  }
-  if (n > 1600)
-    n = 1600;
-  if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * 4);
-  }
+  buffer = gst_inter_surface_take_audio_head (interaudiosrc->surface,
+      1600 * 4, &garbage);
   g_mutex_unlock (interaudiosrc->surface->mutex);
+  gst_inter_surface_free_garbage (garbage);
 
-  if (n < 1600) {
-    GstBuffer *newbuf = gst_buffer_new_and_alloc (1600 * 4);
-
-    GST_DEBUG ("creating %d samples of silence", 1600 - n);
-    memset (GST_BUFFER_DATA (newbuf) + n * 4, 0, 1600 * 4 - n * 4);
-    if (buffer) {
-      memcpy (GST_BUFFER_DATA (newbuf), GST_BUFFER_DATA (buffer), n * 4);
-      gst_buffer_unref (buffer);
+  if (buffer == NULL) {
+    if (interaudiosrc->silence == NULL) {
+      interaudiosrc->silence = gst_buffer_new_and_alloc (1600 * 4);
+      memset (GST_BUFFER_DATA (interaudiosrc->silence), 0, 1600 * 4);
     }
-    buffer = newbuf;
+
+    GST_DEBUG ("creating %d samples of silence", 1600);
+    interaudiosrc->samples_silenced += 1600;
+    buffer = gst_buffer_create_sub (interaudiosrc->silence, 0, 1600 * 4);
+  } else {
+    buffer = gst_buffer_make_metadata_writable (buffer);
   }
-  n = 1600;
+  n = GST_BUFFER_SIZE (buffer) / 4;
 
   GST_BUFFER_OFFSET (buffer) = interaudiosrc->n_samples;
   GST_BUFFER_OFFSET_END (buffer) = interaudiosrc->n_samples + n;
@@ -43,6 +43,10 @@ struct _GstInterAudioSrc
 
   guint64 n_samples;
   int sample_rate;
+  GstBuffer *silence;
+
+  guint64 samples_silenced;
+  char *channel;
 };
 
 struct _GstInterAudioSrcClass
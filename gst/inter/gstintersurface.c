@@ -23,20 +23,336 @@
 
 #include "gstintersurface.h"
 
-static GstInterSurface *surface;
+/* Surfaces are looked up by channel name.  The registry lock only covers
+ * the hash table and the surface refcounts, the frame and sample data is
+ * protected by each surface's own mutex so unrelated channels never
+ * contend. */
+static GMutex *registry_lock;
+static GHashTable *registry;
 
 
+static GstInterSurface *
+gst_inter_surface_new (const char *name)
+{
+  GstInterSurface *surface;
+
+  surface = g_malloc0 (sizeof (GstInterSurface));
+  surface->name = g_strdup (name);
+  surface->refcount = 1;
+  surface->mutex = g_mutex_new ();
+  surface->video_depth = 1;
+
+  return surface;
+}
+
+static void
+gst_inter_surface_free (GstInterSurface * surface)
+{
+  GSList *garbage = NULL;
+
+  gst_inter_surface_clear_video (surface, &garbage);
+  gst_inter_surface_clear_audio (surface, &garbage);
+  gst_inter_surface_free_garbage (garbage);
+
+  g_mutex_free (surface->mutex);
+  g_free (surface->name);
+  g_free (surface);
+}
+
+/* Returns the surface for channel @name, creating it if this is the first
+ * user.  Release it with gst_inter_surface_unref(). */
 GstInterSurface *
 gst_inter_surface_get (const char *name)
 {
+  GstInterSurface *surface;
+
+  g_mutex_lock (registry_lock);
+  surface = g_hash_table_lookup (registry, name);
+  if (surface) {
+    surface->refcount++;
+  } else {
+    surface = gst_inter_surface_new (name);
+    g_hash_table_insert (registry, surface->name, surface);
+  }
+  g_mutex_unlock (registry_lock);
+
   return surface;
+}
 
+void
+gst_inter_surface_unref (GstInterSurface * surface)
+{
+  gboolean last;
+
+  g_mutex_lock (registry_lock);
+  last = (--surface->refcount == 0);
+  if (last)
+    g_hash_table_remove (registry, surface->name);
+  g_mutex_unlock (registry_lock);
+
+  if (last)
+    gst_inter_surface_free (surface);
+}
+
+static void
+gst_inter_surface_describe (gpointer key, gpointer value, gpointer user_data)
+{
+  GstInterSurface *surface = value;
+  GValueArray *array = user_data;
+  GstStructure *s;
+  GValue v = { 0 };
+  guint video_fill = 0;
+  GstClockTime audio_fill = 0;
+  guint i;
+
+  g_mutex_lock (surface->mutex);
+  for (i = 0; i < surface->video_depth; i++) {
+    if (surface->video_ring[i].buffer)
+      video_fill++;
+  }
+  if (surface->sample_rate > 0 && surface->n_channels > 0)
+    audio_fill = gst_util_uint64_scale (surface->audio_bytes /
+        (2 * surface->n_channels), GST_SECOND, surface->sample_rate);
+
+  s = gst_structure_new ("inter-channel",
+      "name", G_TYPE_STRING, surface->name,
+      "users", G_TYPE_INT, surface->refcount,
+      "format", GST_TYPE_FOURCC, gst_video_format_to_fourcc (surface->format),
+      "width", G_TYPE_INT, surface->width,
+      "height", G_TYPE_INT, surface->height,
+      "framerate", GST_TYPE_FRACTION, surface->fps_n, MAX (surface->fps_d, 1),
+      "video-depth", G_TYPE_UINT, surface->video_depth,
+      "video-fill", G_TYPE_UINT, video_fill,
+      "rate", G_TYPE_INT, surface->sample_rate,
+      "channels", G_TYPE_INT, surface->n_channels,
+      "audio-fill", G_TYPE_UINT64, audio_fill, NULL);
+  g_mutex_unlock (surface->mutex);
+
+  g_value_init (&v, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&v, s);
+  g_value_array_append (array, &v);
+  g_value_unset (&v);
+}
+
+/* Returns a snapshot of all channels that currently have users, one
+ * "inter-channel" structure per channel with its video format, how many
+ * ring slots are filled and how much audio is queued (in nanoseconds). */
+GValueArray *
+gst_inter_surface_list (void)
+{
+  GValueArray *array;
+
+  g_mutex_lock (registry_lock);
+  array = g_value_array_new (g_hash_table_size (registry));
+  g_hash_table_foreach (registry, gst_inter_surface_describe, array);
+  g_mutex_unlock (registry_lock);
+
+  return array;
 }
 
 void
 gst_inter_surface_init (void)
 {
-  surface = g_malloc0 (sizeof (GstInterSurface));
-  surface->mutex = g_mutex_new ();
-  surface->audio_adapter = gst_adapter_new ();
+  registry_lock = g_mutex_new ();
+  registry = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+/* Buffers that fall out of the video ring or the audio FIFO are handed back
+ * in @garbage instead of being unreffed in place, so that the (possibly
+ * expensive) final unref happens after the surface mutex has been
+ * released. */
+void
+gst_inter_surface_free_garbage (GSList * garbage)
+{
+  g_slist_foreach (garbage, (GFunc) gst_mini_object_unref, NULL);
+  g_slist_free (garbage);
+}
+
+void
+gst_inter_surface_clear_video (GstInterSurface * surface, GSList ** garbage)
+{
+  int i;
+
+  for (i = 0; i < GST_INTER_SURFACE_MAX_VIDEO_DEPTH; i++) {
+    GstInterSurfaceVideoSlot *slot = &surface->video_ring[i];
+
+    if (slot->buffer)
+      *garbage = g_slist_prepend (*garbage, slot->buffer);
+    slot->buffer = NULL;
+    slot->seq = 0;
+    slot->arrival = GST_CLOCK_TIME_NONE;
+  }
+}
+
+void
+gst_inter_surface_set_video_depth (GstInterSurface * surface, guint depth,
+    GSList ** garbage)
+{
+  depth = CLAMP (depth, 1, GST_INTER_SURFACE_MAX_VIDEO_DEPTH);
+  if (depth == surface->video_depth)
+    return;
+
+  /* slot positions depend on the depth, start over */
+  gst_inter_surface_clear_video (surface, garbage);
+  surface->video_depth = depth;
+}
+
+void
+gst_inter_surface_push_video (GstInterSurface * surface, GstBuffer * buffer,
+    GSList ** garbage)
+{
+  GstInterSurfaceVideoSlot *slot;
+
+  surface->video_seq++;
+  slot = &surface->video_ring[surface->video_seq % surface->video_depth];
+  if (slot->buffer)
+    *garbage = g_slist_prepend (*garbage, slot->buffer);
+  slot->buffer = gst_buffer_ref (buffer);
+  slot->seq = surface->video_seq;
+  slot->arrival = gst_util_get_timestamp ();
+}
+
+/* Returns a new reference to the newest frame that arrived at least
+ * @latency ago.  If the ring is too shallow to hold @latency worth of
+ * frames the oldest frame is returned instead.  The sequence number of the
+ * frame is stored in @seq so the caller can tell repeats and skips apart. */
+GstBuffer *
+gst_inter_surface_get_video (GstInterSurface * surface, GstClockTime latency,
+    guint64 * seq)
+{
+  GstInterSurfaceVideoSlot *best = NULL;
+  GstInterSurfaceVideoSlot *oldest = NULL;
+  GstClockTime now;
+  guint i;
+
+  now = gst_util_get_timestamp ();
+
+  for (i = 0; i < surface->video_depth; i++) {
+    GstInterSurfaceVideoSlot *slot = &surface->video_ring[i];
+
+    if (slot->buffer == NULL)
+      continue;
+
+    if (oldest == NULL || slot->seq < oldest->seq)
+      oldest = slot;
+    if (slot->arrival + latency <= now && (best == NULL
+            || slot->seq > best->seq))
+      best = slot;
+  }
+
+  if (best == NULL)
+    best = oldest;
+  if (best == NULL)
+    return NULL;
+
+  *seq = best->seq;
+  return gst_buffer_ref (best->buffer);
+}
+
+static void
+gst_inter_surface_flush_audio (GstInterSurface * surface, guint size,
+    GSList ** garbage)
+{
+  surface->audio_bytes -= size;
+
+  while (size > 0) {
+    GstBuffer *head = surface->audio_ring[surface->audio_head];
+    guint avail = GST_BUFFER_SIZE (head) - surface->audio_offset;
+
+    if (size < avail) {
+      surface->audio_offset += size;
+      break;
+    }
+
+    size -= avail;
+    *garbage = g_slist_prepend (*garbage, head);
+    surface->audio_ring[surface->audio_head] = NULL;
+    surface->audio_head =
+        (surface->audio_head + 1) % GST_INTER_SURFACE_AUDIO_RING_SIZE;
+    surface->audio_n_buffers--;
+    surface->audio_offset = 0;
+  }
+}
+
+/* Appends @buffer to the audio FIFO and returns the number of bytes that
+ * had to be discarded from the head to stay within audio_max_bytes. */
+guint
+gst_inter_surface_push_audio (GstInterSurface * surface, GstBuffer * buffer,
+    GSList ** garbage)
+{
+  guint dropped = 0;
+  guint tail;
+
+  if (surface->audio_n_buffers == GST_INTER_SURFACE_AUDIO_RING_SIZE) {
+    GstBuffer *head = surface->audio_ring[surface->audio_head];
+
+    dropped += GST_BUFFER_SIZE (head) - surface->audio_offset;
+    gst_inter_surface_flush_audio (surface, dropped, garbage);
+  }
+
+  tail = (surface->audio_head + surface->audio_n_buffers) %
+      GST_INTER_SURFACE_AUDIO_RING_SIZE;
+  surface->audio_ring[tail] = gst_buffer_ref (buffer);
+  surface->audio_n_buffers++;
+  surface->audio_bytes += GST_BUFFER_SIZE (buffer);
+
+  if (surface->audio_max_bytes > 0
+      && surface->audio_bytes > surface->audio_max_bytes) {
+    guint excess = surface->audio_bytes - surface->audio_max_bytes;
+
+    gst_inter_surface_flush_audio (surface, excess, garbage);
+    dropped += excess;
+  }
+
+  return dropped;
+}
+
+/* Removes up to @max_size bytes from the oldest queued buffer only, so
+ * that no copy is ever needed.  If the whole remainder of that buffer is
+ * wanted the buffer itself is returned.  Returns NULL if nothing is
+ * queued. */
+GstBuffer *
+gst_inter_surface_take_audio_head (GstInterSurface * surface, guint max_size,
+    GSList ** garbage)
+{
+  GstBuffer *head;
+  guint avail;
+
+  if (surface->audio_n_buffers == 0 || max_size == 0)
+    return NULL;
+
+  head = surface->audio_ring[surface->audio_head];
+  avail = GST_BUFFER_SIZE (head) - surface->audio_offset;
+
+  if (surface->audio_offset == 0 && avail <= max_size) {
+    /* hand over the reference held by the ring */
+    surface->audio_ring[surface->audio_head] = NULL;
+    surface->audio_head =
+        (surface->audio_head + 1) % GST_INTER_SURFACE_AUDIO_RING_SIZE;
+    surface->audio_n_buffers--;
+    surface->audio_bytes -= avail;
+    return head;
+  }
+
+  avail = MIN (avail, max_size);
+  head = gst_buffer_create_sub (head, surface->audio_offset, avail);
+  gst_inter_surface_flush_audio (surface, avail, garbage);
+
+  return head;
+}
+
+void
+gst_inter_surface_clear_audio (GstInterSurface * surface, GSList ** garbage)
+{
+  while (surface->audio_n_buffers > 0) {
+    *garbage = g_slist_prepend (*garbage,
+        surface->audio_ring[surface->audio_head]);
+    surface->audio_ring[surface->audio_head] = NULL;
+    surface->audio_head =
+        (surface->audio_head + 1) % GST_INTER_SURFACE_AUDIO_RING_SIZE;
+    surface->audio_n_buffers--;
+  }
+  surface->audio_head = 0;
+  surface->audio_offset = 0;
+  surface->audio_bytes = 0;
 }
@@ -20,15 +20,38 @@
 #ifndef _GST_INTER_SURFACE_H_
 #define _GST_INTER_SURFACE_H_
 
-#include <gst/base/gstadapter.h>
 #include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
+#define GST_INTER_SURFACE_MAX_VIDEO_DEPTH 32
+#define GST_INTER_SURFACE_AUDIO_RING_SIZE 64
+
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterSurfaceVideoSlot GstInterSurfaceVideoSlot;
+
+/**
+ * GstInterSurfaceVideoSlot:
+ * @buffer: the frame, or NULL if the slot is empty
+ * @seq: running number of the frame, starting at 1
+ * @arrival: time (as returned by gst_util_get_timestamp()) at which the
+ *     sink stored the frame
+ *
+ * One entry of the video frame ring.
+ */
+struct _GstInterSurfaceVideoSlot
+{
+  GstBuffer *buffer;
+  guint64 seq;
+  GstClockTime arrival;
+};
 
 struct _GstInterSurface
 {
+  /* owned by the registry */
+  char *name;
+  int refcount;
+
   GMutex *mutex;
 
   /* video */
@@ -38,20 +61,52 @@ struct _GstInterSurface
   int width;
   int height;
   int n_frames;
-  int video_buffer_count;
+
+  /* ring of the last video_depth frames, the newest one has sequence
+   * number video_seq and lives at index video_seq % video_depth */
+  GstInterSurfaceVideoSlot video_ring[GST_INTER_SURFACE_MAX_VIDEO_DEPTH];
+  guint video_depth;
+  guint64 video_seq;
 
   /* audio */
   int sample_rate;
   int n_channels;
 
-  GstBuffer *video_buffer;
-  GstAdapter *audio_adapter;
+  /* bounded FIFO of audio buffers; audio_offset bytes of the oldest
+   * buffer have already been consumed */
+  GstBuffer *audio_ring[GST_INTER_SURFACE_AUDIO_RING_SIZE];
+  guint audio_head;
+  guint audio_n_buffers;
+  guint audio_offset;
+  guint audio_bytes;
+  guint audio_max_bytes;
 };
 
 
 GstInterSurface * gst_inter_surface_get (const char *name);
+void gst_inter_surface_unref (GstInterSurface *surface);
+GValueArray * gst_inter_surface_list (void);
 void gst_inter_surface_init (void);
 
+/* all of the following must be called with the surface mutex held */
+void gst_inter_surface_set_video_depth (GstInterSurface *surface,
+    guint depth, GSList **garbage);
+void gst_inter_surface_push_video (GstInterSurface *surface,
+    GstBuffer *buffer, GSList **garbage);
+GstBuffer * gst_inter_surface_get_video (GstInterSurface *surface,
+    GstClockTime latency, guint64 *seq);
+void gst_inter_surface_clear_video (GstInterSurface *surface,
+    GSList **garbage);
+
+guint gst_inter_surface_push_audio (GstInterSurface *surface,
+    GstBuffer *buffer, GSList **garbage);
+GstBuffer * gst_inter_surface_take_audio_head (GstInterSurface *surface,
+    guint max_size, GSList **garbage);
+void gst_inter_surface_clear_audio (GstInterSurface *surface,
+    GSList **garbage);
+
+void gst_inter_surface_free_garbage (GSList *garbage);
+
 
 G_END_DECLS
 
@@ -30,6 +30,8 @@
 
 #include <gst/gst.h>
 #include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 //#define GETTEXT_PACKAGE "intertest"
 
@@ -56,6 +58,7 @@ void gst_inter_test_create_pipeline_playbin (GstInterTest * intertest,
     const char *uri);
 void gst_inter_test_start (GstInterTest * intertest);
 void gst_inter_test_stop (GstInterTest * intertest);
+void gst_inter_test_run_benchmark (void);
 
 static gboolean gst_inter_test_handle_message (GstBus * bus,
     GstMessage * message, gpointer data);
@@ -63,9 +66,26 @@ static gboolean onesecond_timer (gpointer priv);
 
 
 gboolean verbose;
+gboolean benchmark;
+int bench_seconds = 10;
+int bench_width = 1920;
+int bench_height = 1080;
+int bench_fps = 60;
+int bench_streams = 1;
 
 static GOptionEntry entries[] = {
   {"verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Be verbose", NULL},
+  {"benchmark", 'b', 0, G_OPTION_ARG_NONE, &benchmark,
+      "Measure the CPU used per routed stream instead of playing", NULL},
+  {"seconds", 's', 0, G_OPTION_ARG_INT, &bench_seconds,
+      "Benchmark duration in seconds", NULL},
+  {"width", 0, 0, G_OPTION_ARG_INT, &bench_width, "Benchmark frame width",
+      NULL},
+  {"height", 0, 0, G_OPTION_ARG_INT, &bench_height, "Benchmark frame height",
+      NULL},
+  {"fps", 0, 0, G_OPTION_ARG_INT, &bench_fps, "Benchmark frame rate", NULL},
+  {"streams", 'n', 0, G_OPTION_ARG_INT, &bench_streams,
+      "Number of inter channels routed in the benchmark", NULL},
 
   {NULL}
 
@@ -92,6 +112,11 @@ main (int argc, char *argv[])
   }
   g_option_context_free (context);
 
+  if (benchmark) {
+    gst_inter_test_run_benchmark ();
+    exit (0);
+  }
+
   intertest1 = gst_inter_test_new ();
   gst_inter_test_create_pipeline_server (intertest1);
   gst_inter_test_start (intertest1);
@@ -254,6 +279,115 @@ gst_inter_test_create_pipeline_server (GstInterTest * intertest)
   intertest->sink_element = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
 }
 
+static double
+get_cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+static gboolean
+benchmark_timeout (gpointer priv)
+{
+  g_main_loop_quit ((GMainLoop *) priv);
+
+  return FALSE;
+}
+
+/* Routes video and audio through --streams inter channels in a single
+ * process and reports the CPU time used per channel.  The sources fill every
+ * frame, so run once with --width=16 --height=16 to get a baseline for the
+ * test source cost. */
+void
+gst_inter_test_run_benchmark (void)
+{
+  GString *pipe_desc;
+  GstElement *pipeline;
+  GError *error = NULL;
+  GMainLoop *main_loop;
+  GTimeVal start_wall, end_wall;
+  double start_cpu, end_cpu, wall;
+  guint64 dropped = 0, repeated = 0;
+  int i;
+
+  bench_streams = MAX (bench_streams, 1);
+
+  pipe_desc = g_string_new ("");
+  for (i = 0; i < bench_streams; i++) {
+    g_string_append_printf (pipe_desc,
+        "videotestsrc is-live=true pattern=black ! "
+        "video/x-raw-yuv,format=(fourcc)I420,width=%d,height=%d,"
+        "framerate=%d/1 ! intervideosink channel=bench%d sync=true ",
+        bench_width, bench_height, bench_fps, i);
+    g_string_append_printf (pipe_desc,
+        "intervideosrc name=src%d channel=bench%d ! "
+        "video/x-raw-yuv,format=(fourcc)I420,width=%d,height=%d,"
+        "framerate=%d/1 ! fakesink sync=true ", i, i, bench_width,
+        bench_height, bench_fps);
+    g_string_append_printf (pipe_desc,
+        "audiotestsrc is-live=true wave=silence samplesperbuffer=1600 ! "
+        "interaudiosink channel=bench%d interaudiosrc channel=bench%d ! "
+        "fakesink sync=true ", i, i);
+  }
+
+  if (verbose)
+    g_print ("pipeline: %s\n", pipe_desc->str);
+
+  pipeline = (GstElement *) gst_parse_launch (pipe_desc->str, &error);
+  g_string_free (pipe_desc, TRUE);
+
+  if (error) {
+    g_print ("pipeline parsing error: %s\n", error->message);
+    return;
+  }
+
+  main_loop = g_main_loop_new (NULL, FALSE);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start_cpu = get_cpu_time ();
+  g_get_current_time (&start_wall);
+
+  g_timeout_add (bench_seconds * 1000, benchmark_timeout, main_loop);
+  g_main_loop_run (main_loop);
+
+  end_cpu = get_cpu_time ();
+  g_get_current_time (&end_wall);
+
+  for (i = 0; i < bench_streams; i++) {
+    GstElement *src;
+    gchar *name;
+    guint64 d, r;
+
+    name = g_strdup_printf ("src%d", i);
+    src = gst_bin_get_by_name (GST_BIN (pipeline), name);
+    g_free (name);
+
+    g_object_get (src, "frames-dropped", &d, "frames-repeated", &r, NULL);
+    dropped += d;
+    repeated += r;
+    gst_object_unref (src);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (main_loop);
+
+  wall = (end_wall.tv_sec - start_wall.tv_sec) +
+      1e-6 * (end_wall.tv_usec - start_wall.tv_usec);
+
+  g_print ("%d x %dx%d@%d: %.1f%% CPU per routed stream, "
+      "%" G_GUINT64_FORMAT " frames dropped, %" G_GUINT64_FORMAT
+      " repeated\n", bench_streams, bench_width, bench_height, bench_fps,
+      100.0 * (end_cpu - start_cpu) / wall / bench_streams, dropped,
+      repeated);
+}
+
 void
 gst_inter_test_start (GstInterTest * intertest)
 {
@@ -76,9 +76,15 @@ static gboolean gst_inter_video_sink_unlock_stop (GstBaseSink * sink);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_DEPTH,
+  PROP_CHANNEL,
+  PROP_CHANNELS
 };
 
+#define DEFAULT_DEPTH 1
+#define DEFAULT_CHANNEL "default"
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -144,6 +150,22 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
   base_sink_class->unlock_stop =
       GST_DEBUG_FUNCPTR (gst_inter_video_sink_unlock_stop);
 
+  g_object_class_install_property (gobject_class, PROP_DEPTH,
+      g_param_spec_uint ("depth", "Depth",
+          "Number of frames kept for intervideosrc to choose from",
+          1, GST_INTER_SURFACE_MAX_VIDEO_DEPTH, DEFAULT_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNEL,
+      g_param_spec_string ("channel", "Channel",
+          "Channel name to match inter src and sink elements, changes take "
+          "effect on the next start", DEFAULT_CHANNEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNELS,
+      g_param_spec_value_array ("channels", "Channels",
+          "All active inter channels with their format and fill level",
+          g_param_spec_boxed ("channel", "Channel", "Channel description",
+              GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -155,16 +177,35 @@ gst_inter_video_sink_init (GstInterVideoSink * intervideosink,
       gst_pad_new_from_static_template (&gst_inter_video_sink_sink_template,
       "sink");
 
-  intervideosink->surface = gst_inter_surface_get ("default");
+  intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->depth = DEFAULT_DEPTH;
 }
 
 void
 gst_inter_video_sink_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object); */
+  GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object);
+  GSList *garbage = NULL;
 
   switch (property_id) {
+    case PROP_DEPTH:
+      /* the object lock keeps stop() from releasing the surface under us */
+      GST_OBJECT_LOCK (intervideosink);
+      intervideosink->depth = g_value_get_uint (value);
+      if (intervideosink->surface) {
+        g_mutex_lock (intervideosink->surface->mutex);
+        gst_inter_surface_set_video_depth (intervideosink->surface,
+            intervideosink->depth, &garbage);
+        g_mutex_unlock (intervideosink->surface->mutex);
+      }
+      GST_OBJECT_UNLOCK (intervideosink);
+      gst_inter_surface_free_garbage (garbage);
+      break;
+    case PROP_CHANNEL:
+      g_free (intervideosink->channel);
+      intervideosink->channel = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -175,9 +216,18 @@ void
 gst_inter_video_sink_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object); */
+  GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object);
 
   switch (property_id) {
+    case PROP_DEPTH:
+      g_value_set_uint (value, intervideosink->depth);
+      break;
+    case PROP_CHANNEL:
+      g_value_set_string (value, intervideosink->channel);
+      break;
+    case PROP_CHANNELS:
+      g_value_take_boxed (value, gst_inter_surface_list ());
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -197,9 +247,10 @@ gst_inter_video_sink_dispose (GObject * object)
 void
 gst_inter_video_sink_finalize (GObject * object)
 {
-  /* GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object); */
+  GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (object);
 
-  /* clean up object here */
+  g_free (intervideosink->channel);
+  intervideosink->channel = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -216,6 +267,26 @@ gst_inter_video_sink_get_caps (GstBaseSink * sink)
 static gboolean
 gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
 {
+  GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstVideoFormat format;
+  int width, height;
+  int fps_n, fps_d;
+
+  if (!gst_video_format_parse_caps (caps, &format, &width, &height) ||
+      !gst_video_parse_caps_framerate (caps, &fps_n, &fps_d))
+    return FALSE;
+
+  intervideosink->fps_n = fps_n;
+  intervideosink->fps_d = fps_d;
+
+  /* only informational, intervideosrc looks at the buffer caps */
+  g_mutex_lock (intervideosink->surface->mutex);
+  intervideosink->surface->format = format;
+  intervideosink->surface->width = width;
+  intervideosink->surface->height = height;
+  intervideosink->surface->fps_n = fps_n;
+  intervideosink->surface->fps_d = fps_d;
+  g_mutex_unlock (intervideosink->surface->mutex);
 
   return TRUE;
 }
@@ -253,6 +324,22 @@ gst_inter_video_sink_get_times (GstBaseSink * sink, GstBuffer * buffer,
 static gboolean
 gst_inter_video_sink_start (GstBaseSink * sink)
 {
+  GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstInterSurface *surface;
+  GSList *garbage = NULL;
+
+  surface = gst_inter_surface_get (intervideosink->channel);
+
+  /* publish the surface and apply the depth in one go, so that a depth set
+   * concurrently is never overwritten by the one read here */
+  GST_OBJECT_LOCK (intervideosink);
+  intervideosink->surface = surface;
+  g_mutex_lock (surface->mutex);
+  gst_inter_surface_set_video_depth (surface, intervideosink->depth,
+      &garbage);
+  g_mutex_unlock (surface->mutex);
+  GST_OBJECT_UNLOCK (intervideosink);
+  gst_inter_surface_free_garbage (garbage);
 
   return TRUE;
 }
@@ -261,13 +348,20 @@ static gboolean
 gst_inter_video_sink_stop (GstBaseSink * sink)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GstInterSurface *surface;
+  GSList *garbage = NULL;
 
-  g_mutex_lock (intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = NULL;
-  g_mutex_unlock (intervideosink->surface->mutex);
+  GST_OBJECT_LOCK (intervideosink);
+  surface = intervideosink->surface;
+  intervideosink->surface = NULL;
+  GST_OBJECT_UNLOCK (intervideosink);
+
+  g_mutex_lock (surface->mutex);
+  gst_inter_surface_clear_video (surface, &garbage);
+  g_mutex_unlock (surface->mutex);
+  gst_inter_surface_free_garbage (garbage);
+
+  gst_inter_surface_unref (surface);
 
   return TRUE;
 }
@@ -298,14 +392,12 @@ static GstFlowReturn
 gst_inter_video_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
+  GSList *garbage = NULL;
 
   g_mutex_lock (intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
+  gst_inter_surface_push_video (intervideosink->surface, buffer, &garbage);
   g_mutex_unlock (intervideosink->surface->mutex);
+  gst_inter_surface_free_garbage (garbage);
 
   return GST_FLOW_OK;
 }
@@ -44,6 +44,9 @@ struct _GstInterVideoSink
 
   int fps_n;
   int fps_d;
+
+  guint depth;
+  char *channel;
 };
 
 struct _GstInterVideoSinkClass
@@ -77,12 +77,22 @@ static gboolean gst_inter_video_src_unlock_stop (GstBaseSrc * src);
 static gboolean
 gst_inter_video_src_prepare_seek_segment (GstBaseSrc * src, GstEvent * seek,
     GstSegment * segment);
+static GstBuffer *gst_inter_video_src_new_black_frame (GstVideoFormat format,
+    int width, int height);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_LATENCY,
+  PROP_FRAMES_DROPPED,
+  PROP_FRAMES_REPEATED,
+  PROP_CHANNEL,
+  PROP_CHANNELS
 };
 
+#define DEFAULT_LATENCY 0
+#define DEFAULT_CHANNEL "default"
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_inter_video_src_src_template =
@@ -156,6 +166,31 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
     base_src_class->prepare_seek_segment =
         GST_DEBUG_FUNCPTR (gst_inter_video_src_prepare_seek_segment);
 
+  g_object_class_install_property (gobject_class, PROP_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency",
+          "How long a frame stays in the intervideosink ring before it is "
+          "output (in nanoseconds), the ring depth must cover this",
+          0, G_MAXUINT64, DEFAULT_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_FRAMES_DROPPED,
+      g_param_spec_uint64 ("frames-dropped", "Frames dropped",
+          "Number of frames from intervideosink that were never output",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_FRAMES_REPEATED,
+      g_param_spec_uint64 ("frames-repeated", "Frames repeated",
+          "Number of times the previous frame was output again",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNEL,
+      g_param_spec_string ("channel", "Channel",
+          "Channel name to match inter src and sink elements, changes take "
+          "effect on the next start", DEFAULT_CHANNEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_CHANNELS,
+      g_param_spec_value_array ("channels", "Channels",
+          "All active inter channels with their format and fill level",
+          g_param_spec_boxed ("channel", "Channel", "Channel description",
+              GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
 }
 
@@ -171,16 +206,24 @@ gst_inter_video_src_init (GstInterVideoSrc * intervideosrc,
   gst_base_src_set_format (GST_BASE_SRC (intervideosrc), GST_FORMAT_TIME);
   gst_base_src_set_live (GST_BASE_SRC (intervideosrc), TRUE);
 
-  intervideosrc->surface = gst_inter_surface_get ("default");
+  intervideosrc->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosrc->latency = DEFAULT_LATENCY;
 }
 
 void
 gst_inter_video_src_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object); */
+  GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object);
 
   switch (property_id) {
+    case PROP_LATENCY:
+      intervideosrc->latency = g_value_get_uint64 (value);
+      break;
+    case PROP_CHANNEL:
+      g_free (intervideosrc->channel);
+      intervideosrc->channel = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -191,9 +234,24 @@ void
 gst_inter_video_src_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object); */
+  GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object);
 
   switch (property_id) {
+    case PROP_LATENCY:
+      g_value_set_uint64 (value, intervideosrc->latency);
+      break;
+    case PROP_FRAMES_DROPPED:
+      g_value_set_uint64 (value, intervideosrc->frames_dropped);
+      break;
+    case PROP_FRAMES_REPEATED:
+      g_value_set_uint64 (value, intervideosrc->frames_repeated);
+      break;
+    case PROP_CHANNEL:
+      g_value_set_string (value, intervideosrc->channel);
+      break;
+    case PROP_CHANNELS:
+      g_value_take_boxed (value, gst_inter_surface_list ());
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -213,9 +271,10 @@ gst_inter_video_src_dispose (GObject * object)
 void
 gst_inter_video_src_finalize (GObject * object)
 {
-  /* GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object); */
+  GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (object);
 
-  /* clean up object here */
+  g_free (intervideosrc->channel);
+  intervideosrc->channel = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -252,6 +311,13 @@ gst_inter_video_src_set_caps (GstBaseSrc * src, GstCaps * caps)
     intervideosrc->fps_n = fps_n;
     intervideosrc->fps_d = fps_d;
     GST_DEBUG ("fps %d/%d", fps_n, fps_d);
+
+    if (intervideosrc->black_frame)
+      gst_buffer_unref (intervideosrc->black_frame);
+    intervideosrc->black_frame =
+        gst_inter_video_src_new_black_frame (format, width, height);
+    /* force the input check to run again */
+    gst_caps_replace (&intervideosrc->in_caps, NULL);
   }
 
   return ret;
@@ -284,6 +350,13 @@ gst_inter_video_src_start (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (intervideosrc, "start");
 
+  intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
+
+  intervideosrc->last_seq = 0;
+  intervideosrc->n_repeats = 0;
+  intervideosrc->frames_dropped = 0;
+  intervideosrc->frames_repeated = 0;
+
   return TRUE;
 }
 
@@ -294,6 +367,15 @@ gst_inter_video_src_stop (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (intervideosrc, "stop");
 
+  if (intervideosrc->black_frame) {
+    gst_buffer_unref (intervideosrc->black_frame);
+    intervideosrc->black_frame = NULL;
+  }
+  gst_caps_replace (&intervideosrc->in_caps, NULL);
+
+  gst_inter_surface_unref (intervideosrc->surface);
+  intervideosrc->surface = NULL;
+
   return TRUE;
 }
 
@@ -354,57 +436,155 @@ gst_inter_video_src_event (GstBaseSrc * src, GstEvent * event)
   return TRUE;
 }
 
+static GstBuffer *
+gst_inter_video_src_new_black_frame (GstVideoFormat format, int width,
+    int height)
+{
+  GstBuffer *buffer;
+  guint8 *data;
+
+  buffer =
+      gst_buffer_new_and_alloc (gst_video_format_get_size (format, width,
+          height));
+
+  data = GST_BUFFER_DATA (buffer);
+  memset (data, 16,
+      gst_video_format_get_row_stride (format, 0, width) *
+      gst_video_format_get_component_height (format, 0, height));
+
+  memset (data + gst_video_format_get_component_offset (format, 1, width,
+          height), 128,
+      2 * gst_video_format_get_row_stride (format, 1, width) *
+      gst_video_format_get_component_height (format, 1, height));
+
+  return buffer;
+}
+
+/* Returns TRUE if frames with @caps can be pushed out as they are */
+static gboolean
+gst_inter_video_src_check_input (GstInterVideoSrc * intervideosrc,
+    GstCaps * caps)
+{
+  /* no caps on the buffer, nothing to compare against */
+  if (caps == NULL)
+    return TRUE;
+
+  /* the caps are kept alive, so the pointer compare is safe */
+  if (caps != intervideosrc->in_caps) {
+    gst_caps_replace (&intervideosrc->in_caps, caps);
+    if (!gst_video_format_parse_caps (caps, &intervideosrc->in_format,
+            &intervideosrc->in_width, &intervideosrc->in_height)) {
+      intervideosrc->in_format = GST_VIDEO_FORMAT_UNKNOWN;
+    }
+    GST_DEBUG_OBJECT (intervideosrc, "input is now %dx%d",
+        intervideosrc->in_width, intervideosrc->in_height);
+  }
+
+  return intervideosrc->in_format == intervideosrc->format &&
+      intervideosrc->in_width == intervideosrc->width &&
+      intervideosrc->in_height == intervideosrc->height;
+}
+
+/* Slow path for frames that don't match the negotiated size: the top left
+ * part that fits is copied onto black, anything else is cropped. */
+static GstBuffer *
+gst_inter_video_src_convert_frame (GstInterVideoSrc * intervideosrc,
+    GstBuffer * in)
+{
+  GstVideoFormat format = intervideosrc->format;
+  GstBuffer *out;
+  int i, j;
+
+  if (intervideosrc->in_format != format) {
+    GST_WARNING_OBJECT (intervideosrc, "unhandled input format");
+    return NULL;
+  }
+
+  if (GST_BUFFER_SIZE (in) < gst_video_format_get_size (format,
+          intervideosrc->in_width, intervideosrc->in_height))
+    return NULL;
+
+  out = gst_buffer_copy (intervideosrc->black_frame);
+
+  for (i = 0; i < 3; i++) {
+    guint8 *src_data, *dest_data;
+    int src_stride, dest_stride;
+    int w, h;
+
+    src_data = GST_BUFFER_DATA (in) +
+        gst_video_format_get_component_offset (format, i,
+        intervideosrc->in_width, intervideosrc->in_height);
+    dest_data = GST_BUFFER_DATA (out) +
+        gst_video_format_get_component_offset (format, i,
+        intervideosrc->width, intervideosrc->height);
+    src_stride = gst_video_format_get_row_stride (format, i,
+        intervideosrc->in_width);
+    dest_stride = gst_video_format_get_row_stride (format, i,
+        intervideosrc->width);
+    w = MIN (gst_video_format_get_component_width (format, i,
+            intervideosrc->in_width),
+        gst_video_format_get_component_width (format, i,
+            intervideosrc->width));
+    h = MIN (gst_video_format_get_component_height (format, i,
+            intervideosrc->in_height),
+        gst_video_format_get_component_height (format, i,
+            intervideosrc->height));
+
+    for (j = 0; j < h; j++) {
+      memcpy (dest_data + j * dest_stride, src_data + j * src_stride, w);
+    }
+  }
+
+  return out;
+}
+
 static GstFlowReturn
 gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
   GstBuffer *buffer;
-  guint8 *data;
+  guint64 seq = 0;
 
   GST_DEBUG_OBJECT (intervideosrc, "create");
 
-  buffer = NULL;
-
   g_mutex_lock (intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_buffer) {
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
-    intervideosrc->surface->video_buffer_count++;
-    if (intervideosrc->surface->video_buffer_count >= 30) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
+  buffer = gst_inter_surface_get_video (intervideosrc->surface,
+      intervideosrc->latency, &seq);
+  g_mutex_unlock (intervideosrc->surface->mutex);
+
+  if (buffer) {
+    if (seq == intervideosrc->last_seq) {
+      intervideosrc->n_repeats++;
+      if (intervideosrc->n_repeats >= 30) {
+        /* the sink stalled, fall back to black */
+        gst_buffer_unref (buffer);
+        buffer = NULL;
+      } else {
+        intervideosrc->frames_repeated++;
+      }
+    } else {
+      if (intervideosrc->last_seq > 0 && seq > intervideosrc->last_seq + 1) {
+        GST_LOG_OBJECT (intervideosrc, "skipped %" G_GUINT64_FORMAT
+            " frames", seq - intervideosrc->last_seq - 1);
+        intervideosrc->frames_dropped += seq - intervideosrc->last_seq - 1;
+      }
+      intervideosrc->last_seq = seq;
+      intervideosrc->n_repeats = 0;
     }
   }
-  g_mutex_unlock (intervideosrc->surface->mutex);
 
-  if (buffer == NULL) {
-    buffer =
-        gst_buffer_new_and_alloc (gst_video_format_get_size
-        (intervideosrc->format, intervideosrc->width, intervideosrc->height));
-
-    data = GST_BUFFER_DATA (buffer);
-    memset (data, 16,
-        gst_video_format_get_row_stride (intervideosrc->format, 0,
-            intervideosrc->width) *
-        gst_video_format_get_component_height (intervideosrc->format, 0,
-            intervideosrc->height));
+  if (buffer && !gst_inter_video_src_check_input (intervideosrc,
+          GST_BUFFER_CAPS (buffer))) {
+    GstBuffer *frame = gst_inter_video_src_convert_frame (intervideosrc,
+        buffer);
 
-    memset (data + gst_video_format_get_component_offset (intervideosrc->format,
-            1, intervideosrc->width, intervideosrc->height),
-        128,
-        2 * gst_video_format_get_row_stride (intervideosrc->format, 1,
-            intervideosrc->width) *
-        gst_video_format_get_component_height (intervideosrc->format, 1,
-            intervideosrc->height));
+    gst_buffer_unref (buffer);
+    buffer = frame;
+  }
 
-#if 0
-    {
-      int i;
-      for (i = 0; i < 10000; i++) {
-        data[i] = g_random_int () & 0xff;
-      }
-    }
-#endif
+  if (buffer == NULL) {
+    buffer = gst_buffer_ref (intervideosrc->black_frame);
   }
 
   buffer = gst_buffer_make_metadata_writable (buffer);
@@ -48,6 +48,20 @@ struct _GstInterVideoSrc
   int n_frames;
   int width;
   int height;
+  GstBuffer *black_frame;
+
+  /* layout of the frames coming from intervideosink */
+  GstCaps *in_caps;
+  GstVideoFormat in_format;
+  int in_width;
+  int in_height;
+
+  char *channel;
+  GstClockTime latency;
+  guint64 last_seq;
+  int n_repeats;
+  guint64 frames_dropped;
+  guint64 frames_repeated;
 };
 
 struct _GstInterVideoSrcClass
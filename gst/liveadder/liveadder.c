@@ -32,6 +32,13 @@
  * The live adder allows to mix several streams into one by adding the data.
  * Mixed data is clamped to the min/max values of the data format.
  *
+ * Each sink pad has #GstLiveAdderPad:volume and #GstLiveAdderPad:mute
+ * properties that are applied while mixing, so there is no need for a volume
+ * element in front of the pads. With #GstLiveAdder:soft-clip, the peaks of
+ * float streams are rounded off instead of being passed on above full
+ * scale. Unsigned samples are mixed and scaled around the middle of their
+ * range, which is their silence.
+ *
  * Unlike the adder, the liveadder mixes the streams according the their
  * timestamps and waits for some milli-seconds before trying doing the mixing.
  *
@@ -43,12 +50,30 @@
 #endif
 
 #include "liveadder.h"
+#include "gstliveadderorc.h"
 
 #include <gst/audio/audio.h>
 
 #include <string.h>
 
 #define DEFAULT_LATENCY_MS 60
+#define DEFAULT_SOFT_CLIP FALSE
+
+#define DEFAULT_PAD_VOLUME 1.0
+#define DEFAULT_PAD_MUTE FALSE
+#define MAX_PAD_VOLUME 10.0
+
+/* fractional bits of the volume for the integer formats, the largest that
+ * still fit the maximum volume in the multiplier */
+#define VOLUME_SHIFT_INT16 11
+#define VOLUME_SHIFT_INT32 27
+
+/* duration of the slots of the mix ring, and so of the output buffers */
+#define SLOT_DURATION (10 * GST_MSECOND)
+/* the ring covers twice the latency plus this, and grows up to the
+ * maximum if the inputs are further apart */
+#define RING_MARGIN (100 * GST_MSECOND)
+#define RING_MAX_DURATION (10 * GST_SECOND)
 
 GST_DEBUG_CATEGORY_STATIC (live_adder_debug);
 #define GST_CAT_DEFAULT (live_adder_debug)
@@ -80,8 +105,42 @@ enum
 {
   PROP_0,
   PROP_LATENCY,
+  PROP_SOFT_CLIP
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_VOLUME,
+  PROP_PAD_MUTE
 };
 
+#define GST_TYPE_LIVE_ADDER_PAD \
+  (gst_live_adder_pad_get_type())
+#define GST_LIVE_ADDER_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_LIVE_ADDER_PAD, GstLiveAdderPad))
+#define GST_LIVE_ADDER_PAD_CAST(obj) \
+  ((GstLiveAdderPad *)(obj))
+
+typedef struct _GstLiveAdderPad GstLiveAdderPad;
+typedef struct _GstLiveAdderPadClass GstLiveAdderPadClass;
+
+struct _GstLiveAdderPad
+{
+  GstPad parent;
+
+  /* protected by the object lock of the pad */
+  gdouble volume;
+  gboolean mute;
+};
+
+struct _GstLiveAdderPadClass
+{
+  GstPadClass parent;
+};
+
+static GType gst_live_adder_pad_get_type (void);
+
 typedef struct _GstLiveAdderPadPrivate
 {
   GstSegment segment;
@@ -125,33 +184,141 @@ static gboolean gst_live_adder_sink_event (GstPad * pad, GstEvent * event);
 
 static void reset_pad_private (GstPad * pad);
 
-/* clipping versions */
-#define MAKE_FUNC(name,type,ttype,min,max)                      \
+/* the integer versions saturate, the float versions don't clip */
+#define MAKE_FUNC(name,type)                                    \
 static void name (type *out, type *in, gint bytes) {            \
-  gint i;                                                       \
-  for (i = 0; i < bytes / sizeof (type); i++)                   \
-    out[i] = CLAMP ((ttype)out[i] + (ttype)in[i], min, max);    \
+  orc_live_adder_##name (out, in, bytes / sizeof (type));       \
 }
 
-/* non-clipping versions (for float) */
-#define MAKE_FUNC_NC(name,type,ttype)                           \
-static void name (type *out, type *in, gint bytes) {            \
+/* versions scaling the input by the volume first, in fixed point for the
+ * integer formats */
+#define MAKE_VOLUME_FUNC(name,type,param)                       \
+static void name (type *out, type *in, gint bytes,              \
+    gdouble volume) {                                           \
+  orc_live_adder_##name (out, in, param, bytes / sizeof (type)); \
+}
+
+/* unsigned samples are rare, mix them in C. Their silence is bias, half of
+ * their range, which is taken off the input before scaling it */
+#define MAKE_UNSIGNED_FUNC(name,type,max)                       \
+static void name (type *out, type *in, gint bytes,              \
+    gdouble volume, guint32 bias) {                             \
   gint i;                                                       \
-  for (i = 0; i < bytes / sizeof (type); i++)                   \
-    out[i] = (ttype)out[i] + (ttype)in[i];                      \
+  for (i = 0; i < bytes / sizeof (type); i++) {                 \
+    gdouble v = out[i] + ((gdouble) in[i] - bias) * volume;     \
+    out[i] = CLAMP (v + 0.5, 0, max);                           \
+  }                                                             \
 }
 
 /* *INDENT-OFF* */
-MAKE_FUNC (add_int32, gint32, gint64, G_MININT32, G_MAXINT32)
-MAKE_FUNC (add_int16, gint16, gint32, G_MININT16, G_MAXINT16)
-MAKE_FUNC (add_int8, gint8, gint16, G_MININT8, G_MAXINT8)
-MAKE_FUNC (add_uint32, guint32, guint64, 0, G_MAXUINT32)
-MAKE_FUNC (add_uint16, guint16, guint32, 0, G_MAXUINT16)
-MAKE_FUNC (add_uint8, guint8, guint16, 0, G_MAXUINT8)
-MAKE_FUNC_NC (add_float64, gdouble, gdouble)
-MAKE_FUNC_NC (add_float32, gfloat, gfloat)
+MAKE_FUNC (add_int32, gint32)
+MAKE_FUNC (add_int16, gint16)
+MAKE_FUNC (add_int8, gint8)
+MAKE_FUNC (add_float64, gdouble)
+MAKE_FUNC (add_float32, gfloat)
+
+MAKE_VOLUME_FUNC (add_volume_int32, gint32,
+    (gint) (volume * (1 << VOLUME_SHIFT_INT32) + 0.5))
+MAKE_VOLUME_FUNC (add_volume_int16, gint16,
+    (gint) (volume * (1 << VOLUME_SHIFT_INT16) + 0.5))
+MAKE_VOLUME_FUNC (add_volume_int8, gint8,
+    (gint) (volume * (1 << VOLUME_SHIFT_INT16) + 0.5))
+MAKE_VOLUME_FUNC (add_volume_float64, gdouble, volume)
+MAKE_VOLUME_FUNC (add_volume_float32, gfloat, volume)
+
+MAKE_UNSIGNED_FUNC (add_uint32, guint32, G_MAXUINT32)
+MAKE_UNSIGNED_FUNC (add_uint16, guint16, G_MAXUINT16)
+MAKE_UNSIGNED_FUNC (add_uint8, guint8, G_MAXUINT8)
 /* *INDENT-ON* */
 
+/* same curve as orc_live_adder_soft_clip_float32 */
+static void
+soft_clip_float64 (gdouble * out, const gdouble * in, guint n_samples)
+{
+  guint i;
+
+  for (i = 0; i < n_samples; i++) {
+    gdouble a = ABS (in[i]);
+    gdouble v = CLAMP (a - 0.5, 0.0, 1.0);
+
+    a = MIN (a, 0.5) + v - v * v * 0.5;
+    out[i] = in[i] < 0 ? -a : a;
+  }
+}
+
+G_DEFINE_TYPE (GstLiveAdderPad, gst_live_adder_pad, GST_TYPE_PAD);
+
+static void
+gst_live_adder_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLiveAdderPad *pad = GST_LIVE_ADDER_PAD_CAST (object);
+
+  switch (prop_id) {
+    case PROP_PAD_VOLUME:
+      GST_OBJECT_LOCK (pad);
+      pad->volume = g_value_get_double (value);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    case PROP_PAD_MUTE:
+      GST_OBJECT_LOCK (pad);
+      pad->mute = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_live_adder_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstLiveAdderPad *pad = GST_LIVE_ADDER_PAD_CAST (object);
+
+  switch (prop_id) {
+    case PROP_PAD_VOLUME:
+      GST_OBJECT_LOCK (pad);
+      g_value_set_double (value, pad->volume);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    case PROP_PAD_MUTE:
+      GST_OBJECT_LOCK (pad);
+      g_value_set_boolean (value, pad->mute);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_live_adder_pad_class_init (GstLiveAdderPadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_live_adder_pad_set_property;
+  gobject_class->get_property = gst_live_adder_pad_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_VOLUME,
+      g_param_spec_double ("volume", "Volume", "Volume of this stream",
+          0.0, MAX_PAD_VOLUME, DEFAULT_PAD_VOLUME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_PAD_MUTE,
+      g_param_spec_boolean ("mute", "Mute", "Mute this stream",
+          DEFAULT_PAD_MUTE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_live_adder_pad_init (GstLiveAdderPad * pad)
+{
+  pad->volume = DEFAULT_PAD_VOLUME;
+  pad->mute = DEFAULT_PAD_MUTE;
+}
+
 
 static void
 gst_live_adder_base_init (gpointer klass)
@@ -186,6 +353,11 @@ gst_live_adder_class_init (GstLiveAdderClass * klass)
       g_param_spec_uint ("latency", "Buffer latency in ms",
           "Amount of data to buffer", 0, G_MAXUINT, DEFAULT_LATENCY_MS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SOFT_CLIP,
+      g_param_spec_boolean ("soft-clip", "Soft clip",
+          "Round off the peaks of the mixed float samples above half of full "
+          "scale instead of passing them on above full scale",
+          DEFAULT_SOFT_CLIP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -208,13 +380,14 @@ gst_live_adder_init (GstLiveAdder * adder, GstLiveAdderClass * klass)
   adder->format = GST_LIVE_ADDER_FORMAT_UNSET;
   adder->padcount = 0;
   adder->func = NULL;
+  adder->volume_func = NULL;
+  adder->unsigned_func = NULL;
   adder->not_empty_cond = g_cond_new ();
 
   adder->next_timestamp = GST_CLOCK_TIME_NONE;
 
   adder->latency_ms = DEFAULT_LATENCY_MS;
-
-  adder->buffers = g_queue_new ();
+  adder->soft_clip = DEFAULT_SOFT_CLIP;
 }
 
 
@@ -225,10 +398,8 @@ gst_live_adder_finalize (GObject * object)
 
   g_cond_free (adder->not_empty_cond);
 
-  g_queue_foreach (adder->buffers, (GFunc) gst_mini_object_unref, NULL);
-  while (g_queue_pop_head (adder->buffers)) {
-  }
-  g_queue_free (adder->buffers);
+  g_free (adder->ring);
+  g_free (adder->slots);
 
   g_list_free (adder->sinkpads);
 
@@ -265,6 +436,11 @@ gst_live_adder_set_property (GObject * object,
       }
       break;
     }
+    case PROP_SOFT_CLIP:
+      GST_OBJECT_LOCK (adder);
+      adder->soft_clip = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (adder);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -284,6 +460,11 @@ gst_live_adder_get_property (GObject * object,
       g_value_set_uint (value, adder->latency_ms);
       GST_OBJECT_UNLOCK (adder);
       break;
+    case PROP_SOFT_CLIP:
+      GST_OBJECT_LOCK (adder);
+      g_value_set_boolean (value, adder->soft_clip);
+      GST_OBJECT_UNLOCK (adder);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -291,6 +472,354 @@ gst_live_adder_get_property (GObject * object,
 }
 
 
+/* Mix ring, all called with the object lock */
+
+static void
+gst_live_adder_ring_free (GstLiveAdder * adder)
+{
+  g_free (adder->ring);
+  adder->ring = NULL;
+  g_free (adder->slots);
+  adder->slots = NULL;
+  adder->n_slots = 0;
+  adder->n_filled = 0;
+  adder->read_offset = 0;
+}
+
+static guint64
+gst_live_adder_samples (GstLiveAdder * adder, GstClockTime time)
+{
+  return gst_util_uint64_scale_int_round (time, adder->rate, GST_SECOND);
+}
+
+static GstClockTime
+gst_live_adder_sample_time (GstLiveAdder * adder, guint64 offset)
+{
+  return gst_util_uint64_scale_int_round (offset, GST_SECOND, adder->rate);
+}
+
+/* Moves the empty ring to start shortly before offset, leaving room for
+ * the other inputs within the latency. The samples before the new start
+ * are too late to be mixed */
+static void
+gst_live_adder_ring_rebase (GstLiveAdder * adder, guint64 offset)
+{
+  guint64 start, latency;
+  guint i;
+
+  latency = gst_live_adder_samples (adder,
+      adder->latency_ms * GST_MSECOND + adder->peer_latency);
+  start = MAX (offset - MIN (offset, latency), adder->read_offset);
+
+  adder->read_offset = start;
+  adder->ring_read = 0;
+  adder->ring_offset = start - start % adder->slot_samples;
+  for (i = 0; i < adder->n_slots; i++)
+    adder->slots[i].fill_start = adder->slots[i].fill_end = 0;
+
+  /* the start of the first slot was already pushed */
+  if (adder->read_offset > adder->ring_offset)
+    adder->slots[0].fill_start = adder->slots[0].fill_end =
+        adder->read_offset - adder->ring_offset;
+}
+
+static void
+gst_live_adder_ring_init (GstLiveAdder * adder, guint64 offset)
+{
+  GstClockTime duration;
+
+  adder->slot_samples = MAX (gst_live_adder_samples (adder, SLOT_DURATION), 1);
+  duration = 2 * (adder->latency_ms * GST_MSECOND + adder->peer_latency) +
+      RING_MARGIN;
+  adder->n_slots = gst_live_adder_samples (adder, duration) /
+      adder->slot_samples + 1;
+  adder->ring = g_malloc (adder->n_slots * adder->slot_samples * adder->bps);
+  adder->slots = g_new0 (GstLiveAdderSlot, adder->n_slots);
+  adder->n_filled = 0;
+
+  GST_DEBUG_OBJECT (adder, "mix ring of %u slots of %u samples",
+      adder->n_slots, adder->slot_samples);
+
+  gst_live_adder_ring_rebase (adder, offset);
+}
+
+/* Makes the ring cover the samples up to end, returns FALSE if it would be
+ * too large */
+static gboolean
+gst_live_adder_ring_grow (GstLiveAdder * adder, guint64 end)
+{
+  GstLiveAdderSlot *slots;
+  guint8 *ring;
+  guint64 n_slots;
+  guint slot_size, i;
+
+  n_slots = (end - adder->ring_offset + adder->slot_samples - 1) /
+      adder->slot_samples;
+  if (n_slots <= adder->n_slots)
+    return TRUE;
+
+  if (gst_live_adder_sample_time (adder, n_slots * adder->slot_samples) >
+      RING_MAX_DURATION)
+    return FALSE;
+
+  n_slots = MAX (n_slots, 2 * adder->n_slots);
+  slot_size = adder->slot_samples * adder->bps;
+
+  GST_DEBUG_OBJECT (adder, "growing the mix ring to %u slots",
+      (guint) n_slots);
+
+  ring = g_malloc (n_slots * slot_size);
+  slots = g_new0 (GstLiveAdderSlot, n_slots);
+  for (i = 0; i < adder->n_slots; i++) {
+    guint index = (adder->ring_read + i) % adder->n_slots;
+
+    slots[i] = adder->slots[index];
+    if (slots[i].fill_start != slots[i].fill_end)
+      memcpy (ring + i * slot_size, adder->ring + index * slot_size,
+          slot_size);
+  }
+
+  g_free (adder->ring);
+  g_free (adder->slots);
+  adder->ring = ring;
+  adder->slots = slots;
+  adder->n_slots = n_slots;
+  adder->ring_read = 0;
+
+  return TRUE;
+}
+
+/* Fills size bytes with silence, which is not 0 for unsigned samples */
+static void
+gst_live_adder_fill_silence (GstLiveAdder * adder, guint8 * mem, guint size)
+{
+  guint i;
+
+  if (adder->bias == 0) {
+    memset (mem, 0, size);
+    return;
+  }
+
+  switch (adder->width) {
+    case 8:
+      memset (mem, adder->bias, size);
+      break;
+    case 16:
+      for (i = 0; i < size / 2; i++)
+        ((guint16 *) mem)[i] = adder->bias;
+      break;
+    case 32:
+      for (i = 0; i < size / 4; i++)
+        ((guint32 *) mem)[i] = adder->bias;
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+/* Copies size bytes of data scaled by volume, or silence if data is NULL */
+static void
+gst_live_adder_copy (GstLiveAdder * adder, guint8 * mem, guint8 * data,
+    guint size, gdouble volume)
+{
+  if (data && volume == 1.0) {
+    memcpy (mem, data, size);
+  } else {
+    gst_live_adder_fill_silence (adder, mem, size);
+    if (data == NULL)
+      return;
+
+    if (adder->unsigned_func)
+      adder->unsigned_func (mem, data, size, volume, adder->bias);
+    else
+      adder->volume_func (mem, data, size, volume);
+  }
+}
+
+/* Adds size bytes of data scaled by volume, nothing if data is NULL */
+static void
+gst_live_adder_add (GstLiveAdder * adder, guint8 * mem, guint8 * data,
+    guint size, gdouble volume)
+{
+  if (data == NULL)
+    return;
+
+  if (adder->unsigned_func)
+    adder->unsigned_func (mem, data, size, volume, adder->bias);
+  else if (volume == 1.0)
+    adder->func (mem, data, size);
+  else
+    adder->volume_func (mem, data, size, volume);
+}
+
+/* Mixes the samples [start, end) of the slot with data scaled by volume,
+ * silence if data is NULL. The samples not in the slot yet are copied, the
+ * others are added, and the gap between them, if any, is filled with
+ * silence */
+static void
+gst_live_adder_slot_mix (GstLiveAdder * adder, GstLiveAdderSlot * slot,
+    guint8 * mem, guint start, guint end, guint8 * data, gdouble volume)
+{
+  guint bps = adder->bps;
+  guint fill_start = slot->fill_start, fill_end = slot->fill_end;
+  guint mix_start, mix_end;
+
+#define DATA_AT(offset) (data ? data + ((offset) - start) * bps : NULL)
+
+  if (fill_start == fill_end) {
+    gst_live_adder_copy (adder, mem + start * bps, data, (end - start) * bps,
+        volume);
+    slot->fill_start = start;
+    slot->fill_end = end;
+    adder->n_filled++;
+    return;
+  }
+
+  if (end < fill_start)
+    gst_live_adder_fill_silence (adder, mem + end * bps,
+        (fill_start - end) * bps);
+  else if (start > fill_end)
+    gst_live_adder_fill_silence (adder, mem + fill_end * bps,
+        (start - fill_end) * bps);
+
+  if (start < fill_start)
+    gst_live_adder_copy (adder, mem + start * bps, data,
+        (MIN (end, fill_start) - start) * bps, volume);
+
+  mix_start = MAX (start, fill_start);
+  mix_end = MIN (end, fill_end);
+  if (mix_start < mix_end)
+    gst_live_adder_add (adder, mem + mix_start * bps, DATA_AT (mix_start),
+        (mix_end - mix_start) * bps, volume);
+
+  if (end > fill_end) {
+    mix_start = MAX (start, fill_end);
+    gst_live_adder_copy (adder, mem + mix_start * bps, DATA_AT (mix_start),
+        (end - mix_start) * bps, volume);
+  }
+
+#undef DATA_AT
+
+  slot->fill_start = MIN (start, fill_start);
+  slot->fill_end = MAX (end, fill_end);
+}
+
+/* Mixes n_samples samples starting at offset, which must not be before
+ * read_offset, into the slots they cover. data is NULL for silence */
+static gboolean
+gst_live_adder_ring_mix (GstLiveAdder * adder, guint64 offset, guint8 * data,
+    guint n_samples, gdouble volume)
+{
+  guint64 end = offset + n_samples;
+  guint slot_size = adder->slot_samples * adder->bps;
+
+  if (adder->n_filled == 0 &&
+      end > adder->ring_offset + adder->n_slots * adder->slot_samples)
+    gst_live_adder_ring_rebase (adder, offset);
+
+  if (!gst_live_adder_ring_grow (adder, end))
+    return FALSE;
+
+  while (offset < end) {
+    guint i = (offset - adder->ring_offset) / adder->slot_samples;
+    guint index = (adder->ring_read + i) % adder->n_slots;
+    guint64 slot_offset = adder->ring_offset + i * adder->slot_samples;
+    guint start = offset - slot_offset;
+    guint stop = MIN (end - slot_offset, adder->slot_samples);
+
+    gst_live_adder_slot_mix (adder, &adder->slots[index],
+        adder->ring + index * slot_size, start, stop, data, volume);
+
+    if (data)
+      data += (stop - start) * adder->bps;
+    offset = slot_offset + stop;
+  }
+
+  return TRUE;
+}
+
+/* Returns the position in the ring of the first slot holding data, or -1 */
+static gint
+gst_live_adder_ring_first (GstLiveAdder * adder)
+{
+  guint i;
+
+  if (adder->n_filled == 0)
+    return -1;
+
+  for (i = 0; i < adder->n_slots; i++) {
+    GstLiveAdderSlot *slot =
+        &adder->slots[(adder->ring_read + i) % adder->n_slots];
+
+    if (slot->fill_start != slot->fill_end)
+      return i;
+  }
+
+  g_assert_not_reached ();
+  return -1;
+}
+
+/* Returns the data of the first slot holding some and frees it. A slot
+ * pushed before being full stays first to receive the rest of its
+ * samples */
+static GstBuffer *
+gst_live_adder_ring_pop (GstLiveAdder * adder)
+{
+  GstLiveAdderSlot *slot;
+  GstBuffer *buffer;
+  guint8 *data;
+  guint64 start, end;
+  guint slot_size;
+  gint i;
+
+  i = gst_live_adder_ring_first (adder);
+  if (i < 0)
+    return NULL;
+
+  /* skip the empty slots */
+  for (; i > 0; i--) {
+    slot = &adder->slots[adder->ring_read];
+    slot->fill_start = slot->fill_end = 0;
+    adder->ring_read = (adder->ring_read + 1) % adder->n_slots;
+    adder->ring_offset += adder->slot_samples;
+  }
+
+  slot = &adder->slots[adder->ring_read];
+  slot_size = adder->slot_samples * adder->bps;
+  start = adder->ring_offset + slot->fill_start;
+  end = adder->ring_offset + slot->fill_end;
+
+  data = adder->ring + adder->ring_read * slot_size +
+      slot->fill_start * adder->bps;
+  buffer = gst_buffer_new_and_alloc ((end - start) * adder->bps);
+  if (adder->soft_clip && adder->format == GST_LIVE_ADDER_FORMAT_FLOAT) {
+    if (adder->width == 32)
+      orc_live_adder_soft_clip_float32 ((gfloat *) GST_BUFFER_DATA (buffer),
+          (gfloat *) data, GST_BUFFER_SIZE (buffer) / sizeof (gfloat));
+    else
+      soft_clip_float64 ((gdouble *) GST_BUFFER_DATA (buffer),
+          (gdouble *) data, GST_BUFFER_SIZE (buffer) / sizeof (gdouble));
+  } else {
+    memcpy (GST_BUFFER_DATA (buffer), data, GST_BUFFER_SIZE (buffer));
+  }
+  GST_BUFFER_TIMESTAMP (buffer) = gst_live_adder_sample_time (adder, start);
+  GST_BUFFER_DURATION (buffer) = gst_live_adder_sample_time (adder, end) -
+      GST_BUFFER_TIMESTAMP (buffer);
+  gst_buffer_set_caps (buffer, GST_PAD_CAPS (adder->srcpad));
+
+  adder->n_filled--;
+  adder->read_offset = end;
+  if (slot->fill_end == adder->slot_samples) {
+    slot->fill_start = slot->fill_end = 0;
+    adder->ring_read = (adder->ring_read + 1) % adder->n_slots;
+    adder->ring_offset += adder->slot_samples;
+  } else {
+    slot->fill_start = slot->fill_end;
+  }
+
+  return buffer;
+}
+
 /* we can only accept caps that we and downstream can handle. */
 static GstCaps *
 gst_live_adder_sink_getcaps (GstPad * pad)
@@ -366,33 +895,48 @@ gst_live_adder_setcaps (GstPad * pad, GstCaps * caps)
 
     switch (adder->width) {
       case 8:
-        adder->func = (adder->is_signed ?
-            (GstLiveAdderFunction) add_int8 : (GstLiveAdderFunction) add_uint8);
+        adder->func = (GstLiveAdderFunction) add_int8;
+        adder->volume_func = (GstLiveAdderVolumeFunction) add_volume_int8;
+        adder->unsigned_func = (GstLiveAdderUnsignedFunction) add_uint8;
         break;
       case 16:
-        adder->func = (adder->is_signed ?
-            (GstLiveAdderFunction) add_int16 : (GstLiveAdderFunction)
-            add_uint16);
+        adder->func = (GstLiveAdderFunction) add_int16;
+        adder->volume_func = (GstLiveAdderVolumeFunction) add_volume_int16;
+        adder->unsigned_func = (GstLiveAdderUnsignedFunction) add_uint16;
         break;
       case 32:
-        adder->func = (adder->is_signed ?
-            (GstLiveAdderFunction) add_int32 : (GstLiveAdderFunction)
-            add_uint32);
+        adder->func = (GstLiveAdderFunction) add_int32;
+        adder->volume_func = (GstLiveAdderVolumeFunction) add_volume_int32;
+        adder->unsigned_func = (GstLiveAdderUnsignedFunction) add_uint32;
         break;
       default:
         goto not_supported;
     }
+
+    if (adder->depth < 1 || adder->depth > adder->width)
+      goto not_supported;
+
+    if (adder->is_signed) {
+      adder->unsigned_func = NULL;
+      adder->bias = 0;
+    } else {
+      adder->bias = 1U << (adder->depth - 1);
+    }
   } else if (strcmp (media_type, "audio/x-raw-float") == 0) {
     GST_DEBUG_OBJECT (adder, "parse_caps sets adder to format float");
     adder->format = GST_LIVE_ADDER_FORMAT_FLOAT;
     gst_structure_get_int (structure, "width", &adder->width);
+    adder->unsigned_func = NULL;
+    adder->bias = 0;
 
     switch (adder->width) {
       case 32:
         adder->func = (GstLiveAdderFunction) add_float32;
+        adder->volume_func = (GstLiveAdderVolumeFunction) add_volume_float32;
         break;
       case 64:
         adder->func = (GstLiveAdderFunction) add_float64;
+        adder->volume_func = (GstLiveAdderVolumeFunction) add_volume_float64;
         break;
       default:
         goto not_supported;
@@ -406,6 +950,9 @@ gst_live_adder_setcaps (GstPad * pad, GstCaps * caps)
   /* precalc bps */
   adder->bps = (adder->width / 8) * adder->channels;
 
+  /* the mix ring is sized for the old format */
+  gst_live_adder_ring_free (adder);
+
   GST_OBJECT_UNLOCK (adder);
   return TRUE;
 
@@ -427,9 +974,8 @@ gst_live_adder_flush_start (GstLiveAdder * adder)
   /* mark ourselves as flushing */
   adder->srcresult = GST_FLOW_WRONG_STATE;
 
-  /* Empty the queue */
-  g_queue_foreach (adder->buffers, (GFunc) gst_mini_object_unref, NULL);
-  while (g_queue_pop_head (adder->buffers));
+  /* Empty the mix ring */
+  gst_live_adder_ring_free (adder);
 
   /* unlock clock, we just unschedule, the entry will be released by the
    * locking streaming thread. */
@@ -871,24 +1417,20 @@ gst_live_adder_src_event (GstPad * pad, GstEvent * event)
   return result;
 }
 
-static guint
-gst_live_adder_length_from_duration (GstLiveAdder * adder,
-    GstClockTime duration)
-{
-  guint64 ret = (duration * adder->rate / GST_SECOND) * adder->bps;
-
-  return (guint) ret;
-}
-
 static GstFlowReturn
 gst_live_live_adder_chain (GstPad * pad, GstBuffer * buffer)
 {
   GstLiveAdder *adder = GST_LIVE_ADDER (gst_pad_get_parent_element (pad));
   GstLiveAdderPadPrivate *padprivate = NULL;
   GstFlowReturn ret = GST_FLOW_OK;
-  GList *item = NULL;
-  GstClockTime skip = 0;
+  GstLiveAdderPad *lapad = GST_LIVE_ADDER_PAD_CAST (pad);
+  guint64 offset, n_samples, skip = 0;
   gint64 drift = 0;             /* Positive if new buffer after old buffer */
+  gdouble volume;
+
+  GST_OBJECT_LOCK (lapad);
+  volume = lapad->mute ? 0.0 : lapad->volume;
+  GST_OBJECT_UNLOCK (lapad);
 
   GST_OBJECT_LOCK (adder);
 
@@ -934,6 +1476,9 @@ gst_live_live_adder_chain (GstPad * pad, GstBuffer * buffer)
   if (padprivate->segment.format != GST_FORMAT_TIME)
     goto invalid_segment;
 
+  if (adder->bps == 0 || adder->rate == 0)
+    goto not_negotiated;
+
   buffer = gst_buffer_make_metadata_writable (buffer);
 
   drift = GST_BUFFER_TIMESTAMP (buffer) - padprivate->expected_timestamp;
@@ -992,10 +1537,15 @@ gst_live_live_adder_chain (GstPad * pad, GstBuffer * buffer)
       padprivate->segment.format, GST_BUFFER_TIMESTAMP (buffer));
 
 
-  if (GST_CLOCK_TIME_IS_VALID (adder->next_timestamp) &&
-      GST_BUFFER_TIMESTAMP (buffer) < adder->next_timestamp) {
-    if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <
-        adder->next_timestamp) {
+  offset = gst_live_adder_samples (adder, GST_BUFFER_TIMESTAMP (buffer));
+  n_samples = GST_BUFFER_SIZE (buffer) / adder->bps;
+
+  if (adder->ring == NULL)
+    gst_live_adder_ring_init (adder, offset);
+
+  /* the samples before read_offset were pushed already */
+  if (offset < adder->read_offset) {
+    if (offset + n_samples <= adder->read_offset) {
       GST_DEBUG_OBJECT (adder, "Buffer is late, dropping (ts: %" GST_TIME_FORMAT
           " duration: %" GST_TIME_FORMAT ")",
           GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)),
@@ -1003,107 +1553,29 @@ gst_live_live_adder_chain (GstPad * pad, GstBuffer * buffer)
       gst_buffer_unref (buffer);
       goto out;
     } else {
-      skip = adder->next_timestamp - GST_BUFFER_TIMESTAMP (buffer);
+      skip = adder->read_offset - offset;
       GST_DEBUG_OBJECT (adder, "Buffer is partially late, skipping %"
-          GST_TIME_FORMAT, GST_TIME_ARGS (skip));
+          G_GUINT64_FORMAT " samples", skip);
     }
   }
 
-  /* If our new buffer's head is higher than the queue's head, lets wake up,
-   * we may not have to wait for as long
+  /* If our new buffer's head is before the one the task is waiting for,
+   * lets wake up, we may not have to wait for as long
    */
-  if (adder->clock_id &&
-      g_queue_peek_head (adder->buffers) != NULL &&
-      GST_BUFFER_TIMESTAMP (buffer) + skip <
-      GST_BUFFER_TIMESTAMP (g_queue_peek_head (adder->buffers)))
+  if (adder->clock_id && offset + skip < adder->wait_offset)
     gst_clock_id_unschedule (adder->clock_id);
 
-  for (item = g_queue_peek_head_link (adder->buffers);
-      item; item = g_list_next (item)) {
-    GstBuffer *oldbuffer = item->data;
-    GstClockTime old_skip = 0;
-    GstClockTime mix_duration = 0;
-    GstClockTime mix_start = 0;
-    GstClockTime mix_end = 0;
-
-    /* We haven't reached our place yet */
-    if (GST_BUFFER_TIMESTAMP (buffer) + skip >=
-        GST_BUFFER_TIMESTAMP (oldbuffer) + GST_BUFFER_DURATION (oldbuffer))
-      continue;
-
-    /* We're past our place, lets insert ouselves here */
-    if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <=
-        GST_BUFFER_TIMESTAMP (oldbuffer))
-      break;
-
-    /* if we reach this spot, we have overlap, so we must mix */
-
-    /* First make a subbuffer with the non-overlapping part */
-    if (GST_BUFFER_TIMESTAMP (buffer) + skip < GST_BUFFER_TIMESTAMP (oldbuffer)) {
-      GstBuffer *subbuffer = NULL;
-      GstClockTime subbuffer_duration = GST_BUFFER_TIMESTAMP (oldbuffer) -
-          (GST_BUFFER_TIMESTAMP (buffer) + skip);
-
-      subbuffer = gst_buffer_create_sub (buffer,
-          gst_live_adder_length_from_duration (adder, skip),
-          gst_live_adder_length_from_duration (adder, subbuffer_duration));
-
-      GST_BUFFER_TIMESTAMP (subbuffer) = GST_BUFFER_TIMESTAMP (buffer) + skip;
-      GST_BUFFER_DURATION (subbuffer) = subbuffer_duration;
-
-      skip += subbuffer_duration;
-
-      g_queue_insert_before (adder->buffers, item, subbuffer);
-    }
-
-    /* Now we are on the overlapping part */
-    oldbuffer = gst_buffer_make_writable (oldbuffer);
-    item->data = oldbuffer;
-
-    old_skip = GST_BUFFER_TIMESTAMP (buffer) + skip -
-        GST_BUFFER_TIMESTAMP (oldbuffer);
-
-    mix_start = GST_BUFFER_TIMESTAMP (oldbuffer) + old_skip;
-
-    if (GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer) <
-        GST_BUFFER_TIMESTAMP (oldbuffer) + GST_BUFFER_DURATION (oldbuffer))
-      mix_end = GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer);
-    else
-      mix_end = GST_BUFFER_TIMESTAMP (oldbuffer) +
-          GST_BUFFER_DURATION (oldbuffer);
-
-    mix_duration = mix_end - mix_start;
-
-    adder->func (GST_BUFFER_DATA (oldbuffer) +
-        gst_live_adder_length_from_duration (adder, old_skip),
-        GST_BUFFER_DATA (buffer) +
-        gst_live_adder_length_from_duration (adder, skip),
-        gst_live_adder_length_from_duration (adder, mix_duration));
-
-    skip += mix_duration;
+  /* a muted stream still produces silence, but without reading it */
+  if (!gst_live_adder_ring_mix (adder, offset + skip,
+          volume > 0.0 ? GST_BUFFER_DATA (buffer) + skip * adder->bps : NULL,
+          n_samples - skip, volume)) {
+    GST_WARNING_OBJECT (adder, "Buffer at %" GST_TIME_FORMAT " is too far "
+        "ahead of the mixed data, dropping",
+        GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)));
   }
 
   g_cond_broadcast (adder->not_empty_cond);
-
-  if (skip == GST_BUFFER_DURATION (buffer)) {
-    gst_buffer_unref (buffer);
-  } else {
-    if (skip) {
-      GstClockTime subbuffer_duration = GST_BUFFER_DURATION (buffer) - skip;
-      GstClockTime subbuffer_ts = GST_BUFFER_TIMESTAMP (buffer) + skip;
-
-      buffer = gst_buffer_create_sub (buffer,
-          gst_live_adder_length_from_duration (adder, skip),
-          gst_live_adder_length_from_duration (adder, subbuffer_duration));
-      GST_BUFFER_TIMESTAMP (buffer) = subbuffer_ts;
-      GST_BUFFER_DURATION (buffer) = subbuffer_duration;
-    }
-
-    if (item)
-      g_queue_insert_before (adder->buffers, item, buffer);
-    else
-      g_queue_push_tail (adder->buffers, buffer);
-  }
+  gst_buffer_unref (buffer);
 
 out:
 
@@ -1134,6 +1606,15 @@ invalid_segment:
     return GST_FLOW_ERROR;
   }
 
+not_negotiated:
+  {
+    GST_OBJECT_UNLOCK (adder);
+    gst_buffer_unref (buffer);
+    GST_DEBUG_OBJECT (adder, "Buffer received before the format was set");
+    gst_object_unref (adder);
+
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
 }
 
 /*
@@ -1167,6 +1648,7 @@ gst_live_adder_loop (gpointer data)
   GstLiveAdder *adder = GST_LIVE_ADDER (data);
   GstClockTime buffer_timestamp = 0;
   GstClockTime sync_time = 0;
+  gint first;
   GstClock *clock = NULL;
   GstClockID id = NULL;
   GstClockReturn ret;
@@ -1181,14 +1663,17 @@ again:
   for (;;) {
     if (adder->srcresult != GST_FLOW_OK)
       goto flushing;
-    if (!g_queue_is_empty (adder->buffers))
+    if (adder->n_filled > 0)
       break;
     if (check_eos_locked (adder))
       goto eos;
     g_cond_wait (adder->not_empty_cond, GST_OBJECT_GET_LOCK (adder));
   }
 
-  buffer_timestamp = GST_BUFFER_TIMESTAMP (g_queue_peek_head (adder->buffers));
+  first = gst_live_adder_ring_first (adder);
+  adder->wait_offset = adder->ring_offset + first * adder->slot_samples +
+      adder->slots[(adder->ring_read + first) % adder->n_slots].fill_start;
+  buffer_timestamp = gst_live_adder_sample_time (adder, adder->wait_offset);
 
   clock = GST_ELEMENT_CLOCK (adder);
 
@@ -1238,7 +1723,7 @@ again:
 
 push_buffer:
 
-  buffer = g_queue_pop_head (adder->buffers);
+  buffer = gst_live_adder_ring_pop (adder);
 
   if (!buffer)
     goto again;
@@ -1384,7 +1869,8 @@ gst_live_adder_request_new_pad (GstElement * element, GstPadTemplate * templ,
 #endif
 
   name = g_strdup_printf ("sink%d", padcount);
-  newpad = gst_pad_new_from_template (templ, name);
+  newpad = g_object_new (GST_TYPE_LIVE_ADDER_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
   GST_DEBUG_OBJECT (adder, "request new pad %s", name);
   g_free (name);
 
@@ -1492,6 +1978,7 @@ gst_live_adder_change_state (GstElement * element, GstStateChange transition)
       adder->segment_pending = TRUE;
       adder->peer_latency = 0;
       adder->next_timestamp = GST_CLOCK_TIME_NONE;
+      gst_live_adder_ring_free (adder);
       g_list_foreach (adder->sinkpads, (GFunc) reset_pad_private, NULL);
       GST_OBJECT_UNLOCK (adder);
       break;
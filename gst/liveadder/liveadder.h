@@ -47,6 +47,18 @@ typedef enum
 } GstLiveAdderFormat;
 
 typedef void (*GstLiveAdderFunction) (gpointer out, gpointer in, guint size);
+typedef void (*GstLiveAdderVolumeFunction) (gpointer out, gpointer in,
+    guint size, gdouble volume);
+typedef void (*GstLiveAdderUnsignedFunction) (gpointer out, gpointer in,
+    guint size, gdouble volume, guint32 bias);
+
+/* The samples of a slot of the mix ring that hold data, empty when
+ * fill_start == fill_end */
+typedef struct
+{
+  guint fill_start;
+  guint fill_end;
+} GstLiveAdderSlot;
 
 /**
  * GstLiveAdder:
@@ -66,8 +78,19 @@ struct _GstLiveAdder
   GstFlowReturn srcresult;
   GstClockID clock_id;
 
-  /* the queue is ordered head to tail */
-  GQueue *buffers;
+  /* the mix ring: n_slots slots of slot_samples samples, the slot at
+   * ring_read starts at sample ring_offset of the running time. The input
+   * buffers are mixed in the slots they cover and each slot is pushed as
+   * one buffer */
+  guint8 *ring;
+  GstLiveAdderSlot *slots;
+  guint n_slots;
+  guint slot_samples;
+  guint ring_read;
+  guint64 ring_offset;
+  guint n_filled;               /* number of slots holding data */
+  guint64 read_offset;          /* the samples before were pushed */
+  guint64 wait_offset;          /* sample the task is waiting to push */
   GCond *not_empty_cond;
 
   GstClockTime next_timestamp;
@@ -88,6 +111,13 @@ struct _GstLiveAdder
 
   /* function to add samples */
   GstLiveAdderFunction func;
+  /* function to add samples scaled by the volume of their pad */
+  GstLiveAdderVolumeFunction volume_func;
+  /* used instead of both for unsigned samples, whose silence is bias */
+  GstLiveAdderUnsignedFunction unsigned_func;
+  guint32 bias;
+
+  gboolean soft_clip;
 
   GstClockTime latency_ms;
   GstClockTime peer_latency;
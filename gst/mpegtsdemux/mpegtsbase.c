@@ -62,6 +62,8 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
 enum
 {
   ARG_0,
+  PROP_PACKETS_PROCESSED,
+  PROP_PACKETS_DROPPED,
   /* FILL ME */
 };
 
@@ -85,6 +87,7 @@ static void mpegts_base_get_tags_from_sdt (MpegTSBase * base,
     GstStructure * sdt_info);
 static void mpegts_base_get_tags_from_eit (MpegTSBase * base,
     GstStructure * eit_info);
+static void mpegts_base_update_pid_interest (MpegTSBase * base);
 
 GST_BOILERPLATE_FULL (MpegTSBase, mpegts_base, GstElement, GST_TYPE_ELEMENT,
     _extra_init);
@@ -184,6 +187,16 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
   gobject_class->dispose = mpegts_base_dispose;
   gobject_class->finalize = mpegts_base_finalize;
 
+  g_object_class_install_property (gobject_class, PROP_PACKETS_PROCESSED,
+      g_param_spec_uint64 ("packets-processed", "Packets processed",
+          "Number of packets that were parsed", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PACKETS_DROPPED,
+      g_param_spec_uint64 ("packets-dropped", "Packets dropped",
+          "Number of packets dropped right after the header because nobody "
+          "wants their PID", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -198,6 +211,9 @@ mpegts_base_reset (MpegTSBase * base)
   /* PAT */
   MPEGTS_BIT_SET (base->known_psi, 0);
 
+  base->packetizer->packets_processed = 0;
+  base->packetizer->packets_dropped = 0;
+
   /* FIXME : Commenting the Following lines is to be in sync with the following
    * commit
    *
@@ -214,6 +230,8 @@ mpegts_base_reset (MpegTSBase * base)
 
   if (klass->reset)
     klass->reset (base);
+
+  mpegts_base_update_pid_interest (base);
 }
 
 static void
@@ -236,6 +254,7 @@ mpegts_base_init (MpegTSBase * base, MpegTSBaseClass * klass)
 
   base->is_pes = g_new0 (guint8, 1024);
   base->known_psi = g_new0 (guint8, 1024);
+  base->pid_interest = g_new0 (guint8, 1024);
   mpegts_base_reset (base);
   base->program_size = sizeof (MpegTSBaseProgram);
   base->stream_size = sizeof (MpegTSBaseStream);
@@ -257,6 +276,7 @@ mpegts_base_dispose (GObject * object)
     base->disposed = TRUE;
     g_free (base->known_psi);
     g_free (base->is_pes);
+    g_free (base->pid_interest);
   }
 
   if (G_OBJECT_CLASS (parent_class)->dispose)
@@ -294,9 +314,15 @@ static void
 mpegts_base_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* MpegTSBase *base = GST_MPEGTS_BASE (object); */
+  MpegTSBase *base = GST_MPEGTS_BASE (object);
 
   switch (prop_id) {
+    case PROP_PACKETS_PROCESSED:
+      g_value_set_uint64 (value, base->packetizer->packets_processed);
+      break;
+    case PROP_PACKETS_DROPPED:
+      g_value_set_uint64 (value, base->packetizer->packets_dropped);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -469,6 +495,87 @@ mpegts_base_remove_program (MpegTSBase * base, gint program_number)
       klass->program_stopped (base, program);
   }
   g_hash_table_remove (base->programs, GINT_TO_POINTER (program_number));
+
+  mpegts_base_update_pid_interest (base);
+}
+
+static void
+mpegts_base_program_clear_interest (gpointer key, MpegTSBaseProgram * program,
+    MpegTSBase * base)
+{
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+  GList *tmp;
+
+  if (program->pmt_info == NULL || klass->is_program_wanted (base, program))
+    return;
+
+  for (tmp = program->stream_list; tmp; tmp = tmp->next)
+    MPEGTS_BIT_UNSET (base->pid_interest,
+        ((MpegTSBaseStream *) tmp->data)->pid);
+}
+
+static void
+mpegts_base_program_set_interest (gpointer key, MpegTSBaseProgram * program,
+    MpegTSBase * base)
+{
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+  GList *tmp;
+
+  if (program->pmt_pid != G_MAXUINT16)
+    MPEGTS_BIT_SET (base->pid_interest, program->pmt_pid);
+
+  if (program->pmt_info == NULL || !klass->is_program_wanted (base, program))
+    return;
+
+  for (tmp = program->stream_list; tmp; tmp = tmp->next)
+    MPEGTS_BIT_SET (base->pid_interest, ((MpegTSBaseStream *) tmp->data)->pid);
+}
+
+/* Recomputes the PID interest bitmap. Everything is wanted except null
+ * packets and the streams of programs the subclass doesn't want, unless
+ * they are shared with a program it wants. PIDs we know nothing about stay
+ * wanted so that PSI tables on them can still be found. Must be called from
+ * the streaming thread */
+static void
+mpegts_base_update_pid_interest (MpegTSBase * base)
+{
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+
+  g_atomic_int_set (&base->pid_interest_dirty, FALSE);
+
+  if (klass->is_program_wanted == NULL) {
+    mpegts_packetizer_set_pid_filter (base->packetizer, NULL);
+    return;
+  }
+
+  memset (base->pid_interest, 0xff, 1024);
+  MPEGTS_BIT_UNSET (base->pid_interest, 0x1fff);
+  g_hash_table_foreach (base->programs,
+      (GHFunc) mpegts_base_program_clear_interest, base);
+  g_hash_table_foreach (base->programs,
+      (GHFunc) mpegts_base_program_set_interest, base);
+
+  mpegts_packetizer_set_pid_filter (base->packetizer, base->pid_interest);
+}
+
+/* Subclasses call this when the answer of is_program_wanted changes, the
+ * bitmap is recomputed before the next buffer is processed. Can be called
+ * from any thread */
+void
+mpegts_base_invalidate_pid_interest (MpegTSBase * base)
+{
+  g_atomic_int_set (&base->pid_interest_dirty, TRUE);
+}
+
+/* Recomputes the PID interest bitmap if it was invalidated. Called before
+ * data is pushed into the packetizer, in push mode from the chain function
+ * and in pull mode from the loop and from the subclass' own pulls. Must be
+ * called from the streaming thread or with the stream lock held */
+void
+mpegts_base_check_pid_interest (MpegTSBase * base)
+{
+  if (G_UNLIKELY (g_atomic_int_get (&base->pid_interest_dirty)))
+    mpegts_base_update_pid_interest (base);
 }
 
 static MpegTSBaseStream *
@@ -784,6 +891,8 @@ mpegts_base_apply_pmt (MpegTSBase * base,
     klass->program_started (base, program);
   }
 
+  mpegts_base_update_pid_interest (base);
+
   GST_DEBUG_OBJECT (base, "new pmt %" GST_PTR_FORMAT, pmt_info);
 
   gst_element_post_message (GST_ELEMENT_CAST (base),
@@ -1106,6 +1215,8 @@ mpegts_base_chain (GstPad * pad, GstBuffer * buf)
   base = GST_MPEGTS_BASE (gst_object_get_parent (GST_OBJECT (pad)));
   packetizer = base->packetizer;
 
+  mpegts_base_check_pid_interest (base);
+
   mpegts_packetizer_push (base->packetizer, buf);
   while (((pret =
               mpegts_packetizer_next_packet (base->packetizer,
@@ -1137,8 +1248,7 @@ mpegts_base_chain (GstPad * pad, GstBuffer * buf)
     } else if (MPEGTS_BIT_IS_SET (base->is_pes, packet.pid)) {
       /* push the packet downstream */
       res = mpegts_base_push (base, &packet, NULL);
-    } else
-      gst_buffer_unref (packet.buffer);
+    }
 
   next:
     mpegts_packetizer_clear_packet (base->packetizer, &packet);
@@ -1158,6 +1268,8 @@ mpegts_base_scan (MpegTSBase * base)
 
   GST_DEBUG ("Scanning for initial sync point");
 
+  mpegts_base_check_pid_interest (base);
+
   /* Find initial sync point */
   for (i = 0; i < 10; i++) {
     GST_DEBUG ("Grabbing %d => %d",
@@ -1205,6 +1317,9 @@ static void
 mpegts_base_loop (MpegTSBase * base)
 {
   GstFlowReturn ret = GST_FLOW_ERROR;
+
+  mpegts_base_check_pid_interest (base);
+
   switch (base->mode) {
     case BASE_MODE_SCANNING:
       /* Find first sync point */
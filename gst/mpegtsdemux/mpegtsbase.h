@@ -111,6 +111,12 @@ struct _MpegTSBase {
   guint8 *known_psi;
   guint8 *is_pes;
 
+  /* PIDs whose packets somebody wants, only used if the subclass implements
+   * is_program_wanted. The packetizer drops packets of the other PIDs before
+   * they get parsed any further. Recomputed from the streaming thread */
+  guint8 *pid_interest;
+  volatile gint pid_interest_dirty;
+
   gboolean disposed;
 
   /* size of the MpegTSBaseProgram structure, can be overridden
@@ -149,6 +155,11 @@ struct _MpegTSBaseClass {
   /* stream_removed is called whenever a stream is no longer referenced */
   void (*stream_removed) (MpegTSBase *base, MpegTSBaseStream *stream);
 
+  /* is_program_wanted is called to find out whether the packets of the
+   * streams of a program need to be handled. If not implemented all packets
+   * are handled */
+  gboolean (*is_program_wanted) (MpegTSBase *base, MpegTSBaseProgram *program);
+
   /* find_timestamps is called to find PCR */
   GstFlowReturn (*find_timestamps) (MpegTSBase * base, guint64 initoff, guint64 *offset);
 
@@ -186,6 +197,9 @@ gboolean mpegts_base_handle_psi (MpegTSBase * base, MpegTSPacketizerSection * se
 void mpegts_base_program_remove_stream (MpegTSBase * base, MpegTSBaseProgram * program, guint16 pid);
 
 void mpegts_base_remove_program(MpegTSBase *base, gint program_number);
+
+void mpegts_base_invalidate_pid_interest (MpegTSBase *base);
+void mpegts_base_check_pid_interest (MpegTSBase *base);
 G_END_DECLS
 
 #endif /* GST_MPEG_TS_BASE_H */
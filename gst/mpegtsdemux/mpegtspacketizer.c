@@ -140,6 +140,24 @@ mpegts_packetizer_clear_section (MpegTSPacketizer2 * packetizer,
   stream->section_table_id = TABLE_ID_UNSET;
 }
 
+static void
+mpegts_packetizer_drop_chunk (MpegTSPacketizer2 * packetizer)
+{
+  if (packetizer->chunk) {
+    gst_buffer_unref (packetizer->chunk);
+    packetizer->chunk = NULL;
+  }
+  packetizer->chunk_pos = 0;
+}
+
+static inline guint
+mpegts_packetizer_chunk_available (MpegTSPacketizer2 * packetizer)
+{
+  if (packetizer->chunk == NULL)
+    return 0;
+  return GST_BUFFER_SIZE (packetizer->chunk) - packetizer->chunk_pos;
+}
+
 static void
 mpegts_packetizer_class_init (MpegTSPacketizer2Class * klass)
 {
@@ -159,6 +177,8 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->empty = TRUE;
   packetizer->streams = g_new0 (MpegTSPacketizerStream *, 8192);
   packetizer->know_packet_size = FALSE;
+  packetizer->chunk = NULL;
+  packetizer->chunk_pos = 0;
 }
 
 static void
@@ -181,6 +201,7 @@ mpegts_packetizer_dispose (GObject * object)
       g_free (packetizer->streams);
     }
 
+    mpegts_packetizer_drop_chunk (packetizer);
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
     packetizer->disposed = TRUE;
@@ -268,7 +289,7 @@ mpegts_packetizer_parse_adaptation_field_control (MpegTSPacketizer2 *
   return TRUE;
 }
 
-static gboolean
+static MpegTSPacketizerPacketReturn
 mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
 {
@@ -279,6 +300,14 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
 
   packet->payload_unit_start_indicator = (*data >> 6) & 0x01;
   packet->pid = GST_READ_UINT16_BE (data) & 0x1FFF;
+
+  if (packetizer->pid_filter &&
+      !(packetizer->pid_filter[packet->pid / 8] & (1 << (packet->pid % 8)))) {
+    packetizer->packets_dropped++;
+    return PACKET_DROPPED;
+  }
+  packetizer->packets_processed++;
+
   data += 2;
 
   packet->adaptation_field_control = (*data >> 4) & 0x03;
@@ -289,14 +318,14 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
 
   if (packet->adaptation_field_control & 0x02)
     if (!mpegts_packetizer_parse_adaptation_field_control (packetizer, packet))
-      return FALSE;
+      return PACKET_BAD;
 
   if (packet->adaptation_field_control & 0x01)
     packet->payload = packet->data;
   else
     packet->payload = NULL;
 
-  return TRUE;
+  return PACKET_OK;
 }
 
 static gboolean
@@ -2079,6 +2108,7 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
     memset (packetizer->streams, 0, 8192 * sizeof (MpegTSPacketizerStream *));
   }
 
+  mpegts_packetizer_drop_chunk (packetizer);
   gst_adapter_clear (packetizer->adapter);
   packetizer->offset = 0;
   packetizer->empty = TRUE;
@@ -2096,6 +2126,7 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer)
       }
     }
   }
+  mpegts_packetizer_drop_chunk (packetizer);
   gst_adapter_flush (packetizer->adapter, packetizer->adapter->size);
 
   packetizer->offset = 0;
@@ -2113,6 +2144,14 @@ mpegts_packetizer_remove_stream (MpegTSPacketizer2 * packetizer, gint16 pid)
   }
 }
 
+/* @pid_filter is not copied and must stay valid as long as it is set */
+void
+mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 * packetizer,
+    const guint8 * pid_filter)
+{
+  packetizer->pid_filter = pid_filter;
+}
+
 MpegTSPacketizer2 *
 mpegts_packetizer_new (void)
 {
@@ -2137,10 +2176,84 @@ mpegts_packetizer_push (MpegTSPacketizer2 * packetizer, GstBuffer * buffer)
   gst_adapter_push (packetizer->adapter, buffer);
 }
 
+#define SYNC_BYTES G_GUINT64_CONSTANT (0x4747474747474747)
+#define LOW7_BITS G_GUINT64_CONSTANT (0x7f7f7f7f7f7f7f7f)
+
+/* Sets bit n of @bitmap if data[n] is a sync byte. Bytes are compared 8 at a
+ * time: after xor'ing with 0x47..47 the usual SWAR zero byte test leaves the
+ * high bit set in every byte that matched, and the multiply gathers those 8
+ * bits into the top byte. @bitmap must hold (size + 63) / 64 words */
+static void
+mpegts_packetizer_sync_bitmap (const guint8 * data, guint size,
+    guint64 * bitmap)
+{
+  guint i;
+
+  memset (bitmap, 0, ((size + 63) / 64) * sizeof (guint64));
+
+  for (i = 0; i + 8 <= size; i += 8) {
+    guint64 x;
+
+    memcpy (&x, data + i, 8);
+    x = GUINT64_FROM_LE (x) ^ SYNC_BYTES;
+    x = ~(((x & LOW7_BITS) + LOW7_BITS) | x | LOW7_BITS);
+    if (x)
+      bitmap[i / 64] |= (((x >> 7) *
+              G_GUINT64_CONSTANT (0x0102040810204080)) >> 56) << (i % 64);
+  }
+  for (; i < size; i++) {
+    if (data[i] == 0x47)
+      bitmap[i / 64] |= G_GUINT64_CONSTANT (1) << (i % 64);
+  }
+}
+
+/* Returns the 64 bits of @bitmap starting at bit @pos. Bits past @nbits
+ * are 0 */
+static inline guint64
+mpegts_packetizer_bitmap_get (const guint64 * bitmap, guint nbits, guint pos)
+{
+  guint nwords = (nbits + 63) / 64;
+  guint word = pos / 64, shift = pos % 64;
+  guint64 res;
+
+  if (word >= nwords)
+    return 0;
+
+  res = bitmap[word] >> shift;
+  if (shift && word + 1 < nwords)
+    res |= bitmap[word + 1] << (64 - shift);
+
+  return res;
+}
+
+/* Returns a mask of the positions @pos to @pos + 63 that hold a sync byte
+ * followed by @count - 1 more sync bytes, @stride bytes apart */
+static inline guint64
+mpegts_packetizer_sync_candidates (const guint64 * bitmap, guint nbits,
+    guint pos, guint stride, guint count)
+{
+  guint64 res = ~G_GUINT64_CONSTANT (0);
+  guint i;
+
+  for (i = 0; i < count && res; i++)
+    res &= mpegts_packetizer_bitmap_get (bitmap, nbits, pos + i * stride);
+
+  return res;
+}
+
+static inline guint
+mpegts_packetizer_lowest_bit (guint64 mask)
+{
+  if (mask & G_GUINT64_CONSTANT (0xffffffff))
+    return g_bit_nth_lsf ((gulong) (mask & 0xffffffff), -1);
+  return 32 + g_bit_nth_lsf ((gulong) (mask >> 32), -1);
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
   guint8 *dest;
+  guint64 bitmap[(MPEGTS_MAX_PACKETSIZE * 4 + 63) / 64];
   int i, pos = -1, j;
   static const guint psizes[] = {
     MPEGTS_NORMAL_PACKETSIZE,
@@ -2156,30 +2269,47 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 
     /* check for sync bytes */
     gst_adapter_copy (packetizer->adapter, dest, 0, MPEGTS_MAX_PACKETSIZE * 4);
-    /* find first sync byte */
+    mpegts_packetizer_sync_bitmap (dest, MPEGTS_MAX_PACKETSIZE * 4, bitmap);
+
+    /* find the first sync byte followed by 3 more at any of the packet
+     * sizes, checking all packet sizes on 64 positions at once */
     pos = -1;
-    for (i = 0; i < MPEGTS_MAX_PACKETSIZE; i++) {
-      if (dest[i] == 0x47) {
-        for (j = 0; j < 4; j++) {
-          guint packetsize = psizes[j];
-          /* check each of the packet size possibilities in turn */
-          if (dest[i] == 0x47 && dest[i + packetsize] == 0x47 &&
-              dest[i + packetsize * 2] == 0x47 &&
-              dest[i + packetsize * 3] == 0x47) {
-            packetizer->know_packet_size = TRUE;
-            packetizer->packet_size = packetsize;
-            packetizer->caps = gst_caps_new_simple ("video/mpegts",
-                "systemstream", G_TYPE_BOOLEAN, TRUE,
-                "packetsize", G_TYPE_INT, packetsize, NULL);
-            if (packetsize == MPEGTS_M2TS_PACKETSIZE)
-              pos = i - 4;
-            else
-              pos = i;
-            break;
-          }
+    for (i = 0; i < MPEGTS_MAX_PACKETSIZE; i += 64) {
+      guint64 candidates[G_N_ELEMENTS (psizes)], any = 0;
+      guint bit;
+
+      for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
+        candidates[j] = mpegts_packetizer_sync_candidates (bitmap,
+            MPEGTS_MAX_PACKETSIZE * 4, i, psizes[j], 4);
+        /* M2TS packets start 4 bytes before their sync byte */
+        if (psizes[j] == MPEGTS_M2TS_PACKETSIZE && i == 0)
+          candidates[j] &= ~G_GUINT64_CONSTANT (0xf);
+        any |= candidates[j];
+      }
+      if (MPEGTS_MAX_PACKETSIZE - i < 64)
+        any &= (G_GUINT64_CONSTANT (1) << (MPEGTS_MAX_PACKETSIZE - i)) - 1;
+      if (!any)
+        continue;
+
+      bit = mpegts_packetizer_lowest_bit (any);
+      /* check each of the packet size possibilities in turn */
+      for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
+        guint packetsize = psizes[j];
+
+        if (candidates[j] & (G_GUINT64_CONSTANT (1) << bit)) {
+          packetizer->know_packet_size = TRUE;
+          packetizer->packet_size = packetsize;
+          packetizer->caps = gst_caps_new_simple ("video/mpegts",
+              "systemstream", G_TYPE_BOOLEAN, TRUE,
+              "packetsize", G_TYPE_INT, packetsize, NULL);
+          if (packetsize == MPEGTS_M2TS_PACKETSIZE)
+            pos = i + bit - 4;
+          else
+            pos = i + bit;
+          break;
         }
-        break;
       }
+      break;
     }
 
     if (packetizer->know_packet_size)
@@ -2200,9 +2330,6 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
       GST_DEBUG ("Flushing out %d bytes", pos);
       gst_adapter_flush (packetizer->adapter, pos);
       packetizer->offset += pos;
-    } else if (!packetizer->know_packet_size) {
-      /* drop invalid data and move to the next possible packets */
-      gst_adapter_flush (packetizer->adapter, MPEGTS_MAX_PACKETSIZE);
     }
   }
 
@@ -2216,14 +2343,104 @@ mpegts_packetizer_has_packets (MpegTSPacketizer2 * packetizer)
     if (!mpegts_try_discover_packet_size (packetizer))
       return FALSE;
   }
-  return packetizer->adapter->size >= packetizer->packet_size;
+  return mpegts_packetizer_chunk_available (packetizer) +
+      packetizer->adapter->size >= packetizer->packet_size;
 }
 
+/* Replace the current (consumed) chunk with the next run of whole
+ * packets from the adapter. We only take what is contiguous in the first
+ * buffer of the adapter so that the chunk is a subbuffer of the input and no
+ * data gets copied. Only a packet straddling two input buffers is taken on
+ * its own, which costs a copy of that one packet. */
+static gboolean
+mpegts_packetizer_next_chunk (MpegTSPacketizer2 * packetizer)
+{
+  guint packet_size = packetizer->packet_size;
+  guint left = mpegts_packetizer_chunk_available (packetizer);
+  guint size;
+
+  if (G_UNLIKELY (left)) {
+    GstBuffer *tail, *head;
+
+    /* After a resync the last packet of the chunk continues in the adapter.
+     * Merge both parts into a chunk of their own, which only copies that one
+     * packet and leaves the adapter alone */
+    if (packetizer->adapter->size < packet_size - left)
+      return FALSE;
+
+    tail = gst_buffer_create_sub (packetizer->chunk, packetizer->chunk_pos,
+        left);
+    head = gst_adapter_take_buffer (packetizer->adapter, packet_size - left);
+    mpegts_packetizer_drop_chunk (packetizer);
+    packetizer->chunk = gst_buffer_merge (tail, head);
+    gst_buffer_unref (tail);
+    gst_buffer_unref (head);
+
+    return TRUE;
+  }
+
+  mpegts_packetizer_drop_chunk (packetizer);
+
+  if (packetizer->adapter->size < packet_size)
+    return FALSE;
+
+  size = gst_adapter_available_fast (packetizer->adapter);
+  size -= size % packet_size;
+  if (G_UNLIKELY (size == 0))
+    size = packet_size;
+
+  packetizer->chunk = gst_adapter_take_buffer (packetizer->adapter, size);
+  packetizer->chunk_pos = 0;
+
+  GST_LOG ("new chunk of %u packets at offset %" G_GUINT64_FORMAT,
+      size / packet_size, packetizer->offset);
+
+  return TRUE;
+}
+
+/* Looks for the start of the next packet after the broken one at chunk_pos,
+ * within the data we have in the chunk. Sync bytes that are confirmed by
+ * the most sync bytes following at the packet size are preferred. Returns
+ * the number of bytes to skip, packet_size if there is no sync byte at all */
+static guint
+mpegts_packetizer_resync (MpegTSPacketizer2 * packetizer)
+{
+  guint64 bitmap[(MPEGTS_MAX_PACKETSIZE * 4 + 63) / 64];
+  guint packet_size = packetizer->packet_size;
+  guint sync_offset = packet_size == MPEGTS_M2TS_PACKETSIZE ? 4 : 0;
+  guint8 *data;
+  guint size, count, pos;
+
+  data = GST_BUFFER_DATA (packetizer->chunk) + packetizer->chunk_pos;
+  size = MIN (mpegts_packetizer_chunk_available (packetizer), packet_size * 4);
+  mpegts_packetizer_sync_bitmap (data, size, bitmap);
+
+  for (count = 4; count > 0; count--) {
+    for (pos = sync_offset + 1; pos < sync_offset + packet_size; pos += 64) {
+      guint64 candidates;
+      guint end = sync_offset + packet_size - pos;
+
+      candidates = mpegts_packetizer_sync_candidates (bitmap, size, pos,
+          packet_size, count);
+      if (end < 64)
+        candidates &= (G_GUINT64_CONSTANT (1) << end) - 1;
+      if (candidates)
+        return pos + mpegts_packetizer_lowest_bit (candidates) - sync_offset;
+    }
+  }
+
+  return packet_size;
+}
+
+/* Iterates over the packets of the input. The packet is parsed in place
+ * inside the current chunk, no buffer is allocated for it */
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet)
 {
-  guint avail;
+  MpegTSPacketizerPacketReturn ret;
+  guint8 *packet_data;
+  guint packet_size;
 
   packet->buffer = NULL;
 
@@ -2232,65 +2449,58 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       return PACKET_NEED_MORE;
   }
 
-  while ((avail = packetizer->adapter->size) >= packetizer->packet_size) {
-    packet->buffer = gst_adapter_take_buffer (packetizer->adapter,
-        packetizer->packet_size);
+  packet_size = packetizer->packet_size;
+
+  while (TRUE) {
+    if (mpegts_packetizer_chunk_available (packetizer) < packet_size) {
+      if (!mpegts_packetizer_next_chunk (packetizer))
+        break;
+    }
+
+    packet_data = GST_BUFFER_DATA (packetizer->chunk) + packetizer->chunk_pos;
+    packet->buffer = packetizer->chunk;
     /* M2TS packets don't start with the sync byte, all other variants do */
-    if (packetizer->packet_size == MPEGTS_M2TS_PACKETSIZE) {
-      packet->data_start = GST_BUFFER_DATA (packet->buffer) + 4;
+    if (packet_size == MPEGTS_M2TS_PACKETSIZE) {
+      packet->data_start = packet_data + 4;
     } else {
-      packet->data_start = GST_BUFFER_DATA (packet->buffer);
+      packet->data_start = packet_data;
     }
     /* ALL mpeg-ts variants contain 188 bytes of data. Those with bigger packet
      * sizes contain either extra data (timesync, FEC, ..) either before or after
      * the data */
     packet->data_end = packet->data_start + 188;
-    GST_BUFFER_OFFSET (packet->buffer) = packet->offset = packetizer->offset;
+    packet->offset = packetizer->offset;
     GST_DEBUG ("offset %" G_GUINT64_FORMAT, packet->offset);
-    packetizer->offset += packetizer->packet_size;
-    GST_MEMDUMP ("buffer", GST_BUFFER_DATA (packet->buffer), 16);
+    packetizer->offset += packet_size;
+    packetizer->chunk_pos += packet_size;
+    GST_MEMDUMP ("buffer", packet_data, 16);
     GST_MEMDUMP ("data_start", packet->data_start, 16);
 
     /* Check sync byte */
     if (G_UNLIKELY (packet->data_start[0] != 0x47)) {
-      guint i;
-      GstBuffer *tmpbuf;
-
-      GST_LOG ("Lost sync %d", packetizer->packet_size);
-      /* Find the 0x47 in the buffer */
-      for (i = 0; i < packetizer->packet_size; i++)
-        if (GST_BUFFER_DATA (packet->buffer)[i] == 0x47)
-          break;
-      if (G_UNLIKELY (i == packetizer->packet_size)) {
-        GST_ERROR ("REALLY lost the sync");
-        gst_buffer_unref (packet->buffer);
-        goto done;
-      }
-
-      if (packetizer->packet_size == MPEGTS_M2TS_PACKETSIZE) {
-        if (i >= 4)
-          i -= 4;
-        else
-          i += 188;
-      }
-
-      /* Pop out the remaining data... */
-      GST_BUFFER_DATA (packet->buffer) += i;
-      GST_BUFFER_SIZE (packet->buffer) -= i;
-      GST_BUFFER_OFFSET (packet->buffer) += i;
-      tmpbuf =
-          gst_adapter_take_buffer (packetizer->adapter,
-          packetizer->adapter->size);
-      /* ... and push everything back in */
-      gst_adapter_push (packetizer->adapter, packet->buffer);
-      gst_adapter_push (packetizer->adapter, tmpbuf);
+      guint skip;
+
+      GST_LOG ("Lost sync %d", packet_size);
+      /* go back to the start of the broken packet and skip to the next
+       * sync point inside the chunk */
+      packetizer->chunk_pos -= packet_size;
+      skip = mpegts_packetizer_resync (packetizer);
+      if (G_UNLIKELY (skip == packet_size))
+        GST_WARNING ("REALLY lost the sync, dropping %u bytes", skip);
+      else
+        GST_LOG ("Skipping %u bytes to the next sync point", skip);
+      packetizer->chunk_pos += skip;
+      packetizer->offset = packet->offset + skip;
+      packet->buffer = NULL;
       continue;
     }
 
-    return mpegts_packetizer_parse_packet (packetizer, packet);
+    ret = mpegts_packetizer_parse_packet (packetizer, packet);
+    if (G_LIKELY (ret != PACKET_DROPPED))
+      return ret;
+    packet->buffer = NULL;
   }
 
-done:
   return PACKET_NEED_MORE;
 }
 
@@ -2301,6 +2511,46 @@ mpegts_packetizer_clear_packet (MpegTSPacketizer2 * packetizer,
   memset (packet, 0, sizeof (MpegTSPacketizerPacket));
 }
 
+/* Returns a new subbuffer of the chunk covering the whole packet, including
+ * the M2TS timestamp or trailing FEC bytes if any */
+GstBuffer *
+mpegts_packetizer_packet_create_buffer (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet)
+{
+  GstBuffer *buf;
+  guint8 *start = packet->data_start;
+
+  g_return_val_if_fail (packet->buffer != NULL, NULL);
+
+  if (packetizer->packet_size == MPEGTS_M2TS_PACKETSIZE)
+    start -= 4;
+
+  buf = gst_buffer_create_sub (packet->buffer,
+      start - GST_BUFFER_DATA (packet->buffer), packetizer->packet_size);
+  GST_BUFFER_OFFSET (buf) = packet->offset;
+
+  return buf;
+}
+
+/* Returns a new subbuffer of the chunk covering the payload of the packet.
+ * Must only be called if packet->payload != NULL */
+GstBuffer *
+mpegts_packetizer_packet_create_payload (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet)
+{
+  GstBuffer *buf;
+
+  g_return_val_if_fail (packet->buffer != NULL, NULL);
+  g_return_val_if_fail (packet->payload != NULL, NULL);
+
+  buf = gst_buffer_create_sub (packet->buffer,
+      packet->payload - GST_BUFFER_DATA (packet->buffer),
+      packet->data_end - packet->payload);
+  GST_BUFFER_OFFSET (buf) = packet->offset;
+
+  return buf;
+}
+
 gboolean
 mpegts_packetizer_push_section (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerPacket * packet, MpegTSPacketizerSection * section)
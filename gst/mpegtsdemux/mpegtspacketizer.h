@@ -36,6 +36,7 @@
 #define MPEGTS_MIN_PACKETSIZE MPEGTS_NORMAL_PACKETSIZE
 #define MPEGTS_MAX_PACKETSIZE MPEGTS_ATSC_PACKETSIZE
 
+#define MPEGTS_AFC_RANDOM_ACCESS_FLAG	0x40
 #define MPEGTS_AFC_PCR_FLAG	0x10
 #define MPEGTS_AFC_OPCR_FLAG	0x08
 
@@ -79,12 +80,32 @@ struct _MpegTSPacketizer2 {
   /* current offset of the tip of the adapter */
   guint64 offset;
   gboolean empty;
+
+  /* contiguous run of whole packets taken from the adapter, which
+   * next_packet() walks in place. chunk_pos is the position of the next
+   * packet in it */
+  GstBuffer *chunk;
+  guint chunk_pos;
+
+  /* PIDs whose packets are wanted, one bit per PID. Packets of other PIDs
+   * are dropped right after the header is parsed. NULL to keep all */
+  const guint8 *pid_filter;
+
+  /* statistics */
+  guint64 packets_processed;
+  guint64 packets_dropped;
 };
 
 struct _MpegTSPacketizer2Class {
   GObjectClass object_class;
 };
 
+/* Packets are parsed in place inside the packetizer chunk. @buffer is the
+ * chunk the packet lives in and is owned by the packetizer, it is only valid
+ * until the next call to mpegts_packetizer_next_packet(). Use
+ * mpegts_packetizer_packet_create_buffer() or
+ * mpegts_packetizer_packet_create_payload() to get a buffer that can be kept
+ * or pushed downstream. */
 typedef struct
 {
   GstBuffer *buffer;
@@ -131,7 +152,10 @@ typedef struct
 typedef enum {
   PACKET_BAD       = FALSE,
   PACKET_OK        = TRUE,
-  PACKET_NEED_MORE
+  PACKET_NEED_MORE,
+  /* internal, filtered out by the pid filter. Never returned by
+   * mpegts_packetizer_next_packet() */
+  PACKET_DROPPED
 } MpegTSPacketizerPacketReturn;
 
 GType mpegts_packetizer_get_type(void);
@@ -145,8 +169,14 @@ MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *p
   MpegTSPacketizerPacket *packet);
 void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
+GstBuffer *mpegts_packetizer_packet_create_buffer (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packet);
+GstBuffer *mpegts_packetizer_packet_create_payload (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packet);
 void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
+void mpegts_packetizer_set_pid_filter (MpegTSPacketizer2 *packetizer,
+  const guint8 *pid_filter);
 
 gboolean mpegts_packetizer_push_section (MpegTSPacketizer2 *packetzer,
   MpegTSPacketizerPacket *packet, MpegTSPacketizerSection *section);
@@ -59,6 +59,18 @@
  */
 #define SEEK_TIMESTAMP_OFFSET (1000 * GST_MSECOND)
 
+/* minimal distance between the index entries recorded while playing or
+ * seeking, small enough for seeks between two entries to skip the
+ * bisection */
+#define TS_INDEX_INTERVAL (SEEK_TIMESTAMP_OFFSET / 2)
+
+/* sidecar index file: magic, version, upstream size, number of entries,
+ * followed by the entries: time, PCR, offset and flags, all big endian */
+#define TS_INDEX_MAGIC GST_MAKE_FOURCC ('T', 'S', 'I', 'X')
+#define TS_INDEX_VERSION 1
+#define TS_INDEX_HEADER_SIZE 20
+#define TS_INDEX_ENTRY_SIZE 28
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -173,6 +185,7 @@ enum
   ARG_0,
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -186,6 +199,9 @@ static void
 gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program);
 static void
 gst_ts_demux_program_stopped (MpegTSBase * base, MpegTSBaseProgram * program);
+static gboolean
+gst_ts_demux_is_program_wanted (MpegTSBase * base,
+    MpegTSBaseProgram * program);
 static void gst_ts_demux_reset (MpegTSBase * base);
 static GstFlowReturn
 gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
@@ -206,6 +222,9 @@ static void gst_ts_demux_set_property (GObject * object, guint prop_id,
 static void gst_ts_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_ts_demux_finalize (GObject * object);
+static void gst_ts_demux_set_index (GstElement * element, GstIndex * index);
+static GstIndex *gst_ts_demux_get_index (GstElement * element);
+static void gst_ts_demux_save_index (GstTSDemux * demux);
 static GstFlowReturn
 process_pcr (MpegTSBase * base, guint64 initoff, TSPcrOffset * pcroffset,
     guint numpcr, gboolean isinitial);
@@ -254,9 +273,11 @@ static void
 gst_ts_demux_class_init (GstTSDemuxClass * klass)
 {
   GObjectClass *gobject_class;
+  GstElementClass *element_class;
   MpegTSBaseClass *ts_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
   gobject_class->set_property = gst_ts_demux_set_property;
   gobject_class->get_property = gst_ts_demux_get_property;
   gobject_class->finalize = gst_ts_demux_finalize;
@@ -271,6 +292,14 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           "Emit messages for every pcr/opcr/pts/dts", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "File to load the seek index from instead of scanning the stream, "
+          "and to save it to when stopping (NULL to disable)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  element_class->set_index = GST_DEBUG_FUNCPTR (gst_ts_demux_set_index);
+  element_class->get_index = GST_DEBUG_FUNCPTR (gst_ts_demux_get_index);
 
   ts_class = GST_MPEGTS_BASE_CLASS (klass);
   ts_class->reset = GST_DEBUG_FUNCPTR (gst_ts_demux_reset);
@@ -278,6 +307,8 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
   ts_class->push_event = GST_DEBUG_FUNCPTR (push_event);
   ts_class->program_started = GST_DEBUG_FUNCPTR (gst_ts_demux_program_started);
   ts_class->program_stopped = GST_DEBUG_FUNCPTR (gst_ts_demux_program_stopped);
+  ts_class->is_program_wanted =
+      GST_DEBUG_FUNCPTR (gst_ts_demux_is_program_wanted);
   ts_class->stream_added = gst_ts_demux_stream_added;
   ts_class->stream_removed = gst_ts_demux_stream_removed;
   ts_class->find_timestamps = GST_DEBUG_FUNCPTR (find_timestamps);
@@ -306,10 +337,14 @@ gst_ts_demux_reset (MpegTSBase * base)
   GstTSDemux *demux = (GstTSDemux *) base;
 
   if (demux->index) {
+    if (demux->index_dirty)
+      gst_ts_demux_save_index (demux);
     g_array_free (demux->index, TRUE);
     demux->index = NULL;
   }
   demux->index_size = 0;
+  demux->index_total_bytes = 0;
+  demux->index_dirty = FALSE;
   demux->need_newsegment = TRUE;
   demux->program_number = -1;
   demux->duration = GST_CLOCK_TIME_NONE;
@@ -325,6 +360,12 @@ gst_ts_demux_reset (MpegTSBase * base)
 static void
 gst_ts_demux_finalize (GObject * object)
 {
+  GstTSDemux *demux = GST_TS_DEMUX (object);
+
+  g_free (demux->index_location);
+  if (demux->element_index)
+    gst_object_unref (demux->element_index);
+
   if (G_OBJECT_CLASS (parent_class)->finalize)
     G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -342,10 +383,17 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
       /* FIXME: do something if program is switched as opposed to set at
        * beginning */
       demux->program_number = g_value_get_int (value);
+      mpegts_base_invalidate_pid_interest (GST_MPEGTS_BASE (demux));
       break;
     case PROP_EMIT_STATS:
       demux->emit_statistics = g_value_get_boolean (value);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -364,6 +412,11 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_EMIT_STATS:
       g_value_set_boolean (value, demux->emit_statistics);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_string (value, demux->index_location);
+      GST_OBJECT_UNLOCK (demux);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -477,6 +530,7 @@ gst_ts_demux_perform_auxiliary_seek (MpegTSBase * base, GstClockTime seektime,
       (flags & GST_SEEK_FLAG_ACCURATE) ? "accurate" : "",
       (flags & GST_SEEK_FLAG_KEY_UNIT) ? "key_unit" : "");
 
+  mpegts_base_check_pid_interest (base);
   mpegts_packetizer_flush (base->packetizer);
 
   if (base->packetizer->packet_size == MPEGTS_M2TS_PACKETSIZE)
@@ -584,6 +638,284 @@ TSPcrOffset_find (gconstpointer a, gconstpointer b, gpointer user_data)
     return 0;
 }
 
+static gint
+TSPcrOffset_find_offset (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  if (((TSPcrOffset *) a)->offset < ((TSPcrOffset *) b)->offset)
+    return -1;
+  else if (((TSPcrOffset *) a)->offset > ((TSPcrOffset *) b)->offset)
+    return 1;
+  else
+    return 0;
+}
+
+/* Seek index
+ *
+ * find_timestamps() starts the index with the first and last PCR of the
+ * stream and one PCR every PCR_WRAP_SIZE_128KBPS bytes, so that the PCR
+ * wraparounds can be tracked. The PCRs seen while playing and the ones
+ * found while bisecting for a seek are then inserted in between, sorted by
+ * offset and time, so that seeking to an already visited part of the
+ * stream is a lookup. The index can be saved to a sidecar file and loaded
+ * instead of scanning the stream again.
+ */
+
+static void
+gst_ts_demux_index_associate (GstTSDemux * demux, TSPcrOffset * entry)
+{
+  GstIndex *index = NULL;
+  gint id = 0;
+
+  /* the index can be changed from the application thread at any time */
+  GST_OBJECT_LOCK (demux);
+  if (demux->element_index) {
+    index = gst_object_ref (demux->element_index);
+    id = demux->index_id;
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  if (index == NULL)
+    return;
+
+  gst_index_add_association (index, id, entry->flags, GST_FORMAT_TIME,
+      (gint64) (entry->gsttime - demux->first_pcr.gsttime), GST_FORMAT_BYTES,
+      (gint64) entry->offset, NULL);
+  gst_object_unref (index);
+}
+
+static void
+gst_ts_demux_index_associate_all (GstTSDemux * demux)
+{
+  guint i;
+
+  if (demux->index == NULL)
+    return;
+
+  for (i = 0; i < demux->index_size; i++)
+    gst_ts_demux_index_associate (demux,
+        &g_array_index (demux->index, TSPcrOffset, i));
+}
+
+/* inserts @entry unless it is too close to its neighbours. Its time is
+ * computed from the previous entry if it isn't known yet */
+static void
+gst_ts_demux_index_add (GstTSDemux * demux, TSPcrOffset * entry)
+{
+  TSPcrOffset *entries, *prev, *next = NULL;
+  GstClockTime spacing;
+  guint pos;
+
+  if (G_UNLIKELY (demux->index == NULL || demux->index_size == 0))
+    return;
+
+  entries = (TSPcrOffset *) demux->index->data;
+  prev = gst_util_array_binary_search (entries, demux->index_size,
+      sizeof (*prev), TSPcrOffset_find_offset, GST_SEARCH_MODE_BEFORE, entry,
+      NULL);
+
+  /* before the first PCR, or already known */
+  if (prev == NULL || prev->offset == entry->offset)
+    return;
+
+  pos = prev - entries + 1;
+  if (pos < demux->index_size)
+    next = &entries[pos];
+
+  if (!GST_CLOCK_TIME_IS_VALID (entry->gsttime))
+    entry->gsttime = calculate_gsttime (prev, entry->pcr);
+
+  /* random access points are worth a denser index */
+  spacing = (entry->flags & GST_ASSOCIATION_FLAG_KEY_UNIT) ?
+      TS_INDEX_INTERVAL / 4 : TS_INDEX_INTERVAL;
+
+  if (entry->gsttime < prev->gsttime + spacing)
+    return;
+
+  if (next) {
+    if (G_UNLIKELY (entry->gsttime > next->gsttime)) {
+      GST_DEBUG ("PCR discontinuity before offset %" G_GUINT64_FORMAT
+          ", not indexing", entry->offset);
+      return;
+    }
+    if (entry->gsttime + spacing > next->gsttime)
+      return;
+  }
+
+  GST_LOG ("index entry %u time: %" GST_TIME_FORMAT " offset: %"
+      G_GUINT64_FORMAT "%s", pos, GST_TIME_ARGS (entry->gsttime),
+      entry->offset, (entry->flags & GST_ASSOCIATION_FLAG_KEY_UNIT) ?
+      " (random access)" : "");
+
+  g_array_insert_val (demux->index, pos, *entry);
+  demux->index_size++;
+  demux->index_dirty = TRUE;
+
+  gst_ts_demux_index_associate (demux, entry);
+}
+
+/* loads the index from @location if it was saved for a stream of
+ * @total_bytes starting with the @first PCR */
+static gboolean
+gst_ts_demux_load_index (GstTSDemux * demux, const gchar * location,
+    guint64 total_bytes, TSPcrOffset * first)
+{
+  GArray *index = NULL;
+  GError *err = NULL;
+  gchar *contents;
+  gsize length;
+  guint8 *data;
+  guint32 i, n_entries;
+  TSPcrOffset entry, prev = { 0, };
+
+  if (!g_file_get_contents (location, &contents, &length, &err)) {
+    GST_DEBUG_OBJECT (demux, "no index loaded from %s: %s", location,
+        err->message);
+    g_error_free (err);
+    return FALSE;
+  }
+
+  data = (guint8 *) contents;
+  if (length < TS_INDEX_HEADER_SIZE
+      || GST_READ_UINT32_BE (data) != TS_INDEX_MAGIC
+      || GST_READ_UINT32_BE (data + 4) != TS_INDEX_VERSION)
+    goto invalid;
+
+  if (GST_READ_UINT64_BE (data + 8) != total_bytes)
+    goto mismatch;
+
+  n_entries = GST_READ_UINT32_BE (data + 16);
+  if (n_entries < 2 || (length - TS_INDEX_HEADER_SIZE) / TS_INDEX_ENTRY_SIZE
+      < n_entries)
+    goto invalid;
+
+  index = g_array_sized_new (TRUE, TRUE, sizeof (TSPcrOffset), n_entries);
+  data += TS_INDEX_HEADER_SIZE;
+  for (i = 0; i < n_entries; i++) {
+    entry.gsttime = GST_READ_UINT64_BE (data);
+    entry.pcr = GST_READ_UINT64_BE (data + 8);
+    entry.offset = GST_READ_UINT64_BE (data + 16);
+    entry.flags = GST_READ_UINT32_BE (data + 24);
+    data += TS_INDEX_ENTRY_SIZE;
+
+    if (i > 0 && (entry.offset <= prev.offset || entry.gsttime < prev.gsttime))
+      goto invalid;
+    if (entry.offset >= total_bytes)
+      goto invalid;
+
+    g_array_append_val (index, entry);
+    prev = entry;
+  }
+
+  /* a stream of the same size is not necessarily the same stream */
+  entry = g_array_index (index, TSPcrOffset, 0);
+  if (entry.pcr != first->pcr || entry.offset != first->offset)
+    goto mismatch;
+
+  GST_INFO_OBJECT (demux, "loaded %u index entries from %s", n_entries,
+      location);
+
+  demux->index = index;
+  demux->index_size = n_entries;
+  demux->first_pcr = entry;
+  demux->index_pcr = entry;
+  demux->last_pcr = prev;
+  g_free (contents);
+
+  return TRUE;
+
+invalid:
+  GST_WARNING_OBJECT (demux, "invalid index file %s", location);
+  goto fail;
+mismatch:
+  GST_INFO_OBJECT (demux, "index file %s is for another stream", location);
+fail:
+  if (index)
+    g_array_free (index, TRUE);
+  g_free (contents);
+  return FALSE;
+}
+
+static void
+gst_ts_demux_save_index (GstTSDemux * demux)
+{
+  GError *err = NULL;
+  gchar *location;
+  guint8 *contents, *data;
+  gsize length;
+  guint i;
+
+  GST_OBJECT_LOCK (demux);
+  location = g_strdup (demux->index_location);
+  GST_OBJECT_UNLOCK (demux);
+
+  if (location == NULL || demux->index_size < 2)
+    goto done;
+
+  length = TS_INDEX_HEADER_SIZE + demux->index_size * TS_INDEX_ENTRY_SIZE;
+  data = contents = g_malloc (length);
+
+  GST_WRITE_UINT32_BE (data, TS_INDEX_MAGIC);
+  GST_WRITE_UINT32_BE (data + 4, TS_INDEX_VERSION);
+  GST_WRITE_UINT64_BE (data + 8, demux->index_total_bytes);
+  GST_WRITE_UINT32_BE (data + 16, demux->index_size);
+  data += TS_INDEX_HEADER_SIZE;
+  for (i = 0; i < demux->index_size; i++) {
+    TSPcrOffset *entry = &g_array_index (demux->index, TSPcrOffset, i);
+
+    GST_WRITE_UINT64_BE (data, entry->gsttime);
+    GST_WRITE_UINT64_BE (data + 8, entry->pcr);
+    GST_WRITE_UINT64_BE (data + 16, entry->offset);
+    GST_WRITE_UINT32_BE (data + 24, entry->flags);
+    data += TS_INDEX_ENTRY_SIZE;
+  }
+
+  if (g_file_set_contents (location, (gchar *) contents, length, &err)) {
+    GST_INFO_OBJECT (demux, "saved %u index entries to %s", demux->index_size,
+        location);
+    demux->index_dirty = FALSE;
+  } else {
+    GST_WARNING_OBJECT (demux, "could not save the index to %s: %s",
+        location, err->message);
+    g_error_free (err);
+  }
+  g_free (contents);
+
+done:
+  g_free (location);
+}
+
+static void
+gst_ts_demux_set_index (GstElement * element, GstIndex * index)
+{
+  GstTSDemux *demux = GST_TS_DEMUX (element);
+  gint id = 0;
+
+  /* the known entries are added when the stream is scanned */
+  if (index)
+    gst_index_get_writer_id (index, GST_OBJECT (element), &id);
+
+  GST_OBJECT_LOCK (demux);
+  if (demux->element_index)
+    gst_object_unref (demux->element_index);
+  demux->element_index = index ? gst_object_ref (index) : NULL;
+  demux->index_id = id;
+  GST_OBJECT_UNLOCK (demux);
+}
+
+static GstIndex *
+gst_ts_demux_get_index (GstElement * element)
+{
+  GstTSDemux *demux = GST_TS_DEMUX (element);
+  GstIndex *result = NULL;
+
+  GST_OBJECT_LOCK (demux);
+  if (demux->element_index)
+    result = gst_object_ref (demux->element_index);
+  GST_OBJECT_UNLOCK (demux);
+
+  return result;
+}
+
 static GstFlowReturn
 gst_ts_demux_perform_seek (MpegTSBase * base, GstSegment * segment, guint16 pid)
 {
@@ -702,6 +1034,9 @@ gst_ts_demux_perform_seek (MpegTSBase * base, GstSegment * segment, guint16 pid)
       goto done;
     }
 
+    /* remember it for the next seeks */
+    gst_ts_demux_index_add (demux, &seekpcroffset);
+
     if (seekpcroffset.gsttime > seektime) {
       pcr_stop = seekpcroffset;
     } else {
@@ -1314,6 +1649,16 @@ gst_ts_demux_program_stopped (MpegTSBase * base, MpegTSBaseProgram * program)
   demux->program_number = -1;
 }
 
+/* Until a program is selected, all of them are candidates */
+static gboolean
+gst_ts_demux_is_program_wanted (MpegTSBase * base, MpegTSBaseProgram * program)
+{
+  GstTSDemux *demux = GST_TS_DEMUX (base);
+
+  return demux->program_number == -1 ||
+      demux->program_number == program->program_number;
+}
+
 static gboolean
 process_section (MpegTSBase * base)
 {
@@ -1410,6 +1755,9 @@ process_pes (MpegTSBase * base, TSPcrOffset * pcroffset)
       GST_DEBUG ("PCR[0x%x]: %" G_GINT64_FORMAT, packet.pid, packet.pcr);
       pcroffset->pcr = packet.pcr;
       pcroffset->offset = packet.offset;
+      pcroffset->flags =
+          (packet.afc_flags & MPEGTS_AFC_RANDOM_ACCESS_FLAG) ?
+          GST_ASSOCIATION_FLAG_KEY_UNIT : GST_ASSOCIATION_FLAG_NONE;
       done = TRUE;
     }
   next:
@@ -1437,6 +1785,7 @@ find_pcr_packet (MpegTSBase * base, guint64 offset, gint64 length,
   if (G_UNLIKELY (program == NULL))
     return GST_FLOW_ERROR;
 
+  mpegts_base_check_pid_interest (base);
   mpegts_packetizer_flush (base->packetizer);
   if (offset >= 4 && base->packetizer->packet_size == MPEGTS_M2TS_PACKETSIZE)
     offset -= 4;
@@ -1544,9 +1893,13 @@ find_timestamps (MpegTSBase * base, guint64 initoff, guint64 * offset)
   guint i = 0;
   TSPcrOffset initial, final;
   GstTSDemux *demux = GST_TS_DEMUX (base);
+  gchar *location;
+  gboolean loaded;
 
   GST_DEBUG ("Scanning for timestamps");
 
+  mpegts_base_check_pid_interest (base);
+
   /* Flush what remained from before */
   mpegts_packetizer_clear (base->packetizer);
 
@@ -1592,7 +1945,17 @@ find_timestamps (MpegTSBase * base, guint64 initoff, guint64 * offset)
     return ret;
   }
   GST_DEBUG ("Upstream is %" G_GINT64_FORMAT " bytes", total_bytes);
-
+  demux->index_total_bytes = total_bytes;
+
+  /* A saved index spares us the scanning */
+  GST_OBJECT_LOCK (demux);
+  location = g_strdup (demux->index_location);
+  GST_OBJECT_UNLOCK (demux);
+  loaded = location != NULL &&
+      gst_ts_demux_load_index (demux, location, total_bytes, &initial);
+  g_free (location);
+  if (loaded)
+    goto have_index;
 
   /* Let's start scanning 4000 packets from the end */
   scan_offset = MAX (188, total_bytes - 4000 * MPEGTS_MAX_PACKETSIZE);
@@ -1624,6 +1987,10 @@ find_timestamps (MpegTSBase * base, guint64 initoff, guint64 * offset)
   }
 
   verify_timestamps (base, &initial, &final);
+  demux->index_dirty = TRUE;
+
+have_index:
+  gst_ts_demux_index_associate_all (demux);
 
   gst_segment_set_duration (&demux->segment, GST_FORMAT_TIME,
       demux->last_pcr.gsttime - demux->first_pcr.gsttime);
@@ -1762,6 +2129,7 @@ beach:
       pcroffset->pcr = pcrs[nbpcr - 1];
       pcroffset->offset = pcroffs[nbpcr - 1];
     }
+    pcroffset->flags = GST_ASSOCIATION_FLAG_NONE;
     GST_DEBUG ("pcrdiff:%" GST_TIME_FORMAT " offsetdiff %" G_GUINT64_FORMAT,
         GST_TIME_ARGS (PCRTIME_TO_GSTTIME (pcrs[nbpcr - 1] - pcrs[0])),
         pcroffs[nbpcr - 1] - pcroffs[0]);
@@ -1782,7 +2150,7 @@ beach:
 
 static inline void
 gst_ts_demux_record_pcr (GstTSDemux * demux, TSDemuxStream * stream,
-    guint64 pcr, guint64 offset)
+    guint64 pcr, guint64 offset, gboolean random_access)
 {
   MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
 
@@ -1800,6 +2168,14 @@ gst_ts_demux_record_pcr (GstTSDemux * demux, TSDemuxStream * stream,
       demux->first_pcr.offset = offset;
       demux->first_pcr.pcr = pcr;
     }
+    /* refine the seek index in pull mode */
+    if (demux->index) {
+      TSPcrOffset entry = demux->cur_pcr;
+
+      entry.flags = random_access ? GST_ASSOCIATION_FLAG_KEY_UNIT :
+          GST_ASSOCIATION_FLAG_NONE;
+      gst_ts_demux_index_add (demux, &entry);
+    }
   }
 
   if (G_UNLIKELY (demux->emit_statistics)) {
@@ -1893,19 +2269,6 @@ calc_gsttime_from_pts (TSPcrOffset * start, guint64 pts)
   return time;
 }
 
-#if 0
-static gint
-TSPcrOffset_find_offset (gconstpointer a, gconstpointer b, gpointer user_data)
-{
-  if (((TSPcrOffset *) a)->offset < ((TSPcrOffset *) b)->offset)
-    return -1;
-  else if (((TSPcrOffset *) a)->offset > ((TSPcrOffset *) b)->offset)
-    return 1;
-  else
-    return 0;
-}
-#endif
-
 static GstFlowReturn
 gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream)
 {
@@ -2010,11 +2373,10 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
 
   GST_DEBUG ("state:%d", stream->state);
 
-  buf = packet->buffer;
-  /* HACK : Instead of creating a new buffer, we just modify the data/size
-   * of the buffer to point to the payload */
-  GST_BUFFER_DATA (buf) = packet->payload;
-  GST_BUFFER_SIZE (buf) = packet->data_end - packet->payload;
+  /* The packet lives inside the packetizer chunk, only the payloads we
+   * actually output get a subbuffer of their own */
+  buf = mpegts_packetizer_packet_create_payload (((MpegTSBase *) demux)->
+      packetizer, packet);
 
   if (stream->state == PENDING_PACKET_EMPTY) {
     if (G_UNLIKELY (!packet->payload_unit_start_indicator)) {
@@ -2040,6 +2402,8 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
   } else if (stream->state == PENDING_PACKET_BUFFER) {
     GST_LOG ("BUFFER: appending data to bufferlist");
     stream->currentlist = g_list_prepend (stream->currentlist, buf);
+  } else {
+    gst_buffer_unref (buf);
   }
 
 
@@ -2191,7 +2555,6 @@ gst_ts_demux_handle_packet (GstTSDemux * demux, TSDemuxStream * stream,
   if (section) {
     GST_DEBUG ("section complete:%d, buffer size %d",
         section->complete, GST_BUFFER_SIZE (section->buffer));
-    gst_buffer_unref (packet->buffer);
     return res;
   }
 
@@ -2201,17 +2564,14 @@ gst_ts_demux_handle_packet (GstTSDemux * demux, TSDemuxStream * stream,
 
   if (packet->adaptation_field_control & 0x2) {
     if (packet->afc_flags & MPEGTS_AFC_PCR_FLAG)
-      gst_ts_demux_record_pcr (demux, stream, packet->pcr,
-          GST_BUFFER_OFFSET (packet->buffer));
+      gst_ts_demux_record_pcr (demux, stream, packet->pcr, packet->offset,
+          packet->afc_flags & MPEGTS_AFC_RANDOM_ACCESS_FLAG);
     if (packet->afc_flags & MPEGTS_AFC_OPCR_FLAG)
-      gst_ts_demux_record_opcr (demux, stream, packet->opcr,
-          GST_BUFFER_OFFSET (packet->buffer));
+      gst_ts_demux_record_opcr (demux, stream, packet->opcr, packet->offset);
   }
 
   if (packet->payload)
     gst_ts_demux_queue_data (demux, stream, packet);
-  else
-    gst_buffer_unref (packet->buffer);
 
   return res;
 }
@@ -2227,13 +2587,8 @@ gst_ts_demux_push (MpegTSBase * base, MpegTSPacketizerPacket * packet,
   if (G_LIKELY (demux->program)) {
     stream = (TSDemuxStream *) demux->program->streams[packet->pid];
 
-    if (stream) {
+    if (stream)
       res = gst_ts_demux_handle_packet (demux, stream, packet, section);
-    } else if (packet->buffer)
-      gst_buffer_unref (packet->buffer);
-  } else {
-    if (packet->buffer)
-      gst_buffer_unref (packet->buffer);
   }
   return res;
 }
@@ -55,6 +55,8 @@ struct _TSPcrOffset
   guint64 gsttime;
   guint64 pcr;
   guint64 offset;
+  GstAssocFlags flags;          /* KEY_UNIT if the random access indicator
+                                 * was set on the PCR packet */
 };
 
 struct _GstTSDemux
@@ -65,6 +67,7 @@ struct _GstTSDemux
    * accessed from the application thread and the streaming thread */
   guint program_number;		/* Required program number (ignore:-1) */
   gboolean emit_statistics;
+  gchar *index_location;	/* Sidecar file for the seek index */
 
   /*< private >*/
   MpegTSBaseProgram *program;	/* Current program */
@@ -81,6 +84,10 @@ struct _GstTSDemux
   TSPcrOffset last_pcr;
   TSPcrOffset cur_pcr;
   TSPcrOffset index_pcr;
+  guint64 index_total_bytes;	/* Upstream size the index was built for */
+  gboolean index_dirty;		/* Entries were added since loading/saving */
+  GstIndex *element_index;
+  gint index_id;
 };
 
 struct _GstTSDemuxClass
@@ -102,9 +102,14 @@ enum
   ARG_PROG_MAP,
   ARG_M2TS_MODE,
   ARG_PAT_INTERVAL,
-  ARG_PMT_INTERVAL
+  ARG_PMT_INTERVAL,
+  ARG_ALIGNMENT,
+  ARG_AGGREGATE_TIME
 };
 
+#define MPEGTSMUX_DEFAULT_ALIGNMENT 0
+#define MPEGTSMUX_DEFAULT_AGGREGATE_TIME 0
+
 static GstStaticPadTemplate mpegtsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%d",
     GST_PAD_SINK,
@@ -140,6 +145,9 @@ static void gst_mpegtsmux_get_property (GObject * object, guint prop_id,
 static void mpegtsmux_dispose (GObject * object);
 static gboolean new_packet_cb (guint8 * data, guint len, void *user_data,
     gint64 new_pcr);
+static guint8 *alloc_packet_cb (void *user_data);
+static GstFlowReturn mpegtsmux_push_aggregate (MpegTsMux * mux);
+static void mpegtsmux_drop_aggregate (MpegTsMux * mux);
 static void release_buffer_cb (guint8 * data, void *user_data);
 
 static void mpegtsdemux_prepare_srcpad (MpegTsMux * mux);
@@ -207,6 +215,21 @@ mpegtsmux_class_init (MpegTsMuxClass * klass)
           "Set the interval (in ticks of the 90kHz clock) for writing out the PMT table",
           1, G_MAXUINT, TSMUX_DEFAULT_PMT_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass), ARG_ALIGNMENT,
+      g_param_spec_uint ("alignment", "Alignment",
+          "Number of packets per output buffer, e.g. 7 for UDP/RTP or more "
+          "to write files in larger blocks (0 = one buffer per packet)",
+          0, G_MAXUINT / M2TS_PACKET_LENGTH, MPEGTSMUX_DEFAULT_ALIGNMENT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      ARG_AGGREGATE_TIME, g_param_spec_uint64 ("aggregate-time",
+          "Aggregate time",
+          "Push an output buffer before it spans more than this time "
+          "(in nanoseconds, 0 = no limit). Only used with alignment > 0",
+          0, G_MAXUINT64, MPEGTSMUX_DEFAULT_AGGREGATE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -223,11 +246,14 @@ mpegtsmux_init (MpegTsMux * mux, MpegTsMuxClass * g_class)
 
   mux->tsmux = tsmux_new ();
   tsmux_set_write_func (mux->tsmux, new_packet_cb, mux);
+  tsmux_set_alloc_func (mux->tsmux, alloc_packet_cb, mux);
 
   mux->programs = g_new0 (TsMuxProgram *, MAX_PROG_NUMBER);
   mux->first = TRUE;
   mux->last_flow_ret = GST_FLOW_OK;
-  mux->adapter = gst_adapter_new ();
+  mux->m2ts_packets = NULL;
+  mux->m2ts_packets_len = 0;
+  mux->m2ts_packets_size = 0;
   mux->m2ts_mode = FALSE;
   mux->pat_interval = TSMUX_DEFAULT_PAT_INTERVAL;
   mux->pmt_interval = TSMUX_DEFAULT_PMT_INTERVAL;
@@ -238,6 +264,11 @@ mpegtsmux_init (MpegTsMux * mux, MpegTsMuxClass * g_class)
   mux->prog_map = NULL;
   mux->streamheader = NULL;
   mux->streamheader_sent = FALSE;
+
+  mux->alignment = MPEGTSMUX_DEFAULT_ALIGNMENT;
+  mux->aggregate_time = MPEGTSMUX_DEFAULT_AGGREGATE_TIME;
+  mux->out_buffer = NULL;
+  mux->out_reserved = FALSE;
 }
 
 static void
@@ -245,10 +276,11 @@ mpegtsmux_dispose (GObject * object)
 {
   MpegTsMux *mux = GST_MPEG_TSMUX (object);
 
-  if (mux->adapter) {
-    gst_adapter_clear (mux->adapter);
-    g_object_unref (mux->adapter);
-    mux->adapter = NULL;
+  if (mux->m2ts_packets) {
+    g_free (mux->m2ts_packets);
+    mux->m2ts_packets = NULL;
+    mux->m2ts_packets_len = 0;
+    mux->m2ts_packets_size = 0;
   }
   if (mux->collect) {
     gst_object_unref (mux->collect);
@@ -266,6 +298,7 @@ mpegtsmux_dispose (GObject * object)
     g_free (mux->programs);
     mux->programs = NULL;
   }
+  mpegtsmux_drop_aggregate (mux);
   if (mux->streamheader) {
     GstBuffer *buf;
     GList *sh;
@@ -322,6 +355,12 @@ gst_mpegtsmux_set_property (GObject * object, guint prop_id,
         walk = g_slist_next (walk);
       }
       break;
+    case ARG_ALIGNMENT:
+      mux->alignment = g_value_get_uint (value);
+      break;
+    case ARG_AGGREGATE_TIME:
+      mux->aggregate_time = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -347,6 +386,12 @@ gst_mpegtsmux_get_property (GObject * object, guint prop_id,
     case ARG_PMT_INTERVAL:
       g_value_set_uint (value, mux->pmt_interval);
       break;
+    case ARG_ALIGNMENT:
+      g_value_set_uint (value, mux->alignment);
+      break;
+    case ARG_AGGREGATE_TIME:
+      g_value_set_uint64 (value, mux->aggregate_time);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -733,6 +778,8 @@ mpegtsmux_collected (GstCollectPads * pads, MpegTsMux * mux)
   } else {
     /* FIXME: Drain all remaining streams */
     /* At EOS */
+    if (mux->out_buffer)
+      ret = mpegtsmux_push_aggregate (mux);
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
   }
 
@@ -813,6 +860,30 @@ mpegtsmux_release_pad (GstElement * element, GstPad * pad)
   gst_element_remove_pad (element, pad);
 }
 
+/* Returns TRUE for the PAT and PMT packets before the first data packet,
+ * which are collected for the streamheader on the caps. The first data
+ * packet sets the caps. */
+static gboolean
+new_packet_is_streamheader (MpegTsMux * mux, guint8 * data)
+{
+  guint pid;
+
+  if (mux->streamheader_sent)
+    return FALSE;
+
+  pid = ((data[1] & 0x1f) << 8) | data[2];
+  /* if it's a PAT or a PMT */
+  if (pid == 0x00 || (pid >= TSMUX_START_PMT_PID && pid < TSMUX_START_ES_PID))
+    return TRUE;
+
+  if (mux->streamheader) {
+    mpegtsdemux_set_header_on_caps (mux);
+    mux->streamheader_sent = TRUE;
+  }
+
+  return FALSE;
+}
+
 static void
 new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
     guint len)
@@ -820,17 +891,9 @@ new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
   /* Packets should be at least 188 bytes, but check anyway */
   g_return_if_fail (len >= 2);
 
-  if (!mux->streamheader_sent) {
-    guint pid = ((data[1] & 0x1f) << 8) | data[2];
-    /* if it's a PAT or a PMT */
-    if (pid == 0x00 || (pid >= TSMUX_START_PMT_PID && pid < TSMUX_START_ES_PID)) {
-      mux->streamheader =
-          g_list_append (mux->streamheader, gst_buffer_copy (buf));
-    } else if (mux->streamheader) {
-      mpegtsdemux_set_header_on_caps (mux);
-      mux->streamheader_sent = TRUE;
-    }
-  }
+  if (new_packet_is_streamheader (mux, data))
+    mux->streamheader =
+        g_list_append (mux->streamheader, gst_buffer_copy (buf));
 
   /* Set the caps on the buffer only after possibly setting the stream headers
    * into the pad caps above */
@@ -845,111 +908,268 @@ new_packet_common_init (MpegTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
+/* With alignment > 0 the packets are collected in output buffers of
+ * alignment packets, normal TS packets are written there by tsmux directly
+ * through alloc_packet_cb. A buffer is pushed when it is full, before a
+ * packet that starts a keyframe so that buffers without the DELTA_UNIT
+ * flag start with it, and before it spans more than aggregate-time. The
+ * PCRs in the packets are not touched, the buffer carries the timestamp of
+ * its first packet. */
 static gboolean
-new_packet_m2ts (MpegTsMux * mux, guint8 * data, guint len, gint64 new_pcr)
+mpegtsmux_aggregate_must_push (MpegTsMux * mux, GstClockTime ts,
+    gboolean delta)
 {
-  GstBuffer *buf, *out_buf;
-  GstFlowReturn ret;
-  int chunk_bytes;
+  if (mux->out_buffer == NULL)
+    return FALSE;
 
-  GST_LOG_OBJECT (mux, "Have buffer with new_pcr=%" G_GINT64_FORMAT " size %d",
-      new_pcr, len);
+  if (!delta)
+    return TRUE;
 
-  buf = gst_buffer_new_and_alloc (M2TS_PACKET_LENGTH);
-  if (G_UNLIKELY (buf == NULL)) {
-    GST_ELEMENT_ERROR (mux, STREAM, MUX,
-        ("Failed allocating output buffer"), (NULL));
-    mux->last_flow_ret = GST_FLOW_ERROR;
-    return FALSE;
+  return mux->aggregate_time > 0 && GST_CLOCK_TIME_IS_VALID (ts) &&
+      GST_CLOCK_TIME_IS_VALID (mux->out_ts) &&
+      ts >= mux->out_ts + mux->aggregate_time;
+}
+
+/* Returns the place for the next packet in the output buffer */
+static guint8 *
+mpegtsmux_aggregate_reserve (MpegTsMux * mux, guint len, GstClockTime ts,
+    gboolean delta)
+{
+  if (mux->out_buffer == NULL) {
+    mux->out_buffer = gst_buffer_new_and_alloc (MAX (mux->alignment, 1) * len);
+    mux->out_offset = 0;
+    mux->out_ts = ts;
+    mux->out_delta = delta;
   }
 
-  new_packet_common_init (mux, buf, data, len);
+  return GST_BUFFER_DATA (mux->out_buffer) + mux->out_offset;
+}
 
-  /* copies the TS data of 188 bytes to the m2ts buffer at an offset
-     of 4 bytes to leave space for writing the timestamp later */
-  memcpy (GST_BUFFER_DATA (buf) + 4, data, len);
+static GstFlowReturn
+mpegtsmux_push_aggregate (MpegTsMux * mux)
+{
+  GstBuffer *buf = mux->out_buffer;
 
-  if (new_pcr < 0) {
-    /* If theres no pcr in current ts packet then just add the packet
-       to the adapter for later output when we see a PCR */
-    GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
-    gst_adapter_push (mux->adapter, buf);
-    return TRUE;
+  mux->out_buffer = NULL;
+  mux->out_reserved = FALSE;
+
+  if (mux->out_offset == 0) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
   }
 
-  chunk_bytes = gst_adapter_available (mux->adapter);
+  GST_BUFFER_SIZE (buf) = mux->out_offset;
+  GST_BUFFER_TIMESTAMP (buf) = mux->out_ts;
+  if (mux->out_delta)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_set_caps (buf, GST_PAD_CAPS (mux->srcpad));
 
-  /* We have a new PCR, output anything in the adapter */
-  if (mux->first_pcr) {
-    /* We can't generate sensible timestamps for anything that might
-     * be in the adapter preceding the first PCR and will hit a divide
-     * by zero, so empty the adapter. This is probably a null op. */
-    gst_adapter_clear (mux->adapter);
-    /* Warn if we threw anything away */
-    if (chunk_bytes) {
-      GST_ELEMENT_WARNING (mux, STREAM, MUX,
-          ("Discarding %d bytes from stream preceding first PCR",
-              chunk_bytes / M2TS_PACKET_LENGTH * NORMAL_TS_PACKET_LENGTH),
-          (NULL));
-      chunk_bytes = 0;
+  GST_LOG_OBJECT (mux, "Outputting a buffer of length %u with ts %"
+      GST_TIME_FORMAT, mux->out_offset, GST_TIME_ARGS (mux->out_ts));
+
+  return gst_pad_push (mux->srcpad, buf);
+}
+
+static void
+mpegtsmux_drop_aggregate (MpegTsMux * mux)
+{
+  if (mux->out_buffer) {
+    gst_buffer_unref (mux->out_buffer);
+    mux->out_buffer = NULL;
+  }
+  mux->out_reserved = FALSE;
+}
+
+static GstFlowReturn
+mpegtsmux_aggregate (MpegTsMux * mux, guint8 * data, guint len,
+    GstClockTime ts, gboolean delta)
+{
+  GstFlowReturn ret;
+
+  if (mux->out_reserved &&
+      data == GST_BUFFER_DATA (mux->out_buffer) + mux->out_offset) {
+    /* tsmux wrote the packet in place */
+    mux->out_reserved = FALSE;
+  } else {
+    if (mpegtsmux_aggregate_must_push (mux, ts, delta)) {
+      ret = mpegtsmux_push_aggregate (mux);
+      if (G_UNLIKELY (ret != GST_FLOW_OK))
+        return ret;
     }
-    mux->first_pcr = FALSE;
+    memcpy (mpegtsmux_aggregate_reserve (mux, len, ts, delta), data, len);
   }
 
-  if (chunk_bytes) {
-    /* Start the PCR offset counting at 192 bytes: At the end of the packet
-     * that had the last PCR */
-    guint64 pcr_bytes = M2TS_PACKET_LENGTH, ts_rate;
+  mux->out_offset += len;
+  if (mux->out_offset + len > GST_BUFFER_SIZE (mux->out_buffer))
+    return mpegtsmux_push_aggregate (mux);
 
-    /* Include the pending packet size to get the ts_rate right */
-    chunk_bytes += M2TS_PACKET_LENGTH;
+  return GST_FLOW_OK;
+}
 
-    /* calculate rate based on latest and previous pcr values */
-    ts_rate = gst_util_uint64_scale (chunk_bytes, CLOCK_FREQ_SCR,
+static guint8 *
+alloc_packet_cb (void *user_data)
+{
+  /* Called before TsMux writes a packet. M2TS packets get their header
+   * once the next PCR is known and are aggregated when pushed, a full
+   * buffer is pushed when the packet is written */
+  MpegTsMux *mux = (MpegTsMux *) user_data;
+
+  if (mux->alignment == 0 || mux->m2ts_mode ||
+      mpegtsmux_aggregate_must_push (mux, mux->last_ts, mux->is_delta))
+    return NULL;
+
+  mux->out_reserved = TRUE;
+
+  return mpegtsmux_aggregate_reserve (mux, NORMAL_TS_PACKET_LENGTH,
+      mux->last_ts, mux->is_delta);
+}
+
+/* Pushes the packets from start to end in the M2TS packet array as one
+ * buffer */
+static GstFlowReturn
+mpegtsmux_push_m2ts_packets (MpegTsMux * mux, guint start, guint end,
+    GstClockTime ts, gboolean delta)
+{
+  GstBuffer *buf;
+  guint size = (end - start) * M2TS_PACKET_LENGTH;
+
+  buf = gst_buffer_new_and_alloc (size);
+  memcpy (GST_BUFFER_DATA (buf),
+      mux->m2ts_packets + start * M2TS_PACKET_LENGTH, size);
+  GST_BUFFER_TIMESTAMP (buf) = ts;
+  if (delta)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  gst_buffer_set_caps (buf, GST_PAD_CAPS (mux->srcpad));
+
+  GST_LOG_OBJECT (mux, "Outputting %u packets with ts %" GST_TIME_FORMAT,
+      end - start, GST_TIME_ARGS (ts));
+
+  return gst_pad_push (mux->srcpad, buf);
+}
+
+/* Writes the arrival timestamps of the collected packets, the last of which
+ * carries new_pcr, and pushes them */
+static GstFlowReturn
+mpegtsmux_flush_m2ts_packets (MpegTsMux * mux, gint64 new_pcr)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint n_packets = mux->m2ts_packets_len / M2TS_PACKET_LENGTH;
+  guint64 ts_rate = 0;
+  GstClockTime start_ts = GST_CLOCK_TIME_NONE;
+  gboolean start_delta = TRUE;
+  guint i, start = 0;
+
+  /* calculate rate based on latest and previous pcr values, the
+   * PCR offset counting starts at the end of the packet that had the last
+   * PCR */
+  if (n_packets > 1 && new_pcr > mux->previous_pcr) {
+    ts_rate = gst_util_uint64_scale (mux->m2ts_packets_len, CLOCK_FREQ_SCR,
         (new_pcr - mux->previous_pcr));
     GST_LOG_OBJECT (mux, "Processing pending packets with ts_rate %"
         G_GUINT64_FORMAT, ts_rate);
+  }
 
-    while (1) {
-      guint64 cur_pcr;
+  for (i = 0; i < n_packets && ret == GST_FLOW_OK; i++) {
+    guint8 *packet = mux->m2ts_packets + i * M2TS_PACKET_LENGTH;
+    gboolean delta = GST_READ_UINT32_BE (packet) == 0;
+    guint64 cur_pcr;
+    GstClockTime ts;
+
+    /* The header is the bottom 30 bits of the PCR, apparently not
+     * encoded into base + ext as in the packets themselves, so
+     * we can just interpolate, mask and insert */
+    if (i == n_packets - 1 || ts_rate == 0)
+      cur_pcr = new_pcr;
+    else
+      cur_pcr = mux->previous_pcr + gst_util_uint64_scale ((i + 1) *
+          M2TS_PACKET_LENGTH, CLOCK_FREQ_SCR, ts_rate);
+
+    GST_WRITE_UINT32_BE (packet, cur_pcr & 0x3FFFFFFF);
+    ts = MPEG_SYS_TIME_TO_GSTTIME (cur_pcr);
+
+    if (mux->alignment > 0) {
+      ret = mpegtsmux_aggregate (mux, packet, M2TS_PACKET_LENGTH, ts, delta);
+    } else if (i == start || !delta) {
+      /* a keyframe starts a new buffer */
+      if (i > start)
+        ret = mpegtsmux_push_m2ts_packets (mux, start, i, start_ts,
+            start_delta);
+      start = i;
+      start_ts = ts;
+      start_delta = delta;
+    }
+  }
 
-      /* Loop, pulling packets of the adapter, updating their 4 byte
-       * timestamp header and pushing */
+  if (mux->alignment == 0 && ret == GST_FLOW_OK && n_packets > start)
+    ret = mpegtsmux_push_m2ts_packets (mux, start, n_packets, start_ts,
+        start_delta);
 
-      /* The header is the bottom 30 bits of the PCR, apparently not
-       * encoded into base + ext as in the packets themselves, so
-       * we can just interpolate, mask and insert */
-      cur_pcr = (mux->previous_pcr +
-          gst_util_uint64_scale (pcr_bytes, CLOCK_FREQ_SCR, ts_rate));
+  mux->m2ts_packets_len = 0;
 
-      out_buf = gst_adapter_take_buffer (mux->adapter, M2TS_PACKET_LENGTH);
-      if (G_UNLIKELY (!out_buf))
-        break;
-      gst_buffer_set_caps (out_buf, GST_PAD_CAPS (mux->srcpad));
-      GST_BUFFER_TIMESTAMP (out_buf) = MPEG_SYS_TIME_TO_GSTTIME (cur_pcr);
-
-      /* Write the 4 byte timestamp value, bottom 30 bits only = PCR */
-      GST_WRITE_UINT32_BE (GST_BUFFER_DATA (out_buf), cur_pcr & 0x3FFFFFFF);
-
-      GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
-          G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, cur_pcr);
-      ret = gst_pad_push (mux->srcpad, out_buf);
-      if (G_UNLIKELY (ret != GST_FLOW_OK)) {
-        mux->last_flow_ret = ret;
-        return FALSE;
-      }
-      pcr_bytes += M2TS_PACKET_LENGTH;
+  return ret;
+}
+
+static gboolean
+new_packet_m2ts (MpegTsMux * mux, guint8 * data, guint len, gint64 new_pcr)
+{
+  GstFlowReturn ret;
+  guint8 *packet;
+
+  GST_LOG_OBJECT (mux, "Have buffer with new_pcr=%" G_GINT64_FORMAT " size %d",
+      new_pcr, len);
+
+  /* tsmux always writes 188 byte packets */
+  g_return_val_if_fail (len == NORMAL_TS_PACKET_LENGTH, FALSE);
+
+  if (new_packet_is_streamheader (mux, data)) {
+    GstBuffer *buf = gst_buffer_new_and_alloc (M2TS_PACKET_LENGTH);
+
+    GST_WRITE_UINT32_BE (GST_BUFFER_DATA (buf), 0);
+    memcpy (GST_BUFFER_DATA (buf) + 4, data, len);
+    mux->streamheader = g_list_append (mux->streamheader, buf);
+  }
+
+  if (new_pcr >= 0 && mux->first_pcr) {
+    /* We can't generate sensible timestamps for anything that might
+     * be collected before the first PCR and will hit a divide
+     * by zero, so drop it. This is probably a null op. */
+    if (mux->m2ts_packets_len) {
+      GST_ELEMENT_WARNING (mux, STREAM, MUX,
+          ("Discarding %d bytes from stream preceding first PCR",
+              mux->m2ts_packets_len / M2TS_PACKET_LENGTH *
+              NORMAL_TS_PACKET_LENGTH), (NULL));
+      mux->m2ts_packets_len = 0;
     }
+    mux->first_pcr = FALSE;
   }
 
-  /* Finally, output the passed in packet */
-  /* Only write the bottom 30 bits of the PCR */
-  GST_WRITE_UINT32_BE (GST_BUFFER_DATA (buf), new_pcr & 0x3FFFFFFF);
-  GST_BUFFER_TIMESTAMP (buf) = MPEG_SYS_TIME_TO_GSTTIME (new_pcr);
+  /* Packets are collected until the next PCR is known, the array is
+   * reused for every PCR interval */
+  if (mux->m2ts_packets_len + M2TS_PACKET_LENGTH > mux->m2ts_packets_size) {
+    mux->m2ts_packets_size = MAX (mux->m2ts_packets_size * 2,
+        64 * M2TS_PACKET_LENGTH);
+    mux->m2ts_packets = g_realloc (mux->m2ts_packets, mux->m2ts_packets_size);
+  }
+  packet = mux->m2ts_packets + mux->m2ts_packets_len;
+  mux->m2ts_packets_len += M2TS_PACKET_LENGTH;
 
-  GST_LOG_OBJECT (mux, "Outputting a packet of length %d PCR %"
-      G_GUINT64_FORMAT, M2TS_PACKET_LENGTH, new_pcr);
-  ret = gst_pad_push (mux->srcpad, buf);
+  /* Until the timestamp is written the 4 byte header marks the packets that
+   * start a keyframe */
+  if (mux->is_delta) {
+    GST_WRITE_UINT32_BE (packet, 0);
+  } else {
+    GST_DEBUG_OBJECT (mux, "marking as non-delta unit");
+    GST_WRITE_UINT32_BE (packet, 1);
+    mux->is_delta = TRUE;
+  }
+  memcpy (packet + 4, data, len);
+
+  if (new_pcr < 0) {
+    GST_LOG_OBJECT (mux, "Accumulating non-PCR packet");
+    return TRUE;
+  }
+
+  ret = mpegtsmux_flush_m2ts_packets (mux, new_pcr);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     mux->last_flow_ret = ret;
     return FALSE;
@@ -966,6 +1186,24 @@ new_packet_normal_ts (MpegTsMux * mux, guint8 * data, guint len, gint64 new_pcr)
   GstBuffer *buf;
   GstFlowReturn ret;
 
+  if (mux->alignment > 0) {
+    gboolean delta = mux->is_delta;
+
+    if (new_packet_is_streamheader (mux, data)) {
+      buf = gst_buffer_new_and_alloc (len);
+      memcpy (GST_BUFFER_DATA (buf), data, len);
+      mux->streamheader = g_list_append (mux->streamheader, buf);
+    }
+    mux->is_delta = TRUE;
+
+    ret = mpegtsmux_aggregate (mux, data, len, mux->last_ts, delta);
+    if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      mux->last_flow_ret = ret;
+      return FALSE;
+    }
+    return TRUE;
+  }
+
   /* Output a normal TS packet */
   GST_LOG_OBJECT (mux, "Outputting a packet of length %d", len);
   buf = gst_buffer_new_and_alloc (len);
@@ -1073,10 +1311,10 @@ mpegtsmux_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_collect_pads_stop (mux->collect);
+      mpegtsmux_drop_aggregate (mux);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
-      if (mux->adapter)
-        gst_adapter_clear (mux->adapter);
+      mux->m2ts_packets_len = 0;
       break;
     default:
       break;
@@ -85,7 +85,6 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
-#include <gst/base/gstadapter.h>
 
 G_BEGIN_DECLS
 
@@ -116,7 +115,10 @@ struct MpegTsMux {
 
   gboolean first;
   GstFlowReturn last_flow_ret;
-  GstAdapter *adapter;
+  /* M2TS packets waiting for the next PCR to get their timestamp */
+  guint8 *m2ts_packets;
+  guint m2ts_packets_len;
+  guint m2ts_packets_size;
   gint64 previous_pcr;
   gboolean m2ts_mode;
   gboolean first_pcr;
@@ -128,6 +130,16 @@ struct MpegTsMux {
 
   GList *streamheader;
   gboolean streamheader_sent;
+
+  /* packets per output buffer, 0 pushes each packet on its own */
+  guint alignment;
+  GstClockTime aggregate_time;
+
+  GstBuffer *out_buffer;  /* output buffer being filled */
+  guint out_offset;
+  GstClockTime out_ts;    /* timestamp of its first packet */
+  gboolean out_delta;
+  gboolean out_reserved;  /* the next packet was handed to tsmux */
 };
 
 struct MpegTsMuxClass  {
@@ -135,6 +135,8 @@ tsmux_new (void)
   mux->last_pat_ts = -1;
   mux->pat_interval = TSMUX_DEFAULT_PAT_INTERVAL;
 
+  mux->packet = mux->packet_buf;
+
   return mux;
 }
 
@@ -156,6 +158,26 @@ tsmux_set_write_func (TsMux * mux, TsMuxWriteFunc func, void *user_data)
   mux->write_func_data = user_data;
 }
 
+/**
+ * tsmux_set_alloc_func:
+ * @mux: a #TsMux
+ * @func: a user callback function
+ * @user_data: user data passed to @func
+ *
+ * Set the callback function and user data to be called before @mux writes a
+ * packet. @func returns %TSMUX_PACKET_LENGTH bytes of memory to write the
+ * packet to, which are then passed to the write function, or %NULL to let
+ * @mux write the packet to its own buffer.
+ */
+void
+tsmux_set_alloc_func (TsMux * mux, TsMuxAllocFunc func, void *user_data)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->alloc_func = func;
+  mux->alloc_func_data = user_data;
+}
+
 /**
  * tsmux_set_pat_interval:
  * @mux: a #TsMux
@@ -428,13 +450,26 @@ tsmux_find_stream (TsMux * mux, guint16 pid)
   return found;
 }
 
+static guint8 *
+tsmux_get_packet (TsMux * mux)
+{
+  guint8 *packet = NULL;
+
+  if (mux->alloc_func)
+    packet = mux->alloc_func (mux->alloc_func_data);
+
+  mux->packet = packet ? packet : mux->packet_buf;
+
+  return mux->packet;
+}
+
 static gboolean
 tsmux_packet_out (TsMux * mux)
 {
   if (G_UNLIKELY (mux->write_func == NULL))
     return TRUE;
 
-  return mux->write_func (mux->packet_buf, TSMUX_PACKET_LENGTH,
+  return mux->write_func (mux->packet, TSMUX_PACKET_LENGTH,
       mux->write_func_data, mux->new_pcr);
 }
 
@@ -699,9 +734,9 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
 {
   guint payload_len, payload_offs;
   TsMuxPacketInfo *pi = &stream->pi;
+  guint8 *packet;
   gboolean res;
 
-
   mux->new_pcr = -1;
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
@@ -774,11 +809,12 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
     tsmux_stream_initialize_pes_packet (stream);
   pi->stream_avail = tsmux_stream_bytes_avail (stream);
 
-  if (!tsmux_write_ts_header (mux->packet_buf, pi, &payload_len, &payload_offs))
+  packet = tsmux_get_packet (mux);
+
+  if (!tsmux_write_ts_header (packet, pi, &payload_len, &payload_offs))
     return FALSE;
 
-  if (!tsmux_stream_get_data (stream, mux->packet_buf + payload_offs,
-          payload_len))
+  if (!tsmux_stream_get_data (stream, packet + payload_offs, payload_len))
     return FALSE;
 
   res = tsmux_packet_out (mux);
@@ -821,11 +857,13 @@ tsmux_write_section (TsMux * mux, TsMuxSection * section)
   payload_remain = pi->stream_avail;
 
   while (payload_remain > 0) {
+    guint8 *packet = tsmux_get_packet (mux);
+
     if (pi->packet_start_unit_indicator) {
       /* Need to write an extra single byte start pointer */
       pi->stream_avail++;
 
-      if (!tsmux_write_ts_header (mux->packet_buf, pi,
+      if (!tsmux_write_ts_header (packet, pi,
               &payload_len, &payload_offs)) {
         pi->stream_avail--;
         return FALSE;
@@ -833,21 +871,20 @@ tsmux_write_section (TsMux * mux, TsMuxSection * section)
       pi->stream_avail--;
 
       /* Write the pointer byte */
-      mux->packet_buf[payload_offs] = 0x00;
+      packet[payload_offs] = 0x00;
 
       payload_offs++;
       payload_len--;
       pi->packet_start_unit_indicator = FALSE;
     } else {
-      if (!tsmux_write_ts_header (mux->packet_buf, pi,
-              &payload_len, &payload_offs))
+      if (!tsmux_write_ts_header (packet, pi, &payload_len, &payload_offs))
         return FALSE;
     }
 
     TS_DEBUG ("Outputting %d bytes to section. %d remaining after",
         payload_len, payload_remain - payload_len);
 
-    memcpy (mux->packet_buf + payload_offs, cur_in, payload_len);
+    memcpy (packet + payload_offs, cur_in, payload_len);
 
     cur_in += payload_len;
     payload_remain -= payload_len;
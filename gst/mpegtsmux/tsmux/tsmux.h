@@ -100,6 +100,7 @@ typedef struct TsMuxSection TsMuxSection;
 typedef struct TsMux TsMux;
 
 typedef gboolean (*TsMuxWriteFunc) (guint8 *data, guint len, void *user_data, gint64 new_pcr);
+typedef guint8 * (*TsMuxAllocFunc) (void *user_data);
 
 struct TsMuxSection {
   TsMuxPacketInfo pi;
@@ -148,8 +149,11 @@ struct TsMux {
   gint64   last_pat_ts;
 
   guint8 packet_buf[TSMUX_PACKET_LENGTH];
+  guint8 *packet;  /* packet being written, packet_buf or from alloc_func */
   TsMuxWriteFunc write_func;
   void *write_func_data;
+  TsMuxAllocFunc alloc_func;
+  void *alloc_func_data;
 
   /* Scratch space for writing ES_info descriptors */
   guint8 es_info_buf[TSMUX_MAX_ES_INFO_LENGTH];
@@ -162,6 +166,7 @@ void 		tsmux_free 			(TsMux *mux);
 
 /* Setting muxing session properties */
 void 		tsmux_set_write_func 		(TsMux *mux, TsMuxWriteFunc func, void *user_data);
+void 		tsmux_set_alloc_func 		(TsMux *mux, TsMuxAllocFunc func, void *user_data);
 void 		tsmux_set_pat_interval          (TsMux *mux, guint interval);
 guint 		tsmux_get_pat_interval          (TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
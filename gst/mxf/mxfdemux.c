@@ -110,13 +110,26 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_INDEX_CACHE_DIRECTORY,
+  PROP_BYTES_COPIED,
+  PROP_BYTES_FORWARDED,
+  PROP_GROWING_FILE,
+  PROP_GROWING_FILE_TIMEOUT
 };
 
+#define DEFAULT_GROWING_FILE_TIMEOUT (10 * GST_SECOND)
+/* Interval at which the end of a growing file is polled */
+#define GROWING_FILE_POLL_INTERVAL (100 * GST_MSECOND)
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstEvent * event);
 static const GstQueryType *gst_mxf_demux_src_query_type (GstPad * pad);
 static gboolean gst_mxf_demux_src_query (GstPad * pad, GstQuery * query);
+static void gst_mxf_demux_update_index (GstMXFDemux * demux);
+static void gst_mxf_demux_apply_index_table_segments (GstMXFDemux * demux,
+    GstMXFDemuxPartition * partition);
+static void gst_mxf_demux_save_index_cache (GstMXFDemux * demux);
 
 GST_BOILERPLATE (GstMXFDemux, gst_mxf_demux, GstElement, GST_TYPE_ELEMENT);
 
@@ -248,6 +261,24 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   gst_mxf_demux_remove_pads (demux);
 
+  if (demux->index_dirty)
+    gst_mxf_demux_save_index_cache (demux);
+  demux->index_dirty = FALSE;
+  demux->index_loaded = FALSE;
+  demux->file_size = 0;
+
+  GST_OBJECT_LOCK (demux);
+  GST_DEBUG_OBJECT (demux, "copied %" G_GUINT64_FORMAT " bytes, forwarded %"
+      G_GUINT64_FORMAT " bytes", demux->bytes_copied, demux->bytes_forwarded);
+  demux->bytes_copied = 0;
+  demux->bytes_forwarded = 0;
+  GST_OBJECT_UNLOCK (demux);
+  demux->packet_merged = FALSE;
+
+  demux->growing = FALSE;
+  demux->growth_wait = 0;
+  demux->growth_scan_offset = 0;
+
   if (demux->random_index_pack) {
     g_array_free (demux->random_index_pack, TRUE);
     demux->random_index_pack = NULL;
@@ -417,6 +448,11 @@ gst_mxf_demux_handle_partition_pack (GstMXFDemux * demux, const MXFUL * key,
   if (partition.type == MXF_PARTITION_PACK_HEADER)
     demux->footer_partition_pack_offset = partition.footer_partition;
 
+  if (demux->growing && partition.type == MXF_PARTITION_PACK_FOOTER) {
+    GST_DEBUG_OBJECT (demux, "Found footer partition, file is complete");
+    demux->growing = FALSE;
+  }
+
   for (l = demux->partitions; l; l = l->next) {
     GstMXFDemuxPartition *tmp = l->data;
 
@@ -437,6 +473,12 @@ gst_mxf_demux_handle_partition_pack (GstMXFDemux * demux, const MXFUL * key,
         (GCompareFunc) gst_mxf_demux_partition_compare);
   }
 
+  /* Writers of growing files repeat the header metadata in the body
+   * partitions, don't resolve it again every time */
+  if (demux->growing && demux->metadata_resolved
+      && partition.type == MXF_PARTITION_PACK_BODY)
+    p->parsed_metadata = TRUE;
+
   for (l = demux->partitions; l; l = l->next) {
     GstMXFDemuxPartition *a, *b;
 
@@ -751,7 +793,9 @@ gst_mxf_demux_update_essence_tracks (GstMXFDemux * demux)
         goto next;
       }
 
-      if (track->parent.sequence->duration > etrack->duration)
+      /* The duration in the header of a growing file is outdated */
+      if (!demux->growing
+          && track->parent.sequence->duration > etrack->duration)
         etrack->duration = track->parent.sequence->duration;
 
       g_free (etrack->mapping_data);
@@ -1136,6 +1180,10 @@ gst_mxf_demux_update_tracks (GstMXFDemux * demux)
         pad->current_component_start += component->start_position;
       }
       pad->current_essence_track_position = pad->current_component_start;
+
+      if (demux->growing
+          && track->parent.sequence->n_structural_components == 1)
+        pad->current_component_duration = -1;
     }
 
     /* NULL iff playing a source package */
@@ -1192,6 +1240,8 @@ gst_mxf_demux_update_tracks (GstMXFDemux * demux)
 
   g_static_rw_lock_writer_unlock (&demux->metadata_lock);
 
+  gst_mxf_demux_update_index (demux);
+
   for (l = pads; l; l = l->next)
     gst_element_add_pad (GST_ELEMENT_CAST (demux), l->data);
   g_list_free (pads);
@@ -1387,10 +1437,14 @@ gst_mxf_demux_handle_generic_container_system_item (GstMXFDemux * demux,
       "Handling generic container system item of size %u"
       " at offset %" G_GUINT64_FORMAT, GST_BUFFER_SIZE (buffer), demux->offset);
 
-  if (demux->current_partition->essence_container_offset == 0)
+  if (demux->current_partition->essence_container_offset == 0) {
     demux->current_partition->essence_container_offset =
         demux->offset - demux->current_partition->partition.this_partition -
         demux->run_in;
+    /* the index tables of this partition can be resolved now */
+    gst_mxf_demux_apply_index_table_segments (demux,
+        demux->current_partition);
+  }
 
   /* TODO: parse this */
   return GST_FLOW_OK;
@@ -1508,6 +1562,11 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   }
   pad->current_essence_track_position = pad->current_component_start;
 
+  /* The last component of a growing file grows with it */
+  if (demux->growing
+      && pad->current_component_index + 1 >= sequence->n_structural_components)
+    pad->current_component_duration = -1;
+
 
   if (!gst_caps_is_equal (GST_PAD_CAPS (pad), pad->current_essence_track->caps)) {
     gst_pad_set_caps (GST_PAD_CAST (pad), pad->current_essence_track->caps);
@@ -1531,6 +1590,71 @@ gst_mxf_demux_pad_set_component (GstMXFDemux * demux, GstMXFDemuxPad * pad,
   return ret;
 }
 
+/* Finds the position of the edit unit starting at or containing @offset.
+ * Index table entries point to the start of the edit unit, which contains
+ * the essence elements of all tracks in interleaved essence containers */
+static gint64
+gst_mxf_demux_find_index_position (GstMXFDemuxEssenceTrack * etrack,
+    guint64 offset)
+{
+  GstMXFDemuxIndex *entries;
+  gint64 low, high, mid, known, found = -1;
+
+  if (!etrack->offsets || etrack->offsets->len == 0)
+    return -1;
+
+  entries = (GstMXFDemuxIndex *) etrack->offsets->data;
+  low = 0;
+  high = etrack->offsets->len - 1;
+
+  while (low <= high) {
+    mid = (low + high) / 2;
+
+    /* the offsets grow with the positions but can be unknown */
+    known = mid;
+    while (known >= low && entries[known].offset == 0)
+      known--;
+
+    if (known < low) {
+      low = mid + 1;
+    } else if (entries[known].offset <= offset) {
+      found = known;
+      low = mid + 1;
+    } else {
+      high = known - 1;
+    }
+  }
+
+  if (found == -1)
+    return -1;
+  if (entries[found].offset == offset)
+    return found;
+  if (found + 1 < etrack->offsets->len && entries[found + 1].offset > offset)
+    return found;
+
+  return -1;
+}
+
+/* Counts the essence of @packet once, as forwarded if @outbuf is a part of
+ * the packet's data that the adapter didn't have to merge. Handlers only
+ * allocate a new buffer if the essence must be repacked. */
+static void
+gst_mxf_demux_count_essence (GstMXFDemux * demux, GstBuffer * packet,
+    GstBuffer * outbuf)
+{
+  gboolean forwarded = !demux->packet_merged &&
+      GST_BUFFER_DATA (outbuf) >= GST_BUFFER_DATA (packet) &&
+      GST_BUFFER_DATA (outbuf) + GST_BUFFER_SIZE (outbuf) <=
+      GST_BUFFER_DATA (packet) + GST_BUFFER_SIZE (packet);
+
+  GST_OBJECT_LOCK (demux);
+  if (forwarded)
+    demux->bytes_forwarded += GST_BUFFER_SIZE (outbuf);
+  else
+    demux->bytes_copied += GST_BUFFER_SIZE (outbuf);
+  GST_OBJECT_UNLOCK (demux);
+}
+
 static GstFlowReturn
 gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, gboolean peek)
@@ -1552,10 +1676,14 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   GST_DEBUG_OBJECT (demux, "  essence element type = 0x%02x", key->u[14]);
   GST_DEBUG_OBJECT (demux, "  essence element number = 0x%02x", key->u[15]);
 
-  if (demux->current_partition->essence_container_offset == 0)
+  if (demux->current_partition->essence_container_offset == 0) {
     demux->current_partition->essence_container_offset =
         demux->offset - demux->current_partition->partition.this_partition -
         demux->run_in;
+    /* the index tables of this partition can be resolved now */
+    gst_mxf_demux_apply_index_table_segments (demux,
+        demux->current_partition);
+  }
 
   if (!demux->current_package) {
     GST_ERROR_OBJECT (demux, "No package selected yet");
@@ -1594,17 +1722,9 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   if (etrack->position == -1) {
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
-      for (i = 0; i < etrack->offsets->len; i++) {
-        GstMXFDemuxIndex *idx =
-            &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
-
-        if (idx->offset != 0 && idx->offset == demux->offset - demux->run_in) {
-          etrack->position = i;
-          break;
-        }
-      }
-    }
+    etrack->position =
+        gst_mxf_demux_find_index_position (etrack,
+        demux->offset - demux->run_in);
 
     if (etrack->position == -1) {
       GST_WARNING_OBJECT (demux, "Essence track position not in index");
@@ -1629,12 +1749,16 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
         etrack->handle_func (key, inbuf, etrack->caps,
         etrack->source_track, etrack->mapping_data, &outbuf);
     inbuf = NULL;
+
   } else {
     outbuf = inbuf;
     inbuf = NULL;
     ret = GST_FLOW_OK;
   }
 
+  if (ret == GST_FLOW_OK && outbuf && !peek)
+    gst_mxf_demux_count_essence (demux, buffer, outbuf);
+
   if (ret != GST_FLOW_OK) {
     GST_ERROR_OBJECT (demux, "Failed to handle essence element");
     if (outbuf) {
@@ -1655,6 +1779,8 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
       GstMXFDemuxIndex *index =
           &g_array_index (etrack->offsets, GstMXFDemuxIndex, etrack->position);
 
+      if (index->offset == 0)
+        demux->index_dirty = TRUE;
       index->offset = demux->offset - demux->run_in;
       index->keyframe = keyframe;
     } else {
@@ -1663,6 +1789,7 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
       index.offset = demux->offset - demux->run_in;
       index.keyframe = keyframe;
       g_array_insert_val (etrack->offsets, etrack->position, index);
+      demux->index_dirty = TRUE;
     }
   }
 
@@ -1900,6 +2027,7 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer)
 {
   MXFIndexTableSegment *segment;
+  GList *l;
 
   GST_DEBUG_OBJECT (demux,
       "Handling index table segment of size %u at offset %"
@@ -1916,9 +2044,25 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
           GST_BUFFER_SIZE (buffer))) {
 
     GST_ERROR_OBJECT (demux, "Parsing index table segment failed");
+    g_free (segment);
     return GST_FLOW_ERROR;
   }
 
+  /* they were pulled already when starting in pull mode */
+  for (l = demux->pending_index_table_segments; l; l = l->next) {
+    MXFIndexTableSegment *tmp = l->data;
+
+    if (tmp->index_sid == segment->index_sid &&
+        tmp->body_sid == segment->body_sid &&
+        tmp->index_start_position == segment->index_start_position &&
+        tmp->index_duration == segment->index_duration) {
+      GST_DEBUG_OBJECT (demux, "Index table segment already known");
+      mxf_index_table_segment_reset (segment);
+      g_free (segment);
+      return GST_FLOW_OK;
+    }
+  }
+
   demux->pending_index_table_segments =
       g_list_prepend (demux->pending_index_table_segments, segment);
 
@@ -1926,9 +2070,11 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
   return GST_FLOW_OK;
 }
 
+/* Pulls the key and the length of the KLV packet at @offset, and gives the
+ * size of both in @header_size */
 static GstFlowReturn
-gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
-    GstBuffer ** outbuf, guint * read)
+gst_mxf_demux_pull_klv_header (GstMXFDemux * demux, guint64 offset,
+    MXFUL * key, guint64 * packet_length, guint * header_size)
 {
   GstBuffer *buffer = NULL;
   const guint8 *data;
@@ -1980,8 +2126,28 @@ gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
     }
   }
 
-  gst_buffer_unref (buffer);
-  buffer = NULL;
+  *packet_length = length;
+  *header_size = data_offset;
+
+beach:
+  if (buffer)
+    gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
+    GstBuffer ** outbuf, guint * read)
+{
+  GstBuffer *buffer = NULL;
+  guint data_offset = 0;
+  guint64 length;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if ((ret = gst_mxf_demux_pull_klv_header (demux, offset, key, &length,
+              &data_offset)) != GST_FLOW_OK)
+    goto beach;
 
   /* GStreamer's buffer sizes are stored in a guint so we
    * limit ourself to G_MAXUINT large buffers */
@@ -2027,6 +2193,7 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
   }
 
   g_assert (filesize > 4);
+  demux->file_size = filesize;
 
   if ((ret =
           gst_mxf_demux_pull_range (demux, filesize - 4, 4,
@@ -2075,6 +2242,700 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
   demux->offset = old_offset;
 }
 
+/* Growing files
+ *
+ * Files that are still being written have no footer partition and random
+ * index pack yet. Their header metadata has no or outdated durations, so
+ * the tracks are played until the end of the file, which is polled until
+ * the footer partition shows up or the file stops growing. On every poll
+ * the packets appended after the last known partition are walked to pick
+ * up the new partitions and index table segments, and the duration is the
+ * number of edit units in the index.
+ */
+
+static gint64
+gst_mxf_demux_pad_get_growing_duration (GstMXFDemuxPad * pad)
+{
+  GstMXFDemuxEssenceTrack *etrack = pad->current_essence_track;
+
+  if (!etrack || !etrack->offsets || !etrack->source_track
+      || !pad->material_track || pad->material_track->edit_rate.n <= 0
+      || pad->material_track->edit_rate.d <= 0)
+    return -1;
+
+  /* in edit units of the material track */
+  return gst_util_uint64_scale (etrack->offsets->len,
+      etrack->source_track->edit_rate.n * pad->material_track->edit_rate.d,
+      etrack->source_track->edit_rate.d * pad->material_track->edit_rate.n);
+}
+
+static void
+gst_mxf_demux_update_growing_duration (GstMXFDemux * demux)
+{
+  gint64 duration = -1;
+  guint i;
+
+  for (i = 0; i < demux->src->len; i++) {
+    GstMXFDemuxPad *pad = g_ptr_array_index (demux->src, i);
+    gint64 pdur = gst_mxf_demux_pad_get_growing_duration (pad);
+
+    if (pdur <= 0)
+      continue;
+
+    pdur = gst_util_uint64_scale (pdur,
+        GST_SECOND * pad->material_track->edit_rate.d,
+        pad->material_track->edit_rate.n);
+    duration = MAX (duration, pdur);
+  }
+
+  if (duration == -1 || (demux->segment.duration != -1
+          && duration <= demux->segment.duration))
+    return;
+
+  GST_DEBUG_OBJECT (demux, "Duration grew to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (duration));
+  gst_segment_set_duration (&demux->segment, GST_FORMAT_TIME, duration);
+  gst_element_post_message (GST_ELEMENT_CAST (demux),
+      gst_message_new_duration (GST_OBJECT_CAST (demux), GST_FORMAT_TIME,
+          duration));
+}
+
+/* Skips the essence from the last known partition on and handles the
+ * complete partition packs and index table segments, so the index runs
+ * ahead of the data that was read */
+static void
+gst_mxf_demux_scan_growth (GstMXFDemux * demux)
+{
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+  GstMXFDemuxPartition *p;
+  gboolean found = FALSE;
+  guint64 offset, length;
+  guint header_size;
+  MXFUL key;
+
+  if (!demux->partitions)
+    return;
+
+  /* everything after the last partition pack belongs to it */
+  p = g_list_last (demux->partitions)->data;
+  offset = MAX (demux->growth_scan_offset,
+      demux->run_in + p->partition.this_partition);
+  demux->current_partition = p;
+
+  while (demux->growing && gst_mxf_demux_pull_klv_header (demux, offset,
+          &key, &length, &header_size) == GST_FLOW_OK) {
+    p = demux->current_partition;
+
+    if (mxf_is_partition_pack (&key) || mxf_is_index_table_segment (&key)) {
+      GstBuffer *buffer = NULL;
+      GstFlowReturn ret;
+
+      /* not completely written yet */
+      if (gst_mxf_demux_pull_klv_packet (demux, offset, &key, &buffer,
+              NULL) != GST_FLOW_OK)
+        break;
+
+      demux->offset = offset;
+      if (mxf_is_partition_pack (&key))
+        ret = gst_mxf_demux_handle_partition_pack (demux, &key, buffer);
+      else
+        ret = gst_mxf_demux_handle_index_table_segment (demux, &key, buffer);
+      gst_buffer_unref (buffer);
+
+      if (ret != GST_FLOW_OK)
+        break;
+      found = TRUE;
+    } else if (p->partition.body_sid != 0 && p->essence_container_offset == 0
+        && (mxf_is_generic_container_system_item (&key)
+            || mxf_is_generic_container_essence_element (&key)
+            || mxf_is_avid_essence_container_essence_element (&key))) {
+      p->essence_container_offset =
+          offset - demux->run_in - p->partition.this_partition;
+      found = TRUE;
+    }
+
+    offset += header_size + length;
+    demux->growth_scan_offset = offset;
+  }
+
+  /* offsets that are already known are not touched again */
+  if (found)
+    gst_mxf_demux_apply_index_table_segments (demux, NULL);
+
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+}
+
+/* Interrupts or allows again waiting for the file to grow */
+static void
+gst_mxf_demux_set_growth_flushing (GstMXFDemux * demux, gboolean flushing)
+{
+  g_mutex_lock (demux->growth_lock);
+  demux->growth_flushing = flushing;
+  g_cond_signal (demux->growth_cond);
+  g_mutex_unlock (demux->growth_lock);
+}
+
+/* Returns GST_FLOW_OK to retry reading at the current offset,
+ * GST_FLOW_UNEXPECTED once the file is considered complete and
+ * GST_FLOW_WRONG_STATE if the wait was interrupted */
+static GstFlowReturn
+gst_mxf_demux_wait_for_growth (GstMXFDemux * demux)
+{
+  GTimeVal end;
+  gboolean flushing;
+
+  if (demux->growing_file_timeout != 0 &&
+      demux->growth_wait >= demux->growing_file_timeout) {
+    GST_DEBUG_OBJECT (demux, "File didn't grow for %" GST_TIME_FORMAT
+        ", assuming it is complete", GST_TIME_ARGS (demux->growth_wait));
+    demux->growing = FALSE;
+    return GST_FLOW_UNEXPECTED;
+  }
+
+  gst_mxf_demux_scan_growth (demux);
+  gst_mxf_demux_update_growing_duration (demux);
+
+  /* the footer partition was written, read on */
+  if (!demux->growing)
+    return GST_FLOW_OK;
+
+  GST_LOG_OBJECT (demux, "Waiting for the file to grow");
+  g_get_current_time (&end);
+  g_time_val_add (&end, GROWING_FILE_POLL_INTERVAL / GST_USECOND);
+
+  g_mutex_lock (demux->growth_lock);
+  while (!demux->growth_flushing &&
+      g_cond_timed_wait (demux->growth_cond, demux->growth_lock, &end));
+  flushing = demux->growth_flushing;
+  g_mutex_unlock (demux->growth_lock);
+
+  if (flushing) {
+    GST_DEBUG_OBJECT (demux, "Waiting for the file to grow interrupted");
+    return GST_FLOW_WRONG_STATE;
+  }
+
+  demux->growth_wait += GROWING_FILE_POLL_INTERVAL;
+
+  return GST_FLOW_OK;
+}
+
+/* Essence offset index
+ *
+ * The offsets of the edit units of each essence track are kept in its
+ * offsets array, sorted by position. In pull mode they are filled from the
+ * index table segments of all partitions listed in the random index pack
+ * before playback starts, and from the ones found while playing otherwise.
+ * Whatever is not covered by index tables is added while reading the
+ * essence. The result can be cached in a file named after the material
+ * package UMID, which spares walking the partitions the next time.
+ */
+
+/* cache file: magic, version, file size, footer partition offset, number
+ * of tracks, then for every track its body SID, track number, number of
+ * offsets and the offsets, with the keyframe flag in the highest bit, all
+ * big endian */
+#define MXF_INDEX_CACHE_MAGIC GST_MAKE_FOURCC ('M', 'X', 'I', 'X')
+#define MXF_INDEX_CACHE_VERSION 2
+#define MXF_INDEX_CACHE_HEADER_SIZE 28
+#define MXF_INDEX_CACHE_KEYFRAME G_GUINT64_CONSTANT (0x8000000000000000)
+
+/* Most edit units an index can have when neither the duration of the track
+ * nor the size of the file are known, a day at 60 edit units per second */
+#define MXF_INDEX_MAX_EDIT_UNITS (24 * 3600 * 60)
+
+/* Each edit unit takes at least a byte of the file and there are no more
+ * than the track has, if its duration is final */
+static gint64
+gst_mxf_demux_get_max_edit_units (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack)
+{
+  GstFormat fmt = GST_FORMAT_BYTES;
+  gint64 size = demux->file_size;
+
+  if (etrack->duration > 0 && !demux->growing)
+    return etrack->duration;
+
+  if (size == 0 && (!gst_pad_query_peer_duration (demux->sinkpad, &fmt,
+              &size) || fmt != GST_FORMAT_BYTES || size <= 0))
+    return MXF_INDEX_MAX_EDIT_UNITS;
+
+  return size;
+}
+
+/* Applies @segment to the tracks. If @partition is not NULL only the entries
+ * in its essence, from stream offset @start up to @end, are applied */
+static void
+gst_mxf_demux_apply_index_table_segment (GstMXFDemux * demux,
+    MXFIndexTableSegment * segment, GstMXFDemuxPartition * partition,
+    guint64 start, guint64 end)
+{
+  GstMXFDemuxPartition **partitions = NULL;
+  gboolean has_random_access = FALSE;
+  guint n_partitions = 0;
+  guint first = 0, last = segment->n_index_entries;
+  GList *l;
+  guint i, j, k;
+
+  /* Constant edit unit sizes are also used for clip wrapped essence, where
+   * edit units are not KLV packets of their own. These are left to the
+   * offsets found while reading */
+  if (segment->n_index_entries == 0 || segment->body_sid == 0)
+    return;
+
+  if (partition) {
+    if (partition->partition.body_sid != segment->body_sid ||
+        segment->index_entries[0].stream_offset >= end ||
+        segment->index_entries[segment->n_index_entries -
+            1].stream_offset < start)
+      return;
+
+    /* The entries are sorted by stream offset, only look at the ones
+     * inside the partition */
+    while (first < last) {
+      guint mid = first + (last - first) / 2;
+
+      if (segment->index_entries[mid].stream_offset < start)
+        first = mid + 1;
+      else
+        last = mid;
+    }
+    last = first;
+    while (last < segment->n_index_entries &&
+        segment->index_entries[last].stream_offset < end)
+      last++;
+
+    partitions = g_new (GstMXFDemuxPartition *, 1);
+    partitions[n_partitions++] = partition;
+  } else {
+    partitions =
+        g_new (GstMXFDemuxPartition *, g_list_length (demux->partitions));
+    for (l = demux->partitions; l; l = l->next) {
+      GstMXFDemuxPartition *p = l->data;
+
+      if (p->partition.body_sid == segment->body_sid)
+        partitions[n_partitions++] = p;
+    }
+  }
+
+  for (j = 0; j < segment->n_index_entries; j++) {
+    if (segment->index_entries[j].flags & 0x80) {
+      has_random_access = TRUE;
+      break;
+    }
+  }
+
+  for (i = 0; i < demux->essence_tracks->len && n_partitions > 0; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+    guint n_added = 0;
+
+    if (etrack->body_sid != segment->body_sid)
+      continue;
+
+    if (segment->index_start_position < 0 ||
+        segment->index_start_position + segment->n_index_entries >
+        gst_mxf_demux_get_max_edit_units (demux, etrack)) {
+      GST_WARNING_OBJECT (demux, "Skipping index table segment with %u "
+          "entries from position %" G_GINT64_FORMAT " for track %u",
+          segment->n_index_entries, segment->index_start_position,
+          etrack->track_number);
+      continue;
+    }
+
+    if (!etrack->offsets)
+      etrack->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    if (etrack->offsets->len <
+        segment->index_start_position + segment->n_index_entries)
+      g_array_set_size (etrack->offsets,
+          segment->index_start_position + segment->n_index_entries);
+
+    /* Both the entries and the partitions are sorted by stream offset */
+    k = 0;
+    for (j = first; j < last; j++) {
+      MXFIndexEntry *entry = &segment->index_entries[j];
+      GstMXFDemuxIndex *idx;
+      GstMXFDemuxPartition *p;
+
+      while (k + 1 < n_partitions &&
+          partitions[k + 1]->partition.body_offset <= entry->stream_offset)
+        k++;
+      p = partitions[k];
+
+      if (entry->stream_offset < p->partition.body_offset ||
+          p->essence_container_offset == 0)
+        continue;
+
+      idx = &g_array_index (etrack->offsets, GstMXFDemuxIndex,
+          segment->index_start_position + j);
+      if (idx->offset != 0)
+        continue;
+
+      idx->offset = p->partition.this_partition + p->essence_container_offset +
+          entry->stream_offset - p->partition.body_offset;
+      idx->keyframe = !has_random_access || (entry->flags & 0x80);
+      n_added++;
+    }
+
+    if (n_added > 0) {
+      GST_DEBUG_OBJECT (demux, "Added %u offsets from position %"
+          G_GINT64_FORMAT " to the index of track %u", n_added,
+          segment->index_start_position, etrack->track_number);
+      demux->index_dirty = TRUE;
+    }
+  }
+
+  g_free (partitions);
+}
+
+/* applies the index tables to the tracks, only for the essence of
+ * @partition if not NULL */
+static void
+gst_mxf_demux_apply_index_table_segments (GstMXFDemux * demux,
+    GstMXFDemuxPartition * partition)
+{
+  guint64 start = 0, end = G_MAXUINT64;
+  GList *l;
+
+  if (partition) {
+    if (partition->partition.body_sid == 0)
+      return;
+
+    /* The essence of the partition ends where the next one of the same
+     * body SID starts */
+    start = partition->partition.body_offset;
+    l = g_list_find (demux->partitions, partition);
+    for (l = l ? l->next : NULL; l; l = l->next) {
+      GstMXFDemuxPartition *p = l->data;
+
+      if (p->partition.body_sid == partition->partition.body_sid) {
+        end = p->partition.body_offset;
+        break;
+      }
+    }
+  }
+
+  for (l = demux->pending_index_table_segments; l; l = l->next)
+    gst_mxf_demux_apply_index_table_segment (demux, l->data, partition,
+        start, end);
+}
+
+/* Pulls the index table segments of all partitions known from the random
+ * index pack, and finds where their essence container starts */
+static void
+gst_mxf_demux_pull_index_table_segments (GstMXFDemux * demux)
+{
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+  GList *l;
+
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *p = l->data;
+    GstBuffer *buffer = NULL;
+    GstFlowReturn ret;
+    guint64 offset, length;
+    guint read, header_size;
+    MXFUL key;
+
+    offset = demux->offset = demux->run_in + p->partition.this_partition;
+    ret = gst_mxf_demux_pull_klv_packet (demux, offset, &key, &buffer, &read);
+    if (ret != GST_FLOW_OK)
+      continue;
+
+    if (!mxf_is_partition_pack (&key) ||
+        gst_mxf_demux_handle_partition_pack (demux, &key,
+            buffer) != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      continue;
+    }
+    gst_buffer_unref (buffer);
+    offset += read;
+
+    if (p->partition.index_byte_count == 0 &&
+        (p->partition.body_sid == 0 || p->essence_container_offset != 0))
+      continue;
+
+    /* Try to skip the header metadata at once */
+    if (p->partition.header_byte_count != 0 &&
+        gst_mxf_demux_pull_klv_header (demux,
+            offset + p->partition.header_byte_count, &key, &length,
+            &header_size) == GST_FLOW_OK && (mxf_is_fill (&key)
+            || mxf_is_index_table_segment (&key)
+            || mxf_is_generic_container_system_item (&key)
+            || mxf_is_generic_container_essence_element (&key)
+            || mxf_is_avid_essence_container_essence_element (&key)))
+      offset += p->partition.header_byte_count;
+
+    while (gst_mxf_demux_pull_klv_header (demux, offset, &key, &length,
+            &header_size) == GST_FLOW_OK) {
+      if (mxf_is_index_table_segment (&key)) {
+        demux->offset = offset;
+        if (gst_mxf_demux_pull_klv_packet (demux, offset, &key, &buffer,
+                NULL) == GST_FLOW_OK) {
+          gst_mxf_demux_handle_index_table_segment (demux, &key, buffer);
+          gst_buffer_unref (buffer);
+        }
+      } else if (!mxf_is_fill (&key) && !mxf_is_primer_pack (&key) &&
+          !mxf_is_metadata (&key) && !mxf_is_descriptive_metadata (&key)) {
+        if (p->partition.body_sid != 0 &&
+            (mxf_is_generic_container_system_item (&key) ||
+                mxf_is_generic_container_essence_element (&key) ||
+                mxf_is_avid_essence_container_essence_element (&key)))
+          p->essence_container_offset =
+              offset - demux->run_in - p->partition.this_partition;
+        break;
+      }
+      offset += header_size + length;
+    }
+  }
+
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+}
+
+static gchar *
+gst_mxf_demux_get_index_cache_location (GstMXFDemux * demux)
+{
+  gchar *filename, *location;
+
+  if (!demux->index_cache_directory || !demux->current_package_string)
+    return NULL;
+
+  filename = g_strdup_printf ("%s.index", demux->current_package_string);
+  location = g_build_filename (demux->index_cache_directory, filename, NULL);
+  g_free (filename);
+
+  return location;
+}
+
+/* The footer partition tells apart files of the same size, it is 0 if
+ * neither the header partition nor the random index pack give it */
+static guint64
+gst_mxf_demux_get_footer_offset (GstMXFDemux * demux)
+{
+  MXFRandomIndexPackEntry *e;
+
+  if (demux->footer_partition_pack_offset != 0)
+    return demux->footer_partition_pack_offset;
+
+  if (!demux->random_index_pack || demux->random_index_pack->len == 0)
+    return 0;
+
+  e = &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry,
+      demux->random_index_pack->len - 1);
+
+  return e->offset - demux->run_in;
+}
+
+/* Reads the tracks of the index cache from @data, and adds their offsets
+ * to the index if @apply is TRUE. Returns FALSE if the cache is truncated
+ * or its offsets are not sorted or not inside the file. */
+static gboolean
+gst_mxf_demux_read_index_cache (GstMXFDemux * demux, const guint8 * data,
+    const guint8 * end, gboolean apply)
+{
+  guint32 n_tracks, i;
+
+  n_tracks = GST_READ_UINT32_BE (data + 24);
+  data += MXF_INDEX_CACHE_HEADER_SIZE;
+
+  for (i = 0; i < n_tracks; i++) {
+    GstMXFDemuxEssenceTrack *etrack = NULL;
+    guint32 body_sid, track_number, n_offsets, j, k;
+    guint64 last = 0;
+
+    if (end - data < 12)
+      return FALSE;
+    body_sid = GST_READ_UINT32_BE (data);
+    track_number = GST_READ_UINT32_BE (data + 4);
+    n_offsets = GST_READ_UINT32_BE (data + 8);
+    data += 12;
+    if ((end - data) / 8 < n_offsets)
+      return FALSE;
+
+    for (k = 0; k < demux->essence_tracks->len && apply; k++) {
+      GstMXFDemuxEssenceTrack *tmp =
+          &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, k);
+
+      if (tmp->body_sid == body_sid && tmp->track_number == track_number) {
+        etrack = tmp;
+        break;
+      }
+    }
+
+    if (etrack) {
+      if (!etrack->offsets)
+        etrack->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+      if (etrack->offsets->len < n_offsets)
+        g_array_set_size (etrack->offsets, n_offsets);
+    }
+
+    for (j = 0; j < n_offsets; j++, data += 8) {
+      guint64 v = GST_READ_UINT64_BE (data);
+      guint64 offset = v & ~MXF_INDEX_CACHE_KEYFRAME;
+      GstMXFDemuxIndex *idx;
+
+      /* 0 for the edit units that were not found */
+      if (offset == 0)
+        continue;
+
+      if (offset <= last || offset >= demux->file_size) {
+        GST_WARNING_OBJECT (demux, "Invalid offset %" G_GUINT64_FORMAT
+            " of edit unit %u of track %u", offset, j, track_number);
+        return FALSE;
+      }
+      last = offset;
+
+      if (!etrack)
+        continue;
+
+      idx = &g_array_index (etrack->offsets, GstMXFDemuxIndex, j);
+      if (idx->offset == 0) {
+        idx->offset = offset;
+        idx->keyframe = ! !(v & MXF_INDEX_CACHE_KEYFRAME);
+      }
+    }
+
+    if (etrack)
+      GST_DEBUG_OBJECT (demux, "Loaded %u offsets of track %u", n_offsets,
+          track_number);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_mxf_demux_load_index_cache (GstMXFDemux * demux)
+{
+  GError *err = NULL;
+  gchar *location, *contents = NULL;
+  gsize length;
+  const guint8 *data, *end;
+  gboolean ret = FALSE;
+
+  location = gst_mxf_demux_get_index_cache_location (demux);
+  if (!location || demux->file_size == 0)
+    goto done;
+
+  if (!g_file_get_contents (location, &contents, &length, &err)) {
+    GST_DEBUG_OBJECT (demux, "No index cache loaded from %s: %s", location,
+        err->message);
+    g_error_free (err);
+    goto done;
+  }
+
+  data = (const guint8 *) contents;
+  end = data + length;
+  if (length < MXF_INDEX_CACHE_HEADER_SIZE ||
+      GST_READ_UINT32_BE (data) != MXF_INDEX_CACHE_MAGIC ||
+      GST_READ_UINT32_BE (data + 4) != MXF_INDEX_CACHE_VERSION) {
+    GST_WARNING_OBJECT (demux, "Invalid index cache %s", location);
+    goto done;
+  }
+
+  if (GST_READ_UINT64_BE (data + 8) != demux->file_size ||
+      GST_READ_UINT64_BE (data + 16) !=
+      gst_mxf_demux_get_footer_offset (demux)) {
+    GST_DEBUG_OBJECT (demux, "Index cache %s is for another file", location);
+    goto done;
+  }
+
+  /* nothing is added to the index unless the whole cache is valid */
+  if (!gst_mxf_demux_read_index_cache (demux, data, end, FALSE)) {
+    GST_WARNING_OBJECT (demux, "Invalid index cache %s", location);
+    goto done;
+  }
+  gst_mxf_demux_read_index_cache (demux, data, end, TRUE);
+
+  GST_INFO_OBJECT (demux, "Loaded index cache %s", location);
+  ret = TRUE;
+
+done:
+  g_free (contents);
+  g_free (location);
+
+  return ret;
+}
+
+static void
+gst_mxf_demux_save_index_cache (GstMXFDemux * demux)
+{
+  GError *err = NULL;
+  gchar *location;
+  guint8 *contents, *data;
+  gsize length;
+  guint i, j;
+
+  location = gst_mxf_demux_get_index_cache_location (demux);
+  /* only known in pull mode */
+  if (!location || demux->file_size == 0)
+    goto done;
+
+  length = MXF_INDEX_CACHE_HEADER_SIZE;
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+
+    length += 12 + (etrack->offsets ? 8 * etrack->offsets->len : 0);
+  }
+
+  data = contents = g_malloc (length);
+  GST_WRITE_UINT32_BE (data, MXF_INDEX_CACHE_MAGIC);
+  GST_WRITE_UINT32_BE (data + 4, MXF_INDEX_CACHE_VERSION);
+  GST_WRITE_UINT64_BE (data + 8, demux->file_size);
+  GST_WRITE_UINT64_BE (data + 16, gst_mxf_demux_get_footer_offset (demux));
+  GST_WRITE_UINT32_BE (data + 24, demux->essence_tracks->len);
+  data += MXF_INDEX_CACHE_HEADER_SIZE;
+
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+    guint n_offsets = etrack->offsets ? etrack->offsets->len : 0;
+
+    GST_WRITE_UINT32_BE (data, etrack->body_sid);
+    GST_WRITE_UINT32_BE (data + 4, etrack->track_number);
+    GST_WRITE_UINT32_BE (data + 8, n_offsets);
+    data += 12;
+
+    for (j = 0; j < n_offsets; j++, data += 8) {
+      GstMXFDemuxIndex *idx =
+          &g_array_index (etrack->offsets, GstMXFDemuxIndex, j);
+
+      GST_WRITE_UINT64_BE (data,
+          idx->offset | (idx->keyframe ? MXF_INDEX_CACHE_KEYFRAME : 0));
+    }
+  }
+
+  if (g_file_set_contents (location, (gchar *) contents, length, &err)) {
+    GST_INFO_OBJECT (demux, "Saved index cache %s", location);
+  } else {
+    GST_WARNING_OBJECT (demux, "Failed to save index cache %s: %s", location,
+        err->message);
+    g_error_free (err);
+  }
+  g_free (contents);
+
+done:
+  g_free (location);
+}
+
+/* called whenever the essence tracks were updated */
+static void
+gst_mxf_demux_update_index (GstMXFDemux * demux)
+{
+  if (demux->random_access && !demux->index_loaded) {
+    demux->index_loaded = TRUE;
+
+    if (gst_mxf_demux_load_index_cache (demux))
+      demux->index_dirty = FALSE;
+    else if (demux->random_index_pack)
+      gst_mxf_demux_pull_index_table_segments (demux);
+  }
+
+  gst_mxf_demux_apply_index_table_segments (demux, NULL);
+}
+
 static void
 gst_mxf_demux_parse_footer_metadata (GstMXFDemux * demux)
 {
@@ -2278,6 +3139,9 @@ gst_mxf_demux_handle_klv_packet (GstMXFDemux * demux, const MXFUL * key,
   } else if (mxf_is_partition_pack (key)) {
     ret = gst_mxf_demux_handle_partition_pack (demux, key, buffer);
 
+    if (ret == GST_FLOW_OK && demux->growing)
+      gst_mxf_demux_update_growing_duration (demux);
+
     /* If this partition contains the start of an essence container
      * set the positions of all essence streams to 0
      */
@@ -2332,7 +3196,8 @@ gst_mxf_demux_handle_klv_packet (GstMXFDemux * demux, const MXFUL * key,
       && demux->current_partition->partition.type == MXF_PARTITION_PACK_HEADER
       && (!demux->current_partition->partition.closed
           || !demux->current_partition->partition.complete)
-      && (demux->footer_partition_pack_offset != 0 || demux->random_index_pack)) {
+      && (demux->footer_partition_pack_offset != 0 || demux->random_index_pack)
+      && !demux->growing) {
     GST_DEBUG_OBJECT (demux,
         "Open or incomplete header partition, trying to get final metadata from the last partitions");
     gst_mxf_demux_parse_footer_metadata (demux);
@@ -2483,7 +3348,8 @@ from_index:
           gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
           &read);
 
-      if (ret == GST_FLOW_UNEXPECTED) {
+      /* The end of a growing file is not the end of its tracks */
+      if (ret == GST_FLOW_UNEXPECTED && !demux->growing) {
         for (i = 0; i < demux->essence_tracks->len; i++) {
           GstMXFDemuxEssenceTrack *t =
               &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack,
@@ -2563,6 +3429,14 @@ gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
       gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
       &read);
 
+  if (ret == GST_FLOW_OK) {
+    demux->growth_wait = 0;
+  } else if (ret == GST_FLOW_UNEXPECTED && demux->growing) {
+    /* Incomplete or no packet at the end, try again later */
+    if ((ret = gst_mxf_demux_wait_for_growth (demux)) == GST_FLOW_OK)
+      goto beach;
+  }
+
   if (ret == GST_FLOW_UNEXPECTED && demux->src->len > 0) {
     guint i;
     GstMXFDemuxPad *p = NULL;
@@ -2718,8 +3592,12 @@ gst_mxf_demux_loop (GstPad * pad)
       goto pause;
     }
 
-    /* First of all pull&parse the random index pack at EOF */
-    gst_mxf_demux_pull_random_index_pack (demux);
+    /* First of all pull&parse the random index pack at EOF, growing
+     * files have none yet */
+    if (demux->growing_file)
+      demux->growing = TRUE;
+    else
+      gst_mxf_demux_pull_random_index_pack (demux);
   }
 
   /* Now actually do something */
@@ -2953,10 +3831,16 @@ gst_mxf_demux_chain (GstPad * pad, GstBuffer * inbuf)
     gst_adapter_flush (demux->adapter, offset);
 
     if (length > 0) {
+      /* The adapter returns a subbuffer if the packet is contained in
+       * a single input buffer and has to merge them otherwise */
+      demux->packet_merged =
+          gst_adapter_available_fast (demux->adapter) < length;
+
       buffer = gst_adapter_take_buffer (demux->adapter, length);
 
       ret = gst_mxf_demux_handle_klv_packet (demux, &key, buffer, FALSE);
       gst_buffer_unref (buffer);
+      demux->packet_merged = FALSE;
     }
 
     demux->offset += offset + length;
@@ -3213,6 +4097,9 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
   flush = ! !(flags & GST_SEEK_FLAG_FLUSH);
   keyframe = ! !(flags & GST_SEEK_FLAG_KEY_UNIT);
 
+  /* Don't keep waiting for a growing file */
+  gst_mxf_demux_set_growth_flushing (demux, TRUE);
+
   if (flush) {
     GstEvent *e;
 
@@ -3229,6 +4116,7 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
 
   /* Take the stream lock */
   GST_PAD_STREAM_LOCK (demux->sinkpad);
+  gst_mxf_demux_set_growth_flushing (demux, FALSE);
 
   if (flush) {
     GstEvent *e;
@@ -3480,7 +4368,10 @@ gst_mxf_demux_src_query (GstPad * pad, GstQuery * query)
         goto error;
       }
 
-      duration = mxfpad->material_track->parent.sequence->duration;
+      if (demux->growing)
+        duration = gst_mxf_demux_pad_get_growing_duration (mxfpad);
+      else
+        duration = mxfpad->material_track->parent.sequence->duration;
       if (duration <= -1)
         duration = -1;
 
@@ -3584,11 +4475,13 @@ gst_mxf_demux_sink_activate_pull (GstPad * sinkpad, gboolean active)
 
   if (active) {
     demux->random_access = TRUE;
+    gst_mxf_demux_set_growth_flushing (demux, FALSE);
     gst_object_unref (demux);
     return gst_pad_start_task (sinkpad, (GstTaskFunction) gst_mxf_demux_loop,
         sinkpad);
   } else {
     demux->random_access = FALSE;
+    gst_mxf_demux_set_growth_flushing (demux, TRUE);
     gst_object_unref (demux);
     return gst_pad_stop_task (sinkpad);
   }
@@ -3768,7 +4661,10 @@ gst_mxf_demux_query (GstElement * element, GstQuery * query)
         if (!pad->material_track || !pad->material_track->parent.sequence)
           continue;
 
-        pdur = pad->material_track->parent.sequence->duration;
+        if (demux->growing)
+          pdur = gst_mxf_demux_pad_get_growing_duration (pad);
+        else
+          pdur = pad->material_track->parent.sequence->duration;
         if (pad->material_track->edit_rate.n == 0 ||
             pad->material_track->edit_rate.d == 0 || pdur <= -1)
           continue;
@@ -3881,6 +4777,16 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_INDEX_CACHE_DIRECTORY:
+      g_free (demux->index_cache_directory);
+      demux->index_cache_directory = g_value_dup_string (value);
+      break;
+    case PROP_GROWING_FILE:
+      demux->growing_file = g_value_get_boolean (value);
+      break;
+    case PROP_GROWING_FILE_TIMEOUT:
+      demux->growing_file_timeout = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3900,6 +4806,25 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_INDEX_CACHE_DIRECTORY:
+      g_value_set_string (value, demux->index_cache_directory);
+      break;
+    case PROP_BYTES_COPIED:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->bytes_copied);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_BYTES_FORWARDED:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->bytes_forwarded);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_GROWING_FILE:
+      g_value_set_boolean (value, demux->growing_file);
+      break;
+    case PROP_GROWING_FILE_TIMEOUT:
+      g_value_set_uint64 (value, demux->growing_file_timeout);
+      break;
     case PROP_STRUCTURE:{
       GstStructure *s;
 
@@ -3944,6 +4869,8 @@ gst_mxf_demux_finalize (GObject * object)
   demux->current_package_string = NULL;
   g_free (demux->requested_package_string);
   demux->requested_package_string = NULL;
+  g_free (demux->index_cache_directory);
+  demux->index_cache_directory = NULL;
 
   g_ptr_array_free (demux->src, TRUE);
   demux->src = NULL;
@@ -3953,6 +4880,8 @@ gst_mxf_demux_finalize (GObject * object)
   g_hash_table_destroy (demux->metadata);
 
   g_static_rw_lock_free (&demux->metadata_lock);
+  g_mutex_free (demux->growth_lock);
+  g_cond_free (demux->growth_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -3999,6 +4928,36 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIRECTORY,
+      g_param_spec_string ("index-cache-directory", "Index cache directory",
+          "Directory in which the essence offsets found in a file are cached, "
+          "named after its material package UMID (NULL to disable)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BYTES_COPIED,
+      g_param_spec_uint64 ("bytes-copied", "Bytes copied",
+          "Number of essence bytes copied because their KLV packet spanned "
+          "input buffers or they had to be repacked", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BYTES_FORWARDED,
+      g_param_spec_uint64 ("bytes-forwarded", "Bytes forwarded",
+          "Number of essence bytes pushed downstream without being repacked", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROWING_FILE,
+      g_param_spec_boolean ("growing-file", "Growing file",
+          "Play a file that is still being written from its header and body "
+          "partitions and wait for more data at its end (pull mode only)",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GROWING_FILE_TIMEOUT,
+      g_param_spec_uint64 ("growing-file-timeout", "Growing file timeout",
+          "Nanoseconds without growth after which a growing file is "
+          "considered complete (0 = wait forever)", 0, G_MAXUINT64,
+          DEFAULT_GROWING_FILE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -4026,9 +4985,12 @@ gst_mxf_demux_init (GstMXFDemux * demux, GstMXFDemuxClass * g_class)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = 500 * GST_MSECOND;
+  demux->growing_file_timeout = DEFAULT_GROWING_FILE_TIMEOUT;
 
   demux->adapter = gst_adapter_new ();
   g_static_rw_lock_init (&demux->metadata_lock);
+  demux->growth_lock = g_mutex_new ();
+  demux->growth_cond = g_cond_new ();
 
   demux->src = g_ptr_array_new ();
   demux->essence_tracks =
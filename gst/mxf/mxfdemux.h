@@ -152,6 +152,24 @@ struct _GstMXFDemux
   GList *pending_index_table_segments;
 
   GArray *random_index_pack;
+  guint64 file_size;
+
+  /* Essence offset index */
+  gboolean index_loaded;        /* Cache or index tables were loaded */
+  gboolean index_dirty;         /* Offsets were found since loading */
+
+  /* Statistics, protected by the object lock */
+  guint64 bytes_copied;         /* Essence merged or repacked before pushing */
+  guint64 bytes_forwarded;      /* Essence pushed as subbuffers of the input */
+  gboolean packet_merged;       /* Current KLV packet spanned input buffers */
+
+  /* Growing file state */
+  gboolean growing;             /* No footer seen and still growing */
+  GstClockTime growth_wait;     /* Time spent waiting at the end of the file */
+  guint64 growth_scan_offset;   /* Next KLV packet to scan ahead of playback */
+  GMutex *growth_lock;
+  GCond *growth_cond;           /* Signalled to interrupt the wait */
+  gboolean growth_flushing;     /* Protected by growth_lock */
 
   /* Metadata */
   GStaticRWLock metadata_lock;
@@ -169,6 +187,9 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gchar *index_cache_directory;
+  gboolean growing_file;
+  GstClockTime growing_file_timeout;
 };
 
 struct _GstMXFDemuxClass
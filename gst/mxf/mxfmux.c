@@ -54,9 +54,19 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL
 };
 
+#define DEFAULT_PARTITION_INTERVAL 0
+
+/* Index SID of the essence container in partitioned files */
+#define INDEX_SID 2
+
+/* Index entries are written as a local tag with a 16 bit size, start a new
+ * partition before a segment gets too large */
+#define MAX_INDEX_ENTRIES 4096
+
 GST_BOILERPLATE (GstMXFMux, gst_mxf_mux, GstElement, GST_TYPE_ELEMENT);
 
 static void gst_mxf_mux_finalize (GObject * object);
@@ -128,6 +138,14 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gobject_class->set_property = gst_mxf_mux_set_property;
   gobject_class->get_property = gst_mxf_mux_get_property;
 
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Interval in nanoseconds at which a body partition with the index "
+          "table segment of the previous one is started, which makes the file "
+          "playable while it is written (0 = a single body partition without "
+          "index)", 0, G_MAXUINT64, DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_mxf_mux_change_state);
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_request_new_pad);
@@ -150,6 +168,11 @@ gst_mxf_mux_init (GstMXFMux * mux, GstMXFMuxClass * g_class)
   gst_collect_pads_set_function (mux->collect,
       (GstCollectPadsFunction) GST_DEBUG_FUNCPTR (gst_mxf_mux_collected), mux);
 
+  mux->random_index_pack =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->index_entries = g_array_new (FALSE, FALSE, sizeof (MXFIndexEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
+
   gst_mxf_mux_reset (mux);
 }
 
@@ -169,6 +192,9 @@ gst_mxf_mux_finalize (GObject * object)
 
   gst_object_unref (mux->collect);
 
+  g_array_free (mux->random_index_pack, TRUE);
+  g_array_free (mux->index_entries, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -176,9 +202,12 @@ static void
 gst_mxf_mux_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
 {
-  //GstMXFMux *mux = GST_MXF_MUX (object);
+  GstMXFMux *mux = GST_MXF_MUX (object);
 
   switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -189,9 +218,12 @@ static void
 gst_mxf_mux_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
 {
-  //GstMXFMux *mux = GST_MXF_MUX (object);
+  GstMXFMux *mux = GST_MXF_MUX (object);
 
   switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -229,6 +261,12 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   mux->last_gc_timestamp = 0;
   mux->last_gc_position = 0;
   mux->offset = 0;
+
+  g_array_set_size (mux->random_index_pack, 0);
+  mux->body_offset = 0;
+  g_array_set_size (mux->index_entries, 0);
+  mux->index_start_position = 0;
+  mux->last_partition_timestamp = 0;
 }
 
 static gboolean
@@ -940,7 +978,8 @@ gst_mxf_mux_create_metadata (GstMXFMux * mux)
 
     cstorage->essence_container_data[0]->linked_package =
         MXF_METADATA_SOURCE_PACKAGE (cstorage->packages[1]);
-    cstorage->essence_container_data[0]->index_sid = 0;
+    cstorage->essence_container_data[0]->index_sid =
+        (mux->partition_interval > 0) ? INDEX_SID : 0;
     cstorage->essence_container_data[0]->body_sid = 1;
   }
 
@@ -1037,8 +1076,10 @@ gst_mxf_mux_init_partition_pack (GstMXFMux * mux)
   return GST_FLOW_OK;
 }
 
+/* Writes the partition pack, the header metadata and @index, if any, which
+ * is consumed */
 static GstFlowReturn
-gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
+gst_mxf_mux_write_header_metadata (GstMXFMux * mux, GstBuffer * index)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstBuffer *buf;
@@ -1059,7 +1100,12 @@ gst_mxf_mux_write_header_metadata (GstMXFMux * mux)
   header_byte_count += GST_BUFFER_SIZE (buf);
   buffers = g_list_prepend (buffers, buf);
 
+  if (index)
+    buffers = g_list_append (buffers, index);
+
   mux->partition.header_byte_count = header_byte_count;
+  mux->partition.index_byte_count = index ? GST_BUFFER_SIZE (index) : 0;
+  mux->partition.index_sid = index ? INDEX_SID : 0;
   buf = mxf_partition_pack_to_buffer (&mux->partition);
   if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
     GST_ERROR_OBJECT (mux, "Failed pushing partition: %s",
@@ -1091,6 +1137,120 @@ static const guint8 _gc_essence_element_ul[] = {
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
 };
 
+/* Partitioned files
+ *
+ * With a partition interval, a new body partition is started at the first
+ * edit unit after each interval. It contains the index table segment of
+ * the edit units of the previous partition, so readers of the growing file
+ * can seek in everything written so far, while the muxer only keeps the
+ * index entries of one partition. The index entries point to the start of
+ * the edit units, there are no delta entries for the elements in them.
+ */
+
+/* Returns the index table segment of the edit units since the last
+ * partition, or NULL */
+static GstBuffer *
+gst_mxf_mux_take_index_table_segment (GstMXFMux * mux)
+{
+  MXFIndexTableSegment segment;
+  GstBuffer *buf;
+
+  if (mux->partition_interval == 0 || mux->index_entries->len == 0)
+    return NULL;
+
+  memset (&segment, 0, sizeof (MXFIndexTableSegment));
+  mxf_uuid_init (&segment.instance_id, NULL);
+  memcpy (&segment.index_edit_rate, &mux->min_edit_rate,
+      sizeof (MXFFraction));
+  segment.index_start_position = mux->index_start_position;
+  segment.index_duration = mux->index_entries->len;
+  segment.index_sid = INDEX_SID;
+  segment.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+  segment.n_index_entries = mux->index_entries->len;
+  segment.index_entries = (MXFIndexEntry *) mux->index_entries->data;
+
+  buf = mxf_index_table_segment_to_buffer (&segment);
+
+  mux->index_start_position += mux->index_entries->len;
+  g_array_set_size (mux->index_entries, 0);
+
+  return buf;
+}
+
+static GstFlowReturn
+gst_mxf_mux_write_body_partition (GstMXFMux * mux)
+{
+  GstBuffer *buf, *index;
+  GstFlowReturn ret;
+  MXFRandomIndexPackEntry entry;
+
+  index = gst_mxf_mux_take_index_table_segment (mux);
+
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.prev_partition =
+      g_array_index (mux->random_index_pack, MXFRandomIndexPackEntry,
+      mux->random_index_pack->len - 1).offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.header_byte_count = 0;
+  mux->partition.index_byte_count = index ? GST_BUFFER_SIZE (index) : 0;
+  mux->partition.index_sid = index ? INDEX_SID : 0;
+  mux->partition.body_offset = mux->body_offset;
+  mux->partition.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+
+  entry.offset = mux->offset;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->random_index_pack, entry);
+  mux->last_partition_timestamp = mux->last_gc_timestamp;
+
+  GST_DEBUG_OBJECT (mux, "Starting body partition at offset %" G_GUINT64_FORMAT
+      ", essence offset %" G_GUINT64_FORMAT, mux->offset, mux->body_offset);
+
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+    if (index)
+      gst_buffer_unref (index);
+    return ret;
+  }
+
+  if (index)
+    ret = gst_mxf_mux_push (mux, index);
+
+  return ret;
+}
+
+/* Called before writing an element of the edit unit at last_gc_position */
+static GstFlowReturn
+gst_mxf_mux_update_index (GstMXFMux * mux, gboolean delta_unit)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  MXFIndexEntry entry;
+  guint len = mux->index_entries->len;
+
+  if (mux->last_gc_position < mux->index_start_position + len) {
+    /* Another element of the current edit unit */
+    if (delta_unit && len > 0)
+      g_array_index (mux->index_entries, MXFIndexEntry, len - 1).flags &= ~0x80;
+    return GST_FLOW_OK;
+  }
+
+  if (len > 0 && (len >= MAX_INDEX_ENTRIES ||
+          mux->last_gc_timestamp >=
+          mux->last_partition_timestamp + mux->partition_interval)) {
+    if ((ret = gst_mxf_mux_write_body_partition (mux)) != GST_FLOW_OK)
+      return ret;
+  }
+
+  memset (&entry, 0, sizeof (MXFIndexEntry));
+  entry.flags = delta_unit ? 0x00 : 0x80;
+  entry.stream_offset = mux->body_offset;
+  g_array_append_val (mux->index_entries, entry);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * cpad)
 {
@@ -1102,6 +1262,8 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * cpad)
   gboolean flush =
       (cpad->collect.abidata.ABI.eos && !cpad->have_complete_edit_unit
       && cpad->collect.buffer == NULL);
+  gboolean delta_unit;
+  guint size;
 
   if (cpad->have_complete_edit_unit) {
     GST_DEBUG_OBJECT (cpad->collect.pad,
@@ -1123,6 +1285,9 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * cpad)
         cpad->source_track->parent.track_id, cpad->pos);
   }
 
+  /* The writers don't necessarily keep the flags */
+  delta_unit = buf && GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
   ret = cpad->write_func (buf, GST_PAD_CAPS (cpad->collect.pad),
       cpad->mapping_data, cpad->adapter, &outbuf, flush);
   if (ret != GST_FLOW_OK && ret != GST_FLOW_CUSTOM_SUCCESS) {
@@ -1154,15 +1319,25 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * cpad)
       GST_BUFFER_SIZE (buf));
   gst_buffer_unref (buf);
 
+  if (mux->partition_interval > 0 &&
+      (ret = gst_mxf_mux_update_index (mux, delta_unit)) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (mux, "Failed writing body partition: %s",
+        gst_flow_get_name (ret));
+    gst_buffer_unref (packet);
+    return ret;
+  }
+
   GST_DEBUG_OBJECT (cpad->collect.pad, "Pushing buffer of size %u for track %u",
       GST_BUFFER_SIZE (packet), cpad->source_track->parent.track_id);
 
+  size = GST_BUFFER_SIZE (packet);
   if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
     GST_ERROR_OBJECT (cpad->collect.pad,
         "Failed pushing buffer for track %u, reason %s",
         cpad->source_track->parent.track_id, gst_flow_get_name (ret));
     return ret;
   }
+  mux->body_offset += size;
 
   cpad->pos++;
   cpad->last_timestamp =
@@ -1172,26 +1347,6 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * cpad)
   return ret;
 }
 
-static GstFlowReturn
-gst_mxf_mux_write_body_partition (GstMXFMux * mux)
-{
-  GstBuffer *buf;
-
-  mux->partition.type = MXF_PARTITION_PACK_BODY;
-  mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
-  mux->partition.footer_partition = 0;
-  mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
-  mux->partition.body_sid =
-      mux->preface->content_storage->essence_container_data[0]->body_sid;
-
-  buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
-}
-
 static GstFlowReturn
 gst_mxf_mux_handle_eos (GstMXFMux * mux)
 {
@@ -1284,10 +1439,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   }
 
   {
-    guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
     guint64 footer_partition = mux->offset;
-    GArray *rip;
     GstFlowReturn ret;
     MXFRandomIndexPackEntry entry;
 
@@ -1295,7 +1447,9 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
     mux->partition.this_partition = mux->offset;
-    mux->partition.prev_partition = body_partition;
+    mux->partition.prev_partition =
+        g_array_index (mux->random_index_pack, MXFRandomIndexPackEntry,
+        mux->random_index_pack->len - 1).offset;
     mux->partition.footer_partition = mux->offset;
     mux->partition.header_byte_count = 0;
     mux->partition.index_byte_count = 0;
@@ -1303,24 +1457,18 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     mux->partition.body_offset = 0;
     mux->partition.body_sid = 0;
 
-    gst_mxf_mux_write_header_metadata (mux);
+    /* With the index of the last body partition */
+    gst_mxf_mux_write_header_metadata (mux,
+        gst_mxf_mux_take_index_table_segment (mux));
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
     entry.offset = footer_partition;
     entry.body_sid = 0;
-    g_array_append_val (rip, entry);
+    g_array_append_val (mux->random_index_pack, entry);
 
-    packet = mxf_random_index_pack_to_buffer (rip);
+    packet = mxf_random_index_pack_to_buffer (mux->random_index_pack);
     if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
       GST_ERROR_OBJECT (mux, "Failed pushing random index pack");
     }
-    g_array_free (rip, TRUE);
 
     /* Rewrite header partition with updated values */
     if (gst_pad_push_event (mux->srcpad,
@@ -1339,7 +1487,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
       mux->partition.body_offset = 0;
       mux->partition.body_sid = 0;
 
-      ret = gst_mxf_mux_write_header_metadata (mux);
+      ret = gst_mxf_mux_write_header_metadata (mux, NULL);
       if (ret != GST_FLOW_OK) {
         GST_ERROR_OBJECT (mux, "Rewriting header partition failed");
         return ret;
@@ -1402,7 +1550,7 @@ gst_mxf_mux_collected (GstCollectPads * pads, gpointer user_data)
       if ((ret = gst_mxf_mux_init_partition_pack (mux)) != GST_FLOW_OK)
         goto error;
 
-      ret = gst_mxf_mux_write_header_metadata (mux);
+      ret = gst_mxf_mux_write_header_metadata (mux, NULL);
     } else {
       ret = GST_FLOW_ERROR;
     }
@@ -1413,6 +1561,14 @@ gst_mxf_mux_collected (GstCollectPads * pads, gpointer user_data)
     /* Sort pads, we will always write in that order */
     mux->collect->data = g_slist_sort (mux->collect->data, _sort_mux_pads);
 
+    {
+      MXFRandomIndexPackEntry entry;
+
+      entry.offset = 0;
+      entry.body_sid = 0;
+      g_array_append_val (mux->random_index_pack, entry);
+    }
+
     /* Write body partition */
     ret = gst_mxf_mux_write_body_partition (mux);
     if (ret != GST_FLOW_OK)
@@ -92,7 +92,19 @@ typedef struct _GstMXFMux {
   guint64 last_gc_position;
   GstClockTime last_gc_timestamp;
 
+  /* Partitions written so far, for the random index pack */
+  GArray *random_index_pack;
+  guint64 body_offset;          /* Essence bytes written so far */
+
+  /* Index entries of the edit units since the last body partition */
+  GArray *index_entries;
+  guint64 index_start_position;
+  GstClockTime last_partition_timestamp;
+
   gchar *application;
+
+  /* Properties */
+  GstClockTime partition_interval;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
@@ -163,8 +163,8 @@ mxf_up_handle_essence_element (const MXFUL * key, GstBuffer * buffer,
     return GST_FLOW_ERROR;
   }
 
-  if (data->bpp != 4
-      || GST_ROUND_UP_4 (data->width * data->bpp) != data->width * data->bpp) {
+  /* Only repack if the rows have to be padded to 4 bytes */
+  if (GST_ROUND_UP_4 (data->width * data->bpp) != data->width * data->bpp) {
     guint y;
     GstBuffer *ret;
     guint8 *indata, *outdata;
@@ -0,0 +1,236 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Pool of output frames for sdidemux.
+ *
+ * The buffers revive themselves in their finalize function and go back on
+ * the free list, so a frame is allocated once and reused for the whole
+ * stream. Every buffer holds a reference to the pool, which is freed when
+ * the element and all the outstanding buffers are gone. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstsdibufferpool.h"
+
+#define DEFAULT_MAX_FREE 8
+
+static GstMiniObjectClass *gst_sdi_buffer_parent_class;
+
+static GstSdiBufferPool *
+gst_sdi_buffer_pool_ref (GstSdiBufferPool * pool)
+{
+  g_atomic_int_inc (&pool->refcount);
+
+  return pool;
+}
+
+static void
+gst_sdi_buffer_pool_unref (GstSdiBufferPool * pool)
+{
+  if (!g_atomic_int_dec_and_test (&pool->refcount))
+    return;
+
+  g_queue_free (pool->free);
+  g_mutex_free (pool->lock);
+  g_free (pool);
+}
+
+static void
+gst_sdi_buffer_finalize (GstSdiBuffer * buf)
+{
+  GstSdiBufferPool *pool = buf->pool;
+  GstBuffer *buffer = GST_BUFFER_CAST (buf);
+
+  g_mutex_lock (pool->lock);
+  if (!pool->closed && GST_BUFFER_SIZE (buffer) == pool->size &&
+      GST_BUFFER_DATA (buffer) == GST_BUFFER_MALLOCDATA (buffer) &&
+      g_queue_get_length (pool->free) < pool->max_free) {
+    /* revive */
+    gst_buffer_ref (buffer);
+    g_queue_push_tail (pool->free, buffer);
+    g_mutex_unlock (pool->lock);
+    return;
+  }
+  g_mutex_unlock (pool->lock);
+
+  gst_sdi_buffer_pool_unref (pool);
+  buf->pool = NULL;
+
+  gst_sdi_buffer_parent_class->finalize (GST_MINI_OBJECT_CAST (buf));
+}
+
+static void
+gst_sdi_buffer_class_init (gpointer g_class, gpointer class_data)
+{
+  GstMiniObjectClass *mini_object_class = GST_MINI_OBJECT_CLASS (g_class);
+
+  gst_sdi_buffer_parent_class = g_type_class_peek_parent (g_class);
+
+  mini_object_class->finalize =
+      (GstMiniObjectFinalizeFunction) gst_sdi_buffer_finalize;
+}
+
+GType
+gst_sdi_buffer_get_type (void)
+{
+  static GType _gst_sdi_buffer_type;
+
+  if (G_UNLIKELY (_gst_sdi_buffer_type == 0)) {
+    static const GTypeInfo info = {
+      sizeof (GstBufferClass),
+      NULL,
+      NULL,
+      gst_sdi_buffer_class_init,
+      NULL,
+      NULL,
+      sizeof (GstSdiBuffer),
+      0,
+      NULL,
+      NULL
+    };
+    _gst_sdi_buffer_type = g_type_register_static (GST_TYPE_BUFFER,
+        "GstSdiBuffer", &info, 0);
+  }
+  return _gst_sdi_buffer_type;
+}
+
+static GstBuffer *
+gst_sdi_buffer_new (GstSdiBufferPool * pool, guint size)
+{
+  GstSdiBuffer *buf;
+  GstBuffer *buffer;
+
+  buf = (GstSdiBuffer *) gst_mini_object_new (GST_TYPE_SDI_BUFFER);
+  buf->pool = gst_sdi_buffer_pool_ref (pool);
+
+  /* cleared so the padding of the lines is defined */
+  buffer = GST_BUFFER_CAST (buf);
+  GST_BUFFER_MALLOCDATA (buffer) = g_malloc0 (size);
+  GST_BUFFER_DATA (buffer) = GST_BUFFER_MALLOCDATA (buffer);
+  GST_BUFFER_SIZE (buffer) = size;
+
+  return buffer;
+}
+
+GstSdiBufferPool *
+gst_sdi_buffer_pool_new (void)
+{
+  GstSdiBufferPool *pool;
+
+  pool = g_new0 (GstSdiBufferPool, 1);
+  pool->refcount = 1;
+  pool->lock = g_mutex_new ();
+  pool->free = g_queue_new ();
+  pool->max_free = DEFAULT_MAX_FREE;
+
+  return pool;
+}
+
+static void
+gst_sdi_buffer_pool_drain (GstSdiBufferPool * pool)
+{
+  GQueue *free;
+  GstBuffer *buf;
+
+  g_mutex_lock (pool->lock);
+  free = pool->free;
+  pool->free = g_queue_new ();
+  g_mutex_unlock (pool->lock);
+
+  /* the buffers don't match the pool anymore and are really freed */
+  while ((buf = g_queue_pop_head (free)))
+    gst_buffer_unref (buf);
+  g_queue_free (free);
+}
+
+/* Frees the pool once the outstanding buffers are freed, which they are
+ * then instead of going back to the pool */
+void
+gst_sdi_buffer_pool_free (GstSdiBufferPool * pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (pool->lock);
+  pool->closed = TRUE;
+  g_mutex_unlock (pool->lock);
+
+  gst_sdi_buffer_pool_drain (pool);
+  gst_sdi_buffer_pool_unref (pool);
+}
+
+/* Makes the pool hand out buffers of @size bytes and preallocates
+ * @n_buffers of them. Buffers of the previous size are freed. */
+void
+gst_sdi_buffer_pool_set_size (GstSdiBufferPool * pool, guint size,
+    guint n_buffers)
+{
+  gboolean resized;
+  guint i;
+
+  g_return_if_fail (pool != NULL);
+
+  g_mutex_lock (pool->lock);
+  resized = (pool->size != size);
+  pool->size = size;
+  pool->max_free = MAX (DEFAULT_MAX_FREE, n_buffers);
+  i = resized ? 0 : g_queue_get_length (pool->free);
+  g_mutex_unlock (pool->lock);
+
+  if (resized)
+    gst_sdi_buffer_pool_drain (pool);
+
+  for (; i < n_buffers; i++) {
+    GstBuffer *buf = gst_sdi_buffer_new (pool, size);
+
+    g_mutex_lock (pool->lock);
+    g_queue_push_tail (pool->free, buf);
+    g_mutex_unlock (pool->lock);
+  }
+}
+
+/* Returns a buffer of the size of the pool without timestamps, flags or
+ * caps. Its contents are those of the last frame it held. */
+GstBuffer *
+gst_sdi_buffer_pool_get_buffer (GstSdiBufferPool * pool)
+{
+  GstBuffer *buf;
+  guint size;
+
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  g_mutex_lock (pool->lock);
+  buf = g_queue_pop_head (pool->free);
+  size = pool->size;
+  g_mutex_unlock (pool->lock);
+
+  if (buf == NULL) {
+    GST_LOG ("pool empty, allocating a buffer of %u bytes", size);
+    return gst_sdi_buffer_new (pool, size);
+  }
+
+  GST_MINI_OBJECT_FLAGS (buf) = 0;
+  GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_OFFSET (buf) = GST_BUFFER_OFFSET_NONE;
+  GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET_NONE;
+  gst_buffer_set_caps (buf, NULL);
+
+  return buf;
+}
@@ -0,0 +1,64 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_SDI_BUFFER_POOL_H_
+#define _GST_SDI_BUFFER_POOL_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SDI_BUFFER   (gst_sdi_buffer_get_type())
+#define GST_SDI_BUFFER(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SDI_BUFFER,GstSdiBuffer))
+#define GST_IS_SDI_BUFFER(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SDI_BUFFER))
+
+typedef struct _GstSdiBuffer GstSdiBuffer;
+typedef struct _GstSdiBufferPool GstSdiBufferPool;
+
+/* A buffer that goes back to its pool instead of being freed, as long as
+ * the pool is alive and still hands out buffers of its size */
+struct _GstSdiBuffer
+{
+  GstBuffer buffer;
+
+  GstSdiBufferPool *pool;
+};
+
+struct _GstSdiBufferPool
+{
+  gint refcount;
+
+  GMutex *lock;
+  GQueue *free;
+  guint size;
+  guint max_free;
+  gboolean closed;
+};
+
+GType gst_sdi_buffer_get_type (void);
+
+GstSdiBufferPool *gst_sdi_buffer_pool_new (void);
+void gst_sdi_buffer_pool_free (GstSdiBufferPool * pool);
+
+void gst_sdi_buffer_pool_set_size (GstSdiBufferPool * pool, guint size,
+    guint n_buffers);
+GstBuffer *gst_sdi_buffer_pool_get_buffer (GstSdiBufferPool * pool);
+
+G_END_DECLS
+
+#endif
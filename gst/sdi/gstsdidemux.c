@@ -39,6 +39,9 @@
 #include <string.h>
 #include "gstsdidemux.h"
 
+GST_DEBUG_CATEGORY_STATIC (gst_sdi_demux_debug);
+#define GST_CAT_DEFAULT gst_sdi_demux_debug
+
 /* prototypes */
 
 
@@ -55,13 +58,21 @@ static GstFlowReturn gst_sdi_demux_chain (GstPad * pad, GstBuffer * buffer);
 static gboolean gst_sdi_demux_sink_event (GstPad * pad, GstEvent * event);
 static gboolean gst_sdi_demux_src_event (GstPad * pad, GstEvent * event);
 static GstCaps *gst_sdi_demux_src_getcaps (GstPad * pad);
+static void gst_sdi_demux_reset (GstSdiDemux * sdidemux);
 
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_MODE
 };
 
+#define DEFAULT_MODE GST_SDI_DEMUX_MODE_PAL
+
+/* output frames allocated up front, more are allocated when downstream
+ * holds on to them */
+#define N_PREALLOCATED_BUFFERS 4
+
 /* pad templates */
 
 #define GST_VIDEO_CAPS_NTSC(fourcc) \
@@ -80,6 +91,10 @@ enum
   "video/x-raw-yuv,format=(fourcc)" fourcc ",width=720,height=576," \
   "framerate=25/1,interlaced=TRUE,pixel-aspect-ratio=16/11," \
   "chroma-site=mpeg2,color-matrix=sdtv"
+#define GST_VIDEO_CAPS_HD(fourcc) \
+  "video/x-raw-yuv,format=(fourcc)" fourcc ",width=(int){1280,1920}," \
+  "height=(int){720,1080},framerate=(fraction)[1/1,60/1]," \
+  "pixel-aspect-ratio=1/1,chroma-site=mpeg2,color-matrix=hdtv"
 
 static GstStaticPadTemplate gst_sdi_demux_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -92,10 +107,65 @@ static GstStaticPadTemplate gst_sdi_demux_src_template =
     GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_NTSC ("UYVY") ";"
-        GST_VIDEO_CAPS_PAL ("UYVY"))
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_NTSC ("{UYVY,v210}") ";"
+        GST_VIDEO_CAPS_PAL ("{UYVY,v210}") ";"
+        GST_VIDEO_CAPS_HD ("{UYVY,v210}"))
     );
 
+/* indexed by GstSdiDemuxMode */
+static const GstSdiFormat gst_sdi_formats[] = {
+  /* lines, active lines, width, start0, start1, tff, active width,
+   * framerate, pixel aspect ratio, hd */
+  {525, 480, 858, 20, 283, 0, 720, 30000, 1001, 10, 11, FALSE},
+  {625, 576, 864, 23, 336, 1, 720, 25, 1, 12, 11, FALSE},
+  {750, 720, 1980, 26, 0, 0, 1280, 50, 1, 1, 1, TRUE},
+  {750, 720, 1650, 26, 0, 0, 1280, 60000, 1001, 1, 1, TRUE},
+  {750, 720, 1650, 26, 0, 0, 1280, 60, 1, 1, 1, TRUE},
+  {1125, 1080, 2640, 21, 584, 1, 1920, 25, 1, 1, 1, TRUE},
+  {1125, 1080, 2200, 21, 584, 1, 1920, 30000, 1001, 1, 1, TRUE},
+  {1125, 1080, 2200, 21, 584, 1, 1920, 30, 1, 1, 1, TRUE},
+  {1125, 1080, 2750, 42, 0, 0, 1920, 24000, 1001, 1, 1, TRUE},
+  {1125, 1080, 2750, 42, 0, 0, 1920, 24, 1, 1, 1, TRUE},
+  {1125, 1080, 2640, 42, 0, 0, 1920, 25, 1, 1, 1, TRUE},
+  {1125, 1080, 2200, 42, 0, 0, 1920, 30000, 1001, 1, 1, TRUE},
+  {1125, 1080, 2200, 42, 0, 0, 1920, 30, 1, 1, 1, TRUE},
+  {1125, 1080, 2640, 42, 0, 0, 1920, 50, 1, 1, 1, TRUE},
+  {1125, 1080, 2200, 42, 0, 0, 1920, 60000, 1001, 1, 1, TRUE},
+  {1125, 1080, 2200, 42, 0, 0, 1920, 60, 1, 1, 1, TRUE}
+};
+
+#define GST_TYPE_SDI_DEMUX_MODE (gst_sdi_demux_mode_get_type ())
+static GType
+gst_sdi_demux_mode_get_type (void)
+{
+  static GType mode_type = 0;
+  static const GEnumValue modes[] = {
+    {GST_SDI_DEMUX_MODE_NTSC, "SD 525 lines (NTSC)", "ntsc"},
+    {GST_SDI_DEMUX_MODE_PAL, "SD 625 lines (PAL)", "pal"},
+    {GST_SDI_DEMUX_MODE_720P50, "HD 720p 50", "720p50"},
+    {GST_SDI_DEMUX_MODE_720P5994, "HD 720p 59.94", "720p59.94"},
+    {GST_SDI_DEMUX_MODE_720P60, "HD 720p 60", "720p60"},
+    {GST_SDI_DEMUX_MODE_1080I50, "HD 1080i 50", "1080i50"},
+    {GST_SDI_DEMUX_MODE_1080I5994, "HD 1080i 59.94", "1080i59.94"},
+    {GST_SDI_DEMUX_MODE_1080I60, "HD 1080i 60", "1080i60"},
+    {GST_SDI_DEMUX_MODE_1080P2398, "HD 1080p 23.98", "1080p23.98"},
+    {GST_SDI_DEMUX_MODE_1080P24, "HD 1080p 24", "1080p24"},
+    {GST_SDI_DEMUX_MODE_1080P25, "HD 1080p 25", "1080p25"},
+    {GST_SDI_DEMUX_MODE_1080P2997, "HD 1080p 29.97", "1080p29.97"},
+    {GST_SDI_DEMUX_MODE_1080P30, "HD 1080p 30", "1080p30"},
+    {GST_SDI_DEMUX_MODE_1080P50, "3G 1080p 50 (level A)", "1080p50"},
+    {GST_SDI_DEMUX_MODE_1080P5994, "3G 1080p 59.94 (level A)",
+        "1080p59.94"},
+    {GST_SDI_DEMUX_MODE_1080P60, "3G 1080p 60 (level A)", "1080p60"},
+    {0, NULL, NULL}
+  };
+
+  if (!mode_type)
+    mode_type = g_enum_register_static ("GstSdiDemuxMode", modes);
+
+  return mode_type;
+}
+
 /* class initialization */
 
 GST_BOILERPLATE (GstSdiDemux, gst_sdi_demux, GstElement, GST_TYPE_ELEMENT);
@@ -127,10 +197,15 @@ gst_sdi_demux_class_init (GstSdiDemuxClass * klass)
   gobject_class->get_property = gst_sdi_demux_get_property;
   gobject_class->dispose = gst_sdi_demux_dispose;
   gobject_class->finalize = gst_sdi_demux_finalize;
-  if (0)
-    element_class->change_state =
-        GST_DEBUG_FUNCPTR (gst_sdi_demux_change_state);
+  element_class->change_state = GST_DEBUG_FUNCPTR (gst_sdi_demux_change_state);
+
+  g_object_class_install_property (gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "Video format of the SDI stream", GST_TYPE_SDI_DEMUX_MODE,
+          DEFAULT_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  GST_DEBUG_CATEGORY_INIT (gst_sdi_demux_debug, "sdidemux", 0,
+      "SDI demuxer");
 }
 
 static void
@@ -153,16 +228,23 @@ gst_sdi_demux_init (GstSdiDemux * sdidemux, GstSdiDemuxClass * sdidemux_class)
       GST_DEBUG_FUNCPTR (gst_sdi_demux_src_getcaps));
   gst_element_add_pad (GST_ELEMENT (sdidemux), sdidemux->srcpad);
 
-
+  sdidemux->pool = gst_sdi_buffer_pool_new ();
+  sdidemux->mode = DEFAULT_MODE;
 }
 
 void
 gst_sdi_demux_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstSdiDemux *sdidemux;
+
   g_return_if_fail (GST_IS_SDI_DEMUX (object));
+  sdidemux = GST_SDI_DEMUX (object);
 
   switch (property_id) {
+    case PROP_MODE:
+      sdidemux->mode = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -173,9 +255,15 @@ void
 gst_sdi_demux_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstSdiDemux *sdidemux;
+
   g_return_if_fail (GST_IS_SDI_DEMUX (object));
+  sdidemux = GST_SDI_DEMUX (object);
 
   switch (property_id) {
+    case PROP_MODE:
+      g_value_set_enum (value, sdidemux->mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -188,6 +276,7 @@ gst_sdi_demux_dispose (GObject * object)
   g_return_if_fail (GST_IS_SDI_DEMUX (object));
 
   /* clean up as possible.  may be called multiple times */
+  gst_sdi_demux_reset (GST_SDI_DEMUX (object));
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
@@ -198,34 +287,97 @@ gst_sdi_demux_finalize (GObject * object)
   g_return_if_fail (GST_IS_SDI_DEMUX (object));
 
   /* clean up object here */
+  gst_sdi_buffer_pool_free (GST_SDI_DEMUX (object)->pool);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 
+static void
+gst_sdi_demux_set_format (GstSdiDemux * sdidemux, const GstSdiFormat * format)
+{
+  if (sdidemux->output_buffer) {
+    gst_buffer_unref (sdidemux->output_buffer);
+    sdidemux->output_buffer = NULL;
+  }
+  sdidemux->format = format;
+  sdidemux->negotiated = FALSE;
+  sdidemux->have_hsync = FALSE;
+  sdidemux->have_vsync = FALSE;
+  sdidemux->line = 0;
+  sdidemux->offset = 0;
+  sdidemux->last_sync = 0;
+}
+
+static void
+gst_sdi_demux_reset (GstSdiDemux * sdidemux)
+{
+  gst_sdi_demux_set_format (sdidemux, NULL);
+  sdidemux->frame_number = 0;
+}
+
 static GstStateChangeReturn
 gst_sdi_demux_change_state (GstElement * element, GstStateChange transition)
 {
+  GstSdiDemux *sdidemux = GST_SDI_DEMUX (element);
+  GstStateChangeReturn ret;
 
-  return GST_STATE_CHANGE_SUCCESS;
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_sdi_demux_reset (sdidemux);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
 }
 
 static GstCaps *
-gst_sdi_demux_src_getcaps (GstPad * pad)
+gst_sdi_demux_format_caps (const GstSdiFormat * format, guint32 fourcc)
 {
-  return gst_caps_from_string (GST_VIDEO_CAPS_NTSC ("UYVY"));
+  return gst_caps_new_simple ("video/x-raw-yuv",
+      "format", GST_TYPE_FOURCC, fourcc,
+      "width", G_TYPE_INT, format->active_width,
+      "height", G_TYPE_INT, format->active_lines,
+      "framerate", GST_TYPE_FRACTION, format->fps_n, format->fps_d,
+      "interlaced", G_TYPE_BOOLEAN, format->start1 != 0,
+      "pixel-aspect-ratio", GST_TYPE_FRACTION, format->par_n, format->par_d,
+      "chroma-site", G_TYPE_STRING, "mpeg2",
+      "color-matrix", G_TYPE_STRING, format->hd ? "hdtv" : "sdtv", NULL);
 }
 
-static void
-gst_sdi_demux_get_output_buffer (GstSdiDemux * sdidemux)
+/* UYVY first, the 8 bit output is cheaper and what downstream got so far */
+static GstCaps *
+gst_sdi_demux_get_caps (const GstSdiFormat * format)
 {
-  sdidemux->output_buffer =
-      gst_buffer_new_and_alloc (720 * sdidemux->format->active_lines * 2);
-  gst_buffer_set_caps (sdidemux->output_buffer,
-      gst_caps_from_string (GST_VIDEO_CAPS_PAL ("UYVY")));
-  GST_BUFFER_TIMESTAMP (sdidemux->output_buffer) =
-      GST_SECOND * sdidemux->frame_number;
-  sdidemux->frame_number++;
+  GstCaps *caps;
+
+  caps = gst_sdi_demux_format_caps (format,
+      GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'));
+  gst_caps_append (caps, gst_sdi_demux_format_caps (format,
+          GST_MAKE_FOURCC ('v', '2', '1', '0')));
+
+  return caps;
+}
+
+static GstCaps *
+gst_sdi_demux_src_getcaps (GstPad * pad)
+{
+  GstSdiDemux *sdidemux;
+  GstCaps *caps;
+
+  /* the pad can still be queried once it was removed from the element */
+  sdidemux = GST_SDI_DEMUX (gst_pad_get_parent (pad));
+  if (sdidemux == NULL)
+    return gst_caps_copy (gst_pad_get_pad_template_caps (pad));
+
+  caps = gst_sdi_demux_get_caps (&gst_sdi_formats[sdidemux->mode]);
+  gst_object_unref (sdidemux);
+
+  return caps;
 }
 
 static guint32
@@ -241,61 +393,207 @@ get_word10 (guint8 * ptr)
   return a;
 }
 
+/* The unpackers work on groups of 4 10 bit words packed LSB first in 5
+ * bytes, which are 2 pixels. A group is read as one 40 bit value so each
+ * sample is a shift and a mask. */
+static inline guint64
+get_group (const guint8 * ptr)
+{
+  return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((guint64) ptr[3] << 24) |
+      ((guint64) ptr[4] << 32);
+}
+
+/* A single load, which reads 3 bytes past the group */
+static inline guint64
+get_group_fast (const guint8 * ptr)
+{
+  guint64 v;
+
+  memcpy (&v, ptr, 8);
+
+  return GUINT64_FROM_LE (v) & G_GUINT64_CONSTANT (0xffffffffff);
+}
+
+static inline void
+put_word (guint8 * dest, guint32 a)
+{
+  a = GUINT32_TO_LE (a);
+  memcpy (dest, &a, 4);
+}
+
+/* The upper 8 bits of the 4 words are the UYVY bytes */
+static inline void
+put_group_uyvy (guint8 * dest, guint64 v)
+{
+  put_word (dest, ((v >> 2) & 0xff) | ((v >> 4) & 0xff00) |
+      ((v >> 6) & 0xff0000) | ((v >> 8) & 0xff000000));
+}
+
+/* The 120 bits of 3 groups are the 4 words of 3 samples of a v210 block */
+static inline void
+put_groups_v210 (guint8 * dest, guint64 v0, guint64 v1, guint64 v2)
+{
+  put_word (dest + 0, v0 & 0x3fffffff);
+  put_word (dest + 4, (v0 >> 30) | ((v1 & 0xfffff) << 10));
+  put_word (dest + 8, (v1 >> 20) | ((v2 & 0x3ff) << 20));
+  put_word (dest + 12, v2 >> 10);
+}
+
+/* The last group of the active line can end the input buffer, it is read
+ * byte by byte */
 static void
-line10_copy (guint8 * dest, guint8 * src, int n)
+unpack_line_uyvy (guint8 * dest, const guint8 * src, int width)
 {
-  int i;
-  guint32 a;
-  for (i = 0; i < n; i++) {
-    a = get_word10 (src);
-    GST_WRITE_UINT32_BE (dest, a);
+  int i, n = width / 2;
+
+  for (i = 0; i < n - 1; i++) {
+    put_group_uyvy (dest, get_group_fast (src));
     src += 5;
     dest += 4;
   }
+  if (n > 0)
+    put_group_uyvy (dest, get_group (src));
+}
+
+static void
+unpack_line_v210 (guint8 * dest, const guint8 * src, int width)
+{
+  guint64 v[3];
+  int i, k, n = width / 2;
+
+  for (i = 0; i + 3 < n; i += 3) {
+    put_groups_v210 (dest, get_group_fast (src), get_group_fast (src + 5),
+        get_group_fast (src + 10));
+    src += 15;
+    dest += 16;
+  }
+
+  /* the last block is padded with zero samples, the stride is a multiple
+   * of the block size */
+  if (i < n) {
+    for (k = 0; k < 3; k++)
+      v[k] = (i + k < n) ? get_group (src + 5 * k) : 0;
+    put_groups_v210 (dest, v[0], v[1], v[2]);
+  }
+}
+
+static gboolean
+gst_sdi_demux_negotiate (GstSdiDemux * sdidemux)
+{
+  const GstSdiFormat *format = sdidemux->format;
+  GstCaps *caps, *peercaps;
+  guint32 fourcc = 0;
+  gboolean res;
+
+  caps = gst_sdi_demux_get_caps (format);
+  peercaps = gst_pad_peer_get_caps (sdidemux->srcpad);
+  if (peercaps) {
+    GstCaps *icaps = gst_caps_intersect (caps, peercaps);
+
+    gst_caps_unref (peercaps);
+    gst_caps_unref (caps);
+    caps = icaps;
+  }
+
+  if (gst_caps_is_empty (caps)) {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  gst_caps_truncate (caps);
+  gst_structure_get_fourcc (gst_caps_get_structure (caps, 0), "format",
+      &fourcc);
+
+  if (fourcc == GST_MAKE_FOURCC ('v', '2', '1', '0')) {
+    sdidemux->unpack = unpack_line_v210;
+    sdidemux->stride = (format->active_width + 47) / 48 * 128;
+  } else {
+    sdidemux->unpack = unpack_line_uyvy;
+    sdidemux->stride = format->active_width * 2;
+  }
+
+  GST_DEBUG_OBJECT (sdidemux, "output caps %" GST_PTR_FORMAT, caps);
 
+  res = gst_pad_set_caps (sdidemux->srcpad, caps);
+  gst_caps_unref (caps);
+  if (!res)
+    return FALSE;
+
+  gst_sdi_buffer_pool_set_size (sdidemux->pool,
+      sdidemux->stride * format->active_lines, N_PREALLOCATED_BUFFERS);
+  sdidemux->negotiated = TRUE;
+
+  return TRUE;
 }
 
+static GstFlowReturn
+gst_sdi_demux_get_output_buffer (GstSdiDemux * sdidemux)
+{
+  const GstSdiFormat *format = sdidemux->format;
+  GstBuffer *buf;
+  GstClockTime end;
+
+  if (!sdidemux->negotiated && !gst_sdi_demux_negotiate (sdidemux)) {
+    GST_ERROR_OBJECT (sdidemux, "could not negotiate the output");
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  buf = gst_sdi_buffer_pool_get_buffer (sdidemux->pool);
+  gst_buffer_set_caps (buf, GST_PAD_CAPS (sdidemux->srcpad));
+
+  GST_BUFFER_TIMESTAMP (buf) = gst_util_uint64_scale (sdidemux->frame_number,
+      format->fps_d * GST_SECOND, format->fps_n);
+  end = gst_util_uint64_scale (sdidemux->frame_number + 1,
+      format->fps_d * GST_SECOND, format->fps_n);
+  GST_BUFFER_DURATION (buf) = end - GST_BUFFER_TIMESTAMP (buf);
+  GST_BUFFER_OFFSET (buf) = sdidemux->frame_number;
+  GST_BUFFER_OFFSET_END (buf) = sdidemux->frame_number + 1;
+
+  sdidemux->output_buffer = buf;
+  sdidemux->frame_number++;
+
+  return GST_FLOW_OK;
+}
 
 static GstFlowReturn
 copy_line (GstSdiDemux * sdidemux, guint8 * line)
 {
   guint8 *output_data;
   GstFlowReturn ret = GST_FLOW_OK;
-  GstSdiFormat *format = sdidemux->format;
+  const GstSdiFormat *format = sdidemux->format;
+  int row = -1;
+
+  if (sdidemux->output_buffer == NULL) {
+    ret = gst_sdi_demux_get_output_buffer (sdidemux);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
 
   output_data = GST_BUFFER_DATA (sdidemux->output_buffer);
 
   /* line is one less than the video line */
-  if (sdidemux->line >= format->start0 - 1 &&
+  if (format->start1 == 0) {
+    if (sdidemux->line >= format->start0 - 1 &&
+        sdidemux->line < format->start0 - 1 + format->active_lines)
+      row = sdidemux->line - (format->start0 - 1);
+  } else if (sdidemux->line >= format->start0 - 1 &&
       sdidemux->line < format->start0 - 1 + format->active_lines / 2) {
-#if 0
-    memcpy (output_data + 720 * 2 * ((sdidemux->line -
-                (format->start0 - 1)) * 2 + (!format->tff)),
-        line + (format->width - 720) * 2, 720 * 2);
-#else
-    line10_copy (output_data + 720 * 2 * ((sdidemux->line -
-                (format->start0 - 1)) * 2 + (!format->tff)),
-        line + (format->width - 720) / 2 * 5, 720 / 2);
-#endif
-  }
-  if (sdidemux->line >= format->start1 - 1 &&
+    row = (sdidemux->line - (format->start0 - 1)) * 2 + (!format->tff);
+  } else if (sdidemux->line >= format->start1 - 1 &&
       sdidemux->line < format->start1 - 1 + format->active_lines / 2) {
-#if 0
-    memcpy (output_data + 720 * 2 * ((sdidemux->line -
-                (format->start1 - 1)) * 2 + (format->tff)),
-        line + (format->width - 720) * 2, 720 * 2);
-#else
-    line10_copy (output_data + 720 * 2 * ((sdidemux->line -
-                (format->start1 - 1)) * 2 + (format->tff)),
-        line + (format->width - 720) / 2 * 5, 720 / 2);
-#endif
+    row = (sdidemux->line - (format->start1 - 1)) * 2 + (format->tff);
   }
 
+  if (row >= 0)
+    sdidemux->unpack (output_data + sdidemux->stride * row,
+        line + (format->width - format->active_width) / 2 * 5,
+        format->active_width);
+
   sdidemux->offset = 0;
   sdidemux->line++;
   if (sdidemux->line == format->lines) {
     ret = gst_pad_push (sdidemux->srcpad, sdidemux->output_buffer);
-    gst_sdi_demux_get_output_buffer (sdidemux);
+    sdidemux->output_buffer = NULL;
     sdidemux->line = 0;
   }
 
@@ -307,8 +605,71 @@ copy_line (GstSdiDemux * sdidemux, guint8 * line)
 #define SDI_SYNC_V(a) (((a)>>5)&1)
 #define SDI_SYNC_H(a) (((a)>>4)&1)
 
-GstSdiFormat sd_ntsc = { 525, 480, 858, 20, 283, 0 };
-GstSdiFormat sd_pal = { 625, 576, 864, 23, 336, 1 };
+/* Returns the timing reference at @ptr as 0xff0000XY, with XY the upper
+ * 8 bits of the XYZ word, or 0. HD formats repeat each word of it in the
+ * luma and chroma streams. */
+static guint32
+get_sync (const GstSdiFormat * format, guint8 * ptr)
+{
+  guint32 a, b;
+
+  a = get_word10 (ptr);
+  if (!format->hd)
+    return SDI_IS_SYNC (a) ? a : 0;
+
+  if (a != 0xffff0000)
+    return 0;
+  b = get_word10 (ptr + 5);
+  if ((b & 0xffff0000) != 0 || (b >> 8) != (b & 0xff))
+    return 0;
+  a = 0xff000000 | (b & 0xff);
+
+  return SDI_IS_SYNC (a) ? a : 0;
+}
+
+/* Lines start with the EAV, this is the offset of the SAV */
+static int
+get_sav_offset (const GstSdiFormat * format)
+{
+  return ((format->width - format->active_width) / 2 - (format->hd ? 2 : 1)) *
+      5;
+}
+
+/* The 11 bit line number follows the EAV in HD formats */
+static int
+get_line_number (guint8 * line)
+{
+  guint64 v = get_group (line + 10);
+
+  return ((v >> 2) & 0x7f) | (((v >> 22) & 0x0f) << 7);
+}
+
+static GstFlowReturn
+gst_sdi_demux_handle_line (GstSdiDemux * sdidemux, guint8 * line)
+{
+  const GstSdiFormat *format = sdidemux->format;
+  guint32 sync;
+
+  if (format->hd) {
+    if (!sdidemux->have_vsync) {
+      if (SDI_SYNC_H (get_sync (format, line)) && get_line_number (line) == 1)
+        sdidemux->have_vsync = TRUE;
+      sdidemux->line = 0;
+    }
+  } else {
+    sync = get_sync (format, line + get_sav_offset (format));
+    if (!sdidemux->have_vsync) {
+      if (SDI_IS_SYNC (sync) && !SDI_SYNC_F (sync) &&
+          SDI_SYNC_F (sdidemux->last_sync)) {
+        sdidemux->have_vsync = TRUE;
+      }
+      sdidemux->line = 0;
+    }
+    sdidemux->last_sync = sync;
+  }
+
+  return copy_line (sdidemux, line);
+}
 
 static GstFlowReturn
 gst_sdi_demux_chain (GstPad * pad, GstBuffer * buffer)
@@ -318,24 +679,29 @@ gst_sdi_demux_chain (GstPad * pad, GstBuffer * buffer)
   guint8 *data = GST_BUFFER_DATA (buffer);
   int size = GST_BUFFER_SIZE (buffer);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstSdiFormat *format;
+  const GstSdiFormat *format;
+  int line_size;
 
   sdidemux = GST_SDI_DEMUX (gst_pad_get_parent (pad));
-  sdidemux->format = &sd_pal;
+
+  if (sdidemux->format != &gst_sdi_formats[sdidemux->mode]) {
+    GST_DEBUG_OBJECT (sdidemux, "switching to mode %d", sdidemux->mode);
+    gst_sdi_demux_set_format (sdidemux, &gst_sdi_formats[sdidemux->mode]);
+  }
   format = sdidemux->format;
+  line_size = format->width / 2 * 5;
 
   GST_DEBUG_OBJECT (sdidemux, "chain");
 
   if (GST_BUFFER_IS_DISCONT (buffer)) {
     sdidemux->have_hsync = FALSE;
     sdidemux->have_vsync = FALSE;
+    sdidemux->offset = 0;
   }
 
   if (!sdidemux->have_hsync) {
-#if 0
-    for (offset = 0; offset < size; offset += 4) {
-      guint32 sync = READ_UINT32_BE (data + offset);
-      GST_ERROR ("sync value %08x", sync);
+    for (offset = 0; offset + (format->hd ? 10 : 5) <= size; offset += 5) {
+      guint32 sync = get_sync (format, data + offset);
       if (SDI_IS_SYNC (sync) && SDI_SYNC_H (sync)) {
         sdidemux->have_hsync = TRUE;
         sdidemux->line = 0;
@@ -343,138 +709,36 @@ gst_sdi_demux_chain (GstPad * pad, GstBuffer * buffer)
         break;
       }
     }
-#else
-    for (offset = 0; offset < size; offset += 5) {
-      guint32 sync = get_word10 (data + offset);
-      //GST_ERROR("sync value %08x", sync);
-      if (SDI_IS_SYNC (sync) && SDI_SYNC_H (sync)) {
-        sdidemux->have_hsync = TRUE;
-        sdidemux->line = 0;
-        sdidemux->offset = 0;
-        break;
-      }
-    }
-#endif
     if (!sdidemux->have_hsync) {
       GST_ERROR ("no sync");
       goto out;
     }
   }
 
-  if (sdidemux->output_buffer == NULL) {
-    gst_sdi_demux_get_output_buffer (sdidemux);
-  }
-
-#if 0
   if (sdidemux->offset) {
     int n;
 
     /* second half of a line */
-    n = MIN (size - offset, format->width * 2 - sdidemux->offset);
+    n = MIN (size - offset, line_size - sdidemux->offset);
 
     memcpy (sdidemux->stored_line + sdidemux->offset, data + offset, n);
 
     offset += n;
     sdidemux->offset += n;
 
-    if (sdidemux->offset == format->width * 2) {
-      guint32 sync =
-          GST_READ_UINT32_BE (data + offset + (format->width - 720 - 2) * 2);
-
-      //GST_ERROR("%08x", sync);
-      if (!sdidemux->have_vsync) {
-        //GST_ERROR("%08x", GST_READ_UINT32_BE(data+offset));
-        if (SDI_IS_SYNC (sync) && !SDI_SYNC_F (sync) &&
-            SDI_SYNC_F (sdidemux->last_sync)) {
-          sdidemux->have_vsync = TRUE;
-        }
-        sdidemux->line = 0;
-      }
-
-      ret = copy_line (sdidemux, sdidemux->stored_line);
-
-      sdidemux->last_sync = sync;
-    }
+    if (sdidemux->offset == line_size)
+      ret = gst_sdi_demux_handle_line (sdidemux, sdidemux->stored_line);
   }
 
-  while (size - offset >= format->width * 2) {
-    guint32 sync =
-        GST_READ_UINT32_BE (data + offset + (format->width - 720 - 2) * 2);
-
-    //GST_ERROR("%08x", sync);
-    if (!sdidemux->have_vsync) {
-      if (SDI_IS_SYNC (sync) && !SDI_SYNC_F (sync) &&
-          SDI_SYNC_F (sdidemux->last_sync)) {
-        sdidemux->have_vsync = TRUE;
-      }
-      sdidemux->line = 0;
-    }
-
-    ret = copy_line (sdidemux, data + offset);
-    offset += format->width * 2;
-
-    sdidemux->last_sync = sync;
+  while (ret == GST_FLOW_OK && size - offset >= line_size) {
+    ret = gst_sdi_demux_handle_line (sdidemux, data + offset);
+    offset += line_size;
   }
 
-  if (size - offset > 0) {
+  if (ret == GST_FLOW_OK && size - offset > 0) {
     memcpy (sdidemux->stored_line, data + offset, size - offset);
     sdidemux->offset = size - offset;
   }
-#else
-  if (sdidemux->offset) {
-    int n;
-
-    /* second half of a line */
-    n = MIN (size - offset, format->width / 2 * 5 - sdidemux->offset);
-
-    memcpy (sdidemux->stored_line + sdidemux->offset, data + offset, n);
-
-    offset += n;
-    sdidemux->offset += n;
-
-    if (sdidemux->offset == (format->width / 2) * 5) {
-      guint32 sync =
-          get_word10 (data + offset + ((format->width - 720 - 2) / 2) * 5);
-
-      if (!sdidemux->have_vsync) {
-        //GST_ERROR("%08x", GST_READ_UINT32_BE(data+offset));
-        if (SDI_IS_SYNC (sync) && !SDI_SYNC_F (sync) &&
-            SDI_SYNC_F (sdidemux->last_sync)) {
-          sdidemux->have_vsync = TRUE;
-        }
-        sdidemux->line = 0;
-      }
-
-      ret = copy_line (sdidemux, sdidemux->stored_line);
-
-      sdidemux->last_sync = sync;
-    }
-  }
-
-  while (size - offset >= format->width / 2 * 5) {
-    guint32 sync =
-        get_word10 (data + offset + ((format->width - 720 - 2) / 2) * 5);
-
-    //GST_ERROR("%08x", sync);
-    if (!sdidemux->have_vsync) {
-      if (SDI_IS_SYNC (sync) && !SDI_SYNC_F (sync) &&
-          SDI_SYNC_F (sdidemux->last_sync)) {
-        sdidemux->have_vsync = TRUE;
-      }
-      sdidemux->line = 0;
-    }
-
-    ret = copy_line (sdidemux, data + offset);
-    offset += (format->width / 2) * 5;
-
-    sdidemux->last_sync = sync;
-  }
-
-  if (size - offset > 0) {
-    memcpy (sdidemux->stored_line, data + offset, size - offset);
-    sdidemux->offset = size - offset;
-  }
-#endif
 
 out:
   gst_buffer_unref (buffer);
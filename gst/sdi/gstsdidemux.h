@@ -23,6 +23,8 @@
 #include <gst/gst.h>
 #include <gst/gst.h>
 
+#include "gstsdibufferpool.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_SDI_DEMUX   (gst_sdi_demux_get_type())
@@ -35,6 +37,32 @@ typedef struct _GstSdiDemux GstSdiDemux;
 typedef struct _GstSdiDemuxClass GstSdiDemuxClass;
 typedef struct _GstSdiFormat GstSdiFormat;
 
+typedef enum {
+  GST_SDI_DEMUX_MODE_NTSC,
+  GST_SDI_DEMUX_MODE_PAL,
+  GST_SDI_DEMUX_MODE_720P50,
+  GST_SDI_DEMUX_MODE_720P5994,
+  GST_SDI_DEMUX_MODE_720P60,
+  GST_SDI_DEMUX_MODE_1080I50,
+  GST_SDI_DEMUX_MODE_1080I5994,
+  GST_SDI_DEMUX_MODE_1080I60,
+  GST_SDI_DEMUX_MODE_1080P2398,
+  GST_SDI_DEMUX_MODE_1080P24,
+  GST_SDI_DEMUX_MODE_1080P25,
+  GST_SDI_DEMUX_MODE_1080P2997,
+  GST_SDI_DEMUX_MODE_1080P30,
+  GST_SDI_DEMUX_MODE_1080P50,
+  GST_SDI_DEMUX_MODE_1080P5994,
+  GST_SDI_DEMUX_MODE_1080P60
+} GstSdiDemuxMode;
+
+/* 1080p24 has the longest lines, 2750 samples in groups of 5 bytes per
+ * 2 samples */
+#define GST_SDI_MAX_LINE_SIZE (2750 / 2 * 5)
+
+typedef void (*GstSdiUnpackFunc) (guint8 * dest, const guint8 * src,
+    int width);
+
 struct _GstSdiDemux
 {
   GstElement base_sdidemux;
@@ -47,13 +75,25 @@ struct _GstSdiDemux
 
   gboolean have_hsync;
   gboolean have_vsync;
-  guchar stored_line[2160]; /* 864/2*5 */
+  guchar stored_line[GST_SDI_MAX_LINE_SIZE];
 
   int frame_number;
   guint32 last_sync;
-  GstSdiFormat *format;
+  const GstSdiFormat *format;
+
+  /* negotiated output */
+  gboolean negotiated;
+  GstSdiUnpackFunc unpack;
+  int stride;
+  GstSdiBufferPool *pool;
+
+  /* properties */
+  GstSdiDemuxMode mode;
 };
 
+/* Line numbers are those of the SMPTE standards, start1 is 0 for
+ * progressive formats. HD formats interleave the luma and chroma words
+ * and carry the line number after the EAV. */
 struct _GstSdiFormat
 {
   int lines;
@@ -62,6 +102,10 @@ struct _GstSdiFormat
   int start0;
   int start1;
   int tff;
+  int active_width;
+  int fps_n, fps_d;
+  int par_n, par_d;
+  gboolean hd;
 };
 
 struct _GstSdiDemuxClass
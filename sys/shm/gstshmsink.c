@@ -45,7 +45,14 @@ enum
   PROP_SOCKET_PATH,
   PROP_PERMS,
   PROP_SHM_SIZE,
-  PROP_WAIT_FOR_CONNECTION
+  PROP_WAIT_FOR_CONNECTION,
+  PROP_FAILED_ALLOCATIONS,
+  PROP_FRAGMENTATION,
+  PROP_MAX_OUTSTANDING,
+  PROP_CLIENT_TIMEOUT,
+  PROP_CLIENT_STATS,
+  PROP_BATCH_SIZE,
+  PROP_BATCH_LATENCY
 };
 
 struct GstShmClient
@@ -56,6 +63,10 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 256 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_MAX_OUTSTANDING (0)
+#define DEFAULT_CLIENT_TIMEOUT (0)
+#define DEFAULT_BATCH_SIZE (1)
+#define DEFAULT_BATCH_LATENCY (5 * GST_MSECOND)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -112,6 +123,11 @@ gst_shm_sink_init (GstShmSink * self, GstShmSinkClass * g_class)
   self->size = DEFAULT_SIZE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->max_outstanding = DEFAULT_MAX_OUTSTANDING;
+  self->client_timeout = DEFAULT_CLIENT_TIMEOUT;
+  self->batch_size = DEFAULT_BATCH_SIZE;
+  self->batch_latency = DEFAULT_BATCH_LATENCY;
+  self->batch_start = GST_CLOCK_TIME_NONE;
 }
 
 static void
@@ -162,6 +178,62 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           DEFAULT_WAIT_FOR_CONNECTION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_FAILED_ALLOCATIONS,
+      g_param_spec_uint64 ("failed-allocations",
+          "Failed allocations",
+          "Number of times no block of shared memory was available for a "
+          "buffer", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FRAGMENTATION,
+      g_param_spec_double ("fragmentation",
+          "Fragmentation of the shm area",
+          "Share of the free shared memory that is not part of the largest "
+          "free block (0 = not fragmented)", 0.0, 1.0, 0.0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_OUTSTANDING,
+      g_param_spec_uint ("max-outstanding",
+          "Maximum outstanding buffers per client",
+          "A client holding this many buffers does not get new ones until it "
+          "releases some, so a slow reader skips frames instead of holding "
+          "up the others (0 = unlimited)",
+          0, G_MAXINT, DEFAULT_MAX_OUTSTANDING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CLIENT_TIMEOUT,
+      g_param_spec_uint64 ("client-timeout",
+          "Client timeout",
+          "Disconnect clients that hold buffers without releasing any for "
+          "this long (in nanoseconds, 0 = never)",
+          0, G_MAXUINT64, DEFAULT_CLIENT_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CLIENT_STATS,
+      g_param_spec_value_array ("client-stats",
+          "Client statistics",
+          "One structure per connected client with the number of buffers it "
+          "holds, the buffers it skipped and for how long it has been stalled",
+          g_param_spec_boxed ("client", "Client", "Client statistics",
+              GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size",
+          "Batch size",
+          "Announce buffers to the clients that support it in groups of this "
+          "many, to save system calls on both sides (1 = one by one)",
+          1, sp_writer_get_max_batch_size (), DEFAULT_BATCH_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BATCH_LATENCY,
+      g_param_spec_uint64 ("batch-latency",
+          "Batch latency",
+          "Maximum time a buffer waits for its batch to fill before it is "
+          "announced anyway (in nanoseconds)",
+          0, G_MAXUINT64, DEFAULT_BATCH_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL,
       g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
@@ -229,6 +301,37 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (self->cond);
       break;
+    case PROP_MAX_OUTSTANDING:
+      GST_OBJECT_LOCK (object);
+      self->max_outstanding = g_value_get_uint (value);
+      if (self->pipe)
+        sp_writer_set_max_outstanding (self->pipe, self->max_outstanding);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_CLIENT_TIMEOUT:
+      GST_OBJECT_LOCK (object);
+      self->client_timeout = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (object);
+      /* wake up the poll thread so it picks up the new timeout */
+      if (self->poll)
+        gst_poll_restart (self->poll);
+      break;
+    case PROP_BATCH_SIZE:
+      GST_OBJECT_LOCK (object);
+      self->batch_size = g_value_get_uint (value);
+      if (self->pipe) {
+        sp_writer_set_batch_size (self->pipe, self->batch_size);
+        self->batch_start = GST_CLOCK_TIME_NONE;
+      }
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_BATCH_LATENCY:
+      GST_OBJECT_LOCK (object);
+      self->batch_latency = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (object);
+      if (self->poll)
+        gst_poll_restart (self->poll);
+      break;
     default:
       break;
   }
@@ -263,6 +366,62 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_WAIT_FOR_CONNECTION:
       g_value_set_boolean (value, self->wait_for_connection);
       break;
+    case PROP_FAILED_ALLOCATIONS:
+      g_value_set_uint64 (value, self->failed_allocations);
+      break;
+    case PROP_FRAGMENTATION:
+    {
+      gdouble fragmentation = 0.0;
+
+      if (self->pipe) {
+        ShmAllocStats stats;
+        unsigned long free_bytes;
+
+        sp_writer_get_alloc_stats (self->pipe, &stats);
+        free_bytes = stats.size - stats.used_bytes;
+        if (free_bytes > 0)
+          fragmentation = 1.0 - (gdouble) stats.largest_free / free_bytes;
+      }
+      g_value_set_double (value, fragmentation);
+      break;
+    }
+    case PROP_MAX_OUTSTANDING:
+      g_value_set_uint (value, self->max_outstanding);
+      break;
+    case PROP_CLIENT_TIMEOUT:
+      g_value_set_uint64 (value, self->client_timeout);
+      break;
+    case PROP_CLIENT_STATS:
+    {
+      GValueArray *array = g_value_array_new (g_list_length (self->clients));
+      GList *item;
+
+      for (item = self->clients; item; item = item->next) {
+        struct GstShmClient *gclient = item->data;
+        GValue v = { 0 };
+
+        g_value_init (&v, GST_TYPE_STRUCTURE);
+        g_value_take_boxed (&v, gst_structure_new ("shm-client",
+                "fd", G_TYPE_INT, gclient->pollfd.fd,
+                "outstanding", G_TYPE_INT,
+                sp_writer_client_get_outstanding (gclient->client),
+                "skipped", G_TYPE_UINT64,
+                (guint64) sp_writer_client_get_skipped (gclient->client),
+                "stalled", G_TYPE_UINT64,
+                (guint64) sp_writer_client_get_stall_time (gclient->client) *
+                GST_USECOND, NULL));
+        g_value_array_append (array, &v);
+        g_value_unset (&v);
+      }
+      g_value_take_boxed (value, array);
+      break;
+    }
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, self->batch_size);
+      break;
+    case PROP_BATCH_LATENCY:
+      g_value_set_uint64 (value, self->batch_latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -279,6 +438,7 @@ gst_shm_sink_start (GstBaseSink * bsink)
   GstShmSink *self = GST_SHM_SINK (bsink);
 
   self->stop = FALSE;
+  self->failed_allocations = 0;
 
   if (!self->socket_path) {
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
@@ -298,6 +458,9 @@ gst_shm_sink_start (GstBaseSink * bsink)
   }
 
   sp_set_data (self->pipe, self);
+  sp_writer_set_max_outstanding (self->pipe, self->max_outstanding);
+  sp_writer_set_batch_size (self->pipe, self->batch_size);
+  self->batch_start = GST_CLOCK_TIME_NONE;
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
 
@@ -358,6 +521,34 @@ gst_shm_sink_stop (GstBaseSink * bsink)
   return TRUE;
 }
 
+/* Call with the object lock held. Announces the buffers queued in the
+ * clients' batches if @force is set or if the oldest of them has waited for
+ * batch-latency already */
+static void
+gst_shm_sink_flush_batch (GstShmSink * self, gboolean force)
+{
+  GstClockTime now;
+
+  if (!sp_writer_has_unflushed (self->pipe)) {
+    self->batch_start = GST_CLOCK_TIME_NONE;
+    return;
+  }
+
+  now = gst_util_get_timestamp ();
+
+  if (!GST_CLOCK_TIME_IS_VALID (self->batch_start)) {
+    self->batch_start = now;
+    /* let the poll thread time out on this batch */
+    gst_poll_restart (self->poll);
+  }
+
+  if (force || now - self->batch_start >= self->batch_latency) {
+    if (sp_writer_flush (self->pipe) < 0)
+      GST_WARNING_OBJECT (self, "Could not announce buffers to all clients");
+    self->batch_start = GST_CLOCK_TIME_NONE;
+  }
+}
+
 static GstFlowReturn
 gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 {
@@ -379,13 +570,22 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   if (rv == -1) {
     ShmBlock *block = NULL;
     gchar *shmbuf = NULL;
-    while ((block = sp_writer_alloc_block (self->pipe,
-                GST_BUFFER_SIZE (buf))) == NULL) {
+
+    block = sp_writer_alloc_block (self->pipe, GST_BUFFER_SIZE (buf));
+    if (!block) {
+      GST_LOG_OBJECT (self, "No free block for %u bytes, waiting",
+          GST_BUFFER_SIZE (buf));
+      self->failed_allocations++;
+      /* the clients can't release buffers they have not been told about */
+      gst_shm_sink_flush_batch (self, TRUE);
+    }
+    while (block == NULL) {
       g_cond_wait (self->cond, GST_OBJECT_GET_LOCK (self));
       if (self->unlock) {
         GST_OBJECT_UNLOCK (self);
         return GST_FLOW_WRONG_STATE;
       }
+      block = sp_writer_alloc_block (self->pipe, GST_BUFFER_SIZE (buf));
     }
     while (self->wait_for_connection && !self->clients) {
       g_cond_wait (self->cond, GST_OBJECT_GET_LOCK (self));
@@ -403,6 +603,8 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     sp_writer_free_block (block);
   }
 
+  gst_shm_sink_flush_batch (self, FALSE);
+
   GST_OBJECT_UNLOCK (self);
 
   return GST_FLOW_OK;
@@ -438,6 +640,8 @@ gst_shm_sink_buffer_alloc (GstBaseSink * sink, guint64 offset, guint size,
   if (block) {
     buf = sp_writer_block_get_buf (block);
     g_object_ref (self);
+  } else {
+    self->failed_allocations++;
   }
   GST_OBJECT_UNLOCK (self);
 
@@ -469,15 +673,42 @@ pollthread_func (gpointer data)
 {
   GstShmSink *self = GST_SHM_SINK (data);
   GList *item;
+  GstClockTime timeout;
 
   while (!self->stop) {
 
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0)
+    /* wake up regularly to look for stalled clients */
+    GST_OBJECT_LOCK (self);
+    timeout = self->client_timeout;
+    if (timeout > 0)
+      timeout = MAX (timeout / 4, 10 * GST_MSECOND);
+    else
+      timeout = GST_CLOCK_TIME_NONE;
+    /* and to announce a batch that did not fill up in time */
+    if (GST_CLOCK_TIME_IS_VALID (self->batch_start)) {
+      GstClockTime now = gst_util_get_timestamp ();
+      GstClockTime left = 0;
+
+      if (self->batch_start + self->batch_latency > now)
+        left = self->batch_start + self->batch_latency - now;
+      if (!GST_CLOCK_TIME_IS_VALID (timeout) || left < timeout)
+        timeout = left;
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    if (gst_poll_wait (self->poll, timeout) < 0) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
       return NULL;
+    }
 
     if (self->stop)
       return NULL;
 
+    GST_OBJECT_LOCK (self);
+    gst_shm_sink_flush_batch (self, FALSE);
+    GST_OBJECT_UNLOCK (self);
+
     if (gst_poll_fd_has_closed (self->poll, &self->serverpollfd)) {
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed read from shmsink"),
           ("Control socket has closed"));
@@ -511,7 +742,9 @@ pollthread_func (gpointer data)
       gclient->pollfd.fd = sp_writer_get_client_fd (client);
       gst_poll_add_fd (self->poll, &gclient->pollfd);
       gst_poll_fd_ctl_read (self->poll, &gclient->pollfd, TRUE);
+      GST_OBJECT_LOCK (self);
       self->clients = g_list_prepend (self->clients, gclient);
+      GST_OBJECT_UNLOCK (self);
       g_signal_emit (self, signals[SIGNAL_CLIENT_CONNECTED], 0,
           gclient->pollfd.fd);
       /* we need to call gst_poll_wait before calling gst_poll_* status
@@ -548,14 +781,30 @@ pollthread_func (gpointer data)
           goto close_client;
         }
       }
+
+      if (self->client_timeout > 0) {
+        gboolean stalled;
+
+        GST_OBJECT_LOCK (self);
+        stalled = sp_writer_client_get_stall_time (gclient->client) *
+            GST_USECOND > self->client_timeout;
+        GST_OBJECT_UNLOCK (self);
+
+        if (stalled) {
+          GST_WARNING_OBJECT (self, "Client %d has not released a buffer in"
+              " %" GST_TIME_FORMAT ", disconnecting it", gclient->pollfd.fd,
+              GST_TIME_ARGS (self->client_timeout));
+          goto close_client;
+        }
+      }
       continue;
     close_client:
       GST_OBJECT_LOCK (self);
       sp_writer_close_client (self->pipe, gclient->client);
+      self->clients = g_list_remove (self->clients, gclient);
       GST_OBJECT_UNLOCK (self);
 
       gst_poll_remove_fd (self->poll, &gclient->pollfd);
-      self->clients = g_list_remove (self->clients, gclient);
 
       g_signal_emit (self, signals[SIGNAL_CLIENT_DISCONNECTED], 0,
           gclient->pollfd.fd);
@@ -578,6 +827,7 @@ gst_shm_sink_event (GstBaseSink * bsink, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_EOS:
       GST_OBJECT_LOCK (self);
+      gst_shm_sink_flush_batch (self, TRUE);
       while (self->wait_for_connection && sp_writer_pending_writes (self->pipe)
           && !self->unlock)
         g_cond_wait (self->cond, GST_OBJECT_GET_LOCK (self));
@@ -62,6 +62,16 @@ struct _GstShmSink
   gboolean stop;
   gboolean unlock;
 
+  guint64 failed_allocations;
+
+  guint max_outstanding;
+  GstClockTime client_timeout;
+
+  guint batch_size;
+  GstClockTime batch_latency;
+  /* when the oldest buffer that was not announced yet was queued */
+  GstClockTime batch_start;
+
   GCond *cond;
 };
 
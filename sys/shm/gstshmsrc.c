@@ -248,6 +248,10 @@ gst_shm_src_stop_reading (GstShmSrc * self)
   GST_DEBUG_OBJECT (self, "Stopping %p", self);
 
   if (self->pipe) {
+    GST_OBJECT_LOCK (self);
+    self->pipe->waiting = TRUE;
+    sp_client_flush_acks (self->pipe->pipe);
+    GST_OBJECT_UNLOCK (self);
     gst_shm_pipe_dec (self->pipe);
     self->pipe = NULL;
   }
@@ -288,6 +292,9 @@ free_buffer (gpointer data)
 
   GST_OBJECT_LOCK (gsb->pipe->src);
   sp_client_recv_finish (gsb->pipe->pipe, gsb->buf);
+  /* the streaming thread only sends the queued acks before it blocks */
+  if (gsb->pipe->waiting)
+    sp_client_flush_acks (gsb->pipe->pipe);
   GST_OBJECT_UNLOCK (gsb->pipe->src);
 
   gst_shm_pipe_dec (gsb->pipe);
@@ -304,41 +311,58 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   struct GstShmBuffer *gsb;
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
-      if (errno == EBUSY)
-        return GST_FLOW_WRONG_STATE;
-      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
-          ("Poll failed on fd: %s", strerror (errno)));
-      return GST_FLOW_ERROR;
+    gboolean pending;
+
+    /* The rest of the last batch is returned without waiting, otherwise the
+     * queued acks are sent first as the writer may be waiting for them */
+    GST_OBJECT_LOCK (self);
+    pending = sp_client_has_pending (self->pipe->pipe);
+    if (!pending) {
+      sp_client_flush_acks (self->pipe->pipe);
+      self->pipe->waiting = TRUE;
     }
+    GST_OBJECT_UNLOCK (self);
+
+    if (!pending) {
+      if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
+        if (errno == EBUSY)
+          return GST_FLOW_WRONG_STATE;
+        GST_ELEMENT_ERROR (self, RESOURCE, READ,
+            ("Failed to read from shmsrc"),
+            ("Poll failed on fd: %s", strerror (errno)));
+        return GST_FLOW_ERROR;
+      }
 
-    if (self->unlocked)
-      return GST_FLOW_WRONG_STATE;
+      if (self->unlocked)
+        return GST_FLOW_WRONG_STATE;
 
-    if (gst_poll_fd_has_closed (self->poll, &self->pollfd)) {
-      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
-          ("Control socket has closed"));
-      return GST_FLOW_ERROR;
+      if (gst_poll_fd_has_closed (self->poll, &self->pollfd)) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ,
+            ("Failed to read from shmsrc"), ("Control socket has closed"));
+        return GST_FLOW_ERROR;
+      }
+
+      if (gst_poll_fd_has_error (self->poll, &self->pollfd)) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ,
+            ("Failed to read from shmsrc"), ("Control socket has error"));
+        return GST_FLOW_ERROR;
+      }
+
+      if (!gst_poll_fd_can_read (self->poll, &self->pollfd))
+        continue;
     }
 
-    if (gst_poll_fd_has_error (self->poll, &self->pollfd)) {
+    buf = NULL;
+    GST_LOG_OBJECT (self, "Reading from pipe");
+    GST_OBJECT_LOCK (self);
+    self->pipe->waiting = FALSE;
+    rv = sp_client_recv (self->pipe->pipe, &buf);
+    GST_OBJECT_UNLOCK (self);
+    if (rv < 0) {
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
-          ("Control socket has error"));
+          ("Error reading control data: %d", rv));
       return GST_FLOW_ERROR;
     }
-
-    if (gst_poll_fd_can_read (self->poll, &self->pollfd)) {
-      buf = NULL;
-      GST_LOG_OBJECT (self, "Reading from pipe");
-      GST_OBJECT_LOCK (self);
-      rv = sp_client_recv (self->pipe->pipe, &buf);
-      GST_OBJECT_UNLOCK (self);
-      if (rv < 0) {
-        GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
-            ("Error reading control data: %d", rv));
-        return GST_FLOW_ERROR;
-      }
-    }
   } while (buf == NULL);
 
   GST_LOG_OBJECT (self, "Got buffer %p of size %d", buf, rv);
@@ -70,6 +70,9 @@ struct _GstShmPipe {
 
   GstShmSrc *src;
   ShmPipe *pipe;
+
+  /* TRUE while nobody reads from the pipe, acks must then be sent at once */
+  gboolean waiting;
 };
 
 G_END_DECLS
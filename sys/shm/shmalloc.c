@@ -33,14 +33,37 @@
 #include <string.h>
 #include <assert.h>
 
+/* Number of distinct block sizes that get their own free list */
+#define SHM_ALLOC_NUM_CLASSES 8
+/* Maximum number of freed blocks kept around per size */
+#define SHM_ALLOC_MAX_CACHED 16
+
+/* Freed blocks of a frequently used size are not returned to the space but
+ * parked on a per-size free list, so that the next allocation of the same
+ * size (the usual case for raw video) is O(1) and can never fail because of
+ * fragmentation. The parked blocks are given back when an allocation of
+ * another size does not fit. */
+typedef struct _ShmAllocSizeClass
+{
+  unsigned long size;
+  ShmAllocBlock *free_list;
+  unsigned int n_free;
+  unsigned long last_used;
+} ShmAllocSizeClass;
+
 /* This is the allocated space to hold multiple blocks */
 struct _ShmAllocSpace
 {
   /* The total size of this space */
   size_t size;
 
-  /* chained list of the blocks contained in this space */
+  /* chained list of the blocks contained in this space, sorted by offset */
   ShmAllocBlock *blocks;
+
+  ShmAllocSizeClass classes[SHM_ALLOC_NUM_CLASSES];
+  unsigned long clock;
+
+  ShmAllocStats stats;
 };
 
 /* A single block of data */
@@ -56,8 +79,12 @@ struct _ShmAllocBlock
   /* The size of the block */
   unsigned long size;
 
-  /* Pointer to the next block in the chain */
+  /* Pointers to the previous and next blocks in the chain */
+  ShmAllocBlock *prev;
   ShmAllocBlock *next;
+
+  /* Next block in the free list of its size class, if it is parked */
+  ShmAllocBlock *next_free;
 };
 
 
@@ -69,20 +96,26 @@ shm_alloc_space_new (size_t size)
   memset (self, 0, sizeof (ShmAllocSpace));
 
   self->size = size;
+  self->stats.size = size;
 
   return self;
 }
 
+static void shm_alloc_space_flush_classes (ShmAllocSpace * self);
+
 void
 shm_alloc_space_free (ShmAllocSpace * self)
 {
-  assert (self && self->blocks == NULL);
+  assert (self);
+
+  shm_alloc_space_flush_classes (self);
+
+  assert (self->blocks == NULL);
   spalloc_free (ShmAllocSpace, self);
 }
 
-
-ShmAllocBlock *
-shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+static ShmAllocBlock *
+shm_alloc_space_first_fit (ShmAllocSpace * self, unsigned long size)
 {
   ShmAllocBlock *block;
   ShmAllocBlock *item = NULL;
@@ -108,13 +141,14 @@ shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
      * at the end */
     if (self->size - prev_end_offset < size)
       return NULL;
+  } else if (!self->blocks && self->size < size) {
+    return NULL;
   }
 
   block = spalloc_new (ShmAllocBlock);
   memset (block, 0, sizeof (ShmAllocBlock));
   block->offset = prev_end_offset;
   block->size = size;
-  block->use_count = 1;
   block->space = self;
 
   if (prev_item)
@@ -122,7 +156,122 @@ shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
   else
     self->blocks = block;
 
+  block->prev = prev_item;
   block->next = item;
+  if (item)
+    item->prev = block;
+
+  return block;
+}
+
+static void
+shm_alloc_space_unlink_block (ShmAllocBlock * block)
+{
+  ShmAllocSpace *self = block->space;
+
+  if (block->prev)
+    block->prev->next = block->next;
+  else
+    self->blocks = block->next;
+
+  if (block->next)
+    block->next->prev = block->prev;
+
+  spalloc_free (ShmAllocBlock, block);
+}
+
+static ShmAllocSizeClass *
+shm_alloc_space_find_class (ShmAllocSpace * self, unsigned long size)
+{
+  int i;
+
+  for (i = 0; i < SHM_ALLOC_NUM_CLASSES; i++)
+    if (self->classes[i].size == size)
+      return &self->classes[i];
+
+  return NULL;
+}
+
+static void
+shm_alloc_space_flush_class (ShmAllocSpace * self, ShmAllocSizeClass * class)
+{
+  while (class->free_list) {
+    ShmAllocBlock *block = class->free_list;
+
+    class->free_list = block->next_free;
+    self->stats.cached_bytes -= block->size;
+    shm_alloc_space_unlink_block (block);
+  }
+  class->n_free = 0;
+}
+
+static void
+shm_alloc_space_flush_classes (ShmAllocSpace * self)
+{
+  int i;
+
+  for (i = 0; i < SHM_ALLOC_NUM_CLASSES; i++)
+    shm_alloc_space_flush_class (self, &self->classes[i]);
+}
+
+/* Takes an unused class slot, or the least recently used one */
+static ShmAllocSizeClass *
+shm_alloc_space_new_class (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocSizeClass *class = &self->classes[0];
+  int i;
+
+  for (i = 0; i < SHM_ALLOC_NUM_CLASSES; i++) {
+    if (self->classes[i].size == 0) {
+      class = &self->classes[i];
+      break;
+    }
+    if (self->classes[i].last_used < class->last_used)
+      class = &self->classes[i];
+  }
+
+  shm_alloc_space_flush_class (self, class);
+  class->size = size;
+
+  return class;
+}
+
+ShmAllocBlock *
+shm_alloc_space_alloc_block (ShmAllocSpace * self, unsigned long size)
+{
+  ShmAllocSizeClass *class;
+  ShmAllocBlock *block;
+
+  class = shm_alloc_space_find_class (self, size);
+
+  if (class && class->free_list) {
+    block = class->free_list;
+    class->free_list = block->next_free;
+    class->n_free--;
+    block->next_free = NULL;
+    self->stats.cached_bytes -= size;
+    self->stats.cache_hits++;
+  } else {
+    block = shm_alloc_space_first_fit (self, size);
+
+    if (!block && self->stats.cached_bytes > 0) {
+      shm_alloc_space_flush_classes (self);
+      block = shm_alloc_space_first_fit (self, size);
+    }
+
+    if (!block) {
+      self->stats.failures++;
+      return NULL;
+    }
+
+    if (!class)
+      class = shm_alloc_space_new_class (self, size);
+  }
+
+  class->last_used = ++self->clock;
+  block->use_count = 1;
+  self->stats.allocations++;
+  self->stats.used_bytes += size;
 
   return block;
 }
@@ -136,22 +285,21 @@ shm_alloc_space_alloc_block_get_offset (ShmAllocBlock * block)
 static void
 shm_alloc_space_free_block (ShmAllocBlock * block)
 {
-  ShmAllocBlock *item = NULL;
-  ShmAllocBlock *prev_item = NULL;
   ShmAllocSpace *self = block->space;
+  ShmAllocSizeClass *class;
 
-  for (item = self->blocks; item; item = item->next) {
-    if (item == block) {
-      if (prev_item)
-        prev_item->next = item->next;
-      else
-        self->blocks = item->next;
-      break;
-    }
-    prev_item = item;
+  self->stats.used_bytes -= block->size;
+
+  class = shm_alloc_space_find_class (self, block->size);
+  if (class && class->n_free < SHM_ALLOC_MAX_CACHED) {
+    block->next_free = class->free_list;
+    class->free_list = block;
+    class->n_free++;
+    self->stats.cached_bytes += block->size;
+    return;
   }
 
-  spalloc_free (ShmAllocBlock, block);
+  shm_alloc_space_unlink_block (block);
 }
 
 ShmAllocBlock *
@@ -161,12 +309,34 @@ shm_alloc_space_block_get (ShmAllocSpace * self, unsigned long offset)
 
   for (block = self->blocks; block; block = block->next) {
     if (block->offset <= offset && (block->offset + block->size) > offset)
-      return block;
+      return block->use_count > 0 ? block : NULL;
   }
 
   return NULL;
 }
 
+void
+shm_alloc_space_get_stats (ShmAllocSpace * self, ShmAllocStats * stats)
+{
+  ShmAllocBlock *item;
+  unsigned long prev_end_offset = 0;
+  unsigned long largest = 0;
+
+  /* parked blocks count as free, they are released whenever needed */
+  for (item = self->blocks; item; item = item->next) {
+    if (item->use_count == 0)
+      continue;
+    if (item->offset - prev_end_offset > largest)
+      largest = item->offset - prev_end_offset;
+    prev_end_offset = item->offset + item->size;
+  }
+  if (self->size - prev_end_offset > largest)
+    largest = self->size - prev_end_offset;
+
+  *stats = self->stats;
+  stats->largest_free = largest;
+}
+
 
 void
 shm_alloc_space_block_inc (ShmAllocBlock * block)
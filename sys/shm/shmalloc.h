@@ -52,6 +52,23 @@ extern "C" {
 
 typedef struct _ShmAllocSpace ShmAllocSpace;
 typedef struct _ShmAllocBlock ShmAllocBlock;
+typedef struct _ShmAllocStats ShmAllocStats;
+
+struct _ShmAllocStats
+{
+  /* total size of the space */
+  unsigned long size;
+  /* bytes in blocks that are in use */
+  unsigned long used_bytes;
+  /* bytes in freed blocks parked for reuse */
+  unsigned long cached_bytes;
+  /* largest block that could be allocated right now */
+  unsigned long largest_free;
+
+  unsigned long long allocations;
+  unsigned long long cache_hits;
+  unsigned long long failures;
+};
 
 ShmAllocSpace *shm_alloc_space_new (size_t size);
 void shm_alloc_space_free (ShmAllocSpace * self);
@@ -66,6 +83,8 @@ void shm_alloc_space_block_dec (ShmAllocBlock * block);
 ShmAllocBlock * shm_alloc_space_block_get (ShmAllocSpace * space,
     unsigned long offset);
 
+void shm_alloc_space_get_stats (ShmAllocSpace * space, ShmAllocStats * stats);
+
 
 #ifdef __cplusplus
 }
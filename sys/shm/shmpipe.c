@@ -39,6 +39,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <assert.h>
 
 #include "shmalloc.h"
@@ -61,20 +62,57 @@
  * type 4: ack buffer
  * offset
  *
- * Type 4 goes from the client to the server
+ * type 5: protocol extensions
+ * flags
+ *
+ * type 6: shm buffers
+ * count (followed by count BufferEntry)
+ *
+ * type 7: ack buffers
+ * count (followed by count BufferEntry, size unused)
+ *
+ * Type 4, 5 and 7 go from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
+ *
+ * Extensions are negotiated without ever sending an unknown command to an
+ * old peer: the server appends a list of the extensions it supports after
+ * the terminating NUL of the path in type 1, which old clients ignore, and
+ * the client only replies with type 5 if it finds one it supports. Types
+ * 6 and 7 are only used with clients that have enabled the "batch"
+ * extension.
  */
 
 
 #define LISTEN_BACKLOG 10
 
+/* Maximum number of buffers announced or acked in one command */
+#define MAX_BATCH 32
+
+/* Extensions advertised after the shm area path */
+#define EXTENSIONS "batch"
+
 enum
 {
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_PROTOCOL = 5,
+  COMMAND_NEW_BUFFERS = 6,
+  COMMAND_ACK_BUFFERS = 7
+};
+
+enum
+{
+  PROTOCOL_BATCH = (1 << 0)
+};
+
+struct BufferEntry
+{
+  int area_id;
+  unsigned long offset;
+  unsigned long size;
 };
 
 typedef struct _ShmArea ShmArea;
@@ -131,6 +169,21 @@ struct _ShmPipe
   int num_clients;
   ShmClient *clients;
 
+  /* a client holding this many buffers gets no new ones, 0 = unlimited */
+  int max_outstanding;
+
+  /* number of announcements to collect per client before sending them */
+  int batch_size;
+
+  /* client side: extensions enabled with the server, announcements that
+   * were received but not returned yet and acks not sent yet */
+  int protocol_flags;
+  struct BufferEntry pending[MAX_BATCH];
+  int pending_head;
+  int pending_len;
+  struct BufferEntry acks[MAX_BATCH];
+  int n_acks;
+
   mode_t perms;
 };
 
@@ -138,6 +191,19 @@ struct _ShmClient
 {
   int fd;
 
+  /* buffers sent to this client that it has not acked yet */
+  int outstanding;
+  /* buffers this client did not get because it was too far behind */
+  unsigned long long skipped;
+  /* last time (in microseconds) the client acked a buffer or got its first
+   * outstanding one */
+  long long last_progress;
+
+  /* extensions the client enabled and the announcements not sent yet */
+  int protocol_flags;
+  struct BufferEntry batch[MAX_BATCH];
+  int batch_len;
+
   ShmClient *next;
 };
 
@@ -170,15 +236,41 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      unsigned int flags;
+    } protocol;
+    struct
+    {
+      unsigned int count;
+    } buffers;
   } payload;
 };
 
+/* A COMMAND_NEW_BUFFERS or COMMAND_ACK_BUFFERS command and its entries,
+ * sent with a single send() */
+struct BatchCommand
+{
+  struct CommandBuffer cb;
+  struct BufferEntry entries[MAX_BATCH];
+};
+
 static ShmArea *sp_open_shm (char *path, int id, mode_t perms, size_t size);
 static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
 
+static long long
+sp_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 
 
 #define RETURN_ERROR(format, ...) do {                  \
@@ -451,6 +543,68 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+static int
+send_entries (int fd, unsigned short int type, int area_id,
+    struct BufferEntry *entries, int n_entries)
+{
+  struct BatchCommand bc;
+  size_t len = sizeof (struct CommandBuffer) +
+      sizeof (struct BufferEntry) * n_entries;
+
+  memset (&bc.cb, 0, sizeof (struct CommandBuffer));
+  bc.cb.type = type;
+  bc.cb.area_id = area_id;
+  bc.cb.payload.buffers.count = n_entries;
+  memcpy (bc.entries, entries, sizeof (struct BufferEntry) * n_entries);
+
+  if (send (fd, &bc, len, MSG_NOSIGNAL) != len)
+    return 0;
+
+  return 1;
+}
+
+/* Announces a shm area, followed by the extensions this writer supports */
+static int
+send_new_area (int fd, ShmArea * area)
+{
+  struct CommandBuffer cb = { 0 };
+  int namelen = strlen (area->shm_area_name) + 1;
+  int pathlen = namelen + sizeof (EXTENSIONS);
+  char *path;
+  int ret = 0;
+
+  cb.payload.new_shm_area.size = area->shm_area_len;
+  cb.payload.new_shm_area.path_size = pathlen;
+  if (!send_command (fd, &cb, COMMAND_NEW_SHM_AREA, area->id))
+    return 0;
+
+  path = malloc (pathlen);
+  memcpy (path, area->shm_area_name, namelen);
+  memcpy (path + namelen, EXTENSIONS, sizeof (EXTENSIONS));
+
+  if (send (fd, path, pathlen, MSG_NOSIGNAL) == pathlen)
+    ret = 1;
+
+  free (path);
+
+  return ret;
+}
+
+static int
+sp_writer_flush_client (ShmPipe * self, ShmClient * client)
+{
+  int ret;
+
+  if (client->batch_len == 0)
+    return 1;
+
+  ret = send_entries (client->fd, COMMAND_NEW_BUFFERS, self->shm_area->id,
+      client->batch, client->batch_len);
+  client->batch_len = 0;
+
+  return ret;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -458,7 +612,6 @@ sp_writer_resize (ShmPipe * self, size_t size)
   ShmArea *old_current;
   ShmClient *client;
   int c = 0;
-  int pathlen;
 
   if (self->shm_area->shm_area_len == size)
     return 0;
@@ -468,12 +621,13 @@ sp_writer_resize (ShmPipe * self, size_t size)
   if (!newarea)
     return -1;
 
+  /* buffers of the old area must be announced before it is closed */
+  sp_writer_flush (self);
+
   old_current = self->shm_area;
   newarea->next = self->shm_area;
   self->shm_area = newarea;
 
-  pathlen = strlen (newarea->shm_area_name) + 1;
-
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
 
@@ -481,13 +635,7 @@ sp_writer_resize (ShmPipe * self, size_t size)
             old_current->id))
       continue;
 
-    cb.payload.new_shm_area.size = newarea->shm_area_len;
-    cb.payload.new_shm_area.path_size = pathlen;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_SHM_AREA, newarea->id))
-      continue;
-
-    if (send (client->fd, newarea->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-        pathlen)
+    if (!send_new_area (client->fd, newarea))
       continue;
     c++;
   }
@@ -539,7 +687,8 @@ sp_writer_free_block (ShmBlock * block)
   spalloc_free (ShmBlock, block);
 }
 
-/* Returns the number of client this has successfully been sent to */
+/* Returns the number of client this has successfully been sent to,
+ * buffers queued in a client's batch count as sent */
 
 int
 sp_writer_send_buf (ShmPipe * self, char *buf, size_t size)
@@ -580,11 +729,31 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size)
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
-    cb.payload.buffer.offset = offset;
-    cb.payload.buffer.size = bsize;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
+
+    if (self->max_outstanding > 0 &&
+        client->outstanding >= self->max_outstanding) {
+      client->skipped++;
       continue;
+    }
+
+    if ((client->protocol_flags & PROTOCOL_BATCH) && self->batch_size > 1) {
+      struct BufferEntry *entry = &client->batch[client->batch_len++];
+
+      entry->area_id = area->id;
+      entry->offset = offset;
+      entry->size = bsize;
+      if (client->batch_len >= self->batch_size &&
+          !sp_writer_flush_client (self, client))
+        continue;
+    } else {
+      cb.payload.buffer.offset = offset;
+      cb.payload.buffer.size = bsize;
+      if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, area->id))
+        continue;
+    }
     sb->clients[i++] = client->fd;
+    if (client->outstanding++ == 0)
+      client->last_progress = sp_now ();
     c++;
   }
 
@@ -617,6 +786,46 @@ recv_command (int fd, struct CommandBuffer *cb)
   }
 }
 
+/* Checks for @name in the comma separated list of extensions that the
+ * writer sends after the path of a shm area */
+static int
+has_extension (const char *extensions, const char *name)
+{
+  size_t len = strlen (name);
+
+  while (*extensions) {
+    if (!strncmp (extensions, name, len) &&
+        (extensions[len] == ',' || extensions[len] == '\0'))
+      return 1;
+    extensions = strchr (extensions, ',');
+    if (!extensions)
+      break;
+    extensions++;
+  }
+
+  return 0;
+}
+
+static long int
+sp_client_pop_pending (ShmPipe * self, char **buf)
+{
+  struct BufferEntry *entry = &self->pending[self->pending_head];
+  ShmArea *area;
+
+  self->pending_head++;
+  self->pending_len--;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (area->id == entry->area_id) {
+      *buf = area->shm_area_buf + entry->offset;
+      sp_shm_area_inc (area);
+      return entry->size;
+    }
+  }
+
+  return -23;
+}
+
 long int
 sp_client_recv (ShmPipe * self, char **buf)
 {
@@ -624,8 +833,16 @@ sp_client_recv (ShmPipe * self, char **buf)
   ShmArea *newarea;
   ShmArea *area;
   struct CommandBuffer cb;
+  size_t namelen;
   int retval;
 
+  /* Buffers from the last batch come first, the commands that follow them
+   * on the socket may close their area */
+  if (self->pending_len > 0) {
+    assert (buf);
+    return sp_client_pop_pending (self, buf);
+  }
+
   if (!recv_command (self->main_socket, &cb))
     return -1;
 
@@ -634,13 +851,26 @@ sp_client_recv (ShmPipe * self, char **buf)
       assert (cb.payload.new_shm_area.path_size > 0);
       assert (cb.payload.new_shm_area.size > 0);
 
-      area_name = malloc (cb.payload.new_shm_area.path_size);
+      area_name = malloc (cb.payload.new_shm_area.path_size + 1);
       retval = recv (self->main_socket, area_name,
-          cb.payload.new_shm_area.path_size, 0);
+          cb.payload.new_shm_area.path_size, MSG_WAITALL);
       if (retval != cb.payload.new_shm_area.path_size) {
         free (area_name);
         return -3;
       }
+      area_name[cb.payload.new_shm_area.path_size] = '\0';
+
+      /* Older writers send nothing after the path */
+      namelen = strlen (area_name) + 1;
+      if (namelen < cb.payload.new_shm_area.path_size &&
+          !(self->protocol_flags & PROTOCOL_BATCH) &&
+          has_extension (area_name + namelen, "batch")) {
+        struct CommandBuffer pcb = { 0 };
+
+        pcb.payload.protocol.flags = PROTOCOL_BATCH;
+        if (send_command (self->main_socket, &pcb, COMMAND_PROTOCOL, 0))
+          self->protocol_flags |= PROTOCOL_BATCH;
+      }
 
       newarea = sp_open_shm (area_name, cb.area_id, 0,
           cb.payload.new_shm_area.size);
@@ -672,6 +902,21 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_NEW_BUFFERS:
+      assert (buf);
+      if (cb.payload.buffers.count == 0 ||
+          cb.payload.buffers.count > MAX_BATCH)
+        return -5;
+
+      retval = recv (self->main_socket, self->pending,
+          sizeof (struct BufferEntry) * cb.payload.buffers.count, MSG_WAITALL);
+      if (retval != sizeof (struct BufferEntry) * cb.payload.buffers.count)
+        return -3;
+
+      self->pending_head = 0;
+      self->pending_len = cb.payload.buffers.count;
+      return sp_client_pop_pending (self, buf);
+
     default:
       return -99;
   }
@@ -679,36 +924,82 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+static int
+sp_writer_ack (ShmPipe * self, ShmClient * client, int area_id,
+    unsigned long offset)
+{
+  ShmBuffer *buf = NULL, *prev_buf = NULL;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    if (buf->shm_area->id == area_id && buf->offset == offset) {
+      int i;
+
+      /* so that closing the client does not release it again */
+      for (i = 0; i < buf->num_clients; i++) {
+        if (buf->clients[i] == client->fd) {
+          buf->clients[i] = -1;
+          break;
+        }
+      }
+      sp_shmbuf_dec (self, buf, prev_buf);
+      break;
+    }
+    prev_buf = buf;
+  }
+
+  if (!buf)
+    return 0;
+
+  client->outstanding--;
+  client->last_progress = sp_now ();
+
+  return 1;
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client)
 {
-  ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
+  struct BufferEntry entries[MAX_BATCH];
+  int retval;
+  int ret = 0;
+  int i;
 
   if (!recv_command (client->fd, &cb))
     return -1;
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
+      if (!sp_writer_ack (self, client, cb.area_id,
+              cb.payload.ack_buffer.offset))
+        return -2;
+      break;
 
-      for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
-            buf->offset == cb.payload.ack_buffer.offset) {
-          sp_shmbuf_dec (self, buf, prev_buf);
-          break;
-        }
-        prev_buf = buf;
-      }
+    case COMMAND_ACK_BUFFERS:
+      if (cb.payload.buffers.count == 0 ||
+          cb.payload.buffers.count > MAX_BATCH)
+        return -5;
 
-      if (!buf)
-        return -2;
+      retval = recv (client->fd, entries,
+          sizeof (struct BufferEntry) * cb.payload.buffers.count, MSG_WAITALL);
+      if (retval != sizeof (struct BufferEntry) * cb.payload.buffers.count)
+        return -3;
 
+      for (i = 0; i < cb.payload.buffers.count; i++)
+        if (!sp_writer_ack (self, client, entries[i].area_id,
+                entries[i].offset))
+          ret = -2;
       break;
+
+    case COMMAND_PROTOCOL:
+      client->protocol_flags = cb.payload.protocol.flags & PROTOCOL_BATCH;
+      break;
+
     default:
       return -99;
   }
 
-  return 0;
+  return ret;
 }
 
 int
@@ -716,6 +1007,7 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
 {
   ShmArea *shm_area = NULL;
   unsigned long offset;
+  int area_id;
   struct CommandBuffer cb = { 0 };
 
   for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
@@ -727,12 +1019,49 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
   assert (shm_area);
 
   offset = buf - shm_area->shm_area_buf;
+  area_id = shm_area->id;
 
   sp_shm_area_dec (self, shm_area);
 
+  if (self->protocol_flags & PROTOCOL_BATCH) {
+    self->acks[self->n_acks].area_id = area_id;
+    self->acks[self->n_acks].offset = offset;
+    self->acks[self->n_acks].size = 0;
+    self->n_acks++;
+
+    if (self->n_acks == MAX_BATCH)
+      return sp_client_flush_acks (self);
+
+    return 1;
+  }
+
   cb.payload.ack_buffer.offset = offset;
-  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
-      self->shm_area->id);
+  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER, area_id);
+}
+
+/* Sends the acks queued by sp_client_recv_finish(), this must be done
+ * before waiting for the writer as it may be waiting for this memory */
+int
+sp_client_flush_acks (ShmPipe * self)
+{
+  int ret;
+
+  if (self->n_acks == 0)
+    return 1;
+
+  ret = send_entries (self->main_socket, COMMAND_ACK_BUFFERS, 0, self->acks,
+      self->n_acks);
+  self->n_acks = 0;
+
+  return ret;
+}
+
+/* Whether sp_client_recv() has buffers to return without reading from the
+ * socket */
+int
+sp_client_has_pending (ShmPipe * self)
+{
+  return self->pending_len > 0;
 }
 
 ShmPipe *
@@ -769,8 +1098,6 @@ sp_writer_accept_client (ShmPipe * self)
 {
   ShmClient *client = NULL;
   int fd;
-  struct CommandBuffer cb = { 0 };
-  int pathlen = strlen (self->shm_area->shm_area_name) + 1;
 
 
   fd = accept (self->main_socket, NULL, NULL);
@@ -780,20 +1107,13 @@ sp_writer_accept_client (ShmPipe * self)
     return NULL;
   }
 
-  cb.payload.new_shm_area.size = self->shm_area->shm_area_len;
-  cb.payload.new_shm_area.path_size = pathlen;
-  if (!send_command (fd, &cb, COMMAND_NEW_SHM_AREA, self->shm_area->id)) {
+  if (!send_new_area (fd, self->shm_area)) {
     fprintf (stderr, "Sending new shm area failed: %s", strerror (errno));
     goto error;
   }
 
-  if (send (fd, self->shm_area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-      pathlen) {
-    fprintf (stderr, "Sending new shm area path failed: %s", strerror (errno));
-    goto error;
-  }
-
   client = spalloc_new (ShmClient);
+  memset (client, 0, sizeof (ShmClient));
   client->fd = fd;
 
   /* Prepend ot linked list */
@@ -887,6 +1207,86 @@ sp_writer_pending_writes (ShmPipe * self)
   return (self->buffers != NULL);
 }
 
+/* Statistics of the current shm area, older areas are on their way out */
+void
+sp_writer_get_alloc_stats (ShmPipe * self, ShmAllocStats * stats)
+{
+  shm_alloc_space_get_stats (self->shm_area->allocspace, stats);
+}
+
+void
+sp_writer_set_max_outstanding (ShmPipe * self, int max_outstanding)
+{
+  self->max_outstanding = max_outstanding;
+}
+
+int
+sp_writer_client_get_outstanding (ShmClient * client)
+{
+  return client->outstanding;
+}
+
+/* Buffers are announced to clients that support it in groups of
+ * @batch_size, which sp_writer_flush() sends early */
+void
+sp_writer_set_batch_size (ShmPipe * self, int batch_size)
+{
+  sp_writer_flush (self);
+
+  if (batch_size > MAX_BATCH)
+    batch_size = MAX_BATCH;
+  self->batch_size = batch_size;
+}
+
+int
+sp_writer_get_max_batch_size (void)
+{
+  return MAX_BATCH;
+}
+
+/* Returns 0 if the pending announcements have been sent to all clients */
+int
+sp_writer_flush (ShmPipe * self)
+{
+  ShmClient *client;
+  int ret = 0;
+
+  for (client = self->clients; client; client = client->next)
+    if (!sp_writer_flush_client (self, client))
+      ret = -1;
+
+  return ret;
+}
+
+int
+sp_writer_has_unflushed (ShmPipe * self)
+{
+  ShmClient *client;
+
+  for (client = self->clients; client; client = client->next)
+    if (client->batch_len > 0)
+      return 1;
+
+  return 0;
+}
+
+unsigned long long
+sp_writer_client_get_skipped (ShmClient * client)
+{
+  return client->skipped;
+}
+
+/* Returns for how long (in microseconds) the client has been holding
+ * buffers without acking any of them, 0 if it holds none */
+long long
+sp_writer_client_get_stall_time (ShmClient * client)
+{
+  if (client->outstanding == 0)
+    return 0;
+
+  return sp_now () - client->last_progress;
+}
+
 const char *
 sp_writer_get_path (ShmPipe * pipe)
 {
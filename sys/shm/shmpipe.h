@@ -56,6 +56,15 @@
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
  * reading from it.
+ *
+ * If the writer sets a batch size with sp_writer_set_batch_size(),
+ * buffers are announced in groups to the clients that support it. The
+ * writer must then call sp_writer_flush() when it wants the queued
+ * buffers to be delivered, for example before waiting for more data. In
+ * the same way, the client queues its acks once the writer has enabled
+ * batching; it must call sp_client_flush_acks() before it waits on the
+ * socket and should check sp_client_has_pending() before waiting as
+ * sp_client_recv() may already have buffers to return.
  */
 
 
@@ -67,6 +76,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include "shmalloc.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -100,9 +110,22 @@ int sp_writer_recv (ShmPipe * self, ShmClient * client);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
+void sp_writer_set_max_outstanding (ShmPipe * self, int max_outstanding);
+int sp_writer_client_get_outstanding (ShmClient * client);
+unsigned long long sp_writer_client_get_skipped (ShmClient * client);
+long long sp_writer_client_get_stall_time (ShmClient * client);
+void sp_writer_get_alloc_stats (ShmPipe * self, ShmAllocStats * stats);
+
+void sp_writer_set_batch_size (ShmPipe * self, int batch_size);
+int sp_writer_get_max_batch_size (void);
+int sp_writer_flush (ShmPipe * self);
+int sp_writer_has_unflushed (ShmPipe * self);
+
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+int sp_client_flush_acks (ShmPipe * self);
+int sp_client_has_pending (ShmPipe * self);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,198 @@
+/* GStreamer
+ *
+ * colorspace.c: measure the conversion speed of colorspace
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Pushes frames through colorspace from the main thread and reports the
+ * megapixels converted per second for each format pair and each value of
+ * the n-threads property.
+ *
+ * usage: colorspace [-w width] [-h height] [-n frames] [-t threads,...]
+ *                   [from:to ...]
+ *
+ * from and to are fourccs, without pairs a list of the conversions used
+ * on SDI and capture ingest is measured. The thread counts default to
+ * 1,2,4,8, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/colorspace ./colorspace -t 1,4 \
+ *       v210:I420
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+static const gchar *default_pairs[] = {
+  "UYVY:I420", "YUY2:I420", "v210:I420", "v210:UYVY", "NV12:I420",
+  "I420:NV12", "I420:UYVY", "I420:YUY2", "AYUV:I420", "Y42B:I420",
+  NULL
+};
+
+static GstVideoFormat
+parse_format (const gchar * fourcc)
+{
+  if (strlen (fourcc) != 4)
+    return GST_VIDEO_FORMAT_UNKNOWN;
+
+  return gst_video_format_from_fourcc (GST_STR_FOURCC (fourcc));
+}
+
+/* returns the megapixels per second, or a negative value on error */
+static gdouble
+measure (GstVideoFormat from, GstVideoFormat to, gint width, gint height,
+    guint n_frames, guint n_threads)
+{
+  GstElement *pipeline, *csp, *filter, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps, *to_caps;
+  GstBuffer *frame;
+  GstClockTime start, end;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  csp = gst_element_factory_make ("colorspace", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (csp == NULL) {
+    g_printerr ("colorspace element not found\n");
+    exit (1);
+  }
+  g_object_set (csp, "n-threads", n_threads, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  to_caps = gst_video_format_new_caps (to, width, height, 25, 1, 1, 1);
+  g_object_set (filter, "caps", to_caps, NULL);
+  gst_caps_unref (to_caps);
+  gst_bin_add_many (GST_BIN (pipeline), csp, filter, sink, NULL);
+  gst_element_link_many (csp, filter, sink, NULL);
+
+  caps = gst_video_format_new_caps (from, width, height, 25, 1, 1, 1);
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (csp, "sink");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_caps (srcpad, caps);
+
+  frame = gst_buffer_new_and_alloc (gst_video_format_get_size (from, width,
+          height));
+  /* mid grey, which is valid in every format */
+  memset (GST_BUFFER_DATA (frame), 0x80, GST_BUFFER_SIZE (frame));
+  gst_buffer_set_caps (frame, caps);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_push_event (srcpad,
+      gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0));
+
+  /* the first frame negotiates */
+  ret = gst_pad_push (srcpad, gst_buffer_ref (frame));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_frames && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_create_sub (frame, 0, GST_BUFFER_SIZE (frame));
+
+    gst_buffer_set_caps (buf, caps);
+    GST_BUFFER_TIMESTAMP (buf) = i * GST_SECOND / 25;
+    ret = gst_pad_push (srcpad, buf);
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (frame);
+  gst_caps_unref (caps);
+
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+    return -1.0;
+  }
+
+  return (gdouble) width * height * n_frames /
+      ((gdouble) (end - start) / GST_SECOND) / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+  GPtrArray *pairs;
+  gint width = 1920, height = 1080;
+  guint n_frames = 200;
+  const gchar *threads = "1,2,4,8";
+  gchar **n_threads;
+  guint i, j;
+
+  gst_init (&argc, &argv);
+
+  pairs = g_ptr_array_new ();
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-w") && i + 1 < argc)
+      width = MAX (atoi (argv[++i]), 2);
+    else if (!strcmp (argv[i], "-h") && i + 1 < argc)
+      height = MAX (atoi (argv[++i]), 2);
+    else if (!strcmp (argv[i], "-n") && i + 1 < argc)
+      n_frames = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-t") && i + 1 < argc)
+      threads = argv[++i];
+    else
+      g_ptr_array_add (pairs, argv[i]);
+  }
+  if (pairs->len == 0)
+    for (i = 0; default_pairs[i]; i++)
+      g_ptr_array_add (pairs, (gpointer) default_pairs[i]);
+
+  n_threads = g_strsplit (threads, ",", -1);
+
+  g_print ("%dx%d, %u frames\n", width, height, n_frames);
+  g_print ("%-10s", "threads");
+  for (j = 0; n_threads[j]; j++)
+    g_print (" %10u", MAX (atoi (n_threads[j]), 1));
+  g_print ("   (Mpixels/s)\n");
+
+  for (i = 0; i < pairs->len; i++) {
+    const gchar *pair = g_ptr_array_index (pairs, i);
+    GstVideoFormat from, to;
+    gchar **formats;
+    gdouble mps;
+
+    formats = g_strsplit (pair, ":", 2);
+    from = parse_format (formats[0]);
+    to = formats[1] ? parse_format (formats[1]) : GST_VIDEO_FORMAT_UNKNOWN;
+    g_strfreev (formats);
+
+    if (from == GST_VIDEO_FORMAT_UNKNOWN || to == GST_VIDEO_FORMAT_UNKNOWN) {
+      g_printerr ("invalid format pair %s\n", pair);
+      continue;
+    }
+
+    g_print ("%-10s", pair);
+    for (j = 0; n_threads[j]; j++) {
+      mps = measure (from, to, width, height, n_frames,
+          MAX (atoi (n_threads[j]), 1));
+      if (mps < 0)
+        break;
+      g_print (" %10.1f", mps);
+    }
+    g_print ("\n");
+  }
+
+  g_strfreev (n_threads);
+  g_ptr_array_free (pairs, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,202 @@
+/* GStreamer
+ *
+ * liveadder.c: measure the mixing cost of liveadder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Feeds 48 kHz stereo S16 audio in real time into the given numbers of
+ * liveadder sink pads from the main thread and reports the number of
+ * output buffers and the CPU time spent per second of stream for each.
+ * liveadder syncs on the clock, so every measure lasts the duration of the
+ * stream.
+ *
+ * usage: liveadder [-d duration-in-s] [-b buffer-duration-in-ms]
+ *                  [-n pads,...]
+ *
+ * The pad counts default to 1,2,4,8,16,32, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/liveadder ./liveadder -n 8,64
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+
+#define RATE 48000
+#define CHANNELS 2
+
+static guint n_buffers;
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
+{
+  n_buffers++;
+}
+
+static gdouble
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/* returns the CPU time in seconds, or a negative value on error */
+static gdouble
+measure (guint n_pads, guint duration, guint buffer_ms)
+{
+  GstElement *pipeline, *adder, *sink;
+  GstPad **srcpads;
+  GstCaps *caps;
+  GstBuffer *chunk;
+  GstClock *clock;
+  GstClockTime base_time;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, j, n_chunks, chunk_size;
+  gdouble cpu;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  adder = gst_element_factory_make ("liveadder", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (adder == NULL) {
+    g_printerr ("liveadder element not found\n");
+    exit (1);
+  }
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_bin_add_many (GST_BIN (pipeline), adder, sink, NULL);
+  gst_element_link (adder, sink);
+
+  caps = gst_caps_new_simple ("audio/x-raw-int",
+      "rate", G_TYPE_INT, RATE, "channels", G_TYPE_INT, CHANNELS,
+      "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 16,
+      "depth", G_TYPE_INT, 16, "signed", G_TYPE_BOOLEAN, TRUE, NULL);
+
+  srcpads = g_new (GstPad *, n_pads);
+  for (i = 0; i < n_pads; i++) {
+    GstPad *sinkpad;
+
+    srcpads[i] = gst_pad_new ("src", GST_PAD_SRC);
+    sinkpad = gst_element_get_request_pad (adder, "sink%d");
+    gst_pad_link (srcpads[i], sinkpad);
+    gst_object_unref (sinkpad);
+    gst_pad_set_active (srcpads[i], TRUE);
+    gst_pad_set_caps (srcpads[i], caps);
+  }
+
+  chunk_size = RATE * buffer_ms / 1000 * CHANNELS * 2;
+  chunk = gst_buffer_new_and_alloc (chunk_size);
+  memset (GST_BUFFER_DATA (chunk), 0x11, chunk_size);
+
+  n_buffers = 0;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+  clock = gst_element_get_clock (pipeline);
+  base_time = gst_element_get_base_time (pipeline);
+
+  for (i = 0; i < n_pads; i++)
+    gst_pad_push_event (srcpads[i],
+        gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0));
+
+  n_chunks = duration * 1000 / buffer_ms;
+
+  cpu = cpu_time ();
+  for (i = 0; i < n_chunks && ret == GST_FLOW_OK; i++) {
+    GstClockTime ts = i * buffer_ms * GST_MSECOND;
+    GstClockID id;
+
+    /* like a live source, the chunk is available at its end */
+    id = gst_clock_new_single_shot_id (clock,
+        base_time + ts + buffer_ms * GST_MSECOND);
+    gst_clock_id_wait (id, NULL);
+    gst_clock_id_unref (id);
+
+    for (j = 0; j < n_pads && ret == GST_FLOW_OK; j++) {
+      GstBuffer *buf = gst_buffer_create_sub (chunk, 0, chunk_size);
+
+      gst_buffer_set_caps (buf, caps);
+      GST_BUFFER_TIMESTAMP (buf) = ts;
+      GST_BUFFER_DURATION (buf) = buffer_ms * GST_MSECOND;
+      ret = gst_pad_push (srcpads[j], buf);
+    }
+  }
+  for (i = 0; i < n_pads; i++)
+    gst_pad_push_event (srcpads[i], gst_event_new_eos ());
+  cpu = cpu_time () - cpu;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  for (i = 0; i < n_pads; i++)
+    gst_object_unref (srcpads[i]);
+  g_free (srcpads);
+  gst_object_unref (clock);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (chunk);
+  gst_caps_unref (caps);
+
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+    return -1.0;
+  }
+
+  return cpu;
+}
+
+int
+main (int argc, char **argv)
+{
+  const gchar *pads = "1,2,4,8,16,32";
+  gchar **n_pads;
+  guint duration = 5, buffer_ms = 10;
+  gint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-d") && i + 1 < argc)
+      duration = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-b") && i + 1 < argc)
+      buffer_ms = CLAMP (atoi (argv[++i]), 1, 1000);
+    else if (!strcmp (argv[i], "-n") && i + 1 < argc)
+      pads = argv[++i];
+  }
+
+  g_print ("%u Hz, %u channels, %u ms buffers for %u s\n", RATE, CHANNELS,
+      buffer_ms, duration);
+
+  n_pads = g_strsplit (pads, ",", -1);
+  for (i = 0; n_pads[i]; i++) {
+    guint n = MAX (atoi (n_pads[i]), 1);
+    gdouble cpu;
+
+    cpu = measure (n, duration, buffer_ms);
+    if (cpu < 0)
+      continue;
+
+    g_print ("%3u pads: %6.0f buffers/s of stream, "
+        "%.2f ms of CPU per second of stream\n", n,
+        (gdouble) n_buffers / duration, cpu * 1e3 / duration);
+  }
+  g_strfreev (n_pads);
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/* GStreamer
+ *
+ * mpegtsmux.c: measure the output path of mpegtsmux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Muxes a synthetic MPEG-2 video stream of the given bitrate into
+ * mpegtsmux from the main thread and reports, for each value of the
+ * alignment property, the number of output buffers and the CPU time spent
+ * per second of stream.
+ *
+ * usage: mpegtsmux [-r bitrate-in-Mbit/s] [-d duration-in-s]
+ *                  [-a alignment,...] [-m]
+ *
+ * -m writes M2TS (192 byte) packets. The alignments default to 0 (one
+ * buffer per packet), 7 (one UDP/RTP packet) and 348 (64 kB writes), e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/mpegtsmux ./mpegtsmux -r 20
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+
+#define FPS 25
+#define GOP_SIZE 12
+
+static guint n_buffers;
+static guint64 n_bytes;
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
+{
+  n_buffers++;
+  n_bytes += GST_BUFFER_SIZE (buf);
+}
+
+static gdouble
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/* returns the CPU time in seconds, or a negative value on error */
+static gdouble
+measure (guint alignment, gboolean m2ts, guint bitrate, guint duration)
+{
+  GstElement *pipeline, *mux, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+  GstBuffer *frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, frame_size;
+  gdouble cpu;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  mux = gst_element_factory_make ("mpegtsmux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (mux == NULL) {
+    g_printerr ("mpegtsmux element not found\n");
+    exit (1);
+  }
+  g_object_set (mux, "alignment", alignment, "m2ts-mode", m2ts, NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_bin_add_many (GST_BIN (pipeline), mux, sink, NULL);
+  gst_element_link (mux, sink);
+
+  caps = gst_caps_new_simple ("video/mpeg", "mpegversion", G_TYPE_INT, 2,
+      "systemstream", G_TYPE_BOOLEAN, FALSE, NULL);
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_request_pad (mux, "sink_%d");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_caps (srcpad, caps);
+
+  frame_size = bitrate * 1000000 / 8 / FPS;
+  frame = gst_buffer_new_and_alloc (frame_size);
+  memset (GST_BUFFER_DATA (frame), 0x55, frame_size);
+
+  n_buffers = 0;
+  n_bytes = 0;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_push_event (srcpad,
+      gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0));
+
+  cpu = cpu_time ();
+  for (i = 0; i < duration * FPS && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_create_sub (frame, 0, frame_size);
+
+    gst_buffer_set_caps (buf, caps);
+    GST_BUFFER_TIMESTAMP (buf) = gst_util_uint64_scale (i, GST_SECOND, FPS);
+    GST_BUFFER_DURATION (buf) = GST_SECOND / FPS;
+    if (i % GOP_SIZE)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    ret = gst_pad_push (srcpad, buf);
+  }
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  cpu = cpu_time () - cpu;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (frame);
+  gst_caps_unref (caps);
+
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+    return -1.0;
+  }
+
+  return cpu;
+}
+
+int
+main (int argc, char **argv)
+{
+  const gchar *alignments = "0,7,348";
+  gchar **alignment;
+  guint bitrate = 20, duration = 60;
+  gboolean m2ts = FALSE;
+  gint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-r") && i + 1 < argc)
+      bitrate = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-d") && i + 1 < argc)
+      duration = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-a") && i + 1 < argc)
+      alignments = argv[++i];
+    else if (!strcmp (argv[i], "-m"))
+      m2ts = TRUE;
+  }
+
+  g_print ("%u Mbit/s for %u s, %s packets\n", bitrate, duration,
+      m2ts ? "M2TS" : "TS");
+
+  alignment = g_strsplit (alignments, ",", -1);
+  for (i = 0; alignment[i]; i++) {
+    guint n = atoi (alignment[i]);
+    gdouble cpu;
+
+    cpu = measure (n, m2ts, bitrate, duration);
+    if (cpu < 0)
+      continue;
+
+    g_print ("alignment %4u: %8.0f buffers/s of stream, %5.1f bytes average, "
+        "%.2f ms of CPU per second of stream\n", n,
+        (gdouble) n_buffers / duration,
+        n_buffers ? (gdouble) n_bytes / n_buffers : 0.0,
+        cpu * 1e3 / duration);
+  }
+  g_strfreev (alignment);
+
+  return 0;
+}
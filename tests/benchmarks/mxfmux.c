@@ -0,0 +1,197 @@
+/* GStreamer
+ *
+ * mxfmux.c: measure the memory use of mxfmux over long recordings
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Muxes a synthetic recording of small uncompressed frames into mxfmux
+ * from the main thread, as fast as possible, and reports the resident
+ * memory after every hour of stream for each value of the
+ * partition-interval property, together with the number of bytes written
+ * and the CPU time spent.
+ *
+ * usage: mxfmux [-d duration-in-h] [-i partition-interval-in-s,...]
+ *
+ * The intervals default to 0 (a single body partition) and 10, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/mxf ./mxfmux -d 24 -i 10
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <gst/gst.h>
+
+#define FPS 25
+#define WIDTH 32
+#define HEIGHT 24
+
+static guint64 n_bytes;
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
+{
+  n_bytes += GST_BUFFER_SIZE (buf);
+}
+
+static gdouble
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/* resident memory in kB, 0 if unknown */
+static guint64
+resident_memory (void)
+{
+  gchar *contents;
+  guint64 size = 0, resident = 0;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return 0;
+
+  if (sscanf (contents, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT, &size,
+          &resident) != 2)
+    resident = 0;
+  g_free (contents);
+
+  return resident * sysconf (_SC_PAGESIZE) / 1024;
+}
+
+/* returns the CPU time in seconds, or a negative value on error */
+static gdouble
+measure (guint interval, guint hours)
+{
+  GstElement *pipeline, *mux, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+  GstBuffer *frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint64 i;
+  guint frame_size;
+  gdouble cpu;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  mux = gst_element_factory_make ("mxfmux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (mux == NULL) {
+    g_printerr ("mxfmux element not found\n");
+    exit (1);
+  }
+  g_object_set (mux, "partition-interval", (guint64) interval * GST_SECOND,
+      NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_bin_add_many (GST_BIN (pipeline), mux, sink, NULL);
+  gst_element_link (mux, sink);
+
+  caps = gst_caps_new_simple ("video/x-raw-rgb", "bpp", G_TYPE_INT, 32,
+      "depth", G_TYPE_INT, 24, "endianness", G_TYPE_INT, G_BIG_ENDIAN,
+      "red_mask", G_TYPE_INT, 0x0000ff00, "green_mask", G_TYPE_INT,
+      0x00ff0000, "blue_mask", G_TYPE_INT, 0xff000000, "width", G_TYPE_INT,
+      WIDTH, "height", G_TYPE_INT, HEIGHT, "framerate", GST_TYPE_FRACTION, FPS,
+      1, "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_request_pad (mux, "up_video_sink_%u");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_caps (srcpad, caps);
+
+  frame_size = WIDTH * HEIGHT * 4;
+  frame = gst_buffer_new_and_alloc (frame_size);
+  memset (GST_BUFFER_DATA (frame), 0x80, frame_size);
+
+  n_bytes = 0;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  cpu = cpu_time ();
+  for (i = 0; i < (guint64) hours * 3600 * FPS && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_create_sub (frame, 0, frame_size);
+
+    gst_buffer_set_caps (buf, caps);
+    GST_BUFFER_TIMESTAMP (buf) = gst_util_uint64_scale (i, GST_SECOND, FPS);
+    GST_BUFFER_DURATION (buf) = GST_SECOND / FPS;
+    ret = gst_pad_push (srcpad, buf);
+
+    if ((i + 1) % (3600 * FPS) == 0)
+      g_print ("  %3" G_GUINT64_FORMAT " h: %8" G_GUINT64_FORMAT " kB resident, "
+          "%6" G_GUINT64_FORMAT " MB written\n", (i + 1) / (3600 * FPS),
+          resident_memory (), n_bytes / (1024 * 1024));
+  }
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  cpu = cpu_time () - cpu;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (frame);
+  gst_caps_unref (caps);
+
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+    return -1.0;
+  }
+
+  return cpu;
+}
+
+int
+main (int argc, char **argv)
+{
+  const gchar *intervals = "0,10";
+  gchar **interval;
+  guint hours = 4;
+  gint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-d") && i + 1 < argc)
+      hours = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-i") && i + 1 < argc)
+      intervals = argv[++i];
+  }
+
+  g_print ("%ux%u frames at %u fps for %u h\n", WIDTH, HEIGHT, FPS, hours);
+
+  interval = g_strsplit (intervals, ",", -1);
+  for (i = 0; interval[i]; i++) {
+    guint n = atoi (interval[i]);
+    gdouble cpu;
+
+    g_print ("partition interval %u s:\n", n);
+
+    cpu = measure (n, hours);
+    if (cpu < 0)
+      continue;
+
+    g_print ("  %" G_GUINT64_FORMAT " bytes, %.2f ms of CPU per hour of "
+        "stream\n", n_bytes, cpu * 1e3 / hours);
+  }
+  g_strfreev (interval);
+
+  return 0;
+}
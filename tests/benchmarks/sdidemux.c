@@ -0,0 +1,290 @@
+/* GStreamer
+ *
+ * sdidemux.c: measure the unpacking throughput of sdidemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Generates one frame of a 10 bit SDI stream with valid timing references
+ * and line numbers for each mode, pushes it repeatedly into sdidemux from
+ * the main thread and reports the frames per second of CPU time for each
+ * output format, and how many times real time that is.
+ *
+ * usage: sdidemux [-n frames] [-m mode,...] [-f UYVY|v210,...]
+ *
+ * The modes default to pal, 1080i50, 720p60, 1080p50 and 1080p60, the
+ * last two are 3G-SDI rates, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/sdi ./sdidemux -m 1080p60 -f v210
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+
+typedef struct
+{
+  const gchar *name;
+  gint lines, active_lines, width, active_width;
+  gint start0, start1, field2;  /* start1 is 0 for progressive modes */
+  gint fps_n, fps_d;
+  gboolean hd;
+} Mode;
+
+static const Mode modes[] = {
+  {"pal", 625, 576, 864, 720, 23, 336, 313, 25, 1, FALSE},
+  {"720p60", 750, 720, 1650, 1280, 26, 0, 0, 60, 1, TRUE},
+  {"1080i50", 1125, 1080, 2640, 1920, 21, 584, 563, 25, 1, TRUE},
+  {"1080i60", 1125, 1080, 2200, 1920, 21, 584, 563, 30, 1, TRUE},
+  {"1080p50", 1125, 1080, 2640, 1920, 42, 0, 0, 50, 1, TRUE},
+  {"1080p60", 1125, 1080, 2200, 1920, 42, 0, 0, 60, 1, TRUE}
+};
+
+static guint n_frames_out;
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
+{
+  n_frames_out++;
+}
+
+static gdouble
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static guint16
+xyz (gboolean f, gboolean v, gboolean h)
+{
+  return 0x200 | (f << 8) | (v << 7) | (h << 6) | ((v ^ h) << 5) |
+      ((f ^ h) << 4) | ((f ^ v) << 3) | ((f ^ v ^ h) << 2);
+}
+
+/* bit 9 is the inverse of bit 8 */
+static guint16
+ln_word (guint bits)
+{
+  bits <<= 2;
+
+  return bits | ((~bits & 0x100) << 1);
+}
+
+static gboolean
+is_active (const Mode * mode, gint line)
+{
+  if (mode->start1 == 0)
+    return line >= mode->start0 && line < mode->start0 + mode->active_lines;
+
+  return (line >= mode->start0 &&
+      line < mode->start0 + mode->active_lines / 2) ||
+      (line >= mode->start1 && line < mode->start1 + mode->active_lines / 2);
+}
+
+/* the lines start with the EAV, the words are packed LSB first */
+static GstBuffer *
+make_frame (const Mode * mode)
+{
+  GstBuffer *frame;
+  guint16 *words;
+  guint8 *d;
+  gint n_words = mode->width * 2, line_size = mode->width / 2 * 5;
+  gint sav = 2 * (mode->width - mode->active_width) - (mode->hd ? 8 : 4);
+  gint line, i;
+
+  frame = gst_buffer_new_and_alloc (line_size * mode->lines);
+  words = g_new (guint16, n_words);
+
+  for (line = 1; line <= mode->lines; line++) {
+    gboolean f = mode->start1 != 0 && line >= mode->field2;
+    gboolean v = !is_active (mode, line);
+
+    /* blanking, then the active picture */
+    for (i = 0; i < n_words; i++)
+      words[i] = (i & 1) ? 0x040 : 0x200;
+    for (i = sav + (mode->hd ? 8 : 4); i < n_words; i++)
+      words[i] = (i & 1) ? 0x040 + (i % 876) : 0x200 + (line % 64);
+
+    if (mode->hd) {
+      words[0] = words[1] = 0x3ff;
+      words[2] = words[3] = words[4] = words[5] = 0x000;
+      words[6] = words[7] = xyz (f, v, TRUE);
+      words[8] = words[9] = ln_word (line & 0x7f);
+      words[10] = words[11] = ln_word ((line >> 7) & 0x0f);
+      words[sav] = words[sav + 1] = 0x3ff;
+      words[sav + 2] = words[sav + 3] = words[sav + 4] = words[sav + 5] = 0;
+      words[sav + 6] = words[sav + 7] = xyz (f, v, FALSE);
+    } else {
+      words[0] = 0x3ff;
+      words[1] = words[2] = 0x000;
+      words[3] = xyz (f, v, TRUE);
+      words[sav] = 0x3ff;
+      words[sav + 1] = words[sav + 2] = 0x000;
+      words[sav + 3] = xyz (f, v, FALSE);
+    }
+
+    d = GST_BUFFER_DATA (frame) + (line - 1) * line_size;
+    for (i = 0; i < n_words; i += 4) {
+      guint64 group = words[i] | (words[i + 1] << 10) |
+          ((guint64) words[i + 2] << 20) | ((guint64) words[i + 3] << 30);
+
+      d[0] = group;
+      d[1] = group >> 8;
+      d[2] = group >> 16;
+      d[3] = group >> 24;
+      d[4] = group >> 32;
+      d += 5;
+    }
+  }
+  g_free (words);
+
+  return frame;
+}
+
+/* returns the output frames per second of CPU time, or a negative value on
+ * error */
+static gdouble
+measure (const Mode * mode, const gchar * format, guint n_frames)
+{
+  GstElement *pipeline, *demux, *filter, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+  GstBuffer *frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gchar *filter_caps;
+  guint i;
+  gdouble cpu;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  demux = gst_element_factory_make ("sdidemux", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (demux == NULL) {
+    g_printerr ("sdidemux element not found\n");
+    exit (1);
+  }
+  gst_util_set_object_arg (G_OBJECT (demux), "mode", mode->name);
+  filter_caps = g_strdup_printf ("video/x-raw-yuv,format=(fourcc)%s", format);
+  caps = gst_caps_from_string (filter_caps);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_free (filter_caps);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), NULL);
+  gst_bin_add_many (GST_BIN (pipeline), demux, filter, sink, NULL);
+  gst_element_link_many (demux, filter, sink, NULL);
+
+  caps = gst_caps_new_simple ("application/x-raw-sdi", NULL);
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (demux, "sink");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_caps (srcpad, caps);
+
+  frame = make_frame (mode);
+  n_frames_out = 0;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_push_event (srcpad,
+      gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0));
+
+  cpu = cpu_time ();
+  for (i = 0; i < n_frames && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buf = gst_buffer_create_sub (frame, 0, GST_BUFFER_SIZE (frame));
+
+    gst_buffer_set_caps (buf, caps);
+    if (i == 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    ret = gst_pad_push (srcpad, buf);
+  }
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  cpu = cpu_time () - cpu;
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (frame);
+  gst_caps_unref (caps);
+
+  if (ret != GST_FLOW_OK) {
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+    return -1.0;
+  }
+
+  return n_frames_out / cpu;
+}
+
+int
+main (int argc, char **argv)
+{
+  const gchar *mode_names = "pal,1080i50,720p60,1080p50,1080p60";
+  const gchar *format_names = "UYVY,v210";
+  gchar **names, **formats;
+  guint n_frames = 250, k;
+  gint i, j;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-n") && i + 1 < argc)
+      n_frames = MAX (atoi (argv[++i]), 2);
+    else if (!strcmp (argv[i], "-m") && i + 1 < argc)
+      mode_names = argv[++i];
+    else if (!strcmp (argv[i], "-f") && i + 1 < argc)
+      format_names = argv[++i];
+  }
+
+  names = g_strsplit (mode_names, ",", -1);
+  formats = g_strsplit (format_names, ",", -1);
+  for (i = 0; names[i]; i++) {
+    const Mode *mode = NULL;
+    gdouble rate;
+
+    for (k = 0; k < G_N_ELEMENTS (modes); k++)
+      if (!strcmp (modes[k].name, names[i]))
+        mode = &modes[k];
+    if (mode == NULL) {
+      g_printerr ("unknown mode %s\n", names[i]);
+      continue;
+    }
+
+    /* 10 bit words, 2 per sample */
+    rate = (gdouble) mode->width * mode->lines * 20 * mode->fps_n /
+        mode->fps_d / 1e9;
+
+    for (j = 0; formats[j]; j++) {
+      gdouble fps = measure (mode, formats[j], n_frames);
+
+      if (fps < 0)
+        continue;
+
+      g_print ("%-8s %s (%.3f Gbit/s): %7.1f frames/s of CPU, "
+          "%.2f x real time\n", mode->name, formats[j], rate, fps,
+          fps * mode->fps_d / mode->fps_n);
+    }
+  }
+  g_strfreev (formats);
+  g_strfreev (names);
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/* GStreamer
+ *
+ * shm.c: measure the buffer throughput between shmsink and shmsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Sends small buffers from a shmsink to a shmsrc in the same process and
+ * reports the number of buffers per second and the CPU time spent per
+ * buffer, which is dominated by the control socket traffic.
+ *
+ * usage: shm [-n buffers] [-s buffer-size] [-b batch-size]
+ *            [-l batch-latency-in-ms]
+ *
+ * Compare -b 1 (one command per buffer, as with older peers) with larger
+ * batches, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/sys/shm ./shm -n 200000 -b 16
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+
+static GMutex *lock;
+static GCond *cond;
+static guint received;
+static guint n_buffers = 100000;
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
+{
+  g_mutex_lock (lock);
+  if (++received == n_buffers)
+    g_cond_signal (cond);
+  g_mutex_unlock (lock);
+}
+
+static gdouble
+cpu_time (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+  GstElement *writer, *reader, *shmsink, *fakesink;
+  GstClockTime start, end;
+  gchar *socket_path, *desc;
+  guint size = 1024, batch_size = 1, batch_latency = 5;
+  gdouble secs, cpu;
+  gint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-n") && i + 1 < argc)
+      n_buffers = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-s") && i + 1 < argc)
+      size = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-b") && i + 1 < argc)
+      batch_size = MAX (atoi (argv[++i]), 1);
+    else if (!strcmp (argv[i], "-l") && i + 1 < argc)
+      batch_latency = atoi (argv[++i]);
+  }
+
+  lock = g_mutex_new ();
+  cond = g_cond_new ();
+
+  socket_path = g_strdup_printf ("/tmp/shm-benchmark-%d", getpid ());
+
+  desc = g_strdup_printf ("fakesrc num-buffers=%u sizetype=fixed sizemax=%u ! "
+      "shmsink name=sink socket-path=%s shm-size=%u", n_buffers, size,
+      socket_path, MAX (size * 256, 1024 * 1024));
+  writer = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (writer == NULL) {
+    g_printerr ("shmsink element not found\n");
+    return 1;
+  }
+  shmsink = gst_bin_get_by_name (GST_BIN (writer), "sink");
+  g_object_set (shmsink, "batch-size", batch_size, "batch-latency",
+      (guint64) batch_latency * GST_MSECOND, NULL);
+
+  /* the writer creates the socket when it goes to PAUSED and waits there
+   * for the reader to connect */
+  gst_element_set_state (writer, GST_STATE_PAUSED);
+
+  desc = g_strdup_printf ("shmsrc socket-path=%s ! "
+      "fakesink name=sink sync=false signal-handoffs=true", socket_path);
+  reader = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fakesink = gst_bin_get_by_name (GST_BIN (reader), "sink");
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (handoff_cb), NULL);
+
+  start = gst_util_get_timestamp ();
+  cpu = cpu_time ();
+
+  gst_element_set_state (reader, GST_STATE_PLAYING);
+  gst_element_set_state (writer, GST_STATE_PLAYING);
+
+  g_mutex_lock (lock);
+  while (received < n_buffers)
+    g_cond_wait (cond, lock);
+  g_mutex_unlock (lock);
+
+  end = gst_util_get_timestamp ();
+  cpu = cpu_time () - cpu;
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%u buffers of %u bytes (batch-size %u, batch-latency %u ms) "
+      "in %" GST_TIME_FORMAT "\n", n_buffers, size, batch_size, batch_latency,
+      GST_TIME_ARGS (end - start));
+  g_print ("%.0f buffers/s, %.2f us of CPU per buffer\n", n_buffers / secs,
+      cpu * 1e6 / n_buffers);
+
+  gst_element_set_state (reader, GST_STATE_NULL);
+  gst_element_set_state (writer, GST_STATE_NULL);
+  gst_object_unref (fakesink);
+  gst_object_unref (shmsink);
+  gst_object_unref (reader);
+  gst_object_unref (writer);
+  g_free (socket_path);
+  g_cond_free (cond);
+  g_mutex_free (lock);
+
+  return 0;
+}
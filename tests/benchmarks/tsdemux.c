@@ -0,0 +1,392 @@
+/* GStreamer
+ *
+ * tsdemux.c: measure the packet throughput of tsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Pushes a synthetic multi-program transport stream (or the given file)
+ * through tsdemux in push mode from the main thread and reports the number
+ * of packets handled per second.
+ *
+ * usage: tsdemux [-s size-in-MB] [-b blocksize] [-p programs]
+ *                [-n program-number] [-c corrupt-interval] [-j junk-bytes]
+ *                [file.ts]
+ *
+ * -n selects the program tsdemux extracts, the synthetic programs are
+ * numbered from 1.
+ *
+ * -c inserts 1 to 187 bytes of random garbage (with stray sync bytes) every
+ * corrupt-interval packets, -j puts junk before the first packet, to measure
+ * the resync and packet size discovery paths. The garbage is generated from
+ * a fixed seed so runs are comparable.
+ *
+ * Run it against two builds of the plugin to compare them, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst/mpegtsdemux ./tsdemux -s 100
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define PACKET_SIZE 188
+#define PAT_PID 0x0000
+#define PMT_PID_BASE 0x0100
+#define ES_PID_BASE 0x0200
+/* PAT/PMT repetition and PES size, in packets */
+#define PSI_INTERVAL 1000
+#define PES_PACKETS 100
+
+static guint8 continuity[8192];
+
+static guint32
+calc_crc32 (const guint8 * data, guint len)
+{
+  guint32 crc = 0xffffffff;
+  guint i, j;
+
+  for (i = 0; i < len; i++) {
+    crc ^= ((guint32) data[i]) << 24;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+  return crc;
+}
+
+/* writes one 188 byte packet, the payload is padded with adaptation field
+ * stuffing. pcr is in 27MHz units, -1 for none */
+static void
+write_packet (guint8 * p, guint16 pid, gboolean pusi, gint64 pcr,
+    const guint8 * payload, guint len)
+{
+  guint af_len = 184 - len;
+
+  p[0] = 0x47;
+  p[1] = (pusi ? 0x40 : 0x00) | ((pid >> 8) & 0x1f);
+  p[2] = pid & 0xff;
+  p[3] = (af_len ? 0x30 : 0x10) | (continuity[pid]++ & 0x0f);
+
+  if (af_len) {
+    p[4] = af_len - 1;
+    if (af_len > 1) {
+      memset (p + 5, 0xff, af_len - 1);
+      p[5] = 0x00;
+      if (pcr >= 0) {
+        guint64 base = pcr / 300;
+        guint ext = pcr % 300;
+
+        g_assert (af_len >= 8);
+        p[5] = 0x10;
+        p[6] = base >> 25;
+        p[7] = base >> 17;
+        p[8] = base >> 9;
+        p[9] = base >> 1;
+        p[10] = ((base & 1) << 7) | 0x7e | (ext >> 8);
+        p[11] = ext & 0xff;
+      }
+    }
+  }
+  memcpy (p + 4 + af_len, payload, len);
+}
+
+static void
+write_section_packet (guint8 * p, guint16 pid, guint8 * section, guint len)
+{
+  guint8 payload[184];
+  guint32 crc;
+
+  crc = calc_crc32 (section, len - 4);
+  GST_WRITE_UINT32_BE (section + len - 4, crc);
+
+  memset (payload, 0xff, sizeof (payload));
+  payload[0] = 0;               /* pointer_field */
+  memcpy (payload + 1, section, len);
+  write_packet (p, pid, TRUE, -1, payload, 184);
+}
+
+static void
+write_pat (guint8 * p, guint n_programs)
+{
+  guint8 section[184];
+  guint len = 8 + 4 * n_programs + 4;
+  guint i;
+
+  section[0] = 0x00;
+  section[1] = 0xb0 | ((len - 3) >> 8);
+  section[2] = (len - 3) & 0xff;
+  GST_WRITE_UINT16_BE (section + 3, 1);
+  section[5] = 0xc1;
+  section[6] = 0;
+  section[7] = 0;
+  for (i = 0; i < n_programs; i++) {
+    GST_WRITE_UINT16_BE (section + 8 + 4 * i, i + 1);
+    GST_WRITE_UINT16_BE (section + 10 + 4 * i, 0xe000 | (PMT_PID_BASE + i));
+  }
+  write_section_packet (p, PAT_PID, section, len);
+}
+
+static void
+write_pmt (guint8 * p, guint program)
+{
+  guint8 section[184];
+  guint16 es_pid = ES_PID_BASE + program;
+  guint len = 12 + 5 + 4;
+
+  section[0] = 0x02;
+  section[1] = 0xb0 | ((len - 3) >> 8);
+  section[2] = (len - 3) & 0xff;
+  GST_WRITE_UINT16_BE (section + 3, program + 1);
+  section[5] = 0xc1;
+  section[6] = 0;
+  section[7] = 0;
+  GST_WRITE_UINT16_BE (section + 8, 0xe000 | es_pid);
+  GST_WRITE_UINT16_BE (section + 10, 0xf000);
+  section[12] = 0x02;           /* MPEG-2 video */
+  GST_WRITE_UINT16_BE (section + 13, 0xe000 | es_pid);
+  GST_WRITE_UINT16_BE (section + 15, 0xf000);
+  write_section_packet (p, PMT_PID_BASE + program, section, len);
+}
+
+static void
+write_pes_packet (guint8 * p, guint program, guint64 pts, gboolean start)
+{
+  guint8 payload[184];
+
+  memset (payload, 0, sizeof (payload));
+  if (start) {
+    payload[2] = 0x01;
+    payload[3] = 0xe0;
+    payload[6] = 0x80;
+    payload[7] = 0x80;
+    payload[8] = 0x05;
+    payload[9] = 0x21 | ((pts >> 29) & 0x0e);
+    payload[10] = (pts >> 22) & 0xff;
+    payload[11] = ((pts >> 14) & 0xfe) | 0x01;
+    payload[12] = (pts >> 7) & 0xff;
+    payload[13] = ((pts << 1) & 0xfe) | 0x01;
+    /* PCR runs 100ms ahead of the PTS */
+    write_packet (p, ES_PID_BASE + program, TRUE, (pts - 9000) * 300,
+        payload, 176);
+  } else {
+    write_packet (p, ES_PID_BASE + program, FALSE, -1, payload, 184);
+  }
+}
+
+static guint8 *
+make_stream (guint n_packets, guint n_programs)
+{
+  guint8 *data, *p;
+  guint i, es = 0;
+
+  p = data = g_malloc (n_packets * PACKET_SIZE);
+
+  for (i = 0; i < n_packets; i++, p += PACKET_SIZE) {
+    guint slot = i % PSI_INTERVAL;
+
+    if (slot == 0) {
+      write_pat (p, n_programs);
+    } else if (slot <= n_programs) {
+      write_pmt (p, slot - 1);
+    } else {
+      guint program = es % n_programs;
+      guint n = es / n_programs;
+
+      write_pes_packet (p, program, 90000 + (n / PES_PACKETS) * 3600,
+          (n % PES_PACKETS) == 0);
+      es++;
+    }
+  }
+
+  return data;
+}
+
+/* inserts garbage into the stream, returns the new stream */
+static GstBuffer *
+corrupt_stream (GstBuffer * stream, guint interval, guint junk)
+{
+  GByteArray *out;
+  GstBuffer *res;
+  GRand *rand;
+  guint8 garbage[PACKET_SIZE];
+  guint i, n, offset;
+
+  rand = g_rand_new_with_seed (0);
+  out = g_byte_array_sized_new (GST_BUFFER_SIZE (stream) + junk +
+      (interval ? GST_BUFFER_SIZE (stream) / interval : 0));
+
+  for (offset = 0; offset < GST_BUFFER_SIZE (stream); offset += PACKET_SIZE) {
+    if (offset == 0)
+      n = junk;
+    else if (interval && (offset / PACKET_SIZE) % interval == 0)
+      n = g_rand_int_range (rand, 1, PACKET_SIZE);
+    else
+      n = 0;
+
+    while (n) {
+      guint len = MIN (n, PACKET_SIZE);
+
+      for (i = 0; i < len; i++) {
+        garbage[i] = g_rand_int_range (rand, 0, 256);
+        /* make sure there are stray sync bytes in the garbage */
+        if (g_rand_int_range (rand, 0, 16) == 0)
+          garbage[i] = 0x47;
+      }
+      g_byte_array_append (out, garbage, len);
+      n -= len;
+    }
+    g_byte_array_append (out, GST_BUFFER_DATA (stream) + offset,
+        PACKET_SIZE);
+  }
+  g_rand_free (rand);
+
+  res = gst_buffer_new ();
+  GST_BUFFER_SIZE (res) = out->len;
+  GST_BUFFER_MALLOCDATA (res) = g_byte_array_free (out, FALSE);
+  GST_BUFFER_DATA (res) = GST_BUFFER_MALLOCDATA (res);
+  gst_buffer_unref (stream);
+
+  return res;
+}
+
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, GstBin * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (pipeline, sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_set_state (sink, GST_STATE_PLAYING);
+}
+
+int
+main (int argc, char **argv)
+{
+  GstElement *pipeline, *demux;
+  GstPad *srcpad, *sinkpad;
+  GstBuffer *stream;
+  GstClockTime start, end;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gchar *location = NULL;
+  guint size_mb = 100, blocksize = 64 * 1024, n_programs = 8;
+  guint corrupt_interval = 0, junk = 0;
+  gint program_number = -1;
+  guint64 processed, dropped;
+  guint offset, n_packets;
+  gdouble secs;
+  gint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp (argv[i], "-s") && i + 1 < argc)
+      size_mb = atoi (argv[++i]);
+    else if (!strcmp (argv[i], "-b") && i + 1 < argc)
+      blocksize = atoi (argv[++i]);
+    else if (!strcmp (argv[i], "-p") && i + 1 < argc)
+      n_programs = CLAMP (atoi (argv[++i]), 1, 32);
+    else if (!strcmp (argv[i], "-n") && i + 1 < argc)
+      program_number = atoi (argv[++i]);
+    else if (!strcmp (argv[i], "-c") && i + 1 < argc)
+      corrupt_interval = atoi (argv[++i]);
+    else if (!strcmp (argv[i], "-j") && i + 1 < argc)
+      junk = atoi (argv[++i]);
+    else
+      location = argv[i];
+  }
+
+  stream = gst_buffer_new ();
+  if (location) {
+    gchar *contents;
+    gsize length;
+
+    if (!g_file_get_contents (location, &contents, &length, NULL)) {
+      g_printerr ("could not read %s\n", location);
+      return 1;
+    }
+    GST_BUFFER_MALLOCDATA (stream) = (guint8 *) contents;
+    GST_BUFFER_DATA (stream) = (guint8 *) contents;
+    GST_BUFFER_SIZE (stream) = length;
+  } else {
+    n_packets = (size_mb * 1024 * 1024) / PACKET_SIZE;
+    GST_BUFFER_MALLOCDATA (stream) = make_stream (n_packets, n_programs);
+    GST_BUFFER_DATA (stream) = GST_BUFFER_MALLOCDATA (stream);
+    GST_BUFFER_SIZE (stream) = n_packets * PACKET_SIZE;
+  }
+  n_packets = GST_BUFFER_SIZE (stream) / PACKET_SIZE;
+  if (corrupt_interval || junk)
+    stream = corrupt_stream (stream, corrupt_interval, junk);
+
+  pipeline = gst_pipeline_new ("pipeline");
+  demux = gst_element_factory_make ("tsdemux", NULL);
+  if (demux == NULL) {
+    g_printerr ("tsdemux element not found\n");
+    return 1;
+  }
+  g_object_set (demux, "program-number", program_number, NULL);
+  gst_bin_add (GST_BIN (pipeline), demux);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (pad_added_cb), pipeline);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (demux, "sink");
+  gst_pad_link (srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (srcpad, TRUE);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_push_event (srcpad,
+      gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_BYTES, 0, -1, 0));
+
+  start = gst_util_get_timestamp ();
+  for (offset = 0; offset < GST_BUFFER_SIZE (stream) && ret == GST_FLOW_OK;
+      offset += blocksize) {
+    GstBuffer *buf;
+
+    buf = gst_buffer_create_sub (stream, offset,
+        MIN (blocksize, GST_BUFFER_SIZE (stream) - offset));
+    GST_BUFFER_OFFSET (buf) = offset;
+    ret = gst_pad_push (srcpad, buf);
+  }
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+  end = gst_util_get_timestamp ();
+
+  if (ret != GST_FLOW_OK)
+    g_printerr ("push returned %s\n", gst_flow_get_name (ret));
+
+  secs = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%u packets (%u bytes, blocksize %u, corrupt-interval %u, "
+      "junk %u) in %" GST_TIME_FORMAT "\n", n_packets,
+      GST_BUFFER_SIZE (stream), blocksize, corrupt_interval, junk,
+      GST_TIME_ARGS (end - start));
+  g_print ("%.0f packets/s, %.2f MB/s\n", n_packets / secs,
+      GST_BUFFER_SIZE (stream) / secs / (1024 * 1024));
+
+  g_object_get (demux, "packets-processed", &processed, "packets-dropped",
+      &dropped, NULL);
+  g_print ("%" G_GUINT64_FORMAT " packets processed, %" G_GUINT64_FORMAT
+      " dropped by the PID filter\n", processed, dropped);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_buffer_unref (stream);
+
+  return 0;
+}
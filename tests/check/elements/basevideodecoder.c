@@ -0,0 +1,456 @@
+/* GStreamer
+ *
+ * unit test for the parallel decoding of GstBaseVideoDecoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <gst/gst.h>
+#include <gst/video/gstbasevideodecoder.h>
+
+#define WIDTH 16
+#define HEIGHT 16
+#define FPS 25
+#define FRAME_DURATION (GST_SECOND / FPS)
+#define N_FRAMES 20
+#define N_THREADS 4
+#define KEY_INTERVAL 5
+
+/* dummy subclass for testing, a frame is decoded into a one byte buffer.
+ * The frames that come first take the longest, so the workers finish them
+ * out of order, and the workers wait while the gate is closed. */
+
+#define GST_TYPE_TEST_DEC            (gst_test_dec_get_type())
+#define GST_TEST_DEC(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_TEST_DEC,GstTestDec))
+typedef struct _GstTestDec GstTestDec;
+typedef struct _GstTestDecClass GstTestDecClass;
+
+struct _GstTestDec
+{
+  GstBaseVideoDecoder parent;
+
+  /* updated from the workers */
+  gint n_handled;
+  gint n_gops;
+  gint n_bad_gops;
+};
+
+struct _GstTestDecClass
+{
+  GstBaseVideoDecoderClass parent_class;
+};
+
+/* the frames of a GOP seen so far */
+typedef struct
+{
+  guint first;
+  guint n_frames;
+} TestGop;
+
+static GstBaseVideoDecoderParallelism parallelism;
+static GMutex *gate_lock;
+static GCond *gate_cond;
+static gboolean gate_closed;
+static gint n_gops_freed;
+
+static GstStaticPadTemplate gst_test_dec_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-test")
+    );
+
+static GstStaticPadTemplate gst_test_dec_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420"))
+    );
+
+static GType gst_test_dec_get_type (void);
+
+GST_BOILERPLATE (GstTestDec, gst_test_dec, GstBaseVideoDecoder,
+    GST_TYPE_BASE_VIDEO_DECODER);
+
+static void
+gst_test_dec_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_set_details_simple (element_class, "test decoder",
+      "Codec/Decoder/Video", "Dummy test decoder",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_test_dec_sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_test_dec_src_template));
+}
+
+static gboolean
+gst_test_dec_start (GstBaseVideoDecoder * dec)
+{
+  gst_base_video_decoder_set_parallelism (dec, parallelism, N_THREADS);
+
+  return TRUE;
+}
+
+static gboolean
+gst_test_dec_set_format (GstBaseVideoDecoder * dec, GstVideoState * state)
+{
+  GstCaps *caps;
+  gboolean ret;
+
+  state->format = GST_VIDEO_FORMAT_I420;
+  caps = gst_video_format_new_caps (state->format, state->width,
+      state->height, state->fps_n, state->fps_d, 1, 1);
+  ret = gst_pad_set_caps (GST_BASE_VIDEO_CODEC_SRC_PAD (dec), caps);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+static void
+gst_test_dec_free_gop (TestGop * gop)
+{
+  g_atomic_int_inc (&n_gops_freed);
+  g_free (gop);
+}
+
+static GstFlowReturn
+gst_test_dec_handle_frame (GstBaseVideoDecoder * dec, GstVideoFrame * frame)
+{
+  GstTestDec *test = GST_TEST_DEC (dec);
+  guint i = GST_BUFFER_TIMESTAMP (frame->sink_buffer) / FRAME_DURATION;
+
+  g_mutex_lock (gate_lock);
+  while (gate_closed)
+    g_cond_wait (gate_cond, gate_lock);
+  g_mutex_unlock (gate_lock);
+
+  if (parallelism == GST_BASE_VIDEO_DECODER_PARALLELISM_GOP) {
+    TestGop *gop;
+
+    /* the frames of a GOP come in order, from the same worker */
+    if (frame->is_sync_point) {
+      gop = g_new0 (TestGop, 1);
+      gop->first = i;
+      gst_base_video_decoder_set_gop_hook (dec, gop,
+          (GDestroyNotify) gst_test_dec_free_gop);
+    }
+    gop = gst_base_video_decoder_get_gop_hook (dec);
+    if (gop == NULL || gop->first + gop->n_frames != i)
+      g_atomic_int_inc (&test->n_bad_gops);
+    else
+      gop->n_frames++;
+  } else {
+    g_usleep ((N_THREADS - i % N_THREADS) * 2 * 1000);
+  }
+
+  g_atomic_int_inc (&test->n_handled);
+
+  frame->src_buffer = gst_buffer_new_and_alloc (1);
+
+  return gst_base_video_decoder_finish_frame (dec, frame);
+}
+
+static GstFlowReturn
+gst_test_dec_finish (GstBaseVideoDecoder * dec)
+{
+  GstTestDec *test = GST_TEST_DEC (dec);
+  TestGop *gop;
+
+  /* also called at EOS, outside of the workers */
+  gop = gst_base_video_decoder_get_gop_hook (dec);
+  if (gop == NULL)
+    return GST_FLOW_OK;
+
+  if (gop->n_frames != KEY_INTERVAL)
+    g_atomic_int_inc (&test->n_bad_gops);
+  g_atomic_int_inc (&test->n_gops);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_test_dec_class_init (GstTestDecClass * klass)
+{
+  GstBaseVideoDecoderClass *dec_class = GST_BASE_VIDEO_DECODER_CLASS (klass);
+
+  dec_class->start = gst_test_dec_start;
+  dec_class->set_format = gst_test_dec_set_format;
+  dec_class->handle_frame = gst_test_dec_handle_frame;
+  dec_class->finish = gst_test_dec_finish;
+}
+
+static void
+gst_test_dec_init (GstTestDec * dec, GstTestDecClass * g_class)
+{
+  GST_BASE_VIDEO_DECODER (dec)->packetized = TRUE;
+}
+
+/* tests */
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420"))
+    );
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-test")
+    );
+
+static GstElement *dec;
+static GstPad *mysrcpad, *mysinkpad;
+
+static void
+setup_dec (GstBaseVideoDecoderParallelism mode)
+{
+  parallelism = mode;
+  gate_closed = FALSE;
+  n_gops_freed = 0;
+
+  dec = gst_check_setup_element ("testdec");
+  mysrcpad = gst_check_setup_src_pad (dec, &srctemplate, NULL);
+  mysinkpad = gst_check_setup_sink_pad (dec, &sinktemplate, NULL);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+  fail_unless (gst_element_set_state (dec,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+}
+
+static void
+cleanup_dec (void)
+{
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+
+  gst_element_set_state (dec, GST_STATE_NULL);
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (dec);
+  gst_check_teardown_sink_pad (dec);
+  gst_check_teardown_element (dec);
+}
+
+static void
+set_gate (gboolean closed)
+{
+  g_mutex_lock (gate_lock);
+  gate_closed = closed;
+  g_cond_broadcast (gate_cond);
+  g_mutex_unlock (gate_lock);
+}
+
+static GstFlowReturn
+push_frame (guint i)
+{
+  GstBuffer *buf;
+  GstCaps *caps;
+
+  buf = gst_buffer_new_and_alloc (1);
+  caps = gst_caps_new_simple ("video/x-test",
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, FPS, 1, NULL);
+  gst_buffer_set_caps (buf, caps);
+  gst_caps_unref (caps);
+  GST_BUFFER_TIMESTAMP (buf) = i * FRAME_DURATION;
+  GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+  if (i % KEY_INTERVAL != 0)
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return gst_pad_push (mysrcpad, buf);
+}
+
+/* the buffers pushed have the timestamps of frames @first to @last */
+static void
+check_output (guint first, guint last)
+{
+  GList *l;
+  guint i;
+
+  fail_unless_equals_int (g_list_length (buffers), last - first + 1);
+  for (l = buffers, i = first; l; l = l->next, i++) {
+    GstBuffer *buf = l->data;
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buf),
+        i * FRAME_DURATION);
+  }
+}
+
+GST_START_TEST (test_parallel_frame_order)
+{
+  guint64 n_decoded;
+  guint max_queue_depth;
+  guint i;
+
+  setup_dec (GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME);
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+
+  /* EOS drains the workers, the frames are pushed in decoding order */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  check_output (0, N_FRAMES - 1);
+  fail_unless_equals_int (GST_TEST_DEC (dec)->n_handled, N_FRAMES);
+
+  /* a frame is its own lane, at most 2 per worker are in flight */
+  gst_base_video_decoder_get_decode_stats (GST_BASE_VIDEO_DECODER (dec),
+      &n_decoded, NULL, NULL, &max_queue_depth);
+  fail_unless_equals_uint64 (n_decoded, N_FRAMES);
+  fail_unless (max_queue_depth >= 1 && max_queue_depth <= 2 * N_THREADS);
+
+  cleanup_dec ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parallel_flush)
+{
+  guint i;
+
+  setup_dec (GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME);
+
+  /* as many frames as lanes, none gets out of the workers */
+  set_gate (TRUE);
+  for (i = 0; i < 2 * N_THREADS; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  /* the frames in flight belong to the old segment and are dropped */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  set_gate (FALSE);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop ()));
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  /* and the flow is back to normal for the new one */
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME,
+              10 * FRAME_DURATION, -1, 10 * FRAME_DURATION)));
+  for (i = 10; i < N_FRAMES; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  check_output (10, N_FRAMES - 1);
+
+  cleanup_dec ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parallel_gop)
+{
+  GstTestDec *test;
+  guint i;
+
+  setup_dec (GST_BASE_VIDEO_DECODER_PARALLELISM_GOP);
+  test = GST_TEST_DEC (dec);
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  check_output (0, N_FRAMES - 1);
+
+  /* every GOP was handled by one worker with its own hook, finished from
+   * the worker and the hooks were freed once the GOPs were pushed */
+  fail_unless_equals_int (test->n_bad_gops, 0);
+  fail_unless_equals_int (test->n_gops, N_FRAMES / KEY_INTERVAL);
+  fail_unless_equals_int (n_gops_freed, N_FRAMES / KEY_INTERVAL);
+
+  cleanup_dec ();
+}
+
+GST_END_TEST;
+
+static gint n_not_linked;
+
+/* downstream is not linked for one frame only */
+static GstFlowReturn
+not_linked_chain (GstPad * pad, GstBuffer * buf)
+{
+  if (GST_BUFFER_TIMESTAMP (buf) == 3 * FRAME_DURATION) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_LINKED;
+  }
+
+  return gst_check_chain_func (pad, buf);
+}
+
+GST_START_TEST (test_parallel_not_linked)
+{
+  GstFlowReturn ret;
+  guint i;
+
+  setup_dec (GST_BASE_VIDEO_DECODER_PARALLELISM_FRAME);
+  gst_pad_set_chain_function (mysinkpad, not_linked_chain);
+
+  /* reported once at most, without stopping the workers */
+  n_not_linked = 0;
+  for (i = 0; i < N_FRAMES; i++) {
+    ret = push_frame (i);
+    if (ret == GST_FLOW_NOT_LINKED)
+      n_not_linked++;
+    else
+      fail_unless (ret == GST_FLOW_OK);
+  }
+  fail_unless (n_not_linked <= 1);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless_equals_int (g_list_length (buffers), N_FRAMES - 1);
+  fail_unless_equals_int (GST_TEST_DEC (dec)->n_handled, N_FRAMES);
+
+  cleanup_dec ();
+}
+
+GST_END_TEST;
+
+static void
+basevideodecoder_init (void)
+{
+  gst_element_register (NULL, "testdec", GST_RANK_NONE, GST_TYPE_TEST_DEC);
+
+  if (gate_lock == NULL) {
+    gate_lock = g_mutex_new ();
+    gate_cond = g_cond_new ();
+  }
+}
+
+static Suite *
+basevideodecoder_suite (void)
+{
+  Suite *s = suite_create ("basevideodecoder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, basevideodecoder_init, NULL);
+
+  tcase_add_test (tc_chain, test_parallel_frame_order);
+  tcase_add_test (tc_chain, test_parallel_flush);
+  tcase_add_test (tc_chain, test_parallel_gop);
+  tcase_add_test (tc_chain, test_parallel_not_linked);
+
+  return s;
+}
+
+GST_CHECK_MAIN (basevideodecoder);
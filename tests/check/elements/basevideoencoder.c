@@ -0,0 +1,470 @@
+/* GStreamer
+ *
+ * unit test for the lookahead of GstBaseVideoEncoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <gst/gst.h>
+#include <gst/video/gstbasevideoencoder.h>
+
+#define WIDTH 16
+#define HEIGHT 16
+#define FPS 25
+#define FRAME_DURATION (GST_SECOND / FPS)
+#define N_FRAMES 20
+#define LOOKAHEAD 4
+#define BATCH 2
+#define KEY_INTERVAL 5
+#define MIN_LATENCY (10 * GST_MSECOND)
+#define MAX_LATENCY (20 * GST_MSECOND)
+
+/* dummy subclass for testing, a frame is encoded as a one byte buffer and
+ * the analysis of the lookahead hints a key frame every KEY_INTERVAL frames */
+
+#define GST_TYPE_TEST_ENC            (gst_test_enc_get_type())
+#define GST_TEST_ENC(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_TEST_ENC,GstTestEnc))
+typedef struct _GstTestEnc GstTestEnc;
+typedef struct _GstTestEncClass GstTestEncClass;
+
+struct _GstTestEnc
+{
+  GstBaseVideoEncoder parent;
+
+  guint n_batches;
+  guint max_batch;
+  guint max_lookahead;
+};
+
+struct _GstTestEncClass
+{
+  GstBaseVideoEncoderClass parent_class;
+};
+
+static GstStaticPadTemplate gst_test_enc_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420"))
+    );
+
+static GstStaticPadTemplate gst_test_enc_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-test")
+    );
+
+static GType gst_test_enc_get_type (void);
+
+GST_BOILERPLATE (GstTestEnc, gst_test_enc, GstBaseVideoEncoder,
+    GST_TYPE_BASE_VIDEO_ENCODER);
+
+static void
+gst_test_enc_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_set_details_simple (element_class, "test encoder",
+      "Codec/Encoder/Video", "Dummy test encoder",
+      "GStreamer maintainers <gstreamer-devel@lists.sourceforge.net>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_test_enc_sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_test_enc_src_template));
+}
+
+static gboolean
+gst_test_enc_set_format (GstBaseVideoEncoder * enc, GstVideoState * state)
+{
+  gst_base_video_encoder_set_latency (enc, MIN_LATENCY, MAX_LATENCY);
+
+  return TRUE;
+}
+
+static GstCaps *
+gst_test_enc_get_caps (GstBaseVideoEncoder * enc)
+{
+  return gst_caps_new_simple ("video/x-test", NULL);
+}
+
+static GstFlowReturn
+gst_test_enc_handle_frames (GstBaseVideoEncoder * enc, GList * frames)
+{
+  GstTestEnc *test = GST_TEST_ENC (enc);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *l;
+
+  for (l = gst_base_video_encoder_get_lookahead (enc); l; l = l->next) {
+    GstVideoFrame *frame = l->data;
+
+    if (frame->presentation_frame_number % KEY_INTERVAL == 0)
+      frame->type_hint = GST_VIDEO_FRAME_TYPE_KEY;
+  }
+
+  test->n_batches++;
+  test->max_batch = MAX (test->max_batch, g_list_length (frames));
+  test->max_lookahead = MAX (test->max_lookahead,
+      g_list_length (gst_base_video_encoder_get_lookahead (enc)));
+
+  for (l = frames; l && ret == GST_FLOW_OK; l = l->next) {
+    GstVideoFrame *frame = l->data;
+
+    frame->is_sync_point = frame->presentation_frame_number == 0 ||
+        frame->type_hint == GST_VIDEO_FRAME_TYPE_KEY;
+    frame->src_buffer = gst_buffer_new_and_alloc (1);
+    ret = gst_base_video_encoder_finish_frame (enc, frame);
+  }
+
+  return ret;
+}
+
+static void
+gst_test_enc_class_init (GstTestEncClass * klass)
+{
+  GstBaseVideoEncoderClass *enc_class = GST_BASE_VIDEO_ENCODER_CLASS (klass);
+
+  enc_class->set_format = gst_test_enc_set_format;
+  enc_class->get_caps = gst_test_enc_get_caps;
+  enc_class->handle_frames = gst_test_enc_handle_frames;
+}
+
+static void
+gst_test_enc_init (GstTestEnc * enc, GstTestEncClass * g_class)
+{
+  /* do nothing */
+}
+
+/* the same, without @handle_frames, checks that the frames come in order */
+
+#define GST_TYPE_TEST_FRAME_ENC      (gst_test_frame_enc_get_type())
+#define GST_TEST_FRAME_ENC(obj)      (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_TEST_FRAME_ENC,GstTestFrameEnc))
+typedef struct _GstTestFrameEnc GstTestFrameEnc;
+typedef struct _GstTestFrameEncClass GstTestFrameEncClass;
+
+struct _GstTestFrameEnc
+{
+  GstTestEnc parent;
+
+  gint next_frame;
+  guint n_out_of_order;
+};
+
+struct _GstTestFrameEncClass
+{
+  GstTestEncClass parent_class;
+};
+
+static GType gst_test_frame_enc_get_type (void);
+
+GST_BOILERPLATE (GstTestFrameEnc, gst_test_frame_enc, GstTestEnc,
+    GST_TYPE_TEST_ENC);
+
+static void
+gst_test_frame_enc_base_init (gpointer g_class)
+{
+  /* do nothing */
+}
+
+static GstFlowReturn
+gst_test_frame_enc_handle_frame (GstBaseVideoEncoder * enc,
+    GstVideoFrame * frame)
+{
+  GstTestFrameEnc *test = GST_TEST_FRAME_ENC (enc);
+
+  if (frame->presentation_frame_number != test->next_frame)
+    test->n_out_of_order++;
+  test->next_frame = frame->presentation_frame_number + 1;
+
+  frame->is_sync_point = frame->presentation_frame_number == 0;
+  frame->src_buffer = gst_buffer_new_and_alloc (1);
+
+  return gst_base_video_encoder_finish_frame (enc, frame);
+}
+
+static void
+gst_test_frame_enc_class_init (GstTestFrameEncClass * klass)
+{
+  GstBaseVideoEncoderClass *enc_class = GST_BASE_VIDEO_ENCODER_CLASS (klass);
+
+  enc_class->handle_frames = NULL;
+  enc_class->handle_frame = gst_test_frame_enc_handle_frame;
+}
+
+static void
+gst_test_frame_enc_init (GstTestFrameEnc * enc, GstTestFrameEncClass * g_class)
+{
+  /* do nothing */
+}
+
+/* tests */
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-test")
+    );
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ("I420"))
+    );
+
+static GstElement *enc;
+static GstPad *mysrcpad, *mysinkpad;
+
+static gboolean
+upstream_query (GstPad * pad, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_LATENCY) {
+    gst_query_set_latency (query, TRUE, 5 * GST_MSECOND, GST_SECOND);
+    return TRUE;
+  }
+
+  return gst_pad_query_default (pad, query);
+}
+
+static void
+setup_enc_full (const gchar * factory, guint lookahead, guint batch)
+{
+  enc = gst_check_setup_element (factory);
+  gst_base_video_encoder_set_lookahead (GST_BASE_VIDEO_ENCODER (enc),
+      lookahead, batch);
+  mysrcpad = gst_check_setup_src_pad (enc, &srctemplate, NULL);
+  mysinkpad = gst_check_setup_sink_pad (enc, &sinktemplate, NULL);
+  gst_pad_set_query_function (mysrcpad, upstream_query);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+  fail_unless (gst_element_set_state (enc,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+}
+
+static void
+setup_enc (guint lookahead, guint batch)
+{
+  setup_enc_full ("testenc", lookahead, batch);
+}
+
+static void
+cleanup_enc (void)
+{
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+
+  gst_element_set_state (enc, GST_STATE_NULL);
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (enc);
+  gst_check_teardown_sink_pad (enc);
+  gst_check_teardown_element (enc);
+}
+
+static GstFlowReturn
+push_frame (guint i)
+{
+  GstBuffer *buf;
+  GstCaps *caps;
+
+  buf = gst_buffer_new_and_alloc (WIDTH * HEIGHT * 3 / 2);
+  caps = gst_caps_new_simple ("video/x-raw-yuv",
+      "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('I', '4', '2', '0'),
+      "width", G_TYPE_INT, WIDTH, "height", G_TYPE_INT, HEIGHT,
+      "framerate", GST_TYPE_FRACTION, FPS, 1, NULL);
+  gst_buffer_set_caps (buf, caps);
+  gst_caps_unref (caps);
+  GST_BUFFER_TIMESTAMP (buf) = i * FRAME_DURATION;
+  GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+
+  return gst_pad_push (mysrcpad, buf);
+}
+
+static void
+query_latency (GstClockTime * min, GstClockTime * max)
+{
+  GstQuery *query;
+  gboolean live;
+
+  query = gst_query_new_latency ();
+  fail_unless (gst_pad_peer_query (mysinkpad, query));
+  gst_query_parse_latency (query, &live, min, max);
+  fail_unless (live);
+  gst_query_unref (query);
+}
+
+GST_START_TEST (test_lookahead_batches)
+{
+  GstTestEnc *test;
+  guint i, j, n_out = 0, delay, max_delay = 0;
+  GList *l;
+
+  setup_enc (LOOKAHEAD, BATCH);
+  test = GST_TEST_ENC (enc);
+
+  for (i = 0; i < N_FRAMES; i++) {
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+
+    /* frames come out in full batches once LOOKAHEAD frames follow them */
+    if (i + 1 >= LOOKAHEAD + BATCH)
+      fail_unless_equals_int (g_list_length (buffers),
+          (i + 1 - LOOKAHEAD) / BATCH * BATCH);
+    else
+      fail_unless_equals_int (g_list_length (buffers), 0);
+
+    /* how many frames came in since each new output frame */
+    for (j = n_out; j < g_list_length (buffers); j++) {
+      delay = i - j;
+      max_delay = MAX (max_delay, delay);
+    }
+    n_out = g_list_length (buffers);
+  }
+  fail_unless_equals_int (max_delay, LOOKAHEAD + BATCH - 1);
+  fail_unless_equals_int (test->max_batch, BATCH);
+  fail_unless_equals_int (test->max_lookahead, LOOKAHEAD);
+
+  /* EOS drains the lookahead */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless_equals_int (g_list_length (buffers), N_FRAMES);
+
+  /* in order, with the input timestamps, key frames as hinted */
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    GstBuffer *buf = l->data;
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buf),
+        i * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf), FRAME_DURATION);
+    fail_unless_equals_int (!GST_BUFFER_FLAG_IS_SET (buf,
+            GST_BUFFER_FLAG_DELTA_UNIT), i % KEY_INTERVAL == 0);
+  }
+
+  cleanup_enc ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lookahead_latency)
+{
+  GstClockTime min, max, lookahead;
+
+  setup_enc (LOOKAHEAD, BATCH);
+
+  /* the latency needs the framerate */
+  fail_unless (push_frame (0) == GST_FLOW_OK);
+
+  /* the last frame of a batch waits for LOOKAHEAD + BATCH - 1 frames */
+  lookahead = (LOOKAHEAD + BATCH - 1) * FRAME_DURATION;
+  query_latency (&min, &max);
+  fail_unless_equals_uint64 (min, 5 * GST_MSECOND + MIN_LATENCY + lookahead);
+  fail_unless_equals_uint64 (max, GST_SECOND + MAX_LATENCY + lookahead);
+
+  /* and none is left without lookahead */
+  gst_base_video_encoder_set_lookahead (GST_BASE_VIDEO_ENCODER (enc), 0, 1);
+  query_latency (&min, &max);
+  fail_unless_equals_uint64 (min, 5 * GST_MSECOND + MIN_LATENCY);
+  fail_unless_equals_uint64 (max, GST_SECOND + MAX_LATENCY);
+
+  /* the queued frame goes out with the next one */
+  fail_unless (push_frame (1) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 2);
+
+  cleanup_enc ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lookahead_flush)
+{
+  guint i;
+
+  setup_enc (LOOKAHEAD, BATCH);
+
+  for (i = 0; i < LOOKAHEAD; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  /* flushing drops the queued frames */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop ()));
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  cleanup_enc ();
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_lookahead_lowered)
+{
+  GstTestFrameEnc *test;
+  GList *l;
+  guint i;
+
+  setup_enc_full ("testframeenc", LOOKAHEAD, 1);
+  test = GST_TEST_FRAME_ENC (enc);
+
+  for (i = 0; i < LOOKAHEAD; i++)
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  /* the queued frames are handed over before the next one */
+  gst_base_video_encoder_set_lookahead (GST_BASE_VIDEO_ENCODER (enc), 0, 1);
+  for (; i < N_FRAMES; i++) {
+    fail_unless (push_frame (i) == GST_FLOW_OK);
+    fail_unless_equals_int (g_list_length (buffers), i + 1);
+  }
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless_equals_int (test->n_out_of_order, 0);
+  fail_unless_equals_int (g_list_length (buffers), N_FRAMES);
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (l->data),
+        i * FRAME_DURATION);
+
+  cleanup_enc ();
+}
+
+GST_END_TEST;
+
+static void
+basevideoencoder_init (void)
+{
+  gst_element_register (NULL, "testenc", GST_RANK_NONE, GST_TYPE_TEST_ENC);
+  gst_element_register (NULL, "testframeenc", GST_RANK_NONE,
+      GST_TYPE_TEST_FRAME_ENC);
+}
+
+static Suite *
+basevideoencoder_suite (void)
+{
+  Suite *s = suite_create ("basevideoencoder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, basevideoencoder_init, NULL);
+
+  tcase_add_test (tc_chain, test_lookahead_batches);
+  tcase_add_test (tc_chain, test_lookahead_latency);
+  tcase_add_test (tc_chain, test_lookahead_flush);
+  tcase_add_test (tc_chain, test_lookahead_lowered);
+
+  return s;
+}
+
+GST_CHECK_MAIN (basevideoencoder);
@@ -0,0 +1,339 @@
+/* GStreamer
+ *
+ * unit test for the colorspace conversion functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "colorspace.h"
+
+typedef struct
+{
+  GstVideoFormat from;
+  GstVideoFormat to;
+} FormatPair;
+
+static const FormatPair fast_paths[] = {
+  {GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_NV21, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV12},
+  {GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV21},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_UYVY},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_YUY2},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_I420}
+};
+
+/* odd widths, and widths that end with a partial 6 pixel v210 group */
+static const gint widths[] = { 48, 64, 37, 38, 50, 53 };
+static const gint heights[] = { 16, 31 };
+
+/* fast paths and generic conversions, with 4:2:0 and 4:1:1 chroma */
+static const FormatPair thread_pairs[] = {
+  {GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_UYVY},
+  {GST_VIDEO_FORMAT_UYVY, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_AYUV, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_BGRx},
+  {GST_VIDEO_FORMAT_Y41B, GST_VIDEO_FORMAT_YV12}
+};
+
+/* the dithering is only done on the 16 bit intermediate */
+static const FormatPair dither_pairs[] = {
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_I420},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_UYVY},
+  {GST_VIDEO_FORMAT_v210, GST_VIDEO_FORMAT_BGRx}
+};
+
+/* heights that are and aren't a multiple of the band alignment */
+static const gint thread_heights[] = { 48, 61 };
+
+static ColorspaceConvert *
+convert_new (GstVideoFormat from, GstVideoFormat to, gint width, gint height)
+{
+  ColorspaceConvert *convert;
+
+  convert = colorspace_convert_new (to, gst_video_format_is_rgb (to) ?
+      COLOR_SPEC_RGB : COLOR_SPEC_YUV_BT470_6, from,
+      gst_video_format_is_rgb (from) ? COLOR_SPEC_RGB :
+      COLOR_SPEC_YUV_BT470_6, width, height);
+  fail_unless (convert != NULL);
+
+  return convert;
+}
+
+/* colorspace_convert_generic() is static, take it from a conversion that
+ * has no fast path */
+static void
+force_generic (ColorspaceConvert * convert)
+{
+  ColorspaceConvert *plain;
+
+  plain = convert_new (GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_I420, 16, 16);
+  fail_if (convert->convert == plain->convert, "no fast path to compare");
+  convert->convert = plain->convert;
+  colorspace_convert_free (plain);
+}
+
+static guint8 *
+alloc_frame (GstVideoFormat format, gint width, gint height, guint8 value)
+{
+  gint size = gst_video_format_get_size (format, width, height);
+  guint8 *frame = g_malloc (size);
+
+  memset (frame, value, size);
+
+  return frame;
+}
+
+static void
+fill_random (guint8 * data, gint size)
+{
+  gint i;
+
+  for (i = 0; i < size; i++)
+    data[i] = g_random_int_range (0, 256);
+}
+
+/* The 4:2:0 fast paths average the chroma of two lines while the generic
+ * conversion takes it from one of them, so with share_chroma the odd lines
+ * get the chroma of the line above. The padding of the lines is filled
+ * too, as the generic conversion of a wider frame reads it. */
+static void
+fill_v210 (guint8 * data, gint width, gint height, gboolean share_chroma)
+{
+  gint stride = gst_video_format_get_row_stride (GST_VIDEO_FORMAT_v210, 0,
+      width);
+  gint n_samples = stride / 16 * 12;
+  guint16 *samples = g_new (guint16, n_samples);
+  gint i, j;
+
+  for (j = 0; j < height; j++) {
+    guint8 *line = data + j * stride;
+
+    /* in each group the samples alternate between chroma and luma */
+    for (i = 0; i < n_samples; i++) {
+      if (!share_chroma || !(j & 1) || (i & 1))
+        samples[i] = g_random_int_range (0, 1024);
+    }
+
+    for (i = 0; i < n_samples; i += 3)
+      GST_WRITE_UINT32_LE (line + i / 3 * 4, samples[i] |
+          (samples[i + 1] << 10) | (samples[i + 2] << 20));
+  }
+
+  g_free (samples);
+}
+
+/* fails if the samples of the frames, inside width and height, differ */
+static void
+compare_frames (GstVideoFormat format, gint width, gint height,
+    const guint8 * a, const guint8 * b)
+{
+  gint c, i, j;
+
+  for (c = 0; c < 3; c++) {
+    gint offset = gst_video_format_get_component_offset (format, c, width,
+        height);
+    gint stride = gst_video_format_get_row_stride (format, c, width);
+    gint pixel_stride = gst_video_format_get_pixel_stride (format, c);
+    gint w = gst_video_format_get_component_width (format, c, width);
+    gint h = gst_video_format_get_component_height (format, c, height);
+
+    for (j = 0; j < h; j++) {
+      for (i = 0; i < w; i++) {
+        gint k = offset + j * stride + i * pixel_stride;
+
+        fail_unless (a[k] == b[k], "component %d differs at %d,%d: %d != %d",
+            c, i, j, a[k], b[k]);
+      }
+    }
+  }
+}
+
+/* compares the fast path with the generic conversion. The row strides
+ * and component offsets of these formats are the same for an odd width
+ * and the next even one, which the generic conversion needs to convert
+ * the last column */
+static void
+check_fast_path (GstVideoFormat from, GstVideoFormat to, gint width,
+    gint height)
+{
+  ColorspaceConvert *fast, *generic;
+  guint8 *src, *fast_dest, *generic_dest;
+  gint src_size;
+
+  fail_unless_equals_int (gst_video_format_get_size (from, width, height),
+      gst_video_format_get_size (from, GST_ROUND_UP_2 (width), height));
+  fail_unless_equals_int (gst_video_format_get_size (to, width, height),
+      gst_video_format_get_size (to, GST_ROUND_UP_2 (width), height));
+
+  fast = convert_new (from, to, width, height);
+  generic = convert_new (from, to, GST_ROUND_UP_2 (width), height);
+  force_generic (generic);
+
+  src_size = gst_video_format_get_size (from, width, height);
+  src = g_malloc (src_size);
+  if (from == GST_VIDEO_FORMAT_v210)
+    fill_v210 (src, width, height, to == GST_VIDEO_FORMAT_I420);
+  else
+    fill_random (src, src_size);
+
+  fast_dest = alloc_frame (to, width, height, 0x5a);
+  generic_dest = alloc_frame (to, width, height, 0xa5);
+
+  colorspace_convert_convert (fast, fast_dest, src);
+  colorspace_convert_convert (generic, generic_dest, src);
+  compare_frames (to, width, height, fast_dest, generic_dest);
+
+  g_free (src);
+  g_free (fast_dest);
+  g_free (generic_dest);
+  colorspace_convert_free (fast);
+  colorspace_convert_free (generic);
+}
+
+GST_START_TEST (test_fast_paths)
+{
+  gint i, w, h;
+
+  for (i = 0; i < G_N_ELEMENTS (fast_paths); i++) {
+    for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+      for (h = 0; h < G_N_ELEMENTS (heights); h++) {
+        GST_DEBUG ("%" GST_FOURCC_FORMAT " to %" GST_FOURCC_FORMAT ", %dx%d",
+            GST_FOURCC_ARGS (gst_video_format_to_fourcc (fast_paths[i].from)),
+            GST_FOURCC_ARGS (gst_video_format_to_fourcc (fast_paths[i].to)),
+            widths[w], heights[h]);
+        check_fast_path (fast_paths[i].from, fast_paths[i].to, widths[w],
+            heights[h]);
+      }
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* converts the same frame with one thread and with 2, 3 and 4 threads, the
+ * outputs must be the same */
+static void
+check_threads (GstVideoFormat from, GstVideoFormat to, gint width,
+    gint height, gboolean interlaced, ColorSpaceDitherMethod dither)
+{
+  ColorspaceConvert *single;
+  guint8 *src, *ref;
+  gint n_threads, src_size, dest_size;
+
+  src_size = gst_video_format_get_size (from, width, height);
+  dest_size = gst_video_format_get_size (to, width, height);
+  src = g_malloc (src_size);
+  fill_random (src, src_size);
+
+  single = convert_new (from, to, width, height);
+  colorspace_convert_set_interlaced (single, interlaced);
+  colorspace_convert_set_dither (single, dither);
+  ref = alloc_frame (to, width, height, 0);
+  colorspace_convert_convert (single, ref, src);
+  colorspace_convert_free (single);
+
+  for (n_threads = 2; n_threads <= 4; n_threads++) {
+    ColorspaceConvert *threaded;
+    guint8 *dest;
+
+    threaded = convert_new (from, to, width, height);
+    colorspace_convert_set_interlaced (threaded, interlaced);
+    colorspace_convert_set_dither (threaded, dither);
+    colorspace_convert_set_n_threads (threaded, n_threads);
+    dest = alloc_frame (to, width, height, 0);
+    colorspace_convert_convert (threaded, dest, src);
+
+    /* make sure the frame was split */
+    fail_unless (threaded->n_bands > 1);
+    fail_unless (memcmp (ref, dest, dest_size) == 0,
+        "%" GST_FOURCC_FORMAT " to %" GST_FOURCC_FORMAT " %dx%d differs "
+        "with %d threads", GST_FOURCC_ARGS (gst_video_format_to_fourcc (from)),
+        GST_FOURCC_ARGS (gst_video_format_to_fourcc (to)), width, height,
+        n_threads);
+
+    g_free (dest);
+    colorspace_convert_free (threaded);
+  }
+
+  g_free (src);
+  g_free (ref);
+}
+
+GST_START_TEST (test_threads_progressive)
+{
+  gint i, h;
+
+  for (i = 0; i < G_N_ELEMENTS (thread_pairs); i++) {
+    for (h = 0; h < G_N_ELEMENTS (thread_heights); h++)
+      check_threads (thread_pairs[i].from, thread_pairs[i].to, 64,
+          thread_heights[h], FALSE, DITHER_NONE);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_interlaced)
+{
+  gint i, h;
+
+  for (i = 0; i < G_N_ELEMENTS (thread_pairs); i++) {
+    for (h = 0; h < G_N_ELEMENTS (thread_heights); h++)
+      check_threads (thread_pairs[i].from, thread_pairs[i].to, 64,
+          thread_heights[h], TRUE, DITHER_NONE);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_halftone)
+{
+  gint i, h;
+
+  for (i = 0; i < G_N_ELEMENTS (dither_pairs); i++) {
+    for (h = 0; h < G_N_ELEMENTS (thread_heights); h++) {
+      check_threads (dither_pairs[i].from, dither_pairs[i].to, 64,
+          thread_heights[h], FALSE, DITHER_HALFTONE);
+      check_threads (dither_pairs[i].from, dither_pairs[i].to, 64,
+          thread_heights[h], TRUE, DITHER_HALFTONE);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+colorspace_suite (void)
+{
+  Suite *s = suite_create ("colorspace");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_fast_paths);
+  tcase_add_test (tc_chain, test_threads_progressive);
+  tcase_add_test (tc_chain, test_threads_interlaced);
+  tcase_add_test (tc_chain, test_threads_halftone);
+
+  return s;
+}
+
+GST_CHECK_MAIN (colorspace);
@@ -0,0 +1,345 @@
+/* GStreamer
+ *
+ * unit test for the hlsdemux bitrate selection
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* An offline simulator: the fragments of a variant playlist parsed by
+ * GstM3U8Client are "downloaded" over a bandwidth trace and played back at
+ * real time, in simulated time, so the runs are deterministic. */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#include "m3u8.h"
+#include "gsthlsabr.h"
+
+GST_DEBUG_CATEGORY (fragmented_debug);
+
+#define FRAGMENT_DURATION 10
+#define N_FRAGMENTS 60
+/* fragments buffered before starting playback, and at most (as the
+ * fragments-cache property of hlsdemux) */
+#define START_FRAGMENTS 2
+#define MAX_FRAGMENTS 3
+
+static const gint variants[] = { 400000, 800000, 1500000, 3000000 };
+
+typedef struct
+{
+  gdouble duration;             /* seconds */
+  gdouble bandwidth;            /* bits per second */
+} TraceStep;
+
+typedef struct
+{
+  GstM3U8 *last;                /* variant at the end of the run */
+  gdouble stalls;               /* seconds of playback stalled */
+  guint switches;
+  guint down_switches;
+  GstM3U8 *history[N_FRAGMENTS];        /* variant of each fragment */
+  gdouble times[N_FRAGMENTS];   /* end of the download of each fragment */
+} SimResult;
+
+static const TraceStep constant_trace[] = {
+  {0, 10000000}
+};
+
+static const TraceStep step_trace[] = {
+  {120, 5000000},
+  {0, 600000}
+};
+
+static const TraceStep oscillating_trace[] = {
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {10, 2500000}, {10, 1000000}, {10, 2500000}, {10, 1000000},
+  {0, 1000000}
+};
+
+/* hand-written throughput varying like a congested access network, one
+ * sample every 5 seconds. It's not a recorded trace */
+static const TraceStep synthetic_trace[] = {
+  {5, 1800000}, {5, 2100000}, {5, 2400000}, {5, 1900000}, {5, 1200000},
+  {5, 900000}, {5, 1500000}, {5, 2600000}, {5, 3100000}, {5, 2800000},
+  {5, 2200000}, {5, 1600000}, {5, 700000}, {5, 500000}, {5, 900000},
+  {5, 1400000}, {5, 2000000}, {5, 2500000}, {5, 2300000}, {5, 1700000},
+  {5, 1100000}, {5, 1300000}, {5, 1900000}, {5, 2700000}, {5, 3300000},
+  {5, 3000000}, {5, 2400000}, {5, 1800000}, {5, 1500000}, {0, 1600000}
+};
+
+static GstM3U8Client *
+create_client (void)
+{
+  GstM3U8Client *client;
+  GString *playlist;
+  GList *walk;
+  guint i;
+
+  client = gst_m3u8_client_new ("http://localhost/main.m3u8");
+
+  playlist = g_string_new ("#EXTM3U\n");
+  for (i = 0; i < G_N_ELEMENTS (variants); i++)
+    g_string_append_printf (playlist,
+        "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%d\n%d.m3u8\n",
+        variants[i], variants[i]);
+  fail_unless (gst_m3u8_client_update (client,
+          g_string_free (playlist, FALSE)));
+  fail_unless (gst_m3u8_client_has_variant_playlist (client));
+
+  for (walk = client->main->lists; walk; walk = g_list_next (walk)) {
+    gst_m3u8_client_set_current (client, walk->data);
+
+    playlist = g_string_new ("#EXTM3U\n");
+    g_string_append_printf (playlist, "#EXT-X-TARGETDURATION:%d\n",
+        FRAGMENT_DURATION);
+    for (i = 0; i < N_FRAGMENTS; i++)
+      g_string_append_printf (playlist, "#EXTINF:%d,\nfragment-%u.ts\n",
+          FRAGMENT_DURATION, i);
+    g_string_append (playlist, "#EXT-X-ENDLIST\n");
+    fail_unless (gst_m3u8_client_update (client,
+            g_string_free (playlist, FALSE)));
+  }
+
+  gst_m3u8_client_set_current (client, client->main->lists->data);
+
+  return client;
+}
+
+/* returns the time at which bits are downloaded when starting at now */
+static gdouble
+download (const TraceStep * trace, guint n_steps, gdouble now, gdouble bits)
+{
+  gdouble start = 0;
+  guint i;
+
+  for (i = 0; i < n_steps; i++) {
+    gdouble end = start + trace[i].duration;
+
+    /* the last step lasts forever */
+    if (i == n_steps - 1 || now < end) {
+      gdouble t = bits / trace[i].bandwidth;
+
+      if (i == n_steps - 1 || now + t <= end)
+        return now + t;
+      bits -= (end - now) * trace[i].bandwidth;
+      now = end;
+    }
+    start = end;
+  }
+
+  g_assert_not_reached ();
+  return now;
+}
+
+static void
+simulate (GstHLSAbrPolicy policy, const TraceStep * trace, guint n_steps,
+    SimResult * result)
+{
+  GstM3U8Client *client;
+  GstHLSAbr *abr;
+  const gchar *uri;
+  GstClockTime duration;
+  gboolean discont, playing = FALSE;
+  gdouble now = 0, level = 0;
+  guint n = 0;
+
+  memset (result, 0, sizeof (SimResult));
+
+  client = create_client ();
+  abr = gst_hls_abr_new (policy);
+
+  while (gst_m3u8_client_get_next_fragment (client, &discont, &uri,
+          &duration)) {
+    GstM3U8 *current = client->current, *next;
+    gdouble secs, bits, end, time;
+
+    fail_unless (n < N_FRAGMENTS);
+
+    secs = (gdouble) duration / GST_SECOND;
+    bits = (gdouble) current->bandwidth * secs;
+    end = download (trace, n_steps, now, bits);
+    time = end - now;
+
+    /* the playback drains the buffer while downloading */
+    if (playing) {
+      if (level < time) {
+        result->stalls += time - level;
+        level = 0;
+      } else {
+        level -= time;
+      }
+    }
+    now = end;
+    level += secs;
+    if (!playing && level >= START_FRAGMENTS * FRAGMENT_DURATION)
+      playing = TRUE;
+
+    result->history[n] = current;
+    result->times[n] = now;
+    n++;
+
+    gst_hls_abr_add_sample (abr, bits / 8, time * GST_SECOND);
+    next = gst_hls_abr_select (abr, client->main->lists, current,
+        level * GST_SECOND, current->targetduration * GST_SECOND);
+    if (next != current) {
+      result->switches++;
+      if (next->bandwidth < current->bandwidth)
+        result->down_switches++;
+      gst_m3u8_client_set_current (client, next);
+    }
+
+    /* wait until there is room for the next fragment */
+    if (playing && level > MAX_FRAGMENTS * FRAGMENT_DURATION) {
+      now += level - MAX_FRAGMENTS * FRAGMENT_DURATION;
+      level = MAX_FRAGMENTS * FRAGMENT_DURATION;
+    }
+  }
+
+  fail_unless_equals_int (n, N_FRAGMENTS);
+  result->last = client->current;
+
+  GST_DEBUG ("%u switches (%u down), %.1f s stalled, last variant %d",
+      result->switches, result->down_switches, result->stalls,
+      result->last->bandwidth);
+
+  gst_hls_abr_free (abr);
+  gst_m3u8_client_free (client);
+}
+
+static const GstHLSAbrPolicy policies[] = {
+  GST_HLS_ABR_POLICY_EWMA,
+  GST_HLS_ABR_POLICY_HARMONIC
+};
+
+GST_START_TEST (test_constant_bandwidth)
+{
+  SimResult result;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], constant_trace, G_N_ELEMENTS (constant_trace),
+        &result);
+
+    /* climbs one variant at a time to the highest one, and stays there */
+    fail_unless_equals_int (result.last->bandwidth, 3000000);
+    fail_unless_equals_int (result.switches, G_N_ELEMENTS (variants) - 1);
+    fail_unless_equals_int (result.down_switches, 0);
+    fail_unless (result.stalls == 0);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bandwidth_drop)
+{
+  SimResult result;
+  guint i, j, after;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], step_trace, G_N_ELEMENTS (step_trace), &result);
+
+    fail_unless_equals_int (result.last->bandwidth, 400000);
+
+    /* count the fragments downloaded after the drop on a higher variant
+     * than the lowest one, they must be few and the selection must not go
+     * up again */
+    after = 0;
+    for (j = 0; j < N_FRAGMENTS; j++) {
+      if (result.times[j] <= step_trace[0].duration)
+        continue;
+      if (result.history[j]->bandwidth > 400000)
+        after++;
+      if (j > 0 && result.times[j - 1] > step_trace[0].duration)
+        fail_unless (result.history[j]->bandwidth <=
+            result.history[j - 1]->bandwidth);
+    }
+    fail_unless (after <= 4, "%u fragments after the drop", after);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_oscillating_bandwidth)
+{
+  SimResult result;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], oscillating_trace,
+        G_N_ELEMENTS (oscillating_trace), &result);
+
+    /* settles on a variant the average throughput sustains instead of
+     * following each oscillation */
+    fail_unless (result.switches <= 4, "%u switches", result.switches);
+    fail_unless_equals_int (result.down_switches, 0);
+    fail_unless (result.stalls == 0);
+    fail_unless (result.last->bandwidth >= 800000);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_synthetic_trace)
+{
+  SimResult result;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (policies); i++) {
+    simulate (policies[i], synthetic_trace, G_N_ELEMENTS (synthetic_trace),
+        &result);
+
+    fail_unless (result.switches <= 8, "%u switches", result.switches);
+    fail_unless (result.stalls == 0, "%.1f s stalled", result.stalls);
+    fail_unless (result.last->bandwidth >= 800000);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+hlsabr_suite (void)
+{
+  Suite *s = suite_create ("hlsabr");
+  TCase *tc_chain = tcase_create ("general");
+
+  GST_DEBUG_CATEGORY_INIT (fragmented_debug, "fragmented", 0,
+      "Fragmented source");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_constant_bandwidth);
+  tcase_add_test (tc_chain, test_bandwidth_drop);
+  tcase_add_test (tc_chain, test_oscillating_bandwidth);
+  tcase_add_test (tc_chain, test_synthetic_trace);
+
+  return s;
+}
+
+GST_CHECK_MAIN (hlsabr);
@@ -0,0 +1,294 @@
+/* GStreamer
+ *
+ * unit test for hlsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+/* Playlists of local fragments, the fragment n is FRAGMENT_SIZE * n bytes
+ * of value n. A fragment with an URI that no element handles can't be
+ * fetched */
+
+#define FRAGMENT_SIZE 1000
+#define BAD_FRAGMENT_URI "nosuchprotocol:///fragment.ts"
+
+static GMutex *handoff_mutex;
+static GCond *handoff_cond;
+static GList *fragments;
+
+static gchar *
+make_temp_dir (void)
+{
+  gchar *name, *dir;
+
+  name = g_strdup_printf ("gst-check-hlsdemux-%u", g_random_int ());
+  dir = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_free (name);
+  fail_unless (g_mkdir (dir, 0700) == 0);
+
+  return dir;
+}
+
+static void
+remove_temp_dir (gchar * dir)
+{
+  const gchar *name;
+  GDir *d;
+
+  d = g_dir_open (dir, 0, NULL);
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    gchar *path = g_build_filename (dir, name, NULL);
+
+    g_remove (path);
+    g_free (path);
+  }
+  g_dir_close (d);
+  g_rmdir (dir);
+  g_free (dir);
+}
+
+/* writes a playlist of @n_fragments fragments of @duration seconds, the
+ * fragment @bad (counting from 1) can't be fetched. Returns the playlist
+ * location */
+static gchar *
+write_playlist (const gchar * dir, guint n_fragments, guint duration,
+    guint bad)
+{
+  GString *playlist;
+  gchar *location;
+  guint i;
+
+  playlist = g_string_new ("#EXTM3U\n");
+  g_string_append_printf (playlist, "#EXT-X-TARGETDURATION:%u\n", duration);
+  for (i = 1; i <= n_fragments; i++) {
+    g_string_append_printf (playlist, "#EXTINF:%u,\n", duration);
+    if (i == bad) {
+      g_string_append (playlist, BAD_FRAGMENT_URI "\n");
+    } else {
+      gchar *name, *path, *data;
+
+      name = g_strdup_printf ("fragment%u.ts", i);
+      path = g_build_filename (dir, name, NULL);
+      data = g_malloc (FRAGMENT_SIZE * i);
+      memset (data, i, FRAGMENT_SIZE * i);
+      fail_unless (g_file_set_contents (path, data, FRAGMENT_SIZE * i, NULL));
+      g_string_append_printf (playlist, "%s\n", name);
+      g_free (data);
+      g_free (path);
+      g_free (name);
+    }
+  }
+  g_string_append (playlist, "#EXT-X-ENDLIST\n");
+
+  location = g_build_filename (dir, "playlist.m3u8", NULL);
+  fail_unless (g_file_set_contents (location, playlist->str, -1, NULL));
+  g_string_free (playlist, TRUE);
+
+  return location;
+}
+
+static void
+_fragment_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  g_mutex_lock (handoff_mutex);
+  fragments = g_list_append (fragments, gst_buffer_ref (buffer));
+  g_cond_signal (handoff_cond);
+  g_mutex_unlock (handoff_mutex);
+}
+
+static GstElement *
+setup_pipeline (const gchar * location)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  handoff_mutex = g_mutex_new ();
+  handoff_cond = g_cond_new ();
+
+  desc = g_strdup_printf ("filesrc location=%s ! "
+      "hlsdemux fragments-cache=3 prefetch-fragments=2 ! "
+      "fakesink name=sink sync=false signal-handoffs=true", location);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (_fragment_handoff), NULL);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  return pipeline;
+}
+
+static void
+cleanup_pipeline (GstElement * pipeline)
+{
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+
+  g_list_foreach (fragments, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (fragments);
+  fragments = NULL;
+  g_cond_free (handoff_cond);
+  g_mutex_free (handoff_mutex);
+}
+
+static void
+wait_for_fragments (guint n_fragments)
+{
+  g_mutex_lock (handoff_mutex);
+  while (g_list_length (fragments) < n_fragments)
+    g_cond_wait (handoff_cond, handoff_mutex);
+  g_mutex_unlock (handoff_mutex);
+}
+
+/* checks that the fragments were pushed in order and complete */
+static void
+check_fragments (guint n_fragments)
+{
+  GList *l;
+  guint i, j;
+
+  g_mutex_lock (handoff_mutex);
+  fail_unless_equals_int (g_list_length (fragments), n_fragments);
+  for (l = fragments, i = 1; l; l = l->next, i++) {
+    GstBuffer *buf = l->data;
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (buf), FRAGMENT_SIZE * i);
+    for (j = 0; j < GST_BUFFER_SIZE (buf); j++)
+      fail_unless_equals_int (GST_BUFFER_DATA (buf)[j], i);
+  }
+  g_mutex_unlock (handoff_mutex);
+}
+
+GST_START_TEST (test_prefetch)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *dir, *location;
+
+  dir = make_temp_dir ();
+  location = write_playlist (dir, 6, 1, 0);
+  pipeline = setup_pipeline (location);
+
+  /* the fragments downloaded in parallel are still pushed in order */
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  check_fragments (6);
+
+  cleanup_pipeline (pipeline);
+  g_free (location);
+  remove_temp_dir (dir);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_prefetch_error_unused)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *dir, *location;
+
+  /* the third fragment is prefetched while caching the first two, and is
+   * only needed after the 10 seconds of the next update */
+  dir = make_temp_dir ();
+  location = write_playlist (dir, 3, 10, 3);
+  pipeline = setup_pipeline (location);
+
+  wait_for_fragments (2);
+  check_fragments (2);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  fail_unless (msg == NULL);
+  gst_object_unref (bus);
+
+  cleanup_pipeline (pipeline);
+  g_free (location);
+  remove_temp_dir (dir);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_prefetch_error_used)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err = NULL;
+  gchar *dir, *location;
+
+  /* the error is posted when the third fragment is needed, after the
+   * first two were pushed */
+  dir = make_temp_dir ();
+  location = write_playlist (dir, 3, 1, 3);
+  pipeline = setup_pipeline (location);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR);
+  gst_message_parse_error (msg, &err, NULL);
+  fail_unless (err->domain == GST_RESOURCE_ERROR);
+  fail_unless_equals_int (err->code, GST_RESOURCE_ERROR_OPEN_READ);
+  g_error_free (err);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  check_fragments (2);
+
+  cleanup_pipeline (pipeline);
+  g_free (location);
+  remove_temp_dir (dir);
+}
+
+GST_END_TEST;
+
+static Suite *
+hlsdemux_suite (void)
+{
+  Suite *s = suite_create ("hlsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+  tcase_add_test (tc_chain, test_prefetch);
+  tcase_add_test (tc_chain, test_prefetch_error_unused);
+  tcase_add_test (tc_chain, test_prefetch_error_used);
+
+  return s;
+}
+
+GST_CHECK_MAIN (hlsdemux);
@@ -0,0 +1,312 @@
+/* GStreamer
+ *
+ * unit test for the volume, mute and soft clip of liveadder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The element is left in PAUSED without a clock, so the mixed samples are
+ * pushed as soon as a buffer was mixed and a single input is enough to
+ * see what was done to it. */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#define RATE 8000
+#define N_SAMPLES 80
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstElement *
+setup_liveadder (GstPad ** sinkpad)
+{
+  GstElement *adder;
+
+  adder = gst_check_setup_element ("liveadder");
+  mysinkpad = gst_check_setup_sink_pad (adder, &sinktemplate, NULL);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  *sinkpad = gst_element_get_request_pad (adder, "sink%d");
+  fail_unless (*sinkpad != NULL);
+  mysrcpad = gst_pad_new_from_static_template (&srctemplate, "src");
+  fail_unless (gst_pad_link (mysrcpad, *sinkpad) == GST_PAD_LINK_OK);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  return adder;
+}
+
+static void
+cleanup_liveadder (GstElement * adder, GstPad * sinkpad)
+{
+  fail_unless (gst_element_set_state (adder,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_unlink (mysrcpad, sinkpad);
+  gst_object_unref (mysrcpad);
+  gst_element_release_request_pad (adder, sinkpad);
+  gst_object_unref (sinkpad);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_sink_pad (adder);
+  gst_check_teardown_element (adder);
+}
+
+static GstCaps *
+int_caps (gint width, gboolean is_signed)
+{
+  return gst_caps_new_simple ("audio/x-raw-int", "rate", G_TYPE_INT, RATE,
+      "channels", G_TYPE_INT, 1, "width", G_TYPE_INT, width,
+      "depth", G_TYPE_INT, width, "signed", G_TYPE_BOOLEAN, is_signed,
+      "endianness", G_TYPE_INT, G_BYTE_ORDER, NULL);
+}
+
+static GstCaps *
+float_caps (void)
+{
+  return gst_caps_new_simple ("audio/x-raw-float", "rate", G_TYPE_INT, RATE,
+      "channels", G_TYPE_INT, 1, "width", G_TYPE_INT, 32,
+      "endianness", G_TYPE_INT, G_BYTE_ORDER, NULL);
+}
+
+/* Pushes N_SAMPLES samples of @data and returns the samples that come out,
+ * to be freed with g_free() */
+static gpointer
+mix (GstElement * adder, GstCaps * caps, gconstpointer data, guint bps)
+{
+  GstBuffer *buf;
+  guint8 *out;
+  guint size = N_SAMPLES * bps, offset = 0;
+  GList *l;
+
+  fail_unless (gst_element_set_state (adder,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  buf = gst_buffer_new_and_alloc (size);
+  memcpy (GST_BUFFER_DATA (buf), data, size);
+  gst_buffer_set_caps (buf, caps);
+  GST_BUFFER_TIMESTAMP (buf) = 0;
+  GST_BUFFER_DURATION (buf) = gst_util_uint64_scale (N_SAMPLES, GST_SECOND,
+      RATE);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+  gst_caps_unref (caps);
+
+  /* the mixed samples can be split in several buffers */
+  g_mutex_lock (check_mutex);
+  for (;;) {
+    guint avail = 0;
+
+    for (l = buffers; l; l = l->next)
+      avail += GST_BUFFER_SIZE (l->data);
+    if (avail >= size)
+      break;
+    g_cond_wait (check_cond, check_mutex);
+  }
+  g_mutex_unlock (check_mutex);
+
+  out = g_malloc (size);
+  for (l = buffers; l && offset < size; l = l->next) {
+    guint n = MIN (GST_BUFFER_SIZE (l->data), size - offset);
+
+    memcpy (out + offset, GST_BUFFER_DATA (l->data), n);
+    offset += n;
+  }
+  fail_unless_equals_int (offset, size);
+
+  return out;
+}
+
+static void
+set_pad (GstPad * sinkpad, gdouble volume, gboolean mute)
+{
+  g_object_set (sinkpad, "volume", volume, "mute", mute, NULL);
+}
+
+#define fail_unless_close(a, b, tolerance) \
+  fail_unless (ABS ((gdouble) (a) - (gdouble) (b)) <= (tolerance), \
+      "%g is not %g", (gdouble) (a), (gdouble) (b))
+
+GST_START_TEST (test_volume_s16)
+{
+  GstElement *adder;
+  GstPad *sinkpad;
+  gint16 in[N_SAMPLES], *out;
+  gint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    in[i] = (i % 3 == 0) ? 1000 : (i % 3 == 1) ? -1000 : G_MAXINT16;
+
+  adder = setup_liveadder (&sinkpad);
+  set_pad (sinkpad, 0.5, FALSE);
+  out = mix (adder, int_caps (16, TRUE), in, 2);
+
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_close (out[i], in[i] * 0.5, 1);
+
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+}
+
+GST_END_TEST;
+
+/* unsigned samples are scaled around their silence, 128 */
+GST_START_TEST (test_volume_u8)
+{
+  GstElement *adder;
+  GstPad *sinkpad;
+  guint8 in[N_SAMPLES], *out;
+  gint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    in[i] = (i % 3 == 0) ? 168 : (i % 3 == 1) ? 88 : 255;
+
+  adder = setup_liveadder (&sinkpad);
+  set_pad (sinkpad, 0.5, FALSE);
+  out = mix (adder, int_caps (8, FALSE), in, 1);
+
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_close (out[i], 128 + (in[i] - 128) * 0.5, 1);
+
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+}
+
+GST_END_TEST;
+
+/* and saturate at both ends of their range */
+GST_START_TEST (test_volume_u16)
+{
+  GstElement *adder;
+  GstPad *sinkpad;
+  guint16 in[N_SAMPLES], *out;
+  gint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    in[i] = (i & 1) ? 0x8000 + 20000 : 0x8000 - 20000;
+
+  adder = setup_liveadder (&sinkpad);
+  set_pad (sinkpad, 2.0, FALSE);
+  out = mix (adder, int_caps (16, FALSE), in, 2);
+
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_equals_int (out[i], (i & 1) ? G_MAXUINT16 : 0);
+
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_mute)
+{
+  GstElement *adder;
+  GstPad *sinkpad;
+  guint16 in[N_SAMPLES], *out;
+  gint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    in[i] = i * 800;
+
+  /* silence is 0 for signed samples */
+  adder = setup_liveadder (&sinkpad);
+  set_pad (sinkpad, 1.0, TRUE);
+  out = mix (adder, int_caps (16, TRUE), in, 2);
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_equals_int (out[i], 0);
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+
+  /* and the middle of the range for unsigned ones */
+  adder = setup_liveadder (&sinkpad);
+  set_pad (sinkpad, 1.0, TRUE);
+  out = mix (adder, int_caps (16, FALSE), in, 2);
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_equals_int (out[i], 0x8000);
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_soft_clip)
+{
+  GstElement *adder;
+  GstPad *sinkpad;
+  gfloat in[N_SAMPLES], *out;
+  gint i;
+
+  for (i = 0; i < N_SAMPLES; i++)
+    in[i] = (i % 3 == 0) ? 0.25 : (i % 3 == 1) ? 0.75 : -2.0;
+
+  /* passed on as is by default */
+  adder = setup_liveadder (&sinkpad);
+  out = mix (adder, float_caps (), in, 4);
+  for (i = 0; i < N_SAMPLES; i++)
+    fail_unless_close (out[i], in[i], 1e-6);
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+
+  /* the samples below half of full scale are untouched, the others are
+   * rounded off and never go above full scale */
+  adder = setup_liveadder (&sinkpad);
+  g_object_set (adder, "soft-clip", TRUE, NULL);
+  out = mix (adder, float_caps (), in, 4);
+  for (i = 0; i < N_SAMPLES; i++) {
+    if (i % 3 == 0)
+      fail_unless_close (out[i], 0.25, 1e-6);
+    else if (i % 3 == 1)
+      fail_unless_close (out[i], 0.71875, 1e-6);
+    else
+      fail_unless_close (out[i], -1.0, 1e-6);
+  }
+  g_free (out);
+  cleanup_liveadder (adder, sinkpad);
+}
+
+GST_END_TEST;
+
+static Suite *
+liveadder_suite (void)
+{
+  Suite *s = suite_create ("liveadder");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_volume_s16);
+  tcase_add_test (tc_chain, test_volume_u8);
+  tcase_add_test (tc_chain, test_volume_u16);
+  tcase_add_test (tc_chain, test_mute);
+  tcase_add_test (tc_chain, test_soft_clip);
+
+  return s;
+}
+
+GST_CHECK_MAIN (liveadder)
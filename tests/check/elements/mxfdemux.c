@@ -21,9 +21,14 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include "mxfdemux.h"
 
+#define N_FRAMES 100
+#define FPS 25
+#define FRAME_DURATION (GST_SECOND / FPS)
+
 static GstPad *mysrcpad, *mysinkpad;
 static GMainLoop *loop = NULL;
 static gboolean have_eos = FALSE;
@@ -256,6 +261,417 @@ GST_START_TEST (test_push)
 
 GST_END_TEST;
 
+/* Pushes the file in a single buffer, or split in the middle of the essence
+ * packet, and returns the bytes-copied and bytes-forwarded statistics */
+static void
+push_bytes_counted (gboolean split, guint64 * copied, guint64 * forwarded)
+{
+  GstElement *mxfdemux;
+  GstBuffer *buffer;
+  GstPad *sinkpad;
+  guint i, split_offset = sizeof (mxf_file);
+
+  have_data = FALSE;
+  have_eos = FALSE;
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+  fail_unless (sinkpad != NULL);
+
+  mysinkpad = _create_sink_pad ();
+  mysrcpad = _create_src_pad_push ();
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+
+  if (split) {
+    for (i = 0; i + sizeof (mxf_essence) <= sizeof (mxf_file); i++) {
+      if (memcmp (mxf_file + i, mxf_essence, sizeof (mxf_essence)) == 0) {
+        split_offset = i + sizeof (mxf_essence) / 2;
+        break;
+      }
+    }
+    fail_unless (split_offset < sizeof (mxf_file));
+  }
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_DATA (buffer) = (guint8 *) mxf_file;
+  GST_BUFFER_SIZE (buffer) = split_offset;
+  GST_BUFFER_OFFSET (buffer) = 0;
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+
+  if (split_offset < sizeof (mxf_file)) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_DATA (buffer) = (guint8 *) mxf_file + split_offset;
+    GST_BUFFER_SIZE (buffer) = sizeof (mxf_file) - split_offset;
+    GST_BUFFER_OFFSET (buffer) = split_offset;
+    fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+  }
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless (have_eos == TRUE);
+  fail_unless (have_data == TRUE);
+
+  /* the statistics are reset when going back to READY */
+  g_object_get (mxfdemux, "bytes-copied", copied, "bytes-forwarded",
+      forwarded, NULL);
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+}
+
+/* Only the essence is counted, once, and the metadata that the adapter
+ * merges is not */
+GST_START_TEST (test_push_bytes_copied)
+{
+  guint64 copied, forwarded;
+
+  push_bytes_counted (FALSE, &copied, &forwarded);
+  fail_unless_equals_uint64 (copied, 0);
+  fail_unless_equals_uint64 (forwarded, sizeof (mxf_essence));
+
+  push_bytes_counted (TRUE, &copied, &forwarded);
+  fail_unless_equals_uint64 (copied, sizeof (mxf_essence));
+  fail_unless_equals_uint64 (forwarded, 0);
+}
+
+GST_END_TEST;
+
+/* Files written by mxfmux, with a body partition and an index table
+ * segment every second */
+
+static gchar *
+make_temp_dir (void)
+{
+  gchar *name, *dir;
+
+  name = g_strdup_printf ("gst-check-mxfdemux-%u", g_random_int ());
+  dir = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_free (name);
+  fail_unless (g_mkdir (dir, 0700) == 0);
+
+  return dir;
+}
+
+static void
+remove_temp_dir (gchar * dir)
+{
+  const gchar *name;
+  GDir *d;
+
+  d = g_dir_open (dir, 0, NULL);
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    gchar *path = g_build_filename (dir, name, NULL);
+
+    g_remove (path);
+    g_free (path);
+  }
+  g_dir_close (d);
+  g_rmdir (dir);
+  g_free (dir);
+}
+
+/* runs @pipeline until EOS */
+static void
+run_to_eos (GstElement * pipeline)
+{
+  GstMessage *msg;
+  GstBus *bus;
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+}
+
+static gchar *
+mux_file (const gchar * dir, guint n_frames)
+{
+  GstElement *pipeline;
+  gchar *location, *desc;
+
+  location = g_build_filename (dir, "test.mxf", NULL);
+  desc = g_strdup_printf ("videotestsrc num-buffers=%u ! "
+      "video/x-raw-yuv,format=(fourcc)v308,width=64,height=48,"
+      "framerate=%d/1 ! mxfmux partition-interval=%" G_GUINT64_FORMAT " ! "
+      "filesink location=%s", n_frames, FPS, GST_SECOND, location);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  run_to_eos (pipeline);
+  gst_object_unref (pipeline);
+
+  return location;
+}
+
+static GstClockTime preroll_timestamp;
+
+static void
+_preroll_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  preroll_timestamp = GST_BUFFER_TIMESTAMP (buffer);
+}
+
+/* prerolls the demuxer in pull mode, seeks to @position and checks that
+ * it prerolls on the frame there */
+static void
+seek_pull (const gchar * location, const gchar * cache_dir,
+    GstClockTime position)
+{
+  GstElement *pipeline, *sink;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=%s ! "
+      "mxfdemux index-cache-directory=%s ! "
+      "fakesink name=sink signal-handoffs=true", location, cache_dir);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "preroll-handoff", G_CALLBACK (_preroll_handoff),
+      NULL);
+  gst_object_unref (sink);
+
+  preroll_timestamp = GST_CLOCK_TIME_NONE;
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (preroll_timestamp, 0);
+
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position));
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (preroll_timestamp, position);
+
+  /* the index is saved when stopping */
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+}
+
+/* the only file in @dir, named after the material package */
+static gchar *
+get_index_cache (const gchar * dir)
+{
+  const gchar *name;
+  gchar *location = NULL;
+  GDir *d;
+
+  d = g_dir_open (dir, 0, NULL);
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    fail_unless (location == NULL);
+    fail_unless (g_str_has_suffix (name, ".index"));
+    location = g_build_filename (dir, name, NULL);
+  }
+  g_dir_close (d);
+  fail_unless (location != NULL);
+
+  return location;
+}
+
+/* checks that the cache has all the frames of the video track in order */
+static void
+check_index_cache (const gchar * contents, gsize length, guint n_frames)
+{
+  const guint8 *data = (const guint8 *) contents;
+  guint64 last = 0;
+  guint i;
+
+  fail_unless (length >= 28 + 12);
+  fail_unless (GST_READ_UINT32_BE (data) ==
+      GST_MAKE_FOURCC ('M', 'X', 'I', 'X'));
+  fail_unless_equals_int (GST_READ_UINT32_BE (data + 4), 2);
+  fail_unless_equals_int (GST_READ_UINT32_BE (data + 24), 1);
+  fail_unless_equals_int (GST_READ_UINT32_BE (data + 36), n_frames);
+  fail_unless_equals_int (length, 28 + 12 + 8 * n_frames);
+
+  for (i = 0, data += 40; i < n_frames; i++, data += 8) {
+    guint64 v = GST_READ_UINT64_BE (data);
+
+    /* all keyframes */
+    fail_unless (v & G_GUINT64_CONSTANT (0x8000000000000000));
+    v &= ~G_GUINT64_CONSTANT (0x8000000000000000);
+    fail_unless (v > last);
+    last = v;
+  }
+}
+
+GST_START_TEST (test_pull_index)
+{
+  gchar *dir, *cache_dir, *location, *cache, *contents, *contents2;
+  gsize length, length2;
+  struct stat st, st2;
+  guint8 tmp[8];
+
+  dir = make_temp_dir ();
+  cache_dir = make_temp_dir ();
+  location = mux_file (dir, N_FRAMES);
+
+  /* Only the first frames were read when the index is saved, the others
+   * come from the index table segments of all the partitions */
+  seek_pull (location, cache_dir, 2 * GST_SECOND);
+  cache = get_index_cache (cache_dir);
+  fail_unless (g_file_get_contents (cache, &contents, &length, NULL));
+  check_index_cache (contents, length, N_FRAMES);
+
+  /* the cache is used the next time, and not written again as nothing was
+   * added to it */
+  fail_unless (g_stat (cache, &st) == 0);
+  seek_pull (location, cache_dir, 3 * GST_SECOND);
+  fail_unless (g_stat (cache, &st2) == 0);
+  fail_unless (st.st_ino == st2.st_ino);
+  fail_unless (st.st_mtime == st2.st_mtime);
+
+  /* a cache with unsorted offsets is ignored, and replaced by a good one */
+  contents2 = g_memdup (contents, length);
+  memcpy (tmp, contents2 + 40, 8);
+  memcpy (contents2 + 40, contents2 + 48, 8);
+  memcpy (contents2 + 48, tmp, 8);
+  fail_unless (g_file_set_contents (cache, contents2, length, NULL));
+  g_free (contents2);
+
+  seek_pull (location, cache_dir, GST_SECOND + 5 * FRAME_DURATION);
+  fail_unless (g_file_get_contents (cache, &contents2, &length2, NULL));
+  fail_unless_equals_int (length2, length);
+  fail_unless (memcmp (contents, contents2, length) == 0);
+  g_free (contents2);
+
+  /* and so is the cache of another file of the same size */
+  contents2 = g_memdup (contents, length);
+  GST_WRITE_UINT64_BE (contents2 + 16, GST_READ_UINT64_BE (contents + 16) + 1);
+  fail_unless (g_file_set_contents (cache, contents2, length, NULL));
+  g_free (contents2);
+
+  seek_pull (location, cache_dir, 2 * GST_SECOND);
+  fail_unless (g_file_get_contents (cache, &contents2, &length2, NULL));
+  fail_unless (memcmp (contents, contents2, length) == 0);
+  g_free (contents2);
+
+  g_free (contents);
+  g_free (cache);
+  g_free (location);
+  remove_temp_dir (cache_dir);
+  remove_temp_dir (dir);
+}
+
+GST_END_TEST;
+
+static gint n_growing_frames;
+
+static void
+_growing_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  /* counted again from the start after seeking back */
+  if (GST_BUFFER_TIMESTAMP (buffer) == 0)
+    g_atomic_int_set (&n_growing_frames, 0);
+  g_atomic_int_inc (&n_growing_frames);
+}
+
+/* The file is cut before the footer and the rest is appended while the
+ * demuxer waits at its end */
+GST_START_TEST (test_pull_growing)
+{
+  GstElement *pipeline, *sink;
+  GstFormat fmt = GST_FORMAT_TIME;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *dir, *location, *growing, *contents, *desc;
+  gsize length, truncated;
+  gint64 duration;
+  gint n;
+  FILE *f;
+
+  dir = make_temp_dir ();
+  location = mux_file (dir, N_FRAMES);
+  fail_unless (g_file_get_contents (location, &contents, &length, NULL));
+
+  truncated = length / 2;
+  growing = g_build_filename (dir, "growing.mxf", NULL);
+  fail_unless (g_file_set_contents (growing, contents, truncated, NULL));
+
+  desc = g_strdup_printf ("filesrc location=%s ! "
+      "mxfdemux growing-file=true growing-file-timeout=0 ! "
+      "fakesink name=sink sync=false signal-handoffs=true", growing);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (_growing_handoff), NULL);
+  gst_object_unref (sink);
+
+  n_growing_frames = 0;
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  /* wait until the demuxer stops at the end of the file */
+  do {
+    n = g_atomic_int_get (&n_growing_frames);
+    g_usleep (G_USEC_PER_SEC / 2);
+  } while (n == 0 || n != g_atomic_int_get (&n_growing_frames));
+  fail_unless (n < N_FRAMES);
+
+  /* a flushing seek doesn't have to wait for the file to grow */
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, 0));
+
+  f = g_fopen (growing, "ab");
+  fail_unless (f != NULL);
+  fail_unless_equals_int (fwrite (contents + truncated, 1, length - truncated,
+          f), length - truncated);
+  fclose (f);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless_equals_int (g_atomic_int_get (&n_growing_frames), N_FRAMES);
+  fail_unless (gst_element_query_duration (pipeline, &fmt, &duration));
+  fail_unless_equals_uint64 (duration, N_FRAMES * FRAME_DURATION);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+
+  g_free (contents);
+  g_free (growing);
+  g_free (location);
+  remove_temp_dir (dir);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfdemux_suite (void)
 {
@@ -266,6 +682,9 @@ mxfdemux_suite (void)
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
   tcase_add_test (tc_chain, test_push);
+  tcase_add_test (tc_chain, test_push_bytes_copied);
+  tcase_add_test (tc_chain, test_pull_index);
+  tcase_add_test (tc_chain, test_pull_growing);
 
   return s;
 }
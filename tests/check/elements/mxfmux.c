@@ -21,8 +21,13 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
+#define N_FRAMES 100
+#define FPS 25
+#define FRAME_DURATION (GST_SECOND / FPS)
+
 static const gchar *
 get_mpeg2enc_element_name (void)
 {
@@ -239,6 +244,255 @@ GST_START_TEST (test_multiple_av_streams)
 
 GST_END_TEST;
 
+/* Files written with a partition interval, checked packet by packet. The
+ * zero bytes of the ULs match anything, and byte 7 is the registry
+ * version. */
+
+static const guint8 partition_pack_ul[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0x00
+};
+
+static const guint8 random_index_pack_ul[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x11, 0x01, 0x00
+};
+
+static const guint8 index_table_segment_ul[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x10, 0x01, 0x00
+};
+
+static const guint8 essence_element_ul[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x01, 0x02, 0x01, 0x00,
+  0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
+};
+
+typedef struct
+{
+  guint64 offset;
+  guint8 type;                  /* 0x02 header, 0x03 body, 0x04 footer */
+  guint64 this_partition;
+  guint64 header_byte_count;
+  guint64 index_byte_count;
+  guint32 index_sid;
+  guint64 body_offset;
+  guint32 body_sid;
+
+  /* found in the file */
+  guint64 header_bytes;
+  guint64 index_bytes;
+  guint64 essence_bytes;
+} Partition;
+
+static gboolean
+is_ul (const guint8 * data, const guint8 * ul)
+{
+  guint i;
+
+  for (i = 0; i < 16; i++) {
+    if (i != 7 && ul[i] != 0x00 && ul[i] != data[i])
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* returns the size of the KLV packet at @data and the size of its key and
+ * length in @header_size */
+static guint64
+read_klv (const guint8 * data, gsize avail, guint * header_size)
+{
+  guint64 length = 0;
+  guint i, n;
+
+  fail_unless (avail >= 17);
+  if (data[16] & 0x80) {
+    n = data[16] & 0x7f;
+    fail_unless (n <= 8 && avail >= 17 + n);
+    for (i = 0; i < n; i++)
+      length = (length << 8) | data[17 + i];
+    *header_size = 17 + n;
+  } else {
+    length = data[16];
+    *header_size = 17;
+  }
+  fail_unless (length <= avail - *header_size);
+
+  return *header_size + length;
+}
+
+/* the partitions of the file, with what was found in each of them */
+static GArray *
+read_partitions (const guint8 * data, gsize length)
+{
+  GArray *partitions;
+  Partition *part = NULL;
+  guint64 offset = 0, size;
+  guint header_size;
+
+  partitions = g_array_new (FALSE, TRUE, sizeof (Partition));
+
+  while (offset < length && !is_ul (data + offset, random_index_pack_ul)) {
+    const guint8 *p = data + offset;
+
+    size = read_klv (p, length - offset, &header_size);
+
+    if (is_ul (p, partition_pack_ul)) {
+      const guint8 *v = p + header_size;
+
+      fail_unless (size - header_size >= 64);
+      g_array_set_size (partitions, partitions->len + 1);
+      part = &g_array_index (partitions, Partition, partitions->len - 1);
+      part->offset = offset;
+      part->type = p[13];
+      part->this_partition = GST_READ_UINT64_BE (v + 8);
+      part->header_byte_count = GST_READ_UINT64_BE (v + 32);
+      part->index_byte_count = GST_READ_UINT64_BE (v + 40);
+      part->index_sid = GST_READ_UINT32_BE (v + 48);
+      part->body_offset = GST_READ_UINT64_BE (v + 52);
+      part->body_sid = GST_READ_UINT32_BE (v + 60);
+    } else {
+      /* the header metadata, then the index, then the essence */
+      fail_unless (part != NULL);
+      if (is_ul (p, essence_element_ul)) {
+        part->essence_bytes += size;
+      } else if (is_ul (p, index_table_segment_ul)) {
+        fail_unless (part->essence_bytes == 0);
+        part->index_bytes += size;
+      } else {
+        fail_unless (part->index_bytes == 0 && part->essence_bytes == 0);
+        part->header_bytes += size;
+      }
+    }
+
+    offset += size;
+  }
+
+  return partitions;
+}
+
+static GstClockTime preroll_timestamp;
+
+static void
+_preroll_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  preroll_timestamp = GST_BUFFER_TIMESTAMP (buffer);
+}
+
+GST_START_TEST (test_partition_interval)
+{
+  GstElement *pipeline, *sink;
+  GArray *partitions;
+  const guint8 *data, *rip;
+  gchar *name, *dir, *location, *desc, *contents;
+  gsize length;
+  guint64 size, essence = 0;
+  guint32 rip_size;
+  guint header_size, n_body = 0, i;
+  GstClockTime position = 2 * GST_SECOND + 10 * FRAME_DURATION;
+
+  name = g_strdup_printf ("gst-check-mxfmux-%u", g_random_int ());
+  dir = g_build_filename (g_get_tmp_dir (), name, NULL);
+  g_free (name);
+  fail_unless (g_mkdir (dir, 0700) == 0);
+  location = g_build_filename (dir, "test.mxf", NULL);
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d ! "
+      "video/x-raw-yuv,format=(GstFourcc)v308,width=64,height=48,"
+      "framerate=%d/1 ! mxfmux partition-interval=%" G_GUINT64_FORMAT " ! "
+      "filesink location=%s", N_FRAMES, FPS, GST_SECOND, location);
+  run_test (desc);
+  g_free (desc);
+
+  fail_unless (g_file_get_contents (location, &contents, &length, NULL));
+  data = (const guint8 *) contents;
+
+  /* the random index pack at the end lists all the partitions */
+  fail_unless (length > 4);
+  rip_size = GST_READ_UINT32_BE (data + length - 4);
+  fail_unless (rip_size <= length);
+  rip = data + length - rip_size;
+  fail_unless (is_ul (rip, random_index_pack_ul));
+  size = read_klv (rip, rip_size, &header_size);
+  fail_unless_equals_uint64 (size, rip_size);
+  fail_unless_equals_int ((size - header_size - 4) % 12, 0);
+
+  partitions = read_partitions (data, length - rip_size);
+  fail_unless_equals_int ((size - header_size - 4) / 12, partitions->len);
+
+  for (i = 0; i < partitions->len; i++) {
+    Partition *part = &g_array_index (partitions, Partition, i);
+    const guint8 *entry = rip + header_size + 12 * i;
+
+    fail_unless_equals_int (GST_READ_UINT32_BE (entry), part->body_sid);
+    fail_unless_equals_uint64 (GST_READ_UINT64_BE (entry + 4), part->offset);
+    fail_unless_equals_uint64 (part->this_partition, part->offset);
+    fail_unless_equals_uint64 (part->header_bytes, part->header_byte_count);
+    fail_unless_equals_uint64 (part->index_bytes, part->index_byte_count);
+    fail_unless_equals_int (part->index_sid, part->index_bytes ? 2 : 0);
+
+    if (i == 0) {
+      fail_unless_equals_int (part->type, 0x02);
+    } else if (i == partitions->len - 1) {
+      /* with the index of the last body partition */
+      fail_unless_equals_int (part->type, 0x04);
+      fail_unless (part->index_byte_count > 0);
+      fail_unless_equals_int (part->body_sid, 0);
+    } else {
+      fail_unless_equals_int (part->type, 0x03);
+      fail_unless_equals_int (part->body_sid, 1);
+      fail_unless_equals_uint64 (part->body_offset, essence);
+      /* the index of the previous body partition */
+      if (n_body == 0)
+        fail_unless_equals_uint64 (part->index_byte_count, 0);
+      else
+        fail_unless (part->index_byte_count > 0);
+      n_body++;
+    }
+    essence += part->essence_bytes;
+  }
+  fail_unless (n_body >= N_FRAMES / FPS);
+  g_array_free (partitions, TRUE);
+  g_free (contents);
+
+  /* and it can be seeked in */
+  desc = g_strdup_printf ("filesrc location=%s ! mxfdemux ! "
+      "fakesink name=sink signal-handoffs=true", location);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "preroll-handoff", G_CALLBACK (_preroll_handoff),
+      NULL);
+  gst_object_unref (sink);
+
+  preroll_timestamp = GST_CLOCK_TIME_NONE;
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (preroll_timestamp, 0);
+
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position));
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_uint64 (preroll_timestamp, position);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+
+  g_remove (location);
+  g_rmdir (dir);
+  g_free (location);
+  g_free (dir);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfmux_suite (void)
 {
@@ -254,6 +508,7 @@ mxfmux_suite (void)
   tcase_add_test (tc_chain, test_jpeg2000_alaw);
   tcase_add_test (tc_chain, test_dnxhd_mp3);
   tcase_add_test (tc_chain, test_multiple_av_streams);
+  tcase_add_test (tc_chain, test_partition_interval);
 
   return s;
 }
@@ -0,0 +1,401 @@
+/* GStreamer
+ *
+ * unit test for the unpacking and the modes of sdidemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The frames are made by the generator of tests/benchmarks/sdidemux.c and
+ * the output is compared with the active words of each line, so both the
+ * unpacking and the line to row mapping of every mode are checked. */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-raw-sdi"));
+
+static GstStaticPadTemplate uyvy_sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-yuv,format=(fourcc)UYVY"));
+
+static GstStaticPadTemplate v210_sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-yuv,format=(fourcc)v210"));
+
+typedef struct
+{
+  const gchar *name;
+  gint lines, active_lines, width, active_width;
+  gint start0, start1, field2;  /* start1 is 0 for progressive modes */
+  gint fps_n, fps_d;
+  gboolean tff, hd;
+} Mode;
+
+/* SD interlaced, HD progressive with a v210 line that ends in a partial
+ * block, and HD interlaced */
+static const Mode modes[] = {
+  {"pal", 625, 576, 864, 720, 23, 336, 313, 25, 1, TRUE, FALSE},
+  {"720p60", 750, 720, 1650, 1280, 26, 0, 0, 60, 1, FALSE, TRUE},
+  {"1080i50", 1125, 1080, 2640, 1920, 21, 584, 563, 25, 1, TRUE, TRUE}
+};
+
+static guint16
+xyz (gboolean f, gboolean v, gboolean h)
+{
+  return 0x200 | (f << 8) | (v << 7) | (h << 6) | ((v ^ h) << 5) |
+      ((f ^ h) << 4) | ((f ^ v) << 3) | ((f ^ v ^ h) << 2);
+}
+
+/* bit 9 is the inverse of bit 8 */
+static guint16
+ln_word (guint bits)
+{
+  bits <<= 2;
+
+  return bits | ((~bits & 0x100) << 1);
+}
+
+static gboolean
+is_active (const Mode * mode, gint line)
+{
+  if (mode->start1 == 0)
+    return line >= mode->start0 && line < mode->start0 + mode->active_lines;
+
+  return (line >= mode->start0 &&
+      line < mode->start0 + mode->active_lines / 2) ||
+      (line >= mode->start1 && line < mode->start1 + mode->active_lines / 2);
+}
+
+/* word @i of the active picture of @line, counted from the EAV */
+static guint16
+active_word (gint line, gint i)
+{
+  return (i & 1) ? 0x040 + (i % 876) : 0x200 + (line % 64);
+}
+
+/* the lines start with the EAV, the words are packed LSB first */
+static GstBuffer *
+make_frame (const Mode * mode)
+{
+  GstBuffer *frame;
+  guint16 *words;
+  guint8 *d;
+  gint n_words = mode->width * 2, line_size = mode->width / 2 * 5;
+  gint sav = 2 * (mode->width - mode->active_width) - (mode->hd ? 8 : 4);
+  gint line, i;
+
+  frame = gst_buffer_new_and_alloc (line_size * mode->lines);
+  words = g_new (guint16, n_words);
+
+  for (line = 1; line <= mode->lines; line++) {
+    gboolean f = mode->start1 != 0 && line >= mode->field2;
+    gboolean v = !is_active (mode, line);
+
+    /* blanking, then the active picture */
+    for (i = 0; i < n_words; i++)
+      words[i] = (i & 1) ? 0x040 : 0x200;
+    for (i = sav + (mode->hd ? 8 : 4); i < n_words; i++)
+      words[i] = active_word (line, i);
+
+    if (mode->hd) {
+      words[0] = words[1] = 0x3ff;
+      words[2] = words[3] = words[4] = words[5] = 0x000;
+      words[6] = words[7] = xyz (f, v, TRUE);
+      words[8] = words[9] = ln_word (line & 0x7f);
+      words[10] = words[11] = ln_word ((line >> 7) & 0x0f);
+      words[sav] = words[sav + 1] = 0x3ff;
+      words[sav + 2] = words[sav + 3] = words[sav + 4] = words[sav + 5] = 0;
+      words[sav + 6] = words[sav + 7] = xyz (f, v, FALSE);
+    } else {
+      words[0] = 0x3ff;
+      words[1] = words[2] = 0x000;
+      words[3] = xyz (f, v, TRUE);
+      words[sav] = 0x3ff;
+      words[sav + 1] = words[sav + 2] = 0x000;
+      words[sav + 3] = xyz (f, v, FALSE);
+    }
+
+    d = GST_BUFFER_DATA (frame) + (line - 1) * line_size;
+    for (i = 0; i < n_words; i += 4) {
+      guint64 group = words[i] | (words[i + 1] << 10) |
+          ((guint64) words[i + 2] << 20) | ((guint64) words[i + 3] << 30);
+
+      d[0] = group;
+      d[1] = group >> 8;
+      d[2] = group >> 16;
+      d[3] = group >> 24;
+      d[4] = group >> 32;
+      d += 5;
+    }
+  }
+  g_free (words);
+
+  return frame;
+}
+
+/* the row of the output frame of @line, or -1 for blanking lines */
+static gint
+get_row (const Mode * mode, gint line)
+{
+  if (!is_active (mode, line))
+    return -1;
+  if (mode->start1 == 0)
+    return line - mode->start0;
+  if (line < mode->start1)
+    return (line - mode->start0) * 2 + !mode->tff;
+
+  return (line - mode->start1) * 2 + mode->tff;
+}
+
+/* the frame sdidemux should output for make_frame (@mode), the upper 8
+ * bits of the words for UYVY and 3 words in each 32 bit word for v210, of
+ * which the last block of a line is padded with zeros */
+static guint8 *
+make_output (const Mode * mode, gboolean v210, gint * stride)
+{
+  gint w0 = 2 * (mode->width - mode->active_width);
+  gint n_words = 2 * mode->active_width;
+  gint line, row, i, k;
+  guint8 *out, *d;
+
+  *stride = v210 ? (mode->active_width + 47) / 48 * 128 :
+      mode->active_width * 2;
+  out = g_malloc0 (*stride * mode->active_lines);
+
+  for (line = 1; line <= mode->lines; line++) {
+    if ((row = get_row (mode, line)) < 0)
+      continue;
+
+    d = out + row * *stride;
+    if (v210) {
+      for (i = 0; i < n_words; i += 3) {
+        guint32 v = 0;
+
+        for (k = 0; k < 3 && i + k < n_words; k++)
+          v |= active_word (line, w0 + i + k) << (10 * k);
+        GST_WRITE_UINT32_LE (d + i / 3 * 4, v);
+      }
+    } else {
+      for (i = 0; i < n_words; i++)
+        d[i] = active_word (line, w0 + i) >> 2;
+    }
+  }
+
+  return out;
+}
+
+static GstElement *
+setup_sdidemux (GstStaticPadTemplate * sinktemplate)
+{
+  GstElement *demux;
+
+  demux = gst_check_setup_element ("sdidemux");
+  mysrcpad = gst_check_setup_src_pad (demux, &srctemplate, NULL);
+  mysinkpad = gst_check_setup_sink_pad (demux, sinktemplate, NULL);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (demux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  return demux;
+}
+
+static void
+cleanup_sdidemux (GstElement * demux)
+{
+  fail_unless (gst_element_set_state (demux,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+
+  gst_check_drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (demux);
+  gst_check_teardown_sink_pad (demux);
+  gst_check_teardown_element (demux);
+}
+
+/* Pushes the frame of @mode twice, as the SD modes only find the start of
+ * a frame at the end of the previous one, and returns the first frame that
+ * comes out */
+static GstBuffer *
+demux_frame (GstElement * demux, const Mode * mode)
+{
+  GstBuffer *frame, *buf;
+  gint i;
+
+  gst_util_set_object_arg (G_OBJECT (demux), "mode", mode->name);
+  gst_check_drop_buffers ();
+
+  frame = make_frame (mode);
+  for (i = 0; i < 2; i++) {
+    buf = gst_buffer_create_sub (frame, 0, GST_BUFFER_SIZE (frame));
+    if (i == 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+  }
+  gst_buffer_unref (frame);
+
+  fail_unless (buffers != NULL);
+
+  return buffers->data;
+}
+
+static void
+check_frame (GstBuffer * buf, const Mode * mode, gboolean v210)
+{
+  GstStructure *s;
+  guint32 fourcc;
+  gint width, height, stride, row;
+  gboolean interlaced;
+  guint8 *expected;
+
+  fail_unless (GST_BUFFER_CAPS (buf) != NULL);
+  s = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
+  fail_unless (gst_structure_get_fourcc (s, "format", &fourcc));
+  fail_unless_equals_int (fourcc, v210 ? GST_MAKE_FOURCC ('v', '2', '1', '0')
+      : GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'));
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless_equals_int (width, mode->active_width);
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless_equals_int (height, mode->active_lines);
+  fail_unless (gst_structure_get_boolean (s, "interlaced", &interlaced));
+  fail_unless_equals_int (interlaced, mode->start1 != 0);
+
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buf), 0);
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf),
+      gst_util_uint64_scale (GST_SECOND, mode->fps_d, mode->fps_n));
+
+  expected = make_output (mode, v210, &stride);
+  fail_unless_equals_int (GST_BUFFER_SIZE (buf), stride * mode->active_lines);
+  for (row = 0; row < mode->active_lines; row++) {
+    fail_unless (memcmp (GST_BUFFER_DATA (buf) + row * stride,
+            expected + row * stride, stride) == 0, "%s: row %d differs",
+        mode->name, row);
+  }
+  g_free (expected);
+}
+
+GST_START_TEST (test_uyvy)
+{
+  GstElement *demux;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (modes); i++) {
+    demux = setup_sdidemux (&uyvy_sinktemplate);
+    check_frame (demux_frame (demux, &modes[i]), &modes[i], FALSE);
+    cleanup_sdidemux (demux);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_v210)
+{
+  GstElement *demux;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (modes); i++) {
+    demux = setup_sdidemux (&v210_sinktemplate);
+    check_frame (demux_frame (demux, &modes[i]), &modes[i], TRUE);
+    cleanup_sdidemux (demux);
+  }
+}
+
+GST_END_TEST;
+
+/* the output is renegotiated when the mode changes while streaming */
+GST_START_TEST (test_mode_switch)
+{
+  GstElement *demux;
+  guint i;
+
+  demux = setup_sdidemux (&v210_sinktemplate);
+  for (i = 0; i <= G_N_ELEMENTS (modes); i++) {
+    const Mode *mode = &modes[i % G_N_ELEMENTS (modes)];
+
+    check_frame (demux_frame (demux, mode), mode, TRUE);
+  }
+  cleanup_sdidemux (demux);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_src_getcaps)
+{
+  GstElement *demux;
+  GstStructure *s;
+  GstCaps *caps;
+  GstPad *srcpad;
+  guint32 fourcc;
+  gint width, height;
+
+  demux = gst_check_setup_element ("sdidemux");
+  srcpad = gst_element_get_static_pad (demux, "src");
+
+  /* both formats of the mode, UYVY first */
+  gst_util_set_object_arg (G_OBJECT (demux), "mode", "1080i50");
+  caps = gst_pad_get_caps (srcpad);
+  fail_unless_equals_int (gst_caps_get_size (caps), 2);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_fourcc (s, "format", &fourcc));
+  fail_unless_equals_int (fourcc, GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'));
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless_equals_int (width, 1920);
+  fail_unless (gst_structure_get_int (s, "height", &height));
+  fail_unless_equals_int (height, 1080);
+  s = gst_caps_get_structure (caps, 1);
+  fail_unless (gst_structure_get_fourcc (s, "format", &fourcc));
+  fail_unless_equals_int (fourcc, GST_MAKE_FOURCC ('v', '2', '1', '0'));
+  gst_caps_unref (caps);
+
+  /* the template caps once the pad has no parent anymore */
+  gst_element_remove_pad (demux, srcpad);
+  caps = gst_pad_get_caps (srcpad);
+  fail_unless (gst_caps_is_equal (caps,
+          gst_pad_get_pad_template_caps (srcpad)));
+  gst_caps_unref (caps);
+  gst_object_unref (srcpad);
+
+  gst_check_teardown_element (demux);
+}
+
+GST_END_TEST;
+
+static Suite *
+sdidemux_suite (void)
+{
+  Suite *s = suite_create ("sdidemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_uyvy);
+  tcase_add_test (tc_chain, test_v210);
+  tcase_add_test (tc_chain, test_mode_switch);
+  tcase_add_test (tc_chain, test_src_getcaps);
+
+  return s;
+}
+
+GST_CHECK_MAIN (sdidemux)